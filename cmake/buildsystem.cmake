@@ -33,4 +33,48 @@ configure_target(
     LIBRARIES           Common Math DSA Threading Networking
 )
 
+# Search benchmark: compare-function search against the SIMD kernels
+configure_target(
+#  |Parameter|----------|Value|
+    TARGET_NAME         "bench_vector_search"   # Name of the target
+    ENDPOINT            "LOCAL"                 # Determines whether the target is remote or local
+    TARGET_TYPE         "EXE"                   # Can be an executable or an SO
+    SOURCE_DIR          "projects/bench_vector_search"  # Top-level directory for the project source files
+    DESTINATION_DIR     "projects"              # Top-level destination project directory
+    LIBRARIES           Common DSA
+)
+
+# List benchmark: malloc() nodes against slab pool nodes
+configure_target(
+#  |Parameter|----------|Value|
+    TARGET_NAME         "bench_list_pool"       # Name of the target
+    ENDPOINT            "LOCAL"                 # Determines whether the target is remote or local
+    TARGET_TYPE         "EXE"                   # Can be an executable or an SO
+    SOURCE_DIR          "projects/bench_list_pool"  # Top-level directory for the project source files
+    DESTINATION_DIR     "projects"              # Top-level destination project directory
+    LIBRARIES           Common DSA
+)
+
+# List benchmark: recursive merge sort against list_sort() and list_sort_array()
+configure_target(
+#  |Parameter|----------|Value|
+    TARGET_NAME         "bench_list_sort"       # Name of the target
+    ENDPOINT            "LOCAL"                 # Determines whether the target is remote or local
+    TARGET_TYPE         "EXE"                   # Can be an executable or an SO
+    SOURCE_DIR          "projects/bench_list_sort"  # Top-level directory for the project source files
+    DESTINATION_DIR     "projects"              # Top-level destination project directory
+    LIBRARIES           Common DSA
+)
+
+# Server benchmark: system calls per request of each server mode
+configure_target(
+#  |Parameter|----------|Value|
+    TARGET_NAME         "bench_tcp_syscalls"    # Name of the target
+    ENDPOINT            "LOCAL"                 # Determines whether the target is remote or local
+    TARGET_TYPE         "EXE"                   # Can be an executable or an SO
+    SOURCE_DIR          "projects/bench_tcp_syscalls"  # Top-level directory for the project source files
+    DESTINATION_DIR     "projects"              # Top-level destination project directory
+    LIBRARIES           Common DSA Threading Networking
+)
+
 # *** end of file ***
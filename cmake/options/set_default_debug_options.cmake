@@ -7,7 +7,9 @@
 # -----------------------------------------------------------------------------
 
 function(set_default_debug_options)
-    add_compile_options(-std=c17 -Wall -Wextra -pedantic -Werror -fsanitize=address -g)
+    # The test suites are C++, so the C standard is set for C sources only
+    add_compile_options($<$<COMPILE_LANGUAGE:C>:-std=c17>)
+    add_compile_options(-Wall -Wextra -pedantic -Werror -fsanitize=address -g)
     link_libraries(-fsanitize=address)
     add_compile_definitions(DEBUG)
 endfunction()
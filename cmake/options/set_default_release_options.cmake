@@ -6,6 +6,8 @@
 # -----------------------------------------------------------------------------
 
 function(set_default_release_options)
-    add_compile_options(-std=c17 -Wall -Wextra -pedantic)
+    # The test suites are C++, so the C standard is set for C sources only
+    add_compile_options($<$<COMPILE_LANGUAGE:C>:-std=c17>)
+    add_compile_options(-Wall -Wextra -pedantic)
     add_compile_definitions(NDEBUG)
 endfunction()
@@ -23,7 +23,8 @@ function(configure_target)
     endif()
 
     # Add the target
-    add_target(${ARG_TARGET_NAME} ${ARG_ENDPOINT} ${ARG_TARGET_TYPE} ${ARG_SOURCE_DIR} ${ARG_DESTINATION_DIR} ${ARG_LIBRARIES})
+    # Quoted so the whole library list reaches add_target() as one argument
+    add_target(${ARG_TARGET_NAME} ${ARG_ENDPOINT} ${ARG_TARGET_TYPE} ${ARG_SOURCE_DIR} ${ARG_DESTINATION_DIR} "${ARG_LIBRARIES}")
 endfunction()
 
 # *** end of file ***
\ No newline at end of file
@@ -7,9 +7,27 @@
 
 # Function to add test suites for each target
 function(add_all_tests)
-    # Here you can loop through each target and add corresponding tests
-    # This is a placeholder and should be adapted based on your project structure
+    # One suite per library, linked against that library
     # Example: add_gtest(MyExecutable tests/my_executable_tests.cpp)
+    set(DSA_TESTS
+        tests/concurrent_map_tests.cpp
+        tests/hash_table_tests.cpp
+        tests/intrusive_list_tests.cpp
+        tests/position_index_tests.cpp
+        tests/slab_pool_tests.cpp
+        tests/sort_tests.cpp
+        tests/timer_wheel_tests.cpp
+        tests/unrolled_list_tests.cpp
+    )
+    add_gtest(DSA "${DSA_TESTS}")
+
+    set(NETWORKING_TESTS
+        tests/conn_reader_tests.cpp
+        tests/conn_writer_tests.cpp
+        tests/socket_io_tests.cpp
+        tests/tcp_reactor_tests.cpp
+    )
+    add_gtest(Networking "${NETWORKING_TESTS}")
 endfunction()
 
 # *** end of file ***
\ No newline at end of file
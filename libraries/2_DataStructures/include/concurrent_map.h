@@ -0,0 +1,122 @@
+/**
+ * @file concurrent_map.h
+ *
+ * @brief A sharded hash map for tables shared by many threads.
+ *
+ * The map composes independent hash_table_t shards, each on its own cache
+ * line, and routes every key to one shard. Writers serialize on their shard's
+ * lock only. Readers take no locks at all: shard slots and chain links are
+ * published with release stores, and removed entries are handed to an
+ * epoch-based reclaimer that frees them only once every reader that could
+ * still observe them has finished.
+ */
+#ifndef _CONCURRENT_MAP_H
+#define _CONCURRENT_MAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "hash_table.h"
+
+#define CMAP_CACHE_LINE   64  // Alignment of shards and reader slots
+#define CMAP_READER_SLOTS 64  // Reader counters, shared if more threads read
+#define CMAP_RETIRE_BATCH 128 // Removed entries collected before reclaiming
+
+/**
+ * @brief A pointer to a user-defined function that inspects the data of an
+ *        entry inside a read-side critical section. The data is guaranteed to
+ *        remain valid until the function returns. The function may add and
+ *        remove entries; entries it removes are reclaimed by a later remove
+ *        made outside any read, or by concurrent_map_destroy().
+ */
+typedef void (*READ_F)(void * data, void * context);
+
+typedef struct concurrent_map concurrent_map_t;
+
+/**
+ * @brief creates a new concurrent map
+ *
+ * @param shard_count number of independent shards, 0 picks a default
+ * @param shard_size number of slots in each shard
+ * @param customfree pointer to the user defined free function, free() if NULL
+ *
+ * @return concurrent_map_t pointer to allocated map, NULL on failure
+ */
+concurrent_map_t * concurrent_map_new(uint32_t shard_count,
+                                      uint32_t shard_size,
+                                      FREE_F   customfree);
+
+/**
+ * @brief adds an item to the map
+ *
+ * @param map pointer to map
+ * @param data data to be stored at that key value
+ * @param key key for data to be stored at
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int concurrent_map_add(concurrent_map_t * map, void * data, char * key);
+
+/**
+ * @brief looks up an item in the map without taking any locks
+ *
+ * The returned pointer stays valid until the entry is removed and reclaimed.
+ * Callers that race with removal of the same key should use
+ * concurrent_map_read() instead.
+ *
+ * @param map pointer to map
+ * @param key key for data being searched for
+ *
+ * @return void * data, or NULL if the key is not present
+ */
+void * concurrent_map_lookup(concurrent_map_t * map, char * key);
+
+/**
+ * @brief looks up an item and passes it to 'reader' while it is protected
+ *        from reclamation
+ *
+ * @param map pointer to map
+ * @param key key for data being searched for
+ * @param reader function called with the data if the key is present
+ * @param context passed through to 'reader'
+ *
+ * @return int E_SUCCESS if the key was found, E_FAILURE otherwise
+ */
+int concurrent_map_read(concurrent_map_t * map,
+                        char *             key,
+                        READ_F             reader,
+                        void *             context);
+
+/**
+ * @brief removes an item from the map, freeing it once no reader can still
+ *        observe it
+ *
+ * @param map pointer to map
+ * @param key key of data to be removed
+ *
+ * @return int E_SUCCESS for success, E_FAILURE if the key is not present
+ */
+int concurrent_map_remove(concurrent_map_t * map, char * key);
+
+/**
+ * @brief returns the number of entries in the map
+ *
+ * @param map pointer to map
+ *
+ * @return size_t number of entries, a snapshot if writers are active
+ */
+size_t concurrent_map_count(concurrent_map_t * map);
+
+/**
+ * @brief destroys the map and every entry in it, no other thread may be
+ *        using the map
+ *
+ * @param map_addr pointer to map address, set to NULL on success
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int concurrent_map_destroy(concurrent_map_t ** map_addr);
+
+#endif /* _CONCURRENT_MAP_H */
+
+/*** end of file ***/
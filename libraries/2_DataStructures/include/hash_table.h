@@ -2,6 +2,7 @@
 #define _HASH_TABLE_H
 
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,20 +18,67 @@
  */
 typedef void (*FREE_F)(void * data);
 
+/**
+ * @brief A function pointer to a custom-defined serialize function used by
+ *        hash_table_save(). It must flatten the data stored in a table entry
+ *        into a single buffer allocated with malloc(), storing the buffer and
+ *        its length in the output parameters. The buffer is freed by the
+ *        caller once it has been written to disk.
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+typedef int (*SERIALIZE_F)(void * data, void ** buffer_p, size_t * length_p);
+
+/**
+ * @brief A function pointer to a custom-defined deserialize function used by
+ *        hash_table_image_lookup(). It receives a read-only view of the bytes
+ *        previously produced by a SERIALIZE_F and must return a newly
+ *        allocated copy of the data, or NULL on failure.
+ */
+typedef void * (*DESERIALIZE_F)(const void * buffer, size_t length);
+
 /**
  * @brief structure of a node_t object
  *
- * @param key       pointer to the saved keyvalue string
- * @param data      saved data pointer
- * @param next      pointer to next node_t
+ * @param key         pointer to the saved keyvalue string
+ * @param data        saved data pointer
+ * @param next        pointer to next node_t
+ * @param older       next entry towards the eviction end (expiry mode only)
+ * @param newer       next entry towards the recent end (expiry mode only)
+ * @param expires_at  monotonic expiry time in milliseconds, 0 if none
+ * @param last_access monotonic time of the last access in milliseconds
+ * @param index       table slot holding this node
+ * @param referenced  CLOCK reference bit
  */
 typedef struct node_t
 {
     char *          key;
     void *          data;
     struct node_t * next;
+    struct node_t * older;
+    struct node_t * newer;
+    uint64_t        expires_at;
+    uint64_t        last_access;
+    uint32_t        index;
+    bool            referenced;
 } node_t;
 
+/**
+ * @brief eviction policies available once expiry mode is enabled with
+ *        hash_table_set_expiry()
+ *
+ * EVICT_LRU          evict the least recently used entry
+ * EVICT_CLOCK        second-chance approximation of LRU, lookups only set a
+ *                    reference bit instead of relinking the entry
+ * EVICT_SAMPLED_LRU  evict the least recently used of a few random entries
+ */
+typedef enum evict_policy
+{
+    EVICT_LRU,
+    EVICT_CLOCK,
+    EVICT_SAMPLED_LRU
+} evict_policy_t;
+
 /**
  * @brief structure of a hash_table_t object
  *
@@ -42,6 +90,16 @@ typedef struct node_t
  * @param size          number of positions supported by table
  * @param table         the table of node_t lists
  * @param customfree    pointer to the user defined free function
+ * @param count         number of entries currently stored
+ * @param expiring      true once hash_table_set_expiry() has been called
+ * @param policy        eviction policy used when max_entries is reached
+ * @param max_entries   maximum number of entries, 0 for unbounded
+ * @param default_ttl   time to live given to entries by hash_table_add()
+ * @param oldest        eviction end of the entry order list
+ * @param newest        recent end of the entry order list
+ * @param clock_hand    current position of the CLOCK hand
+ * @param sweep_cursor  next slot visited by the incremental sweep
+ * @param rng_state     state of the sampler used by EVICT_SAMPLED_LRU
  */
 typedef struct hash_table_t
 {
@@ -49,6 +107,16 @@ typedef struct hash_table_t
     node_t **       table;
     FREE_F          customfree;
     pthread_mutex_t lock;
+    uint32_t        count;
+    bool            expiring;
+    evict_policy_t  policy;
+    uint32_t        max_entries;
+    uint64_t        default_ttl;
+    node_t *        oldest;
+    node_t *        newest;
+    node_t *        clock_hand;
+    uint32_t        sweep_cursor;
+    uint64_t        rng_state;
 } hash_table_t;
 
 /**
@@ -60,6 +128,31 @@ typedef struct hash_table_t
  */
 hash_table_t * hash_table_init(uint32_t size, FREE_F customfree);
 
+/**
+ * @brief initializes a caller-provided hash table in place
+ *
+ * Used by containers that embed hash tables, for example to keep each one on
+ * its own cache line. Release the table with hash_table_teardown().
+ *
+ * @param table pointer to the table to initialize
+ * @param size number indexes in the table
+ * @param customfree pointer to the user defined free function
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int hash_table_setup(hash_table_t * table, uint32_t size, FREE_F customfree);
+
+/**
+ * @brief computes the slot a key hashes to
+ *
+ * @param table pointer to table address
+ * @param key key to hash
+ * @param index set to the slot index on success
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int hash_table_index(hash_table_t * table, const char * key, uint32_t * index);
+
 /**
  * @brief adds an item to the table
  *
@@ -71,9 +164,64 @@ hash_table_t * hash_table_init(uint32_t size, FREE_F customfree);
  */
 int hash_table_add(hash_table_t * table, void * data, char * key);
 
+/**
+ * @brief enables expiry mode on an empty table
+ *
+ * In expiry mode every entry carries a time to live and the table holds at
+ * most 'max_entries' entries, evicting according to 'policy' when full.
+ * Expired entries are removed lazily when looked up, and a few slots are
+ * swept on every insertion. Long-lived tables that see few insertions should
+ * also call hash_table_sweep() periodically.
+ *
+ * @param table pointer to table address
+ * @param max_entries maximum number of entries, 0 for unbounded
+ * @param default_ttl_ms time to live used by hash_table_add(), 0 for none
+ * @param policy eviction policy used when the table is full
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int hash_table_set_expiry(hash_table_t * table,
+                          uint32_t       max_entries,
+                          uint64_t       default_ttl_ms,
+                          evict_policy_t policy);
+
+/**
+ * @brief adds an item with its own time to live to a table in expiry mode
+ *
+ * @param table pointer to table address
+ * @param data data to be stored at that key value
+ * @param key key for data to be stored at
+ * @param ttl_ms time to live in milliseconds, 0 for none
+ *
+ * @return int exit code
+ */
+int hash_table_add_ttl(hash_table_t * table,
+                       void *         data,
+                       char *         key,
+                       uint64_t       ttl_ms);
+
+/**
+ * @brief removes expired entries from the next 'max_slots' table slots
+ *
+ * The sweep resumes where the previous one stopped, so calling it regularly
+ * with a small budget bounds memory without scanning the whole table at once.
+ *
+ * @param table pointer to table address
+ * @param max_slots number of slots to visit
+ * @param expired_count set to the number of entries removed, may be NULL
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int hash_table_sweep(hash_table_t * table,
+                     uint32_t       max_slots,
+                     size_t *       expired_count);
+
 /**
  * @brief looks up an item in the table by key
  *
+ * In expiry mode an expired entry is removed instead of being returned, and
+ * a successful lookup refreshes the entry for the eviction policy.
+ *
  * @param table pointer to table address
  * @param key key for data being searched for
  *
@@ -126,6 +274,15 @@ int hash_table_remove(hash_table_t * table, char * key);
  */
 int hash_table_clear(hash_table_t * table);
 
+/**
+ * @brief clears a table initialized with hash_table_setup() and releases its
+ *        slots, without freeing the table itself
+ *
+ * @param table pointer to table
+ * @return int
+ */
+int hash_table_teardown(hash_table_t * table);
+
 /**
  * @brief destroys hash table
  *
@@ -134,4 +291,80 @@ int hash_table_clear(hash_table_t * table);
  */
 int hash_table_destroy(hash_table_t ** table_addr);
 
+/**
+ * @brief A read-only hash table backed by a memory mapped snapshot file.
+ *
+ * The image is produced by hash_table_save() and opened with
+ * hash_table_load_mmap(). Buckets and entries are addressed by file offsets,
+ * so the image is position independent and nothing is copied at load time.
+ * Loading walks every chain once to reject truncated or corrupt images;
+ * after that, pages are faulted in on demand as lookups touch them.
+ */
+typedef struct hash_table_image_t hash_table_image_t;
+
+/**
+ * @brief writes a compact snapshot of the table to disk
+ *
+ * The snapshot is written to a temporary file next to 'path' and renamed into
+ * place once complete, so readers never observe a partially written image.
+ *
+ * @param table pointer to table address
+ * @param path path of the snapshot file to create or replace
+ * @param serialize_fn function used to flatten each entry's data
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int hash_table_save(hash_table_t * table,
+                    const char *   path,
+                    SERIALIZE_F    serialize_fn);
+
+/**
+ * @brief maps a snapshot written by hash_table_save() into memory
+ *
+ * Fails if any entry lies outside the file or links to an entry that is not
+ * strictly after it.
+ *
+ * @param path path of the snapshot file
+ * @param deserialize_fn function used by hash_table_image_lookup() to copy
+ * data out of the image, may be NULL if only hash_table_image_peek() is used
+ *
+ * @return hash_table_image_t pointer to the mapped image, NULL on failure
+ */
+hash_table_image_t * hash_table_load_mmap(const char *  path,
+                                          DESERIALIZE_F deserialize_fn);
+
+/**
+ * @brief looks up an item in a mapped image without copying it
+ *
+ * @param image pointer to the mapped image
+ * @param key key for data being searched for
+ * @param length_p set to the length of the returned data, may be NULL
+ *
+ * @return const void * read-only view into the image, valid until the image
+ * is closed, or NULL if the key is not present
+ */
+const void * hash_table_image_peek(hash_table_image_t * image,
+                                   char *               key,
+                                   size_t *             length_p);
+
+/**
+ * @brief looks up an item in a mapped image and copies it out
+ *
+ * @param image pointer to the mapped image
+ * @param key key for data being searched for
+ *
+ * @return void * data returned by the image's DESERIALIZE_F, owned by the
+ * caller, or NULL if the key is not present
+ */
+void * hash_table_image_lookup(hash_table_image_t * image, char * key);
+
+/**
+ * @brief unmaps a snapshot image
+ *
+ * @param image_addr pointer to image address, set to NULL on success
+ *
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+int hash_table_image_close(hash_table_image_t ** image_addr);
+
 #endif
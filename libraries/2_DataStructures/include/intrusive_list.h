@@ -0,0 +1,252 @@
+/**
+ * @file intrusive_list.h
+ *
+ * @brief A doubly linked list whose links live inside the user's objects.
+ *
+ * The caller embeds an intrusive_link_t in their own struct and links that,
+ * so adding an object to a list never allocates and removing it is O(1)
+ * without searching. INTRUSIVE_LIST_ENTRY() turns a link back into a pointer
+ * to the object containing it. An object can be on several lists at once by
+ * embedding one link per list. The list does not own its objects and never
+ * frees them.
+ *
+ * Example:
+ *
+ *     typedef struct conn
+ *     {
+ *         int              fd;
+ *         intrusive_link_t idle_link;
+ *     } conn_t;
+ *
+ *     intrusive_list_push_tail(&idle, &conn->idle_link);
+ *     conn_t * oldest = INTRUSIVE_LIST_ENTRY(
+ *         intrusive_list_pop_head(&idle), conn_t, idle_link);
+ */
+#ifndef _INTRUSIVE_LIST_H
+#define _INTRUSIVE_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Returns a pointer to the object of type 'type' whose member
+ *        'member' is at 'link_ptr'. NULL links map to NULL, and 'link_ptr'
+ *        is evaluated once.
+ */
+#define INTRUSIVE_LIST_ENTRY(link_ptr, type, member) \
+    ((type *)intrusive_link_object((link_ptr), offsetof(type, member)))
+
+/**
+ * @brief Loops over every link of 'list' from head to tail. The current
+ *        link may be removed inside the loop body, 'next_ptr' is used to
+ *        hold the link that follows it.
+ */
+#define INTRUSIVE_LIST_FOREACH(list, link_ptr, next_ptr)                  \
+    for ((link_ptr) = (list)->sentinel.next, (next_ptr) = (link_ptr)->next; \
+         (link_ptr) != &(list)->sentinel;                                  \
+         (link_ptr) = (next_ptr), (next_ptr) = (link_ptr)->next)
+
+/**
+ * @brief A link embedded in a user object
+ *
+ * @param prev pointer to the previous link, NULL while unlinked
+ * @param next pointer to the next link, NULL while unlinked
+ */
+typedef struct intrusive_link_t
+{
+    struct intrusive_link_t * prev;
+    struct intrusive_link_t * next;
+} intrusive_link_t;
+
+/**
+ * @brief structure of an intrusive list
+ *
+ * The list is circular through 'sentinel', so linking and unlinking never
+ * need to special case the ends.
+ *
+ * @param sentinel link before the head and after the tail
+ * @param size number of linked objects
+ */
+typedef struct intrusive_list_t
+{
+    intrusive_link_t sentinel;
+    size_t           size;
+} intrusive_list_t;
+
+/**
+ * @brief Returns the address 'offset' bytes before 'link', or NULL for a
+ *        NULL link. Used by INTRUSIVE_LIST_ENTRY().
+ */
+static inline void * intrusive_link_object(intrusive_link_t * link,
+                                           size_t             offset)
+{
+    return (NULL == link) ? NULL : (void *)((char *)link - offset);
+}
+
+/**
+ * @brief A pointer to a user-defined function that gets called in the
+ *        foreach_call on each link of the list.
+ */
+typedef void (*LINK_ACT_F)(intrusive_link_t * link);
+
+/**
+ * @brief initialises an empty list, must be called before any other use
+ *
+ * @param list pointer to the list
+ */
+void intrusive_list_init(intrusive_list_t * list);
+
+/**
+ * @brief marks a link as not being on any list, must be called on every
+ *        link before it is first pushed
+ *
+ * @param link pointer to the link
+ */
+void intrusive_link_init(intrusive_link_t * link);
+
+/**
+ * @brief checks whether a link is currently on a list
+ *
+ * @param link pointer to the link
+ * @return true if the link is on a list, false otherwise
+ */
+bool intrusive_link_is_linked(intrusive_link_t * link);
+
+/**
+ * @brief checks if the list is empty
+ *
+ * @param list pointer to the list
+ * @return true if the list is empty or NULL, false otherwise
+ */
+bool intrusive_list_is_empty(intrusive_list_t * list);
+
+/**
+ * @brief links an object at the head of the list
+ *
+ * @param list pointer to the list
+ * @param link pointer to the object's link, which must not be linked
+ * @return 0 on success, non-zero value on failure
+ */
+int intrusive_list_push_head(intrusive_list_t * list, intrusive_link_t * link);
+
+/**
+ * @brief links an object at the tail of the list
+ *
+ * @param list pointer to the list
+ * @param link pointer to the object's link, which must not be linked
+ * @return 0 on success, non-zero value on failure
+ */
+int intrusive_list_push_tail(intrusive_list_t * list, intrusive_link_t * link);
+
+/**
+ * @brief links an object directly before another one already on the list
+ *
+ * @param list pointer to the list
+ * @param position pointer to a link on 'list'
+ * @param link pointer to the object's link, which must not be linked
+ * @return 0 on success, non-zero value on failure
+ */
+int intrusive_list_insert_before(intrusive_list_t * list,
+                                 intrusive_link_t * position,
+                                 intrusive_link_t * link);
+
+/**
+ * @brief links an object directly after another one already on the list
+ *
+ * @param list pointer to the list
+ * @param position pointer to a link on 'list'
+ * @param link pointer to the object's link, which must not be linked
+ * @return 0 on success, non-zero value on failure
+ */
+int intrusive_list_insert_after(intrusive_list_t * list,
+                                intrusive_link_t * position,
+                                intrusive_link_t * link);
+
+/**
+ * @brief unlinks an object from the list in O(1), leaving its link ready to
+ *        be pushed again
+ *
+ * @param list pointer to the list the object is on
+ * @param link pointer to the object's link
+ * @return 0 on success, non-zero value on failure
+ */
+int intrusive_list_remove(intrusive_list_t * list, intrusive_link_t * link);
+
+/**
+ * @brief unlinks and returns the link at the head of the list
+ *
+ * @param list pointer to the list
+ * @return pointer to the unlinked link, NULL if the list is empty
+ */
+intrusive_link_t * intrusive_list_pop_head(intrusive_list_t * list);
+
+/**
+ * @brief unlinks and returns the link at the tail of the list
+ *
+ * @param list pointer to the list
+ * @return pointer to the unlinked link, NULL if the list is empty
+ */
+intrusive_link_t * intrusive_list_pop_tail(intrusive_list_t * list);
+
+/**
+ * @brief returns the link at the head of the list without unlinking it
+ *
+ * @param list pointer to the list
+ * @return pointer to the head link, NULL if the list is empty
+ */
+intrusive_link_t * intrusive_list_peek_head(intrusive_list_t * list);
+
+/**
+ * @brief returns the link at the tail of the list without unlinking it
+ *
+ * @param list pointer to the list
+ * @return pointer to the tail link, NULL if the list is empty
+ */
+intrusive_link_t * intrusive_list_peek_tail(intrusive_list_t * list);
+
+/**
+ * @brief returns the link after 'link'
+ *
+ * @param list pointer to the list 'link' is on
+ * @param link pointer to a link on 'list'
+ * @return pointer to the next link, NULL if 'link' is the tail
+ */
+intrusive_link_t * intrusive_list_next(intrusive_list_t * list,
+                                       intrusive_link_t * link);
+
+/**
+ * @brief returns the link before 'link'
+ *
+ * @param list pointer to the list 'link' is on
+ * @param link pointer to a link on 'list'
+ * @return pointer to the previous link, NULL if 'link' is the head
+ */
+intrusive_link_t * intrusive_list_prev(intrusive_list_t * list,
+                                       intrusive_link_t * link);
+
+/**
+ * @brief moves every object of 'source' onto the tail of 'dest' in O(1),
+ *        leaving 'source' empty
+ *
+ * @param dest pointer to the receiving list
+ * @param source pointer to the list to empty
+ * @return 0 on success, non-zero value on failure
+ */
+int intrusive_list_splice_tail(intrusive_list_t * dest,
+                               intrusive_list_t * source);
+
+/**
+ * @brief calls a user defined action on every link from head to tail, the
+ *        action may unlink the link it is given
+ *
+ * @param list pointer to the list
+ * @param action_function pointer to user defined action function
+ * @return 0 on success, non-zero value on failure
+ */
+int intrusive_list_foreach_call(intrusive_list_t * list,
+                                LINK_ACT_F         action_function);
+
+#endif /* _INTRUSIVE_LIST_H */
+
+/*** end of file ***/
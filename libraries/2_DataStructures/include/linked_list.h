@@ -8,6 +8,8 @@
 #include <stdlib.h>
 
 #include "comparisons.h"
+#include "position_index.h"
+#include "slab_pool.h"
 
 /**
  * @brief structure of a list node
@@ -58,14 +60,18 @@ typedef void (*ACT_F)(void *);
  * @param tail pointer to the tail node
  * @param customfree pointer to the user defined free function
  * @param compare_function pointer to the user defined compare function
+ * @param node_pool pool nodes are allocated from, NULL to use malloc()
+ * @param position_index index from positions to nodes, NULL when disabled
  */
 typedef struct list_t
 {
-    uint32_t      size;
-    list_node_t * head;
-    list_node_t * tail;
-    FREE_F        custom_free;
-    CMP_F         compare_func;
+    uint32_t           size;
+    list_node_t *      head;
+    list_node_t *      tail;
+    FREE_F             custom_free;
+    CMP_F              compare_func;
+    slab_pool_t *      node_pool;
+    position_index_t * position_index;
 } list_t;
 
 /**
@@ -78,6 +84,18 @@ typedef struct list_t
  */
 list_t * list_new(FREE_F, CMP_F);
 
+/**
+ * @brief creates a new list whose nodes come from a slab pool, so pushes and
+ *        pops do not call malloc() and nodes are packed together in memory
+ *
+ * @param customfree pointer to the free function to be used with that list
+ * @param compare_function pointer to the compare function to be used with
+ * that list
+ * @param slab_nodes number of nodes per slab, 0 for the pool's default
+ * @returns pointer to allocated list on success or NULL on failure
+ */
+list_t * list_new_pooled(FREE_F, CMP_F, size_t slab_nodes);
+
 /**
  * @brief pushes a new node onto the head of list
  *
@@ -118,7 +136,8 @@ int list_emptycheck(list_t * list);
  * @brief pops the head node out of the list
  *
  * @param list list to pop the node out of
- * @return pointer to popped node on success, NULL on failure
+ * @return pointer to popped node on success, NULL on failure, release with
+ *         list_node_release()
  */
 list_node_t * list_pop_head(list_t * list);
 
@@ -126,7 +145,8 @@ list_node_t * list_pop_head(list_t * list);
  * @brief pops the tail node out of the list
  *
  * @param list list to pop the node out of
- * @return pointer to popped node on success, NULL on failure
+ * @return pointer to popped node on success, NULL on failure, release with
+ *         list_node_release()
  */
 list_node_t * list_pop_tail(list_t * list);
 
@@ -135,7 +155,8 @@ list_node_t * list_pop_tail(list_t * list);
  *
  * @param list list to pop the node out of
  * @param position position of the node
- * @return pointer to popped node on success, NULL on failure
+ * @return pointer to popped node on success, NULL on failure, release with
+ *         list_node_release()
  */
 list_node_t * list_pop_position(list_t * list, uint32_t position);
 
@@ -238,11 +259,27 @@ list_t * list_find_all_occurrences(list_t * list, void ** search_data);
 /**
  * @brief sort list as per user defined compare function
  *
+ * Uses an iterative merge sort that relinks the nodes, so it is stable,
+ * needs no extra memory and does not recurse.
+ *
  * @param list pointer to list to be sorted
  * @return 0 on success, non-zero value on failure
  */
 int list_sort(list_t * list);
 
+/**
+ * @brief sort list as per user defined compare function by copying the data
+ *        pointers into an array, sorting the array and writing them back
+ *
+ * Usually faster than list_sort() on large lists since the sort works on
+ * contiguous memory, but it allocates list->size pointers and is not stable.
+ * Nodes keep their place and only their data moves.
+ *
+ * @param list pointer to list to be sorted
+ * @return 0 on success, non-zero value on failure
+ */
+int list_sort_array(list_t * list);
+
 /**
  * @brief clear all nodes out of a list
  *
@@ -259,6 +296,38 @@ int list_clear(list_t * list);
  */
 int list_delete(list_t ** list_address);
 
+/**
+ * @brief builds a position index for the list, making the positional push,
+ *        pop, peek and remove functions O(log n)
+ *
+ * Without the index those functions walk from whichever end of the list is
+ * nearer. With it, every push and pop, including at the head and tail, also
+ * pays O(log n) to keep the index up to date, and sorting rebuilds it.
+ *
+ * @param list list to index, enabling an already enabled index does nothing
+ * @return 0 on success, non-zero value on failure
+ */
+int list_enable_position_index(list_t * list);
+
+/**
+ * @brief frees the list's position index, if it has one
+ *
+ * @param list list to stop indexing
+ */
+void list_disable_position_index(list_t * list);
+
+/**
+ * @brief releases a node returned by one of the pop functions, the node's
+ *        data is not freed
+ *
+ * Nodes from pooled lists must be released with this function rather than
+ * free(); it works for any list.
+ *
+ * @param list the list the node was popped from
+ * @param node the popped node
+ */
+void list_node_release(list_t * list, list_node_t * node);
+
 /**
  * @brief frees an item and its associated memory
  *
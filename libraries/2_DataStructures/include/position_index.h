@@ -0,0 +1,85 @@
+/**
+ * @file position_index.h
+ *
+ * @brief An order-statistic index mapping positions to items.
+ *
+ * The index is a sequence of item pointers kept in an implicit treap, a
+ * randomised balanced tree where each node knows the size of its subtree.
+ * Looking up, inserting or removing the item at any position takes expected
+ * O(log n) time, and inserting or removing shifts the positions of every item
+ * after it. The index is not thread safe.
+ */
+#ifndef _POSITION_INDEX_H
+#define _POSITION_INDEX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef struct position_index position_index_t;
+
+/**
+ * @brief creates a new, empty position index
+ *
+ * @return position_index_t pointer to allocated index, NULL on failure
+ */
+position_index_t * position_index_new(void);
+
+/**
+ * @brief inserts an item so that it ends up at 'position'
+ *
+ * @param index pointer to index
+ * @param position position to insert at, at most the number of items
+ * @param item item to insert, must not be NULL
+ *
+ * @return int 0 on success, non-zero value on failure
+ */
+int position_index_insert(position_index_t * index,
+                          uint32_t           position,
+                          void *             item);
+
+/**
+ * @brief removes the item at 'position'
+ *
+ * @param index pointer to index
+ * @param position position of the item
+ *
+ * @return void * the removed item, NULL if position is out of bounds
+ */
+void * position_index_remove(position_index_t * index, uint32_t position);
+
+/**
+ * @brief gets the item at 'position'
+ *
+ * @param index pointer to index
+ * @param position position of the item
+ *
+ * @return void * the item, NULL if position is out of bounds
+ */
+void * position_index_get(position_index_t * index, uint32_t position);
+
+/**
+ * @brief returns the number of items in the index
+ *
+ * @param index pointer to index
+ *
+ * @return uint32_t number of items
+ */
+uint32_t position_index_size(position_index_t * index);
+
+/**
+ * @brief removes every item from the index
+ *
+ * @param index pointer to index
+ */
+void position_index_clear(position_index_t * index);
+
+/**
+ * @brief destroys the index, the items themselves are not touched
+ *
+ * @param index_addr pointer to index address, set to NULL
+ */
+void position_index_destroy(position_index_t ** index_addr);
+
+#endif /* _POSITION_INDEX_H */
+
+/*** end of file ***/
@@ -0,0 +1,73 @@
+/**
+ * @file slab_pool.h
+ *
+ * @brief A pool allocator for many small objects of one size.
+ *
+ * Objects are carved out of large slabs and recycled through an intrusive
+ * free list, so allocating and releasing an object is a pointer swap rather
+ * than a call into malloc(), and objects allocated together sit next to each
+ * other in memory. Slabs are only returned to the system when the pool is
+ * destroyed. The pool is not thread safe.
+ */
+#ifndef _SLAB_POOL_H
+#define _SLAB_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SLAB_POOL_SLAB_BYTES 65536 // Default slab size when none is given
+
+typedef struct slab_pool slab_pool_t;
+
+/**
+ * @brief creates a new slab pool
+ *
+ * @param object_size size of each object in bytes
+ * @param objects_per_slab number of objects carved from each slab, 0 sizes
+ *        slabs to about SLAB_POOL_SLAB_BYTES
+ *
+ * @return slab_pool_t pointer to allocated pool, NULL on failure
+ */
+slab_pool_t * slab_pool_new(size_t object_size, size_t objects_per_slab);
+
+/**
+ * @brief takes a zeroed object from the pool, allocating a new slab only
+ *        when every existing object is in use
+ *
+ * Objects are aligned for pointers and integers up to pointer size.
+ *
+ * @param pool pointer to pool
+ *
+ * @return void * pointer to the object, NULL on failure
+ */
+void * slab_pool_alloc(slab_pool_t * pool);
+
+/**
+ * @brief returns an object to the pool for reuse
+ *
+ * @param pool pointer to the pool the object came from
+ * @param object pointer to the object, may be NULL
+ */
+void slab_pool_free(slab_pool_t * pool, void * object);
+
+/**
+ * @brief returns the number of objects currently allocated from the pool
+ *
+ * @param pool pointer to pool
+ *
+ * @return size_t number of objects in use
+ */
+size_t slab_pool_in_use(slab_pool_t * pool);
+
+/**
+ * @brief destroys the pool and every slab, invalidating any objects still
+ *        in use
+ *
+ * @param pool_addr pointer to pool address, set to NULL
+ */
+void slab_pool_destroy(slab_pool_t ** pool_addr);
+
+#endif /* _SLAB_POOL_H */
+
+/*** end of file ***/
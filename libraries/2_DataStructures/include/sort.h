@@ -0,0 +1,121 @@
+/**
+ * @file sort.h
+ *
+ * @brief Sorting routines shared by the vector types.
+ *
+ * Comparison sorts call the library's CMP_F and treat LESS_THAN as the only
+ * "orders before" result, so comparators written for the rest of the library
+ * work unchanged. Radix sorts are provided for integer data and for data that
+ * can be ordered by an unsigned 64-bit key.
+ */
+#ifndef _SORT_H
+#define _SORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "comparisons.h"
+
+/**
+ * @brief A pointer to a user-defined function that maps data to an unsigned
+ * key whose natural order is the desired sort order.
+ */
+typedef uint64_t (*SORT_KEY_F)(void * data);
+
+/**
+ * @brief Sorts an array in place with a pattern-defeating introsort.
+ *
+ * Runs in O(n log n) worst case, finishes sorted and reverse sorted input in
+ * linear time and is not stable.
+ *
+ * @param base Pointer to the first element, may be NULL if 'count' is 0.
+ * @param count Number of elements.
+ * @param elem_size Size of one element in bytes.
+ * @param compare_func Comparison function.
+ * @param indirect true if each element is a pointer and 'compare_func'
+ * should receive the pointers themselves (as stored by vector_t), false if
+ * 'compare_func' should receive pointers to the elements.
+ * @return Status code indicating success or failure.
+ */
+int sort_introsort(void * base,
+                   size_t count,
+                   size_t elem_size,
+                   CMP_F  compare_func,
+                   bool   indirect);
+
+/**
+ * @brief Merges two sorted arrays into 'dest'. Elements from 'left' are
+ * taken first on ties, so the merge is stable.
+ *
+ * @param left Pointer to the first sorted run, may be NULL if empty.
+ * @param left_count Number of elements in 'left'.
+ * @param right Pointer to the second sorted run, may be NULL if empty.
+ * @param right_count Number of elements in 'right'.
+ * @param dest Buffer of left_count + right_count elements, must not overlap
+ * either run.
+ * @param elem_size Size of one element in bytes.
+ * @param compare_func Comparison function.
+ * @param indirect As for sort_introsort().
+ * @return Status code indicating success or failure.
+ */
+int sort_merge(const void * left,
+               size_t       left_count,
+               const void * right,
+               size_t       right_count,
+               void *       dest,
+               size_t       elem_size,
+               CMP_F        compare_func,
+               bool         indirect);
+
+/**
+ * @brief Sorts unsigned 32-bit integers with an LSD radix sort.
+ *
+ * @param values Pointer to the first value, may be NULL if 'count' is 0.
+ * @param count Number of values.
+ * @return Status code indicating success or failure.
+ */
+int sort_radix_u32(uint32_t * values, size_t count);
+
+/**
+ * @brief Sorts signed 32-bit integers with an LSD radix sort.
+ *
+ * @param values Pointer to the first value, may be NULL if 'count' is 0.
+ * @param count Number of values.
+ * @return Status code indicating success or failure.
+ */
+int sort_radix_i32(int32_t * values, size_t count);
+
+/**
+ * @brief Sorts unsigned 64-bit integers with an LSD radix sort.
+ *
+ * @param values Pointer to the first value, may be NULL if 'count' is 0.
+ * @param count Number of values.
+ * @return Status code indicating success or failure.
+ */
+int sort_radix_u64(uint64_t * values, size_t count);
+
+/**
+ * @brief Sorts signed 64-bit integers with an LSD radix sort.
+ *
+ * @param values Pointer to the first value, may be NULL if 'count' is 0.
+ * @param count Number of values.
+ * @return Status code indicating success or failure.
+ */
+int sort_radix_i64(int64_t * values, size_t count);
+
+/**
+ * @brief Stably sorts an array of data pointers by the key 'key_func'
+ * returns for each one. Each key is computed once.
+ *
+ * @param elements Pointer to the first data pointer, may be NULL if
+ * 'count' is 0.
+ * @param count Number of data pointers.
+ * @param key_func Function returning the sort key of a data pointer.
+ * @return Status code indicating success or failure.
+ */
+int sort_radix_keyed(void ** elements, size_t count, SORT_KEY_F key_func);
+
+#endif /* _SORT_H */
+
+/*** end of file ***/
@@ -0,0 +1,140 @@
+/**
+ * @file timer_wheel.h
+ *
+ * @brief A hashed timer wheel for many timeouts of coarse precision.
+ *
+ * Time is cut into ticks and each tick hashes to one of a fixed number of
+ * slots, each an intrusive list. Scheduling, rescheduling and cancelling a
+ * timer are O(1) and never allocate, as the caller embeds a
+ * timer_wheel_entry_t in their own object. Expiring visits only the slots of
+ * the ticks that have passed, so a loop that checks the wheel after every
+ * wait pays almost nothing when no tick has gone by. Deadlines further out
+ * than one turn of the wheel stay in their slot until their own turn comes.
+ *
+ * Timers never fire early; they fire on the first expire call made once the
+ * tick holding their deadline has ended. The wheel does not read the clock,
+ * timer_wheel_now_ms() is provided for callers that want the monotonic clock.
+ * The wheel is not thread safe.
+ */
+#ifndef _TIMER_WHEEL_H
+#define _TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "intrusive_list.h"
+
+#define TIMER_WHEEL_DEFAULT_SLOTS 512 // Slots when none are given
+
+/**
+ * @brief A timer embedded in a user object
+ *
+ * @param link entry in a slot, or in the caller's list once expired
+ * @param deadline time the timer fires at, in the caller's milliseconds
+ * @param slot index of the slot the timer is in while scheduled
+ */
+typedef struct timer_wheel_entry
+{
+    intrusive_link_t link;
+    uint64_t         deadline;
+    size_t           slot;
+} timer_wheel_entry_t;
+
+typedef struct timer_wheel timer_wheel_t;
+
+/**
+ * @brief creates a new timer wheel
+ *
+ * @param slot_count number of slots, 0 for TIMER_WHEEL_DEFAULT_SLOTS
+ * @param tick_ms length of a tick in milliseconds, at least 1
+ * @param now_ms the current time, which the first tick starts from
+ *
+ * @return timer_wheel_t pointer to allocated wheel, NULL on failure
+ */
+timer_wheel_t * timer_wheel_new(size_t   slot_count,
+                                uint64_t tick_ms,
+                                uint64_t now_ms);
+
+/**
+ * @brief reads the monotonic clock
+ *
+ * @return uint64_t the current monotonic time in milliseconds
+ */
+uint64_t timer_wheel_now_ms(void);
+
+/**
+ * @brief marks a timer as not scheduled, must be called on every entry
+ *        before it is first scheduled
+ *
+ * @param entry pointer to the entry
+ */
+void timer_wheel_entry_init(timer_wheel_entry_t * entry);
+
+/**
+ * @brief checks whether a timer is scheduled on a wheel
+ *
+ * @param entry pointer to the entry
+ * @return true if the timer is scheduled or on an expired list, false
+ *         otherwise
+ */
+bool timer_wheel_is_scheduled(timer_wheel_entry_t * entry);
+
+/**
+ * @brief schedules a timer, moving it if it is already scheduled
+ *
+ * A deadline that has already passed fires on the first expire call once
+ * the current tick has ended.
+ *
+ * @param wheel pointer to the wheel
+ * @param entry pointer to an entry that is not on an expired list
+ * @param deadline_ms time to fire at, in the same clock as expire calls
+ * @return 0 on success, non-zero value on failure
+ */
+int timer_wheel_schedule(timer_wheel_t *       wheel,
+                         timer_wheel_entry_t * entry,
+                         uint64_t              deadline_ms);
+
+/**
+ * @brief cancels a timer, doing nothing if it is not scheduled
+ *
+ * @param wheel pointer to the wheel
+ * @param entry pointer to an entry that is not on an expired list
+ * @return 0 on success, non-zero value on failure
+ */
+int timer_wheel_cancel(timer_wheel_t * wheel, timer_wheel_entry_t * entry);
+
+/**
+ * @brief moves every timer whose deadline has passed onto 'expired'
+ *
+ * Expired entries are linked through their own link, so each must be popped
+ * off 'expired' before it is scheduled or cancelled again.
+ *
+ * @param wheel pointer to the wheel
+ * @param now_ms the current time
+ * @param expired pointer to an initialised list that receives the entries
+ * @return size_t number of timers expired
+ */
+size_t timer_wheel_expire(timer_wheel_t *    wheel,
+                          uint64_t           now_ms,
+                          intrusive_list_t * expired);
+
+/**
+ * @brief returns the number of scheduled timers
+ *
+ * @param wheel pointer to the wheel
+ * @return size_t number of timers, 0 for a NULL wheel
+ */
+size_t timer_wheel_size(timer_wheel_t * wheel);
+
+/**
+ * @brief destroys the wheel, leaving any timers still scheduled untouched
+ *        but no longer usable with it
+ *
+ * @param wheel_addr pointer to wheel address, set to NULL
+ */
+void timer_wheel_destroy(timer_wheel_t ** wheel_addr);
+
+#endif /* _TIMER_WHEEL_H */
+
+/*** end of file ***/
@@ -0,0 +1,277 @@
+/**
+ * @file unrolled_list.h
+ *
+ * @brief A doubly linked list that stores several data pointers per node.
+ *
+ * Each node holds up to 'node_capacity' data pointers in a small array, so a
+ * walk over the list touches one node, and usually one cache miss, per
+ * 'node_capacity' elements instead of per element. Pushing onto either end
+ * stays O(1) and nodes are allocated from a slab pool. Apart from holding
+ * elements rather than nodes, the API mirrors list_t.
+ */
+#ifndef _UNROLLED_LIST_H
+#define _UNROLLED_LIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "comparisons.h"
+#include "slab_pool.h"
+
+#define UNROLLED_LIST_NODE_CAPACITY 13   // Default, fills a 128 byte node
+#define UNROLLED_LIST_MAX_CAPACITY  4096 // Largest allowed node capacity
+
+/**
+ * @brief A pointer to a user-defined free function, used to free the data
+ *        stored in the list.
+ */
+typedef void (*FREE_F)(void *);
+
+/**
+ * @brief A pointer to a user-defined function that gets called in the
+ *        foreach_call on each element of the list.
+ */
+typedef void (*ACT_F)(void *);
+
+/**
+ * @brief structure of an unrolled list node
+ *
+ * @param prev pointer to the node before it
+ * @param next pointer to the node after it
+ * @param count number of data pointers stored in the node
+ * @param items the data pointers, in list order
+ */
+typedef struct unrolled_node_t
+{
+    struct unrolled_node_t * prev;
+    struct unrolled_node_t * next;
+    uint32_t                 count;
+    void *                   items[];
+} unrolled_node_t;
+
+/**
+ * @brief structure of an unrolled list object
+ *
+ * @param size number of elements stored in the list
+ * @param node_capacity maximum number of elements per node
+ * @param head pointer to the first node
+ * @param tail pointer to the last node
+ * @param custom_free pointer to the user defined free function
+ * @param compare_func pointer to the user defined compare function
+ * @param node_pool pool the nodes are allocated from
+ */
+typedef struct unrolled_list_t
+{
+    uint32_t          size;
+    uint32_t          node_capacity;
+    unrolled_node_t * head;
+    unrolled_node_t * tail;
+    FREE_F            custom_free;
+    CMP_F             compare_func;
+    slab_pool_t *     node_pool;
+} unrolled_list_t;
+
+/**
+ * @brief creates a new unrolled list
+ *
+ * @param free_func pointer to the free function used on the list's data,
+ *        NULL for free()
+ * @param comp_func pointer to the compare function used on the list's data,
+ *        NULL for int_comp()
+ * @param node_capacity elements per node, 0 for UNROLLED_LIST_NODE_CAPACITY,
+ *        otherwise between 2 and UNROLLED_LIST_MAX_CAPACITY
+ * @returns pointer to allocated list on success or NULL on failure
+ */
+unrolled_list_t * unrolled_list_new(FREE_F   free_func,
+                                    CMP_F    comp_func,
+                                    uint32_t node_capacity);
+
+/**
+ * @brief pushes data onto the head of the list
+ *
+ * @param list list to push the data into
+ * @param data data to be pushed
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_push_head(unrolled_list_t * list, void * data);
+
+/**
+ * @brief pushes data onto the tail of the list
+ *
+ * @param list list to push the data into
+ * @param data data to be pushed
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_push_tail(unrolled_list_t * list, void * data);
+
+/**
+ * @brief inserts data into the list so that it ends up at 'position'
+ *
+ * @param list list to push the data into
+ * @param data data to be pushed
+ * @param position the position to insert the data at, at most list->size
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_push_position(unrolled_list_t * list,
+                                void *            data,
+                                uint32_t          position);
+
+/**
+ * @brief checks if the list is empty
+ *
+ * @param list pointer to the list to be checked
+ * @returns non-zero if list is empty or NULL, 0 if not empty
+ */
+int unrolled_list_emptycheck(unrolled_list_t * list);
+
+/**
+ * @brief pops the data at the head of the list
+ *
+ * @param list list to pop the data out of
+ * @returns pointer to the popped data on success, NULL on failure
+ */
+void * unrolled_list_pop_head(unrolled_list_t * list);
+
+/**
+ * @brief pops the data at the tail of the list
+ *
+ * @param list list to pop the data out of
+ * @returns pointer to the popped data on success, NULL on failure
+ */
+void * unrolled_list_pop_tail(unrolled_list_t * list);
+
+/**
+ * @brief pops the data at a specific position of the list
+ *
+ * @param list list to pop the data out of
+ * @param position position of the data
+ * @returns pointer to the popped data on success, NULL on failure
+ */
+void * unrolled_list_pop_position(unrolled_list_t * list, uint32_t position);
+
+/**
+ * @brief removes and frees the data at the head of the list
+ *
+ * @param list list to remove the data from
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_remove_head(unrolled_list_t * list);
+
+/**
+ * @brief removes and frees the data at the tail of the list
+ *
+ * @param list list to remove the data from
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_remove_tail(unrolled_list_t * list);
+
+/**
+ * @brief removes and frees the data at a specific position of the list
+ *
+ * @param list list to remove the data from
+ * @param position position of the data
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_remove_position(unrolled_list_t * list, uint32_t position);
+
+/**
+ * @brief gets the data at the head of the list without popping it
+ *
+ * @param list list to peek into
+ * @returns pointer to the data on success, NULL on failure
+ */
+void * unrolled_list_peek_head(unrolled_list_t * list);
+
+/**
+ * @brief gets the data at the tail of the list without popping it
+ *
+ * @param list list to peek into
+ * @returns pointer to the data on success, NULL on failure
+ */
+void * unrolled_list_peek_tail(unrolled_list_t * list);
+
+/**
+ * @brief gets the data at a specific position of the list without popping
+ *        it, walking from whichever end is nearer
+ *
+ * @param list list to peek into
+ * @param position position of the data
+ * @returns pointer to the data on success, NULL on failure
+ */
+void * unrolled_list_peek_position(unrolled_list_t * list, uint32_t position);
+
+/**
+ * @brief removes and frees the first element that compares EQUAL to the
+ *        given data
+ *
+ * @param list list to remove the data from
+ * @param item_to_remove address of a pointer to the data to search for
+ * @returns 0 on success, including when nothing matched, non-zero value on
+ *          failure
+ */
+int unrolled_list_remove_data(unrolled_list_t * list, void ** item_to_remove);
+
+/**
+ * @brief performs a user defined action on every element of the list, in
+ *        list order
+ *
+ * @param list list to perform actions on
+ * @param action_function pointer to user defined action function, called
+ *        with each element's data
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_foreach_call(unrolled_list_t * list, ACT_F action_function);
+
+/**
+ * @brief finds the first element that compares EQUAL to the search data
+ *
+ * @param list list to search through
+ * @param search_data address of a pointer to the data to search for
+ * @returns pointer to the matching data on success, NULL if not found
+ */
+void * unrolled_list_find_first_occurrence(unrolled_list_t * list,
+                                           void **           search_data);
+
+/**
+ * @brief finds every element that compares EQUAL to the search data
+ *
+ * The new list shares the matching data with 'list' and uses the same free
+ * function, so only one of the two lists may free it.
+ *
+ * @param list list to search through
+ * @param search_data address of a pointer to the data to search for
+ * @returns pointer to a new list of the matches in list order on success,
+ *          NULL on failure
+ */
+unrolled_list_t * unrolled_list_find_all_occurrences(unrolled_list_t * list,
+                                                     void ** search_data);
+
+/**
+ * @brief sorts the list as per the user defined compare function and packs
+ *        the elements into as few nodes as possible
+ *
+ * @param list pointer to list to be sorted
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_sort(unrolled_list_t * list);
+
+/**
+ * @brief frees every element and node of the list, leaving it empty
+ *
+ * @param list list to clear out
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_clear(unrolled_list_t * list);
+
+/**
+ * @brief deletes a list and every element in it
+ *
+ * @param list_address pointer to list pointer, set to NULL
+ * @returns 0 on success, non-zero value on failure
+ */
+int unrolled_list_delete(unrolled_list_t ** list_address);
+
+#endif /* _UNROLLED_LIST_H */
+
+/*** end of file ***/
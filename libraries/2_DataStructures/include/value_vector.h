@@ -0,0 +1,305 @@
+#ifndef _VALUE_VECTOR_H
+#define _VALUE_VECTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "comparisons.h"
+#include "sort.h"
+#include "utilities.h"
+
+/**
+ * @brief A pointer to a user-defined function that gets called in the
+ * foreach_call on each element in the vector.
+ */
+typedef void (*ACT_F)(void *);
+
+/**
+ * @brief structure of a value vector object
+ *
+ * Unlike vector_t, which stores pointers to separately allocated data, a
+ * value vector stores the elements themselves back to back, so walking it is
+ * a linear scan of one block of memory.
+ *
+ * @param data pointer to the element storage
+ * @param elem_size size of one element in bytes
+ * @param size number of elements currently stored
+ * @param capacity number of elements the storage can hold
+ * @param compare_func pointer to the user defined compare function, called
+ * with pointers to two elements; NULL compares the raw bytes for equality
+ */
+typedef struct value_vector
+{
+    unsigned char * data;
+    size_t          elem_size;
+    int             size;
+    int             capacity;
+    CMP_F           compare_func;
+} value_vector_t;
+
+/**
+ * @brief Initializes a new value vector.
+ * @param elem_size Size of one element in bytes.
+ * @param compare_func Function pointer to a comparison function for the
+ * elements, may be NULL.
+ * @param initial_capacity Initial capacity of the vector, may be 0.
+ * @return A pointer to the newly created vector.
+ */
+value_vector_t * value_vector_new(size_t elem_size,
+                                  CMP_F  compare_func,
+                                  int    initial_capacity);
+
+/**
+ * @brief Ensures the vector can hold at least 'capacity' elements without
+ * reallocating.
+ * @param vector Pointer to the vector.
+ * @param capacity Minimum capacity required.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_reserve(value_vector_t * vector, int capacity);
+
+/**
+ * @brief Copies an element onto the end of the vector.
+ * @param vector Pointer to the vector.
+ * @param element Pointer to the element to copy in.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_append(value_vector_t * vector, const void * element);
+
+/**
+ * @brief Copies 'count' contiguous elements onto the end of the vector.
+ * @param vector Pointer to the vector.
+ * @param elements Pointer to the first of 'count' elements.
+ * @param count Number of elements to copy in.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_append_many(value_vector_t * vector,
+                             const void *     elements,
+                             int              count);
+
+/**
+ * @brief Copies an element into the vector at a specific index.
+ * @param vector Pointer to the vector.
+ * @param element Pointer to the element to copy in.
+ * @param index Index at which to insert the element.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_insert(value_vector_t * vector,
+                        const void *     element,
+                        int              index);
+
+/**
+ * @brief Removes the last element from the vector.
+ * @param vector Pointer to the vector.
+ * @param element Buffer the removed element is copied to, may be NULL.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_pop(value_vector_t * vector, void * element);
+
+/**
+ * @brief Removes the element at a specific index from the vector.
+ * @param vector Pointer to the vector.
+ * @param index Index of the element to remove.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_remove(value_vector_t * vector, int index);
+
+/**
+ * @brief Returns a pointer to the element at a specific index. The pointer
+ * is invalidated by any call that changes the vector's capacity.
+ * @param vector Pointer to the vector.
+ * @param index Index of the element.
+ * @return Pointer to the element, or NULL if the index is out of bounds.
+ */
+void * value_vector_at(value_vector_t * vector, int index);
+
+/**
+ * @brief Overwrites the element at a specific index.
+ * @param vector Pointer to the vector.
+ * @param index Index of the element to overwrite.
+ * @param element Pointer to the new value.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_set(value_vector_t * vector, int index, const void * element);
+
+/**
+ * @brief Finds the first element equal to 'element'.
+ * @param vector Pointer to the vector.
+ * @param element Pointer to the value to search for.
+ * @return Index of the first match, or -1 if there is none.
+ */
+int value_vector_find_first(value_vector_t * vector, const void * element);
+
+/**
+ * @brief Number of uint64_t words needed for a match bitmap over 'size'
+ * elements.
+ */
+#define VALUE_VECTOR_BITMAP_WORDS(size) (((size_t)(size) + 63) / 64)
+
+/**
+ * @brief Finds the first element equal to 'value' in a vector of 32-bit
+ * integers, signed or unsigned. Uses AVX2 or SSE2 when the CPU supports
+ * them, selected at runtime, and a scalar loop otherwise.
+ * @param vector Pointer to a vector with an elem_size of 4.
+ * @param value The value to search for.
+ * @return Index of the first match, or -1 if there is none.
+ */
+int value_vector_find_u32(value_vector_t * vector, uint32_t value);
+
+/**
+ * @brief Finds the first element equal to 'value' in a vector of 64-bit
+ * integers, signed or unsigned.
+ * @param vector Pointer to a vector with an elem_size of 8.
+ * @param value The value to search for.
+ * @return Index of the first match, or -1 if there is none.
+ */
+int value_vector_find_u64(value_vector_t * vector, uint64_t value);
+
+/**
+ * @brief Marks every element equal to 'value' in a vector of 32-bit
+ * integers. Bit (idx % 64) of word (idx / 64) is set for each match.
+ * @param vector Pointer to a vector with an elem_size of 4.
+ * @param value The value to search for.
+ * @param bitmap Buffer of VALUE_VECTOR_BITMAP_WORDS(vector->size) words.
+ * @return Number of matches, or -1 on failure.
+ */
+int value_vector_match_u32(value_vector_t * vector,
+                           uint32_t         value,
+                           uint64_t *       bitmap);
+
+/**
+ * @brief Marks every element equal to 'value' in a vector of 64-bit
+ * integers, as value_vector_match_u32() does.
+ * @param vector Pointer to a vector with an elem_size of 8.
+ * @param value The value to search for.
+ * @param bitmap Buffer of VALUE_VECTOR_BITMAP_WORDS(vector->size) words.
+ * @return Number of matches, or -1 on failure.
+ */
+int value_vector_match_u64(value_vector_t * vector,
+                           uint64_t         value,
+                           uint64_t *       bitmap);
+
+/**
+ * @brief Converts a match bitmap into an ascending array of indexes.
+ * @param bitmap Bitmap filled in by a match function.
+ * @param size Number of elements the bitmap covers.
+ * @param indices Buffer large enough for every match.
+ * @return Number of indexes written.
+ */
+int value_vector_bitmap_indices(const uint64_t * bitmap,
+                                int              size,
+                                int *            indices);
+
+/**
+ * @brief Calls 'action_function' with a pointer to each element in order.
+ * @param vector Pointer to the vector.
+ * @param action_function Function called on each element.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_foreach(value_vector_t * vector, ACT_F action_function);
+
+/**
+ * @brief Sorts the elements in place using the vector's compare function.
+ * @param vector Pointer to the vector.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_sort(value_vector_t * vector);
+
+/**
+ * @brief Removes every element, keeping the storage.
+ * @param vector Pointer to the vector.
+ * @return Status code indicating success or failure.
+ */
+int value_vector_clear(value_vector_t * vector);
+
+/**
+ * @brief Frees the vector and its storage.
+ * @param vector Pointer to the vector's address, set to NULL.
+ */
+void value_vector_delete(value_vector_t ** vector);
+
+/**
+ * @brief Defines inline typed accessors over a value_vector_t of 'type'.
+ *
+ * VALUE_VECTOR_DEFINE(int32, int32_t, sort_radix_i32) generates
+ * int32_vector_new(), int32_vector_data(), int32_vector_get(),
+ * int32_vector_push(), int32_vector_find() and int32_vector_sort(). The find
+ * and compare loops work on 'type' directly, so the compiler can inline and
+ * vectorise them instead of calling through CMP_F.
+ *
+ * 'sort_fn' is called as sort_fn(type * values, size_t count) by
+ * name##_vector_sort(). Integer types pass their radix sort; other types
+ * pass name##_vector_introsort, which the macro also generates.
+ */
+#define VALUE_VECTOR_DEFINE(name, type, sort_fn)                              \
+    static inline comp_rtns_t name##_vector_cmp(void * lhs, void * rhs)       \
+    {                                                                         \
+        type left  = *(const type *)lhs;                                      \
+        type right = *(const type *)rhs;                                      \
+        if (left < right)                                                     \
+        {                                                                     \
+            return LESS_THAN;                                                 \
+        }                                                                     \
+        return (left > right) ? GREATER_THAN : EQUAL;                         \
+    }                                                                         \
+                                                                              \
+    static inline value_vector_t * name##_vector_new(int initial_capacity)    \
+    {                                                                         \
+        return value_vector_new(sizeof(type), NULL, initial_capacity);        \
+    }                                                                         \
+                                                                              \
+    static inline type * name##_vector_data(value_vector_t * vector)          \
+    {                                                                         \
+        return (type *)vector->data;                                          \
+    }                                                                         \
+                                                                              \
+    static inline type name##_vector_get(value_vector_t * vector, int index)  \
+    {                                                                         \
+        return ((type *)vector->data)[index];                                 \
+    }                                                                         \
+                                                                              \
+    static inline int name##_vector_push(value_vector_t * vector, type value) \
+    {                                                                         \
+        if (vector->size < vector->capacity)                                  \
+        {                                                                     \
+            ((type *)vector->data)[vector->size++] = value;                   \
+            return E_SUCCESS;                                                 \
+        }                                                                     \
+        return value_vector_append(vector, &value);                           \
+    }                                                                         \
+                                                                              \
+    static inline int name##_vector_find(value_vector_t * vector, type value) \
+    {                                                                         \
+        const type * values = (const type *)vector->data;                     \
+        for (int idx = 0; idx < vector->size; idx++)                          \
+        {                                                                     \
+            if (values[idx] == value)                                         \
+            {                                                                 \
+                return idx;                                                   \
+            }                                                                 \
+        }                                                                     \
+        return -1;                                                            \
+    }                                                                         \
+                                                                              \
+    static inline int name##_vector_introsort(type * values, size_t count)    \
+    {                                                                         \
+        return sort_introsort(                                                \
+            values, count, sizeof(type), name##_vector_cmp, false);           \
+    }                                                                         \
+                                                                              \
+    static inline int name##_vector_sort(value_vector_t * vector)             \
+    {                                                                         \
+        return sort_fn((type *)vector->data, (size_t)vector->size);           \
+    }
+
+VALUE_VECTOR_DEFINE(int32, int32_t, sort_radix_i32)
+VALUE_VECTOR_DEFINE(uint32, uint32_t, sort_radix_u32)
+VALUE_VECTOR_DEFINE(int64, int64_t, sort_radix_i64)
+VALUE_VECTOR_DEFINE(uint64, uint64_t, sort_radix_u64)
+VALUE_VECTOR_DEFINE(double, double, double_vector_introsort)
+
+#endif /* _VALUE_VECTOR_H */
+
+/*** end of file ***/
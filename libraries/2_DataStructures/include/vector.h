@@ -7,6 +7,7 @@
 #include <stdlib.h>
 
 #include "comparisons.h"
+#include "sort.h"
 
 /**
  * @brief A pointer to a user-defined function that gets called in the
@@ -22,6 +23,20 @@ typedef void (*ACT_F)(void *);
  */
 typedef void (*FREE_F)(void *);
 
+/**
+ * @brief structure of a vector object
+ *
+ * @param elements pointer to the element storage
+ * @param size number of elements currently stored
+ * @param capacity number of elements the storage can hold
+ * @param custom_free pointer to the user defined free function
+ * @param compare_func pointer to the user defined compare function
+ * @param mapped true if the storage is an anonymous mapping rather than a
+ * heap allocation, used for large vectors so growth can use mremap()
+ * @param sorted true while the elements are known to be in compare_func
+ * order. Set by vector_sort() and kept by the sorted operations; any other
+ * insertion clears it. Changes made to the data itself are not tracked.
+ */
 typedef struct vector
 {
     void ** elements;
@@ -29,6 +44,8 @@ typedef struct vector
     int     capacity;
     FREE_F  custom_free;
     CMP_F   compare_func;
+    bool    mapped;
+    bool    sorted;
 } vector_t;
 
 /**
@@ -37,13 +54,29 @@ typedef struct vector
  * elements.
  * @param compare_func Function pointer to a comparison function for the
  * elements.
- * @param initial_capacity Initial capacity of the vector.
+ * @param initial_capacity Initial capacity of the vector, may be 0.
  * @return A pointer to the newly created vector.
  */
 vector_t * vector_new(FREE_F custom_free,
                       CMP_F  compare_func,
                       int    initial_capacity);
 
+/**
+ * @brief Ensures the vector can hold at least 'capacity' elements without
+ * reallocating.
+ * @param vector Pointer to the vector.
+ * @param capacity Minimum capacity required.
+ * @return Status code indicating success or failure.
+ */
+int vector_reserve(vector_t * vector, int capacity);
+
+/**
+ * @brief Reduces the capacity of the vector to its current size.
+ * @param vector Pointer to the vector.
+ * @return Status code indicating success or failure.
+ */
+int vector_shrink_to_fit(vector_t * vector);
+
 /**
  * @brief Appends a data element to the end of the vector.
  * @param vector Pointer to the vector.
@@ -52,6 +85,30 @@ vector_t * vector_new(FREE_F custom_free,
  */
 int vector_append(vector_t * vector, void * data);
 
+/**
+ * @brief Appends 'count' data elements to the end of the vector, growing it at
+ * most once and copying the pointers in a single block.
+ * @param vector Pointer to the vector.
+ * @param data Array of 'count' non-NULL data pointers to append.
+ * @param count Number of elements in 'data'.
+ * @return Status code indicating success or failure.
+ */
+int vector_append_many(vector_t * vector, void ** data, int count);
+
+/**
+ * @brief Appends a data element without checking arguments or capacity.
+ *
+ * Intended for tight loops after vector_reserve() has made room; the caller
+ * guarantees that 'vector' is valid, 'data' is non-NULL and size < capacity.
+ * @param vector Pointer to the vector.
+ * @param data Pointer to the data to append.
+ */
+static inline void vector_push_unchecked(vector_t * vector, void * data)
+{
+    vector->elements[vector->size++] = data;
+    vector->sorted                   = false;
+}
+
 /**
  * @brief Inserts a data element at a specific index in the vector.
  * @param vector Pointer to the vector.
@@ -125,6 +182,7 @@ int vector_iterate(vector_t * vector, ACT_F action_function);
 
 /**
  * @brief Finds the first occurrence of a specific element in the vector.
+ * Sorted vectors are searched with vector_lower_bound() in O(log n).
  * @param vector Pointer to the vector.
  * @param search_data Pointer to the data to search for.
  * @return Pointer to the first occurrence, or NULL if not found.
@@ -140,12 +198,64 @@ void * vector_find_first_occurrence(vector_t * vector, void ** search_data);
 vector_t * vector_find_all_occurrences(vector_t * vector, void ** search_data);
 
 /**
- * @brief Sorts the elements in the vector.
+ * @brief Sorts the elements in the vector with sort_introsort(). The compare
+ * function is called with two data pointers; LESS_THAN orders the first
+ * before the second.
  * @param vector Pointer to the vector.
  * @return Status code indicating success or failure.
  */
 int vector_sort(vector_t * vector);
 
+/**
+ * @brief Stably sorts the elements in the vector by an unsigned key with
+ * sort_radix_keyed(). Faster than vector_sort() for large vectors whose
+ * order can be expressed as an integer or an integer key prefix.
+ * @param vector Pointer to the vector.
+ * @param key_func Function returning the sort key of a data pointer.
+ * @return Status code indicating success or failure.
+ */
+int vector_sort_by_key(vector_t * vector, SORT_KEY_F key_func);
+
+/**
+ * @brief Returns the index of the first element that does not order before
+ * 'key', using a branchless binary search. The vector must be sorted.
+ * @param vector Pointer to the vector.
+ * @param key Pointer to the data to search for, passed to compare_func as
+ * its second argument.
+ * @return Index in [0, size], or -1 if the vector is not sorted.
+ */
+int vector_lower_bound(vector_t * vector, void * key);
+
+/**
+ * @brief Returns the index of the first element that 'key' orders before,
+ * using a branchless binary search. The vector must be sorted.
+ * @param vector Pointer to the vector.
+ * @param key Pointer to the data to search for, passed to compare_func as
+ * its first argument.
+ * @return Index in [0, size], or -1 if the vector is not sorted.
+ */
+int vector_upper_bound(vector_t * vector, void * key);
+
+/**
+ * @brief Inserts a data element after any equal elements, keeping the vector
+ * sorted. The vector must be sorted; a new or cleared vector is.
+ * @param vector Pointer to the vector.
+ * @param data Pointer to the data to insert.
+ * @return Status code indicating success or failure.
+ */
+int vector_insert_sorted(vector_t * vector, void * data);
+
+/**
+ * @brief Moves every element of 'source' into 'dest' in one linear merge,
+ * keeping 'dest' sorted. Elements of 'dest' come first among equals. Both
+ * vectors must be sorted by the same order and must be distinct; 'source' is
+ * left empty and its elements become owned by 'dest'.
+ * @param dest Pointer to the vector merged into.
+ * @param source Pointer to the vector merged from.
+ * @return Status code indicating success or failure.
+ */
+int vector_merge_sorted(vector_t * dest, vector_t * source);
+
 /**
  * @brief Clears all elements from the vector.
  * @param vector Pointer to the vector.
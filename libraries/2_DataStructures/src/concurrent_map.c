@@ -0,0 +1,625 @@
+#include <sched.h>   // sched_yield()
+#include <stdbool.h>
+#include <string.h>  // strncmp(), strncpy()
+
+#include "concurrent_map.h"
+#include "utilities.h"
+
+#define DEFAULT_SHARDS 16
+#define MAX_KEY_SIZE   64 // Matches the key storage of hash_table_t
+#define MAX_LENGTH     50 // Matches the key comparison of hash_table_t
+#define FNV_OFFSET     2166136261U
+#define FNV_PRIME      16777619U
+#define EPOCH_FLIPS    2 // Flips per grace period, one per reader counter
+
+/**
+ * @brief A shard of the map. Each one starts on its own cache line, so the
+ * lock and counters of one shard never share a line with another shard.
+ */
+typedef struct shard
+{
+    _Alignas(CMAP_CACHE_LINE) hash_table_t table;
+} shard_t;
+
+/**
+ * @brief Per-slot reader counters, one for each parity of the global epoch.
+ */
+typedef struct reader_slot
+{
+    _Alignas(CMAP_CACHE_LINE) uint64_t active[2];
+} reader_slot_t;
+
+struct concurrent_map
+{
+    uint32_t        shard_count;   // Number of shards
+    shard_t *       shards;        // Cache-line aligned shard array
+    reader_slot_t * readers;       // Cache-line aligned reader counters
+    pthread_mutex_t reclaim_lock;  // Protects the retired list
+    node_t *        retired;       // Removed nodes, linked through 'older'
+    uint32_t        retired_count; // Length of the retired list
+    node_t *        deferred;      // Nodes removed inside a read, lock-free
+    _Alignas(CMAP_CACHE_LINE) uint64_t epoch; // Read by every reader
+};
+
+/**
+ * @brief Reader slot of the calling thread, assigned on first use.
+ */
+static _Thread_local uint32_t reader_slot_g = UINT32_MAX;
+
+/**
+ * @brief Read-side critical sections the calling thread is inside, so a
+ * remove made from a READ_F knows not to wait for readers.
+ */
+static _Thread_local uint32_t read_depth_g = 0;
+
+/**
+ * @brief Source of reader slot assignments.
+ */
+static uint32_t next_reader_slot_g = 0;
+
+/**
+ * @brief Picks the shard responsible for a key. Uses FNV-1a rather than the
+ * shard's own hash, so shard choice and slot choice are independent.
+ *
+ * @param map The map
+ * @param key The key
+ * @return shard_t* The shard for the key
+ */
+static shard_t * shard_for_key(concurrent_map_t * map, const char * key);
+
+/**
+ * @brief Enters a read-side critical section.
+ *
+ * @param map The map
+ * @param slot_p Set to the reader slot used, pass it to read_unlock()
+ * @return uint32_t The epoch parity entered, pass it to read_unlock()
+ */
+static uint32_t read_lock(concurrent_map_t * map, uint32_t * slot_p);
+
+/**
+ * @brief Leaves a read-side critical section.
+ *
+ * @param map The map
+ * @param slot The reader slot returned by read_lock()
+ * @param parity The epoch parity returned by read_lock()
+ */
+static void read_unlock(concurrent_map_t * map,
+                        uint32_t           slot,
+                        uint32_t           parity);
+
+/**
+ * @brief Finds a published node without locking. Must be called inside a
+ * read-side critical section or with the shard locked.
+ *
+ * @param table The shard's table
+ * @param key The key to search for
+ * @return node_t* The node, or NULL if the key is not present
+ */
+static node_t * find_node(hash_table_t * table, const char * key);
+
+/**
+ * @brief Waits until every read-side critical section that was active when
+ * the call started has finished. The reclaim lock must be held.
+ *
+ * @param map The map
+ */
+static void wait_for_readers(concurrent_map_t * map);
+
+/**
+ * @brief Queues an unlinked node for reclamation, reclaiming the whole batch
+ * once it is large enough. Inside a read-side critical section the node is
+ * only pushed onto the deferred list, as waiting for readers would wait for
+ * the caller itself.
+ *
+ * @param map The map
+ * @param p_node The unlinked node
+ */
+static void retire_node(concurrent_map_t * map, node_t * p_node);
+
+/**
+ * @brief Frees a list of retired nodes.
+ *
+ * @param map The map
+ * @param p_node The first node of the list
+ */
+static void free_retired(concurrent_map_t * map, node_t * p_node);
+
+concurrent_map_t * concurrent_map_new(uint32_t shard_count,
+                                      uint32_t shard_size,
+                                      FREE_F   customfree)
+{
+    concurrent_map_t * p_map      = NULL;
+    int                check      = E_FAILURE;
+    uint32_t           ready      = 0;
+    bool               lock_ready = false;
+
+    if (0 == shard_size)
+    {
+        print_error("concurrent_map_new(): Invalid shard size of 0.");
+        goto END;
+    }
+
+    if (0 == shard_count)
+    {
+        shard_count = DEFAULT_SHARDS;
+    }
+
+    p_map = aligned_alloc(CMAP_CACHE_LINE, sizeof(concurrent_map_t));
+    if (NULL == p_map)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+    *p_map = (concurrent_map_t) { 0 };
+
+    p_map->shards =
+        aligned_alloc(CMAP_CACHE_LINE, shard_count * sizeof(shard_t));
+    p_map->readers = aligned_alloc(CMAP_CACHE_LINE,
+                                   CMAP_READER_SLOTS * sizeof(reader_slot_t));
+    if ((NULL == p_map->shards) || (NULL == p_map->readers))
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+    memset(p_map->readers, 0, CMAP_READER_SLOTS * sizeof(reader_slot_t));
+
+    check = pthread_mutex_init(&p_map->reclaim_lock, NULL);
+    if (E_SUCCESS != check)
+    {
+        print_error("concurrent_map_new(): Unable to initialize mutex.");
+        goto END;
+    }
+    lock_ready = true;
+
+    for (ready = 0; ready < shard_count; ready++)
+    {
+        check = hash_table_setup(
+            &p_map->shards[ready].table, shard_size, customfree);
+        if (E_SUCCESS != check)
+        {
+            print_error("concurrent_map_new(): Unable to set up shard.");
+            goto END;
+        }
+    }
+
+    p_map->shard_count = shard_count;
+
+END:
+    if ((NULL != p_map) && (E_SUCCESS != check))
+    {
+        for (uint32_t idx = 0; idx < ready; idx++)
+        {
+            hash_table_teardown(&p_map->shards[idx].table);
+        }
+        if (true == lock_ready)
+        {
+            pthread_mutex_destroy(&p_map->reclaim_lock);
+        }
+        free(p_map->shards);
+        free(p_map->readers);
+        free(p_map);
+        p_map = NULL;
+    }
+
+    return p_map;
+}
+
+int concurrent_map_add(concurrent_map_t * map, void * data, char * key)
+{
+    int            exit_code  = E_FAILURE;
+    hash_table_t * table      = NULL;
+    node_t *       p_new_node = NULL;
+    node_t *       p_current  = NULL;
+    uint32_t       index      = 0;
+
+    if ((NULL == map) || (NULL == data) || (NULL == key))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    table = &shard_for_key(map, key)->table;
+
+    exit_code = hash_table_index(table, key, &index);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("Hashing failure.");
+        goto END;
+    }
+
+    p_new_node = calloc(1, sizeof(node_t));
+    if (NULL == p_new_node)
+    {
+        print_error("CMR failure.");
+        exit_code = E_FAILURE;
+        goto END;
+    }
+
+    p_new_node->key = calloc(MAX_KEY_SIZE + 1, sizeof(char));
+    if (NULL == p_new_node->key)
+    {
+        print_error("CMR failure.");
+        free(p_new_node);
+        exit_code = E_FAILURE;
+        goto END;
+    }
+
+    strncpy(p_new_node->key, key, MAX_KEY_SIZE);
+    p_new_node->data  = data;
+    p_new_node->index = index;
+
+    // The node is fully built before the release store makes it reachable
+    pthread_mutex_lock(&table->lock);
+    p_current = table->table[index];
+    if (NULL == p_current)
+    {
+        __atomic_store_n(&table->table[index], p_new_node, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        while (NULL != p_current->next)
+        {
+            p_current = p_current->next;
+        }
+
+        __atomic_store_n(&p_current->next, p_new_node, __ATOMIC_RELEASE);
+    }
+    __atomic_add_fetch(&table->count, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&table->lock);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void * concurrent_map_lookup(concurrent_map_t * map, char * key)
+{
+    void *   p_data = NULL;
+    node_t * p_node = NULL;
+    uint32_t slot   = 0;
+    uint32_t parity = 0;
+
+    if ((NULL == map) || (NULL == key))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    parity = read_lock(map, &slot);
+    p_node = find_node(&shard_for_key(map, key)->table, key);
+    if (NULL != p_node)
+    {
+        p_data = p_node->data;
+    }
+    read_unlock(map, slot, parity);
+
+END:
+    return p_data;
+}
+
+int concurrent_map_read(concurrent_map_t * map,
+                        char *             key,
+                        READ_F             reader,
+                        void *             context)
+{
+    int      exit_code = E_FAILURE;
+    node_t * p_node    = NULL;
+    uint32_t slot      = 0;
+    uint32_t parity    = 0;
+
+    if ((NULL == map) || (NULL == key) || (NULL == reader))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    parity = read_lock(map, &slot);
+    p_node = find_node(&shard_for_key(map, key)->table, key);
+    if (NULL != p_node)
+    {
+        reader(p_node->data, context);
+        exit_code = E_SUCCESS;
+    }
+    read_unlock(map, slot, parity);
+
+END:
+    return exit_code;
+}
+
+int concurrent_map_remove(concurrent_map_t * map, char * key)
+{
+    int            exit_code = E_FAILURE;
+    hash_table_t * table     = NULL;
+    node_t *       p_current = NULL;
+    node_t *       p_prev    = NULL;
+    uint32_t       index     = 0;
+
+    if ((NULL == map) || (NULL == key))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    table = &shard_for_key(map, key)->table;
+
+    exit_code = hash_table_index(table, key, &index);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("Hashing failure.");
+        goto END;
+    }
+
+    exit_code = E_FAILURE;
+
+    pthread_mutex_lock(&table->lock);
+    p_current = table->table[index];
+    while (NULL != p_current)
+    {
+        if (0 == strncmp(p_current->key, key, MAX_LENGTH))
+        {
+            // Readers already on 'p_current' can still follow its next link
+            if (NULL == p_prev)
+            {
+                __atomic_store_n(
+                    &table->table[index], p_current->next, __ATOMIC_RELEASE);
+            }
+            else
+            {
+                __atomic_store_n(
+                    &p_prev->next, p_current->next, __ATOMIC_RELEASE);
+            }
+            __atomic_sub_fetch(&table->count, 1, __ATOMIC_RELAXED);
+            exit_code = E_SUCCESS;
+            break;
+        }
+
+        p_prev    = p_current;
+        p_current = p_current->next;
+    }
+    pthread_mutex_unlock(&table->lock);
+
+    if (E_SUCCESS == exit_code)
+    {
+        retire_node(map, p_current);
+    }
+
+END:
+    return exit_code;
+}
+
+size_t concurrent_map_count(concurrent_map_t * map)
+{
+    size_t count = 0;
+
+    if (NULL == map)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    for (uint32_t idx = 0; idx < map->shard_count; idx++)
+    {
+        count += __atomic_load_n(&map->shards[idx].table.count,
+                                 __ATOMIC_RELAXED);
+    }
+
+END:
+    return count;
+}
+
+int concurrent_map_destroy(concurrent_map_t ** map_addr)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == map_addr) || (NULL == *map_addr))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    // No readers remain, so retired nodes can be freed immediately
+    free_retired(*map_addr, (*map_addr)->retired);
+    free_retired(*map_addr, (*map_addr)->deferred);
+    (*map_addr)->retired  = NULL;
+    (*map_addr)->deferred = NULL;
+
+    for (uint32_t idx = 0; idx < (*map_addr)->shard_count; idx++)
+    {
+        hash_table_teardown(&(*map_addr)->shards[idx].table);
+    }
+
+    pthread_mutex_destroy(&(*map_addr)->reclaim_lock);
+    free((*map_addr)->shards);
+    free((*map_addr)->readers);
+    free(*map_addr);
+    *map_addr = NULL;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/***********************************************************************
+ * NOTE: STATIC FUNCTIONS LISTED BELOW
+ ***********************************************************************/
+
+static shard_t * shard_for_key(concurrent_map_t * map, const char * key)
+{
+    uint32_t              target = FNV_OFFSET;
+    const unsigned char * letter = (const unsigned char *)key;
+
+    for (uint32_t idx = 0; idx < MAX_KEY_SIZE; idx++)
+    {
+        if ('\0' == letter[idx])
+        {
+            break;
+        }
+
+        target = (target ^ letter[idx]) * FNV_PRIME;
+    }
+
+    // Map the full 32-bit hash onto the shard range without a division
+    return &map->shards[((uint64_t)target * map->shard_count) >> 32];
+}
+
+static uint32_t read_lock(concurrent_map_t * map, uint32_t * slot_p)
+{
+    uint32_t   parity    = 0;
+    uint64_t * p_counter = NULL;
+
+    if (UINT32_MAX == reader_slot_g)
+    {
+        reader_slot_g =
+            __atomic_fetch_add(&next_reader_slot_g, 1, __ATOMIC_RELAXED) %
+            CMAP_READER_SLOTS;
+    }
+    *slot_p = reader_slot_g;
+    read_depth_g++;
+
+    // Retry if the epoch flipped between reading it and announcing ourselves,
+    // otherwise a reclaimer could miss this reader
+    for (;;)
+    {
+        parity    = __atomic_load_n(&map->epoch, __ATOMIC_SEQ_CST) & 1U;
+        p_counter = &map->readers[*slot_p].active[parity];
+        __atomic_fetch_add(p_counter, 1, __ATOMIC_SEQ_CST);
+
+        if (parity == (__atomic_load_n(&map->epoch, __ATOMIC_SEQ_CST) & 1U))
+        {
+            break;
+        }
+
+        __atomic_fetch_sub(p_counter, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return parity;
+}
+
+static void read_unlock(concurrent_map_t * map,
+                        uint32_t           slot,
+                        uint32_t           parity)
+{
+    __atomic_fetch_sub(
+        &map->readers[slot].active[parity], 1, __ATOMIC_RELEASE);
+    read_depth_g--;
+}
+
+static node_t * find_node(hash_table_t * table, const char * key)
+{
+    node_t * p_node = NULL;
+    uint32_t index  = 0;
+
+    if (E_SUCCESS != hash_table_index(table, key, &index))
+    {
+        goto END;
+    }
+
+    p_node = __atomic_load_n(&table->table[index], __ATOMIC_ACQUIRE);
+    while (NULL != p_node)
+    {
+        if (0 == strncmp(p_node->key, key, MAX_LENGTH))
+        {
+            goto END;
+        }
+
+        p_node = __atomic_load_n(&p_node->next, __ATOMIC_ACQUIRE);
+    }
+
+END:
+    return p_node;
+}
+
+static void wait_for_readers(concurrent_map_t * map)
+{
+    uint32_t parity = 0;
+
+    // A reader counted under either parity may predate the unlinks, so both
+    // counters must drain, each after a flip that stops new readers using it
+    for (uint32_t flip = 0; flip < EPOCH_FLIPS; flip++)
+    {
+        parity = __atomic_fetch_add(&map->epoch, 1, __ATOMIC_SEQ_CST) & 1U;
+
+        for (uint32_t idx = 0; idx < CMAP_READER_SLOTS; idx++)
+        {
+            while (0 != __atomic_load_n(&map->readers[idx].active[parity],
+                                        __ATOMIC_ACQUIRE))
+            {
+                sched_yield();
+            }
+        }
+    }
+}
+
+static void retire_node(concurrent_map_t * map, node_t * p_node)
+{
+    node_t * p_batch    = NULL;
+    node_t * p_deferred = NULL;
+
+    // Shards never use expiry mode, so 'older' is free to link retired nodes.
+    // Inside a read the reclaim lock is not taken either, as its holder may
+    // be waiting for this very read to finish
+    if (0 != read_depth_g)
+    {
+        p_node->older = __atomic_load_n(&map->deferred, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&map->deferred,
+                                            &p_node->older,
+                                            p_node,
+                                            true,
+                                            __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED))
+        {
+            // A failed exchange reloaded 'older', so simply retry
+        }
+
+        return;
+    }
+
+    pthread_mutex_lock(&map->reclaim_lock);
+
+    p_node->older = map->retired;
+    map->retired  = p_node;
+    map->retired_count++;
+
+    // Adopt nodes removed from inside reads since the last reclaim
+    p_deferred = __atomic_exchange_n(&map->deferred, NULL, __ATOMIC_ACQUIRE);
+    while (NULL != p_deferred)
+    {
+        p_node        = p_deferred;
+        p_deferred    = p_deferred->older;
+        p_node->older = map->retired;
+        map->retired  = p_node;
+        map->retired_count++;
+    }
+
+    if (CMAP_RETIRE_BATCH <= map->retired_count)
+    {
+        p_batch            = map->retired;
+        map->retired       = NULL;
+        map->retired_count = 0;
+
+        wait_for_readers(map);
+        free_retired(map, p_batch);
+    }
+
+    pthread_mutex_unlock(&map->reclaim_lock);
+}
+
+static void free_retired(concurrent_map_t * map, node_t * p_node)
+{
+    node_t * p_older = NULL;
+
+    while (NULL != p_node)
+    {
+        p_older = p_node->older;
+
+        map->shards[0].table.customfree(p_node->data);
+        p_node->data = NULL;
+        free(p_node->key);
+        p_node->key = NULL;
+        free(p_node);
+
+        p_node = p_older;
+    }
+}
+
+/*** end of file ***/
@@ -1,4 +1,10 @@
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "hash_table.h"
 #include "utilities.h"
@@ -8,8 +14,55 @@
 #define MAX_KEY_SIZE 64
 #define MAX_LENGTH   50 // used for strncmp() in hash_table_lookup()
 
+#define SWEEP_SLOTS_PER_ADD 4  // Slots swept by every insertion in expiry mode
+#define EVICTION_SAMPLES    5  // Entries sampled by EVICT_SAMPLED_LRU
+#define EVICTION_PROBES     64 // Slot draws before sampling gives up
+#define MS_PER_SEC          1000U
+#define NS_PER_MS           1000000U
+
+#define SNAPSHOT_MAGIC   0x31544248U // "HBT1" in little-endian byte order
+#define SNAPSHOT_VERSION 1U
+#define SNAPSHOT_ALIGN   8U // Alignment of every entry inside the image
+#define SNAPSHOT_SUFFIX  ".tmp"
+
 typedef unsigned const char uchar_t;
 
+/**
+ * @brief On-disk header found at offset 0 of a snapshot image. It is followed
+ * by 'bucket_count' uint64_t offsets, one per bucket, where 0 marks an empty
+ * bucket. Every offset in the image is relative to the start of the file.
+ */
+typedef struct snapshot_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t bucket_count;
+    uint32_t reserved;
+    uint64_t entry_count;
+    uint64_t file_size;
+} snapshot_header_t;
+
+/**
+ * @brief On-disk entry. It is followed by 'key_length' key bytes, a NUL
+ * terminator, 'data_length' data bytes, and padding up to SNAPSHOT_ALIGN.
+ * 'next' holds the offset of the next entry in the same bucket, or 0.
+ */
+typedef struct snapshot_entry
+{
+    uint64_t next;
+    uint32_t key_length;
+    uint32_t data_length;
+} snapshot_entry_t;
+
+struct hash_table_image_t
+{
+    uint8_t *        base;
+    size_t           length;
+    uint32_t         bucket_count;
+    const uint64_t * buckets;
+    DESERIALIZE_F    deserialize;
+};
+
 /**
  * @brief Implements a hashing algorithm used to insert and lookup data
  *
@@ -29,10 +82,149 @@ static int hash(uint32_t size, void * p_data, uint32_t * p_index);
  */
 static node_t * new_node(char * p_key, void * p_data);
 
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return uint64_t The current time in milliseconds
+ */
+static uint64_t monotonic_ms(void);
+
+/**
+ * @brief Checks whether a node's time to live has elapsed.
+ *
+ * @param p_node The node to check
+ * @param now The current monotonic time in milliseconds
+ * @return bool true if the node has expired
+ */
+static bool node_expired(const node_t * p_node, uint64_t now);
+
+/**
+ * @brief Creates a node and links it into the table, evicting an entry first
+ * if the table is in expiry mode and full.
+ *
+ * @param table The table to add to
+ * @param data The data to store
+ * @param key The key to store the data at
+ * @param ttl_ms Time to live in milliseconds, 0 for none
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+static int add_node(hash_table_t * table,
+                    void *         data,
+                    char *         key,
+                    uint64_t       ttl_ms);
+
+/**
+ * @brief Unlinks a node from its slot and the order list, then frees it. The
+ * table lock must be held.
+ *
+ * @param table The table holding the node
+ * @param p_prev The node before 'p_node' in its slot, or NULL if it is first
+ * @param p_node The node to remove
+ */
+static void unlink_node(hash_table_t * table,
+                        node_t *       p_prev,
+                        node_t *       p_node);
+
+/**
+ * @brief Records an access to a node for the table's eviction policy.
+ *
+ * @param table The table holding the node
+ * @param p_node The node that was accessed
+ * @param now The current monotonic time in milliseconds
+ */
+static void touch_node(hash_table_t * table, node_t * p_node, uint64_t now);
+
+/**
+ * @brief Removes one entry chosen by the table's eviction policy.
+ *
+ * @param table The table to evict from, must be locked and non-empty
+ */
+static void evict_node(hash_table_t * table);
+
+/**
+ * @brief Picks a random entry by drawing a slot, then a position in its
+ * chain, so entries behind the head of a chain can be picked too.
+ *
+ * @param table The table to sample, must be locked
+ * @return node_t * The entry, or NULL if the drawn slot is empty
+ */
+static node_t * sample_node(hash_table_t * table);
+
+/**
+ * @brief Advances the table's xorshift64 sampler.
+ *
+ * @param table The table whose sampler to advance, must be locked
+ * @return uint64_t The next pseudo-random value
+ */
+static uint64_t next_random(hash_table_t * table);
+
+/**
+ * @brief Removes expired entries from the next 'max_slots' slots, starting at
+ * the table's sweep cursor.
+ *
+ * @param table The table to sweep, must be locked
+ * @param max_slots The number of slots to visit
+ * @param now The current monotonic time in milliseconds
+ * @return size_t The number of entries removed
+ */
+static size_t sweep_slots(hash_table_t * table,
+                          uint32_t       max_slots,
+                          uint64_t       now);
+
+/**
+ * @brief Writes every entry of a table to a snapshot stream, filling in the
+ * bucket offsets as it goes.
+ *
+ * @param table The table to write, must be locked by the caller
+ * @param p_file The stream, positioned just past the bucket offsets
+ * @param serialize_fn The function used to flatten entry data
+ * @param p_buckets Array of 'table->size' offsets to fill in
+ * @param p_header The header whose counters are updated
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+static int write_snapshot_entries(hash_table_t *      table,
+                                  FILE *              p_file,
+                                  SERIALIZE_F         serialize_fn,
+                                  uint64_t *          p_buckets,
+                                  snapshot_header_t * p_header);
+
+/**
+ * @brief Returns the entry at an offset of a mapped image, checking that it
+ * lies inside the entry area, that its key is terminated and that its 'next'
+ * link points strictly forward inside the image.
+ *
+ * @param image The mapped image
+ * @param offset Offset of the entry
+ * @return const snapshot_entry_t* The entry, or NULL if it is corrupt
+ */
+static const snapshot_entry_t * image_entry_at(hash_table_image_t * image,
+                                               uint64_t             offset);
+
+/**
+ * @brief Walks every chain of a mapped image once, so a corrupt image is
+ * rejected at load time rather than on some later lookup.
+ *
+ * @param image The mapped image
+ * @param entry_count Number of entries the header claims
+ * @return int E_SUCCESS if every entry is valid, E_FAILURE otherwise
+ */
+static int validate_image(hash_table_image_t * image, uint64_t entry_count);
+
+/**
+ * @brief Finds an entry in a mapped image, validating every offset against
+ * the bounds of the mapping.
+ *
+ * @param image The mapped image
+ * @param key The key to search for
+ * @return const snapshot_entry_t* The entry, or NULL if it is not present
+ */
+static const snapshot_entry_t * find_image_entry(hash_table_image_t * image,
+                                                 char *               key);
+
 hash_table_t * hash_table_init(uint32_t size, FREE_F customfree)
 {
     hash_table_t * p_hash_table = NULL;
-    int            mutex_check  = -1;
+    int            check        = E_FAILURE;
 
     if (0 == size)
     {
@@ -47,37 +239,120 @@ hash_table_t * hash_table_init(uint32_t size, FREE_F customfree)
         goto END;
     }
 
-    p_hash_table->table = calloc(size, sizeof(node_t *));
-    if (NULL == p_hash_table->table)
+    check = hash_table_setup(p_hash_table, size, customfree);
+    if (E_SUCCESS != check)
+    {
+        free(p_hash_table);
+        p_hash_table = NULL;
+        goto END;
+    }
+
+END:
+    return p_hash_table;
+}
+
+int hash_table_setup(hash_table_t * table, uint32_t size, FREE_F customfree)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == table)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 == size)
+    {
+        print_error("Invalid hash table size of 0");
+        goto END;
+    }
+
+    *table = (hash_table_t) { 0 };
+
+    table->table = calloc(size, sizeof(node_t *));
+    if (NULL == table->table)
     {
         print_error("CMR failure.");
         goto END;
     }
 
-    mutex_check = pthread_mutex_init(&p_hash_table->lock, NULL);
-    if (E_SUCCESS != mutex_check)
+    exit_code = pthread_mutex_init(&table->lock, NULL);
+    if (E_SUCCESS != exit_code)
     {
         print_error("Unable to initialize mutex.");
-        free(p_hash_table->table);
-        p_hash_table->table = NULL;
-        free(p_hash_table);
-        p_hash_table = NULL;
+        free(table->table);
+        table->table = NULL;
+        exit_code    = E_FAILURE;
         goto END;
     }
 
-    p_hash_table->size       = size;
-    p_hash_table->customfree = (NULL == customfree) ? free : customfree;
+    table->size       = size;
+    table->customfree = (NULL == customfree) ? free : customfree;
 
 END:
-    return p_hash_table;
+    return exit_code;
+}
+
+int hash_table_index(hash_table_t * table, const char * key, uint32_t * index)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == table) || (NULL == key) || (NULL == index))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = hash(table->size, (void *)key, index);
+
+END:
+    return exit_code;
+}
+
+int hash_table_set_expiry(hash_table_t * table,
+                          uint32_t       max_entries,
+                          uint64_t       default_ttl_ms,
+                          evict_policy_t policy)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == table)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((EVICT_LRU != policy) && (EVICT_CLOCK != policy) &&
+        (EVICT_SAMPLED_LRU != policy))
+    {
+        print_error("hash_table_set_expiry(): Invalid eviction policy.");
+        goto END;
+    }
+
+    pthread_mutex_lock(&table->lock);
+    if (0 != table->count)
+    {
+        pthread_mutex_unlock(&table->lock);
+        print_error("hash_table_set_expiry(): Table must be empty.");
+        goto END;
+    }
+
+    table->expiring     = true;
+    table->max_entries  = max_entries;
+    table->default_ttl  = default_ttl_ms;
+    table->policy       = policy;
+    table->sweep_cursor = 0;
+    table->rng_state    = monotonic_ms() | 1;
+    pthread_mutex_unlock(&table->lock);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
 }
 
 int hash_table_add(hash_table_t * table, void * data, char * key)
 {
-    int      exit_code      = E_FAILURE;
-    uint32_t index          = 0;
-    node_t * p_current_node = NULL;
-    node_t * p_new_node     = NULL;
+    int exit_code = E_FAILURE;
 
     if ((NULL == table) || (NULL == data) || (NULL == key))
     {
@@ -85,36 +360,61 @@ int hash_table_add(hash_table_t * table, void * data, char * key)
         goto END;
     }
 
-    exit_code = hash(table->size, key, &index);
-    if (E_SUCCESS != exit_code)
+    exit_code = add_node(table, data, key, table->default_ttl);
+
+END:
+    return exit_code;
+}
+
+int hash_table_add_ttl(hash_table_t * table,
+                       void *         data,
+                       char *         key,
+                       uint64_t       ttl_ms)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == table) || (NULL == data) || (NULL == key))
     {
-        print_error("Hashing failure.");
+        print_error("NULL argument passed.");
         goto END;
     }
 
-    p_new_node = new_node(key, data);
-    if (NULL == p_new_node)
+    if (false == table->expiring)
     {
+        print_error("hash_table_add_ttl(): Expiry mode is not enabled.");
         goto END;
     }
 
-    pthread_mutex_lock(&table->lock);
-    p_current_node = table->table[index];
-    if (NULL == p_current_node)
+    exit_code = add_node(table, data, key, ttl_ms);
+
+END:
+    return exit_code;
+}
+
+int hash_table_sweep(hash_table_t * table,
+                     uint32_t       max_slots,
+                     size_t *       expired_count)
+{
+    int    exit_code = E_FAILURE;
+    size_t expired   = 0;
+
+    if (NULL == table)
     {
-        table->table[index] = p_new_node;
+        print_error("NULL argument passed.");
+        goto END;
     }
-    else
+
+    if (true == table->expiring)
     {
-        // Handle collisions
-        while (NULL != p_current_node->next)
-        {
-            p_current_node = p_current_node->next;
-        }
+        pthread_mutex_lock(&table->lock);
+        expired = sweep_slots(table, max_slots, monotonic_ms());
+        pthread_mutex_unlock(&table->lock);
+    }
 
-        p_current_node->next = p_new_node;
+    if (NULL != expired_count)
+    {
+        *expired_count = expired;
     }
-    pthread_mutex_unlock(&table->lock);
 
     exit_code = E_SUCCESS;
 END:
@@ -128,6 +428,8 @@ void * hash_table_lookup(hash_table_t * table, char * key)
     uint32_t index          = 0;
     int      check          = 0;
     node_t * p_current_node = NULL;
+    node_t * p_prev_node    = NULL;
+    uint64_t now            = 0;
 
     if ((NULL == table) || (NULL == key))
     {
@@ -142,19 +444,50 @@ void * hash_table_lookup(hash_table_t * table, char * key)
         goto END;
     }
 
-    p_current_node = table->table[index];
+    if (false == table->expiring)
+    {
+        p_current_node = table->table[index];
+
+        while (NULL != p_current_node)
+        {
+            check = strncmp(p_current_node->key, key, MAX_LENGTH);
+            if (0 == check)
+            {
+                p_data = p_current_node->data;
+                goto END;
+            }
+
+            p_current_node = p_current_node->next;
+        }
+
+        goto END;
+    }
 
+    // Lookups update recency state in expiry mode, so they must be locked
+    now = monotonic_ms();
+    pthread_mutex_lock(&table->lock);
+    p_current_node = table->table[index];
     while (NULL != p_current_node)
     {
         check = strncmp(p_current_node->key, key, MAX_LENGTH);
         if (0 == check)
         {
-            p_data = p_current_node->data;
-            goto END;
+            if (true == node_expired(p_current_node, now))
+            {
+                unlink_node(table, p_prev_node, p_current_node);
+            }
+            else
+            {
+                touch_node(table, p_current_node, now);
+                p_data = p_current_node->data;
+            }
+            break;
         }
 
+        p_prev_node    = p_current_node;
         p_current_node = p_current_node->next;
     }
+    pthread_mutex_unlock(&table->lock);
 
 END:
     return p_data;
@@ -170,6 +503,7 @@ int hash_table_find(hash_table_t * table,
     size_t   count     = 0;
     node_t * current   = NULL;
     char *   str_res   = NULL;
+    uint64_t now       = 0;
 
     if ((NULL == table) || (NULL == search) || (NULL == result_count) ||
         (NULL == results))
@@ -178,16 +512,24 @@ int hash_table_find(hash_table_t * table,
         goto END;
     }
 
-    buffer = calloc(table->size, sizeof(char *));
+    now = monotonic_ms();
 
     pthread_mutex_lock(&table->lock);
+    buffer = calloc(table->count + 1, sizeof(char *));
+    if (NULL == buffer)
+    {
+        pthread_mutex_unlock(&table->lock);
+        print_error("CMR failure.");
+        goto END;
+    }
+
     for (uint32_t idx = 0; idx < table->size; ++idx)
     {
         current = table->table[idx];
         while (NULL != current)
         {
             str_res = strstr(current->key, search);
-            if (NULL != str_res)
+            if ((NULL != str_res) && (false == node_expired(current, now)))
             {
                 // Duplicate and store the key
                 buffer[count++] = strndup(current->key, MAX_KEY_SIZE);
@@ -213,6 +555,7 @@ int hash_table_list(hash_table_t * table,
     char **  buffer    = NULL;
     size_t   count     = 0;
     node_t * current   = NULL;
+    uint64_t now       = 0;
 
     if ((NULL == table) || (NULL == result_count) || (NULL == results))
     {
@@ -220,17 +563,28 @@ int hash_table_list(hash_table_t * table,
         goto END;
     }
 
-    buffer = calloc(table->size, sizeof(char *));
+    now = monotonic_ms();
 
     pthread_mutex_lock(&table->lock);
+    buffer = calloc(table->count + 1, sizeof(char *));
+    if (NULL == buffer)
+    {
+        pthread_mutex_unlock(&table->lock);
+        print_error("CMR failure.");
+        goto END;
+    }
+
     for (uint32_t idx = 0; idx < table->size; ++idx)
     {
         current = table->table[idx];
         while (NULL != current)
         {
-            // Duplicate and store the key
-            buffer[count++] = strndup(current->key, MAX_KEY_SIZE);
-            current         = current->next;
+            if (false == node_expired(current, now))
+            {
+                // Duplicate and store the key
+                buffer[count++] = strndup(current->key, MAX_KEY_SIZE);
+            }
+            current = current->next;
         }
     }
     pthread_mutex_unlock(&table->lock);
@@ -276,20 +630,7 @@ int hash_table_remove(hash_table_t * table, char * key)
         }
         else
         {
-            if (NULL == p_prev_node)
-            {
-                table->table[index] = p_current_node->next;
-            }
-            else
-            {
-                p_prev_node->next = p_current_node->next;
-            }
-
-            table->customfree(p_current_node->data);
-            p_current_node->data = NULL;
-            free(p_current_node->key);
-            p_current_node->key = NULL;
-            free(p_current_node);
+            unlink_node(table, p_prev_node, p_current_node);
             p_current_node = NULL;
             exit_code      = E_SUCCESS;
         }
@@ -329,6 +670,11 @@ int hash_table_clear(hash_table_t * table)
         }
         table->table[idx] = NULL;
     }
+
+    table->count      = 0;
+    table->oldest     = NULL;
+    table->newest     = NULL;
+    table->clock_hand = NULL;
     pthread_mutex_unlock(&table->lock);
 
     exit_code = E_SUCCESS;
@@ -336,59 +682,358 @@ END:
     return exit_code;
 }
 
-int hash_table_destroy(hash_table_t ** table_addr)
+int hash_table_teardown(hash_table_t * table)
 {
     int exit_code = E_FAILURE;
 
-    if (NULL == *table_addr)
+    if (NULL == table)
     {
         print_error("NULL argument passed.");
         goto END;
     }
 
-    exit_code = hash_table_clear(*table_addr);
+    exit_code = hash_table_clear(table);
     if (E_SUCCESS != exit_code)
     {
         print_error("Unable to clear hash table.");
         goto END;
     }
 
-    pthread_mutex_destroy(&(*table_addr)->lock);
-    free((*table_addr)->table);
-    (*table_addr)->table = NULL;
-    free(*table_addr);
-    *table_addr = NULL;
-
-    exit_code = E_SUCCESS;
+    pthread_mutex_destroy(&table->lock);
+    free(table->table);
+    table->table = NULL;
 
 END:
     return exit_code;
 }
 
-/***********************************************************************
- * NOTE: STATIC FUNCTIONS LISTED BELOW
- ***********************************************************************/
-
-static int hash(uint32_t size, void * p_data, uint32_t * index)
+int hash_table_destroy(hash_table_t ** table_addr)
 {
-    int          exit_code = E_FAILURE;
-    uint32_t     target    = 0;
-    uchar_t *    letter    = NULL;
-    const char * string    = NULL;
+    int exit_code = E_FAILURE;
 
-    if ((NULL == p_data) || (NULL == index))
+    if (NULL == *table_addr)
     {
         print_error("NULL argument passed.");
         goto END;
     }
 
-    string = (const char *)p_data; // Interpret the key as a string
-    letter = (uchar_t *)string;    // Point to the first character
-
-    while ('\0' != *letter)
+    exit_code = hash_table_teardown(*table_addr);
+    if (E_SUCCESS != exit_code)
     {
-        target = (((target * BASE) + *letter) % PRIME);
-        letter++;
+        goto END;
+    }
+
+    free(*table_addr);
+    *table_addr = NULL;
+
+    exit_code = E_SUCCESS;
+
+END:
+    return exit_code;
+}
+
+int hash_table_save(hash_table_t * table,
+                    const char *   path,
+                    SERIALIZE_F    serialize_fn)
+{
+    int               exit_code = E_FAILURE;
+    int               check     = E_FAILURE;
+    char *            p_tmp     = NULL;
+    FILE *            p_file    = NULL;
+    uint64_t *        p_buckets = NULL;
+    size_t            path_len  = 0;
+    snapshot_header_t header    = { 0 };
+
+    if ((NULL == table) || (NULL == path) || (NULL == serialize_fn))
+    {
+        print_error("hash_table_save(): NULL argument passed.");
+        goto END;
+    }
+
+    path_len = strlen(path);
+    p_tmp    = calloc(path_len + sizeof(SNAPSHOT_SUFFIX), sizeof(char));
+    if (NULL == p_tmp)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+    memcpy(p_tmp, path, path_len);
+    memcpy(p_tmp + path_len, SNAPSHOT_SUFFIX, sizeof(SNAPSHOT_SUFFIX));
+
+    p_buckets = calloc(table->size, sizeof(uint64_t));
+    if (NULL == p_buckets)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    p_file = fopen(p_tmp, "wb");
+    if (NULL == p_file)
+    {
+        print_strerror("hash_table_save(): fopen() failed.");
+        goto END;
+    }
+
+    header.magic        = SNAPSHOT_MAGIC;
+    header.version      = SNAPSHOT_VERSION;
+    header.bucket_count = table->size;
+
+    // Reserve room for the header and bucket offsets, written last
+    if ((1 != fwrite(&header, sizeof(header), 1, p_file)) ||
+        (table->size !=
+         fwrite(p_buckets, sizeof(uint64_t), table->size, p_file)))
+    {
+        print_error("hash_table_save(): Unable to write header.");
+        goto END;
+    }
+
+    pthread_mutex_lock(&table->lock);
+    check = write_snapshot_entries(
+        table, p_file, serialize_fn, p_buckets, &header);
+    pthread_mutex_unlock(&table->lock);
+    if (E_SUCCESS != check)
+    {
+        goto END;
+    }
+
+    if ((0 != fseek(p_file, 0, SEEK_SET)) ||
+        (1 != fwrite(&header, sizeof(header), 1, p_file)) ||
+        (table->size !=
+         fwrite(p_buckets, sizeof(uint64_t), table->size, p_file)))
+    {
+        print_error("hash_table_save(): Unable to finalize header.");
+        goto END;
+    }
+
+    if ((0 != fflush(p_file)) || (0 != fsync(fileno(p_file))))
+    {
+        print_strerror("hash_table_save(): Unable to flush snapshot.");
+        goto END;
+    }
+
+    check  = fclose(p_file);
+    p_file = NULL;
+    if (0 != check)
+    {
+        print_strerror("hash_table_save(): fclose() failed.");
+        goto END;
+    }
+
+    // Atomically replace any previous snapshot
+    if (0 != rename(p_tmp, path))
+    {
+        print_strerror("hash_table_save(): rename() failed.");
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    if (NULL != p_file)
+    {
+        fclose(p_file);
+    }
+    if ((E_SUCCESS != exit_code) && (NULL != p_tmp))
+    {
+        unlink(p_tmp);
+    }
+    free(p_buckets);
+    free(p_tmp);
+    return exit_code;
+}
+
+hash_table_image_t * hash_table_load_mmap(const char *  path,
+                                          DESERIALIZE_F deserialize_fn)
+{
+    hash_table_image_t *      p_image  = NULL;
+    const snapshot_header_t * p_header = NULL;
+    void *                    p_map    = MAP_FAILED;
+    int                       fd       = -1;
+    struct stat               info     = { 0 };
+    size_t                    min_size = 0;
+
+    if (NULL == path)
+    {
+        print_error("hash_table_load_mmap(): NULL argument passed.");
+        goto END;
+    }
+
+    errno = 0;
+    fd    = open(path, O_RDONLY | O_CLOEXEC);
+    if (-1 == fd)
+    {
+        print_strerror("hash_table_load_mmap(): open() failed.");
+        goto END;
+    }
+
+    if ((0 != fstat(fd, &info)) ||
+        ((size_t)info.st_size < sizeof(snapshot_header_t)))
+    {
+        print_error("hash_table_load_mmap(): Invalid snapshot size.");
+        goto END;
+    }
+
+    p_map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == p_map)
+    {
+        print_strerror("hash_table_load_mmap(): mmap() failed.");
+        goto END;
+    }
+
+    p_header = (const snapshot_header_t *)p_map;
+    min_size = sizeof(snapshot_header_t) +
+               ((size_t)p_header->bucket_count * sizeof(uint64_t));
+    if ((SNAPSHOT_MAGIC != p_header->magic) ||
+        (SNAPSHOT_VERSION != p_header->version) ||
+        (0 == p_header->bucket_count) ||
+        ((uint64_t)info.st_size != p_header->file_size) ||
+        ((size_t)info.st_size < min_size))
+    {
+        print_error("hash_table_load_mmap(): Invalid snapshot header.");
+        goto END;
+    }
+
+    p_image = calloc(1, sizeof(hash_table_image_t));
+    if (NULL == p_image)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    p_image->base         = p_map;
+    p_image->length       = (size_t)info.st_size;
+    p_image->bucket_count = p_header->bucket_count;
+    p_image->buckets      = (const uint64_t *)(p_header + 1);
+    p_image->deserialize  = deserialize_fn;
+
+    if (E_SUCCESS != validate_image(p_image, p_header->entry_count))
+    {
+        print_error("hash_table_load_mmap(): Corrupt snapshot entries.");
+        free(p_image);
+        p_image = NULL;
+        goto END;
+    }
+
+    // Lookups jump between unrelated buckets, so read-ahead only wastes I/O
+    madvise(p_map, (size_t)info.st_size, MADV_RANDOM);
+
+END:
+    if ((NULL == p_image) && (MAP_FAILED != p_map))
+    {
+        munmap(p_map, (size_t)info.st_size);
+    }
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+    return p_image;
+}
+
+const void * hash_table_image_peek(hash_table_image_t * image,
+                                   char *               key,
+                                   size_t *             length_p)
+{
+    const void *             p_data  = NULL;
+    const snapshot_entry_t * p_entry = NULL;
+
+    if ((NULL == image) || (NULL == key))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    p_entry = find_image_entry(image, key);
+    if (NULL == p_entry)
+    {
+        goto END;
+    }
+
+    p_data = (const uint8_t *)(p_entry + 1) + p_entry->key_length + 1;
+    if (NULL != length_p)
+    {
+        *length_p = p_entry->data_length;
+    }
+
+END:
+    return p_data;
+}
+
+void * hash_table_image_lookup(hash_table_image_t * image, char * key)
+{
+    void *       p_data = NULL;
+    const void * p_view = NULL;
+    size_t       length = 0;
+
+    if ((NULL == image) || (NULL == key))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (NULL == image->deserialize)
+    {
+        print_error("hash_table_image_lookup(): No deserialize function.");
+        goto END;
+    }
+
+    p_view = hash_table_image_peek(image, key, &length);
+    if (NULL == p_view)
+    {
+        goto END;
+    }
+
+    p_data = image->deserialize(p_view, length);
+
+END:
+    return p_data;
+}
+
+int hash_table_image_close(hash_table_image_t ** image_addr)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == image_addr) || (NULL == *image_addr))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = munmap((*image_addr)->base, (*image_addr)->length);
+    if (E_SUCCESS != exit_code)
+    {
+        print_strerror("hash_table_image_close(): munmap() failed.");
+    }
+
+    free(*image_addr);
+    *image_addr = NULL;
+
+END:
+    return exit_code;
+}
+
+/***********************************************************************
+ * NOTE: STATIC FUNCTIONS LISTED BELOW
+ ***********************************************************************/
+
+static int hash(uint32_t size, void * p_data, uint32_t * index)
+{
+    int          exit_code = E_FAILURE;
+    uint32_t     target    = 0;
+    uchar_t *    letter    = NULL;
+    const char * string    = NULL;
+
+    if ((NULL == p_data) || (NULL == index))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    string = (const char *)p_data; // Interpret the key as a string
+    letter = (uchar_t *)string;    // Point to the first character
+
+    while ('\0' != *letter)
+    {
+        target = (((target * BASE) + *letter) % PRIME);
+        letter++;
     }
 
     *index = (target % size);
@@ -433,3 +1078,528 @@ static node_t * new_node(char * key, void * data)
 END:
     return new_node;
 }
+
+static uint64_t monotonic_ms(void)
+{
+    struct timespec now = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * MS_PER_SEC) +
+           ((uint64_t)now.tv_nsec / NS_PER_MS);
+}
+
+static bool node_expired(const node_t * p_node, uint64_t now)
+{
+    return (0 != p_node->expires_at) && (now >= p_node->expires_at);
+}
+
+static int add_node(hash_table_t * table,
+                    void *         data,
+                    char *         key,
+                    uint64_t       ttl_ms)
+{
+    int      exit_code      = E_FAILURE;
+    uint32_t index          = 0;
+    uint64_t now            = 0;
+    node_t * p_current_node = NULL;
+    node_t * p_new_node     = NULL;
+
+    exit_code = hash(table->size, key, &index);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("Hashing failure.");
+        goto END;
+    }
+
+    p_new_node = new_node(key, data);
+    if (NULL == p_new_node)
+    {
+        exit_code = E_FAILURE;
+        goto END;
+    }
+
+    p_new_node->index = index;
+
+    pthread_mutex_lock(&table->lock);
+    if (true == table->expiring)
+    {
+        now                     = monotonic_ms();
+        p_new_node->last_access = now;
+        p_new_node->expires_at  = (0 == ttl_ms) ? 0 : now + ttl_ms;
+
+        // Amortize expiry across writers instead of stopping the world
+        sweep_slots(table, SWEEP_SLOTS_PER_ADD, now);
+
+        if ((0 != table->max_entries) && (table->count >= table->max_entries))
+        {
+            evict_node(table);
+        }
+
+        // Newest entries sit just behind the CLOCK hand
+        p_new_node->older = table->newest;
+        if (NULL != table->newest)
+        {
+            table->newest->newer = p_new_node;
+        }
+        else
+        {
+            table->oldest = p_new_node;
+        }
+        table->newest = p_new_node;
+    }
+
+    p_current_node = table->table[index];
+    if (NULL == p_current_node)
+    {
+        table->table[index] = p_new_node;
+    }
+    else
+    {
+        // Handle collisions
+        while (NULL != p_current_node->next)
+        {
+            p_current_node = p_current_node->next;
+        }
+
+        p_current_node->next = p_new_node;
+    }
+    table->count++;
+    pthread_mutex_unlock(&table->lock);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static void unlink_node(hash_table_t * table,
+                        node_t *       p_prev,
+                        node_t *       p_node)
+{
+    if (NULL == p_prev)
+    {
+        table->table[p_node->index] = p_node->next;
+    }
+    else
+    {
+        p_prev->next = p_node->next;
+    }
+
+    if (true == table->expiring)
+    {
+        if (table->clock_hand == p_node)
+        {
+            table->clock_hand = p_node->newer;
+        }
+
+        if (NULL != p_node->older)
+        {
+            p_node->older->newer = p_node->newer;
+        }
+        else
+        {
+            table->oldest = p_node->newer;
+        }
+
+        if (NULL != p_node->newer)
+        {
+            p_node->newer->older = p_node->older;
+        }
+        else
+        {
+            table->newest = p_node->older;
+        }
+    }
+
+    table->count--;
+
+    table->customfree(p_node->data);
+    p_node->data = NULL;
+    free(p_node->key);
+    p_node->key = NULL;
+    free(p_node);
+}
+
+static void touch_node(hash_table_t * table, node_t * p_node, uint64_t now)
+{
+    p_node->last_access = now;
+    p_node->referenced  = true;
+
+    if ((EVICT_LRU != table->policy) || (table->newest == p_node))
+    {
+        goto END;
+    }
+
+    // Move the node to the recent end of the order list
+    if (NULL != p_node->older)
+    {
+        p_node->older->newer = p_node->newer;
+    }
+    else
+    {
+        table->oldest = p_node->newer;
+    }
+    p_node->newer->older = p_node->older;
+
+    p_node->older        = table->newest;
+    p_node->newer        = NULL;
+    table->newest->newer = p_node;
+    table->newest        = p_node;
+
+END:
+    return;
+}
+
+static void evict_node(hash_table_t * table)
+{
+    node_t * p_victim    = NULL;
+    node_t * p_candidate = NULL;
+    node_t * p_prev      = NULL;
+    uint32_t samples     = 0;
+
+    switch (table->policy)
+    {
+        case EVICT_CLOCK:
+            // Give referenced entries a second chance, bounded to two laps
+            for (uint32_t idx = 0; idx < (2 * table->count); idx++)
+            {
+                if (NULL == table->clock_hand)
+                {
+                    table->clock_hand = table->oldest;
+                }
+
+                p_candidate = table->clock_hand;
+                if (false == p_candidate->referenced)
+                {
+                    p_victim = p_candidate;
+                    break;
+                }
+
+                p_candidate->referenced = false;
+                table->clock_hand       = p_candidate->newer;
+            }
+            break;
+
+        case EVICT_SAMPLED_LRU:
+            // Empty slots are drawn again, so they do not use up samples
+            for (uint32_t idx = 0;
+                 (idx < EVICTION_PROBES) && (samples < EVICTION_SAMPLES);
+                 idx++)
+            {
+                p_candidate = sample_node(table);
+                if (NULL == p_candidate)
+                {
+                    continue;
+                }
+
+                samples++;
+                if ((NULL == p_victim) ||
+                    (p_candidate->last_access < p_victim->last_access))
+                {
+                    p_victim = p_candidate;
+                }
+            }
+            break;
+
+        case EVICT_LRU:
+        default:
+            break;
+    }
+
+    if (NULL == p_victim)
+    {
+        p_victim = table->oldest;
+    }
+
+    if (NULL == p_victim)
+    {
+        goto END;
+    }
+
+    // Find the predecessor in the victim's slot so it can be unlinked
+    p_candidate = table->table[p_victim->index];
+    while (p_candidate != p_victim)
+    {
+        p_prev      = p_candidate;
+        p_candidate = p_candidate->next;
+    }
+
+    unlink_node(table, p_prev, p_victim);
+
+END:
+    return;
+}
+
+static node_t * sample_node(hash_table_t * table)
+{
+    node_t * p_node   = table->table[next_random(table) % table->size];
+    node_t * p_walk   = p_node;
+    uint32_t length   = 0;
+    uint32_t position = 0;
+
+    while (NULL != p_walk)
+    {
+        length++;
+        p_walk = p_walk->next;
+    }
+
+    if (0 == length)
+    {
+        goto END;
+    }
+
+    position = (uint32_t)(next_random(table) % length);
+    while (0 < position)
+    {
+        p_node = p_node->next;
+        position--;
+    }
+
+END:
+    return p_node;
+}
+
+static uint64_t next_random(hash_table_t * table)
+{
+    // xorshift64, good enough to pick samples
+    table->rng_state ^= table->rng_state << 13;
+    table->rng_state ^= table->rng_state >> 7;
+    table->rng_state ^= table->rng_state << 17;
+
+    return table->rng_state;
+}
+
+static size_t sweep_slots(hash_table_t * table,
+                          uint32_t       max_slots,
+                          uint64_t       now)
+{
+    size_t   expired        = 0;
+    uint32_t index          = 0;
+    node_t * p_current_node = NULL;
+    node_t * p_prev_node    = NULL;
+    node_t * p_next_node    = NULL;
+
+    if (max_slots > table->size)
+    {
+        max_slots = table->size;
+    }
+
+    for (uint32_t idx = 0; idx < max_slots; idx++)
+    {
+        index               = table->sweep_cursor;
+        table->sweep_cursor = (index + 1) % table->size;
+
+        p_prev_node    = NULL;
+        p_current_node = table->table[index];
+        while (NULL != p_current_node)
+        {
+            p_next_node = p_current_node->next;
+            if (true == node_expired(p_current_node, now))
+            {
+                unlink_node(table, p_prev_node, p_current_node);
+                expired++;
+            }
+            else
+            {
+                p_prev_node = p_current_node;
+            }
+            p_current_node = p_next_node;
+        }
+    }
+
+    return expired;
+}
+
+static int write_snapshot_entries(hash_table_t *      table,
+                                  FILE *              p_file,
+                                  SERIALIZE_F         serialize_fn,
+                                  uint64_t *          p_buckets,
+                                  snapshot_header_t * p_header)
+{
+    static const uint8_t zeroes[SNAPSHOT_ALIGN] = { 0 };
+
+    int              exit_code  = E_FAILURE;
+    int              check      = E_FAILURE;
+    uint64_t         offset     = 0;
+    size_t           padding    = 0;
+    size_t           entry_size = 0;
+    void *           p_buffer   = NULL;
+    size_t           length     = 0;
+    node_t *         p_current  = NULL;
+    snapshot_entry_t entry      = { 0 };
+
+    offset = sizeof(snapshot_header_t) + (table->size * sizeof(uint64_t));
+
+    for (uint32_t idx = 0; idx < table->size; idx++)
+    {
+        p_current = table->table[idx];
+        if (NULL != p_current)
+        {
+            p_buckets[idx] = offset;
+        }
+
+        while (NULL != p_current)
+        {
+            p_buffer = NULL;
+            length   = 0;
+            check    = serialize_fn(p_current->data, &p_buffer, &length);
+            if ((E_SUCCESS != check) || (UINT32_MAX < length) ||
+                ((NULL == p_buffer) && (0 != length)))
+            {
+                print_error("hash_table_save(): Unable to serialize data.");
+                free(p_buffer);
+                goto END;
+            }
+
+            entry.key_length  = (uint32_t)strnlen(p_current->key, MAX_KEY_SIZE);
+            entry.data_length = (uint32_t)length;
+            entry_size = sizeof(entry) + entry.key_length + 1 + length;
+            padding    = (SNAPSHOT_ALIGN - (entry_size % SNAPSHOT_ALIGN)) %
+                      SNAPSHOT_ALIGN;
+
+            // Chained entries are written back to back
+            entry.next = (NULL == p_current->next)
+                             ? 0
+                             : offset + entry_size + padding;
+
+            if ((1 != fwrite(&entry, sizeof(entry), 1, p_file)) ||
+                (entry.key_length !=
+                 fwrite(p_current->key, 1, entry.key_length, p_file)) ||
+                (1 != fwrite(zeroes, 1, 1, p_file)) ||
+                (length != fwrite(p_buffer, 1, length, p_file)) ||
+                (padding != fwrite(zeroes, 1, padding, p_file)))
+            {
+                print_error("hash_table_save(): Unable to write entry.");
+                free(p_buffer);
+                goto END;
+            }
+
+            free(p_buffer);
+            offset += entry_size + padding;
+            p_header->entry_count++;
+            p_current = p_current->next;
+        }
+    }
+
+    p_header->file_size = offset;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static const snapshot_entry_t * image_entry_at(hash_table_image_t * image,
+                                               uint64_t             offset)
+{
+    const snapshot_entry_t * p_entry = NULL;
+    const char *             p_key   = NULL;
+    uint64_t                 first   = 0;
+    uint64_t                 end     = 0;
+
+    first = sizeof(snapshot_header_t) +
+            ((uint64_t)image->bucket_count * sizeof(uint64_t));
+    if ((0 != (offset % SNAPSHOT_ALIGN)) || (offset < first) ||
+        (offset > image->length - sizeof(snapshot_entry_t)))
+    {
+        print_error("image_entry_at(): Corrupt entry offset.");
+        goto END;
+    }
+
+    p_entry = (const snapshot_entry_t *)(image->base + offset);
+    end     = offset + sizeof(snapshot_entry_t) + p_entry->key_length + 1 +
+          p_entry->data_length;
+    p_key   = (const char *)(p_entry + 1);
+    if ((end > image->length) || ('\0' != p_key[p_entry->key_length]))
+    {
+        print_error("image_entry_at(): Corrupt entry length.");
+        p_entry = NULL;
+        goto END;
+    }
+
+    // Links only ever point forward, so following them always terminates
+    if ((0 != p_entry->next) &&
+        ((p_entry->next <= offset) || (p_entry->next >= image->length)))
+    {
+        print_error("image_entry_at(): Corrupt entry link.");
+        p_entry = NULL;
+        goto END;
+    }
+
+END:
+    return p_entry;
+}
+
+static int validate_image(hash_table_image_t * image, uint64_t entry_count)
+{
+    int                      exit_code = E_FAILURE;
+    const snapshot_entry_t * p_entry   = NULL;
+    uint64_t                 offset    = 0;
+    uint64_t                 seen      = 0;
+
+    for (uint32_t idx = 0; idx < image->bucket_count; idx++)
+    {
+        offset = image->buckets[idx];
+        while (0 != offset)
+        {
+            p_entry = image_entry_at(image, offset);
+            if (NULL == p_entry)
+            {
+                goto END;
+            }
+
+            seen++;
+            offset = p_entry->next;
+        }
+    }
+
+    // Chains that merge into one another would count entries twice
+    if (seen != entry_count)
+    {
+        print_error("validate_image(): Entry count mismatch.");
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static const snapshot_entry_t * find_image_entry(hash_table_image_t * image,
+                                                 char *               key)
+{
+    const snapshot_entry_t * p_entry = NULL;
+    const char *             p_key   = NULL;
+    uint64_t                 offset  = 0;
+    uint32_t                 index   = 0;
+    int                      check   = E_FAILURE;
+
+    check = hash(image->bucket_count, key, &index);
+    if (E_SUCCESS != check)
+    {
+        print_error("Hashing failure.");
+        goto END;
+    }
+
+    offset = image->buckets[index];
+    while (0 != offset)
+    {
+        p_entry = image_entry_at(image, offset);
+        if (NULL == p_entry)
+        {
+            break;
+        }
+
+        p_key = (const char *)(p_entry + 1);
+        check = strncmp(p_key, key, MAX_LENGTH);
+        if (0 == check)
+        {
+            goto END;
+        }
+
+        offset = p_entry->next;
+    }
+
+    p_entry = NULL;
+END:
+    return p_entry;
+}
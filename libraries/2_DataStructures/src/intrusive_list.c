@@ -0,0 +1,358 @@
+#include "intrusive_list.h"
+#include "utilities.h"
+
+/**
+ * @brief Links 'link' between two adjacent links.
+ *
+ * @param list Pointer to the list.
+ * @param prev Pointer to the link that will precede 'link'.
+ * @param next Pointer to the link that will follow 'link'.
+ * @param link Pointer to the unlinked link.
+ */
+static inline void link_between(intrusive_list_t * list,
+                                intrusive_link_t * prev,
+                                intrusive_link_t * next,
+                                intrusive_link_t * link);
+
+/**
+ * @brief Unlinks 'link' from its neighbours and marks it unlinked.
+ *
+ * @param list Pointer to the list.
+ * @param link Pointer to a link on 'list'.
+ */
+static inline void unlink_link(intrusive_list_t * list,
+                               intrusive_link_t * link);
+
+void intrusive_list_init(intrusive_list_t * list)
+{
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    list->sentinel.prev = &list->sentinel;
+    list->sentinel.next = &list->sentinel;
+    list->size          = 0;
+}
+
+void intrusive_link_init(intrusive_link_t * link)
+{
+    if (NULL == link)
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    link->prev = NULL;
+    link->next = NULL;
+}
+
+bool intrusive_link_is_linked(intrusive_link_t * link)
+{
+    return (NULL != link) && (NULL != link->next);
+}
+
+bool intrusive_list_is_empty(intrusive_list_t * list)
+{
+    return (NULL == list) || (0 == list->size);
+}
+
+int intrusive_list_push_head(intrusive_list_t * list, intrusive_link_t * link)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == list) || (NULL == link))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (NULL != link->next)
+    {
+        print_error("Link is already on a list.");
+        goto END;
+    }
+
+    link_between(list, &list->sentinel, list->sentinel.next, link);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int intrusive_list_push_tail(intrusive_list_t * list, intrusive_link_t * link)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == list) || (NULL == link))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (NULL != link->next)
+    {
+        print_error("Link is already on a list.");
+        goto END;
+    }
+
+    link_between(list, list->sentinel.prev, &list->sentinel, link);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int intrusive_list_insert_before(intrusive_list_t * list,
+                                 intrusive_link_t * position,
+                                 intrusive_link_t * link)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == list) || (NULL == position) || (NULL == link))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((NULL == position->next) || (NULL != link->next))
+    {
+        print_error("Invalid link state.");
+        goto END;
+    }
+
+    link_between(list, position->prev, position, link);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int intrusive_list_insert_after(intrusive_list_t * list,
+                                intrusive_link_t * position,
+                                intrusive_link_t * link)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == list) || (NULL == position) || (NULL == link))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((NULL == position->next) || (NULL != link->next))
+    {
+        print_error("Invalid link state.");
+        goto END;
+    }
+
+    link_between(list, position, position->next, link);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int intrusive_list_remove(intrusive_list_t * list, intrusive_link_t * link)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == list) || (NULL == link))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((NULL == link->next) || (link == &list->sentinel))
+    {
+        print_error("Link is not on a list.");
+        goto END;
+    }
+
+    unlink_link(list, link);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+intrusive_link_t * intrusive_list_pop_head(intrusive_list_t * list)
+{
+    intrusive_link_t * link = NULL;
+
+    link = intrusive_list_peek_head(list);
+    if (NULL != link)
+    {
+        unlink_link(list, link);
+    }
+
+    return link;
+}
+
+intrusive_link_t * intrusive_list_pop_tail(intrusive_list_t * list)
+{
+    intrusive_link_t * link = NULL;
+
+    link = intrusive_list_peek_tail(list);
+    if (NULL != link)
+    {
+        unlink_link(list, link);
+    }
+
+    return link;
+}
+
+intrusive_link_t * intrusive_list_peek_head(intrusive_list_t * list)
+{
+    intrusive_link_t * link = NULL;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 != list->size)
+    {
+        link = list->sentinel.next;
+    }
+
+END:
+    return link;
+}
+
+intrusive_link_t * intrusive_list_peek_tail(intrusive_list_t * list)
+{
+    intrusive_link_t * link = NULL;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 != list->size)
+    {
+        link = list->sentinel.prev;
+    }
+
+END:
+    return link;
+}
+
+intrusive_link_t * intrusive_list_next(intrusive_list_t * list,
+                                       intrusive_link_t * link)
+{
+    intrusive_link_t * next = NULL;
+
+    if ((NULL == list) || (NULL == link) || (NULL == link->next))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    if (link->next != &list->sentinel)
+    {
+        next = link->next;
+    }
+
+END:
+    return next;
+}
+
+intrusive_link_t * intrusive_list_prev(intrusive_list_t * list,
+                                       intrusive_link_t * link)
+{
+    intrusive_link_t * prev = NULL;
+
+    if ((NULL == list) || (NULL == link) || (NULL == link->prev))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    if (link->prev != &list->sentinel)
+    {
+        prev = link->prev;
+    }
+
+END:
+    return prev;
+}
+
+int intrusive_list_splice_tail(intrusive_list_t * dest,
+                               intrusive_list_t * source)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == dest) || (NULL == source))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((dest != source) && (0 != source->size))
+    {
+        source->sentinel.next->prev = dest->sentinel.prev;
+        source->sentinel.prev->next = &dest->sentinel;
+        dest->sentinel.prev->next   = source->sentinel.next;
+        dest->sentinel.prev         = source->sentinel.prev;
+        dest->size += source->size;
+
+        intrusive_list_init(source);
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int intrusive_list_foreach_call(intrusive_list_t * list,
+                                LINK_ACT_F         action_function)
+{
+    int                exit_code = E_FAILURE;
+    intrusive_link_t * link      = NULL;
+    intrusive_link_t * next      = NULL;
+
+    if ((NULL == list) || (NULL == action_function))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    INTRUSIVE_LIST_FOREACH(list, link, next)
+    {
+        action_function(link);
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static inline void link_between(intrusive_list_t * list,
+                                intrusive_link_t * prev,
+                                intrusive_link_t * next,
+                                intrusive_link_t * link)
+{
+    link->prev = prev;
+    link->next = next;
+    prev->next = link;
+    next->prev = link;
+    list->size++;
+}
+
+static inline void unlink_link(intrusive_list_t * list,
+                               intrusive_link_t * link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->prev       = NULL;
+    link->next       = NULL;
+    list->size--;
+}
+
+/*** end of file ***/
@@ -1,23 +1,47 @@
 #include "linked_list.h"
 #include "comparisons.h"
+#include "sort.h"
 #include "utilities.h"
 
+#define LIST_SORT_MAX_RUNS 33 // One run per bit of list_t.size, plus a carry
+
 /**
- * @brief Create a new `list_node_t`
+ * @brief Create a new `list_node_t`, from the list's node pool if it has one
  *
+ * @param list The list the node will belong to
  * @param data The data to store in the node
  * @return list_node_t*
  */
-static list_node_t * list_node_new(void * data);
+static list_node_t * list_node_new(list_t * list, void * data);
+
+/**
+ * @brief Release the storage of a node, back to the list's node pool if it
+ * has one. The node's data is not touched.
+ *
+ * @param list The list the node belonged to
+ * @param node The node to release
+ */
+static void list_node_free(list_t * list, list_node_t * node);
+
+/**
+ * @brief Returns the node at a position, using the position index when the
+ * list has one and otherwise walking from whichever end is nearer.
+ *
+ * @param list Pointer to the linked list.
+ * @param position Position of the node, less than list->size.
+ * @return Pointer to the node at 'position'.
+ */
+static list_node_t * node_at(list_t * list, uint32_t position);
 
 /**
  * @brief Finds a node in the linked list that matches the given data.
  *
  * @param list Pointer to the linked list.
  * @param data Pointer to the data to be matched.
+ * @param position Receives the position of the node if found.
  * @return Pointer to the node containing the data if found, NULL otherwise.
  */
-static list_node_t * find_node(list_t * list, void * data);
+static list_node_t * find_node(list_t * list, void * data, uint32_t * position);
 
 /**
  * @brief Removes a given node from the linked list.
@@ -27,39 +51,31 @@ static list_node_t * find_node(list_t * list, void * data);
  *
  * @param list Pointer to the linked list.
  * @param node Pointer to the node to be removed.
+ * @param position Position of the node in the list.
  */
-static void remove_node(list_t * list, list_node_t * node);
-
-/**
- * @brief Splits a list into two equal halves
- *
- * @param head Pointer to the head of the list to be split.
- * @param first_half Pointer to store the head of the first half.
- * @param second_half Pointer to store the head of the second half.
- */
-static void split(list_node_t *  head,
-                  list_node_t ** first_half,
-                  list_node_t ** second_half);
+static void remove_node(list_t * list, list_node_t * node, uint32_t position);
 
 /**
- * @brief Merges two sorted linked lists into a single sorted linked list.
+ * @brief Merges two sorted, NULL terminated runs into a single sorted run.
+ * Nodes from 'first' are taken first on ties, so the merge is stable. Only
+ * the 'next' links are maintained.
  *
- * @param first Pointer to the head of the first sorted list.
- * @param second Pointer to the head of the second sorted list.
+ * @param first Pointer to the head of the earlier sorted run.
+ * @param second Pointer to the head of the later sorted run.
  * @param compare_func Pointer to the comparison function used to sort the list.
- * @return Pointer to the head of the merged sorted list.
+ * @return Pointer to the head of the merged sorted run.
  */
 static list_node_t * merge(list_node_t * first,
                            list_node_t * second,
                            CMP_F         compare_func);
 
 /**
- * @brief Internal recursive function to implement merge sort on linked list.
+ * @brief Sorts the list with an iterative bottom-up merge sort, then rebuilds
+ * the 'prev' links and the tail in a final pass. Uses constant stack space.
  *
- * @param head_ref Pointer to the head of the list to be sorted.
- * @param compare_func Pointer to the comparison function used to sort the list.
+ * @param list Pointer to the list to be sorted.
  */
-static void merge_sort(list_node_t ** head_ref, CMP_F compare_func);
+static void merge_sort(list_t * list);
 
 list_t * list_new(FREE_F free_func, CMP_F comp_func)
 {
@@ -72,11 +88,36 @@ list_t * list_new(FREE_F free_func, CMP_F comp_func)
         goto END;
     }
 
-    new_list->size         = 0;
-    new_list->head         = NULL;
-    new_list->tail         = NULL;
-    new_list->custom_free  = (NULL == free_func) ? free : free_func;
-    new_list->compare_func = (NULL == comp_func) ? int_comp : comp_func;
+    new_list->size           = 0;
+    new_list->head           = NULL;
+    new_list->tail           = NULL;
+    new_list->custom_free    = (NULL == free_func) ? free : free_func;
+    new_list->compare_func   = (NULL == comp_func) ? int_comp : comp_func;
+    new_list->node_pool      = NULL;
+    new_list->position_index = NULL;
+
+END:
+    return new_list;
+}
+
+list_t * list_new_pooled(FREE_F free_func, CMP_F comp_func, size_t slab_nodes)
+{
+    list_t * new_list = NULL;
+
+    new_list = list_new(free_func, comp_func);
+    if (NULL == new_list)
+    {
+        goto END;
+    }
+
+    new_list->node_pool = slab_pool_new(sizeof(list_node_t), slab_nodes);
+    if (NULL == new_list->node_pool)
+    {
+        print_error("Unable to create node pool.");
+        free(new_list);
+        new_list = NULL;
+        goto END;
+    }
 
 END:
     return new_list;
@@ -93,13 +134,21 @@ int list_push_head(list_t * list, void * data)
         goto END;
     }
 
-    new_node = list_node_new(data);
+    new_node = list_node_new(list, data);
     if (NULL == new_node)
     {
         print_error("Unable to create new node.");
         goto END;
     }
 
+    if ((NULL != list->position_index) &&
+        (E_SUCCESS != position_index_insert(list->position_index, 0, new_node)))
+    {
+        print_error("Unable to index new node.");
+        list_node_free(list, new_node);
+        goto END;
+    }
+
     if (NULL == list->head)
     {
         // Establish 'new_node' as the first node of an empty list
@@ -136,13 +185,22 @@ int list_push_tail(list_t * list, void * data)
         goto END;
     }
 
-    new_node = list_node_new(data);
+    new_node = list_node_new(list, data);
     if (NULL == new_node)
     {
         print_error("Unable to create new node.");
         goto END;
     }
 
+    if ((NULL != list->position_index) &&
+        (E_SUCCESS !=
+         position_index_insert(list->position_index, list->size, new_node)))
+    {
+        print_error("Unable to index new node.");
+        list_node_free(list, new_node);
+        goto END;
+    }
+
     if (NULL == list->head)
     {
         // Establish 'new_node' as the first node of an empty list
@@ -191,31 +249,36 @@ int list_push_position(list_t * list, void * data, uint32_t position)
         exit_code = list_push_head(list, data);
         goto END;
     }
-    if (position == list->size - 1)
+    if (position == list->size)
     {
         exit_code = list_push_tail(list, data);
         goto END;
     }
 
-    new_node = list_node_new(data);
+    new_node = list_node_new(list, data);
     if (NULL == new_node)
     {
         print_error("Unable to create new node.");
         goto END;
     }
 
-    // Navigate to the specified position
-    current_node = list->head;
-    for (uint32_t idx = 0; idx < position - 1; idx++)
+    // Find the node currently at 'position', which 'new_node' goes before
+    current_node = node_at(list, position);
+
+    if ((NULL != list->position_index) &&
+        (E_SUCCESS !=
+         position_index_insert(list->position_index, position, new_node)))
     {
-        current_node = current_node->next;
+        print_error("Unable to index new node.");
+        list_node_free(list, new_node);
+        goto END;
     }
 
     // Insert the new node at the specified position
-    new_node->next           = current_node->next;
-    new_node->prev           = current_node;
-    current_node->next->prev = new_node;
-    current_node->next       = new_node;
+    new_node->next           = current_node;
+    new_node->prev           = current_node->prev;
+    current_node->prev->next = new_node;
+    current_node->prev       = new_node;
 
     list->size += 1;
 
@@ -255,6 +318,11 @@ list_node_t * list_pop_head(list_t * list)
 
     head_node = list->head;
 
+    if (NULL != list->position_index)
+    {
+        position_index_remove(list->position_index, 0);
+    }
+
     if (list->head == list->tail)
     {
         list->head = NULL;
@@ -284,6 +352,11 @@ list_node_t * list_pop_tail(list_t * list)
 
     tail_node = list->tail;
 
+    if (NULL != list->position_index)
+    {
+        position_index_remove(list->position_index, list->size - 1);
+    }
+
     if (list->head == list->tail)
     {
         list->head = NULL;
@@ -330,10 +403,11 @@ list_node_t * list_pop_position(list_t * list, uint32_t position)
         goto END;
     }
 
-    current = list->head;
-    for (uint32_t idx = 0; idx < position; idx++)
+    current = node_at(list, position);
+
+    if (NULL != list->position_index)
     {
-        current = current->next;
+        position_index_remove(list->position_index, position);
     }
 
     node_to_pop         = current;
@@ -364,9 +438,13 @@ int list_remove_head(list_t * list)
     }
 
     node_to_remove = list_pop_head(list);
+    if (NULL == node_to_remove)
+    {
+        goto END;
+    }
+
     list->custom_free(node_to_remove->data);
-    node_to_remove->data = NULL;
-    free(node_to_remove);
+    list_node_free(list, node_to_remove);
     node_to_remove = NULL;
 
     exit_code = E_SUCCESS;
@@ -386,9 +464,13 @@ int list_remove_tail(list_t * list)
     }
 
     node_to_remove = list_pop_tail(list);
+    if (NULL == node_to_remove)
+    {
+        goto END;
+    }
+
     list->custom_free(node_to_remove->data);
-    node_to_remove->data = NULL;
-    free(node_to_remove);
+    list_node_free(list, node_to_remove);
     node_to_remove = NULL;
 
     exit_code = E_SUCCESS;
@@ -415,8 +497,7 @@ int list_remove_position(list_t * list, uint32_t position)
 
     node_to_remove = list_pop_position(list, position);
     list->custom_free(node_to_remove->data);
-    node_to_remove->data = NULL;
-    free(node_to_remove);
+    list_node_free(list, node_to_remove);
     node_to_remove = NULL;
 
     exit_code = E_SUCCESS;
@@ -472,11 +553,7 @@ list_node_t * list_peek_position(list_t * list, uint32_t position)
         goto END;
     }
 
-    current_node = list->head;
-    for (uint32_t idx = 0; idx < position; idx++)
-    {
-        current_node = current_node->next;
-    }
+    current_node = node_at(list, position);
 
 END:
     return current_node;
@@ -486,6 +563,7 @@ int list_remove_data(list_t * list, void ** item_to_remove)
 {
     int           exit_code      = E_FAILURE;
     list_node_t * node_to_remove = NULL;
+    uint32_t      position       = 0;
 
     if (NULL == list || NULL == item_to_remove || NULL == *item_to_remove)
     {
@@ -493,10 +571,10 @@ int list_remove_data(list_t * list, void ** item_to_remove)
         goto END;
     }
 
-    node_to_remove = find_node(list, *item_to_remove);
+    node_to_remove = find_node(list, *item_to_remove, &position);
     if (NULL != node_to_remove)
     {
-        remove_node(list, node_to_remove);
+        remove_node(list, node_to_remove, position);
     }
 
     exit_code = E_SUCCESS;
@@ -607,13 +685,64 @@ int list_sort(list_t * list)
 
     if (NULL != list)
     {
-        merge_sort(&(list->head), list->compare_func);
+        merge_sort(list);
         exit_code = E_SUCCESS;
     }
 
     return exit_code;
 }
 
+int list_sort_array(list_t * list)
+{
+    int           exit_code = E_FAILURE;
+    void **       items     = NULL;
+    list_node_t * node      = NULL;
+    size_t        idx       = 0;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (2 > list->size)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    items = malloc(list->size * sizeof(void *));
+    if (NULL == items)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        items[idx++] = node->data;
+    }
+
+    exit_code = sort_introsort(
+        items, list->size, sizeof(void *), list->compare_func, true);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("Unable to sort list.");
+        goto END;
+    }
+
+    // The nodes stay where they are and take the data in sorted order
+    idx = 0;
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        node->data = items[idx++];
+    }
+
+END:
+    free(items);
+    return exit_code;
+}
+
 int list_clear(list_t * list)
 {
     int           exit_code    = E_FAILURE;
@@ -638,12 +767,15 @@ int list_clear(list_t * list)
         next_node = current_node->next;
 
         list->custom_free(current_node->data);
-        current_node->data = NULL;
-        free(current_node);
-        current_node = NULL;
+        list_node_free(list, current_node);
         current_node = next_node;
     }
 
+    if (NULL != list->position_index)
+    {
+        position_index_clear(list->position_index);
+    }
+
     list->head = NULL;
     list->tail = NULL;
     list->size = 0;
@@ -663,11 +795,24 @@ int list_delete(list_t ** list_address)
         goto END;
     }
 
-    exit_code = list_clear(*list_address);
-    if (E_SUCCESS != exit_code)
+    if (0 != (*list_address)->size)
     {
-        print_error("Unable to clear list.");
-        goto END;
+        exit_code = list_clear(*list_address);
+        if (E_SUCCESS != exit_code)
+        {
+            print_error("Unable to clear list.");
+            goto END;
+        }
+    }
+
+    if (NULL != (*list_address)->node_pool)
+    {
+        slab_pool_destroy(&(*list_address)->node_pool);
+    }
+
+    if (NULL != (*list_address)->position_index)
+    {
+        position_index_destroy(&(*list_address)->position_index);
     }
 
     free(*list_address);
@@ -678,6 +823,68 @@ END:
     return exit_code;
 }
 
+int list_enable_position_index(list_t * list)
+{
+    int           exit_code = E_FAILURE;
+    list_node_t * node      = NULL;
+    uint32_t      position  = 0;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (NULL != list->position_index)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    list->position_index = position_index_new();
+    if (NULL == list->position_index)
+    {
+        print_error("Unable to create position index.");
+        goto END;
+    }
+
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        if (E_SUCCESS !=
+            position_index_insert(list->position_index, position++, node))
+        {
+            print_error("Unable to index list.");
+            position_index_destroy(&list->position_index);
+            goto END;
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void list_disable_position_index(list_t * list)
+{
+    if ((NULL == list) || (NULL == list->position_index))
+    {
+        return;
+    }
+
+    position_index_destroy(&list->position_index);
+}
+
+void list_node_release(list_t * list, list_node_t * node)
+{
+    if ((NULL == list) || (NULL == node))
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    list_node_free(list, node);
+}
+
 void custom_free(void * mem_addr)
 {
     free(mem_addr);
@@ -688,7 +895,7 @@ void custom_free(void * mem_addr)
  * NOTE: STATIC FUNCTIONS LISTED BELOW
  ***********************************************************************/
 
-static list_node_t * list_node_new(void * data)
+static list_node_t * list_node_new(list_t * list, void * data)
 {
     list_node_t * new_node = NULL;
 
@@ -698,7 +905,14 @@ static list_node_t * list_node_new(void * data)
         goto END;
     }
 
-    new_node = calloc(1, sizeof(list_node_t));
+    if (NULL != list->node_pool)
+    {
+        new_node = slab_pool_alloc(list->node_pool);
+    }
+    else
+    {
+        new_node = calloc(1, sizeof(list_node_t));
+    }
     if (NULL == new_node)
     {
         print_error("CMR failure.");
@@ -713,7 +927,47 @@ END:
     return new_node;
 }
 
-static list_node_t * find_node(list_t * list, void * data)
+static void list_node_free(list_t * list, list_node_t * node)
+{
+    if (NULL != list->node_pool)
+    {
+        slab_pool_free(list->node_pool, node);
+    }
+    else
+    {
+        free(node);
+    }
+}
+
+static list_node_t * node_at(list_t * list, uint32_t position)
+{
+    list_node_t * current_node = NULL;
+
+    if (NULL != list->position_index)
+    {
+        current_node = position_index_get(list->position_index, position);
+    }
+    else if (position < (list->size / 2))
+    {
+        current_node = list->head;
+        for (uint32_t idx = 0; idx < position; idx++)
+        {
+            current_node = current_node->next;
+        }
+    }
+    else
+    {
+        current_node = list->tail;
+        for (uint32_t idx = list->size - 1; idx > position; idx--)
+        {
+            current_node = current_node->prev;
+        }
+    }
+
+    return current_node;
+}
+
+static list_node_t * find_node(list_t * list, void * data, uint32_t * position)
 {
     list_node_t * current_node = NULL;
 
@@ -723,6 +977,7 @@ static list_node_t * find_node(list_t * list, void * data)
         goto END;
     }
 
+    *position    = 0;
     current_node = list->head;
     while (NULL != current_node)
     {
@@ -732,13 +987,14 @@ static list_node_t * find_node(list_t * list, void * data)
             goto END;
         }
         current_node = current_node->next;
+        (*position)++;
     }
 
 END:
     return current_node;
 }
 
-static void remove_node(list_t * list, list_node_t * node)
+static void remove_node(list_t * list, list_node_t * node, uint32_t position)
 {
     if ((NULL == list) || (NULL == node))
     {
@@ -746,6 +1002,11 @@ static void remove_node(list_t * list, list_node_t * node)
         goto END;
     }
 
+    if (NULL != list->position_index)
+    {
+        position_index_remove(list->position_index, position);
+    }
+
     if (NULL != node->prev)
     {
         node->prev->next = node->next;
@@ -765,8 +1026,7 @@ static void remove_node(list_t * list, list_node_t * node)
     }
 
     list->custom_free(node->data);
-    node->data = NULL;
-    free(node);
+    list_node_free(list, node);
     node = NULL;
 
     list->size--;
@@ -775,86 +1035,94 @@ END:
     return;
 }
 
-static void split(list_node_t *  head,
-                  list_node_t ** first_half,
-                  list_node_t ** second_half)
+static list_node_t * merge(list_node_t * first,
+                           list_node_t * second,
+                           CMP_F         compare_func)
 {
-    list_node_t * slow = head;
-    list_node_t * fast = head->next;
+    list_node_t   merged = { 0 };
+    list_node_t * last   = &merged;
 
-    // Split the list into two halves by advancing 'fast' two nodes, and 'slow'
-    // one node
-    while (NULL != fast)
+    while ((NULL != first) && (NULL != second))
     {
-        fast = fast->next;
-        if (NULL != fast)
+        // Take from 'second' only when it is strictly less, keeping ties in
+        // their original order
+        if (LESS_THAN == compare_func(second->data, first->data))
+        {
+            last->next = second;
+            second     = second->next;
+        }
+        else
         {
-            slow = slow->next;
-            fast = fast->next;
+            last->next = first;
+            first      = first->next;
         }
+
+        last = last->next;
     }
 
-    *first_half  = head;
-    *second_half = slow->next;
-    slow->next   = NULL;
+    last->next = (NULL != first) ? first : second;
+
+    return merged.next;
 }
 
-static list_node_t * merge(list_node_t * first,
-                           list_node_t * second,
-                           CMP_F         compare_func)
+static void merge_sort(list_t * list)
 {
-    list_node_t * result = NULL;
+    // runs[idx] holds a sorted run of 2^idx nodes, or NULL. Adding a node
+    // carries up through the occupied slots like a binary counter, so the
+    // runs always cover the list in order from the highest slot down
+    list_node_t * runs[LIST_SORT_MAX_RUNS] = { NULL };
+    list_node_t * carry                    = NULL;
+    list_node_t * next                     = NULL;
+    list_node_t * prev                     = NULL;
+    size_t        idx                      = 0;
 
-    if (NULL == first)
+    if (2 > list->size)
     {
-        result = second;
-        goto END;
+        return;
     }
 
-    if (NULL == second)
+    for (list_node_t * node = list->head; NULL != node; node = next)
     {
-        result = first;
-        goto END;
+        next       = node->next;
+        node->next = NULL;
+        carry      = node;
+
+        for (idx = 0; NULL != runs[idx]; idx++)
+        {
+            carry     = merge(runs[idx], carry, list->compare_func);
+            runs[idx] = NULL;
+        }
+
+        runs[idx] = carry;
     }
 
-    // 'first' is less than 'second'
-    if (LESS_THAN == compare_func(first->data, second->data))
+    // Lower slots hold later nodes, so they are merged in as 'second'
+    carry = NULL;
+    for (idx = 0; idx < LIST_SORT_MAX_RUNS; idx++)
     {
-        result             = first;
-        result->next       = merge(first->next, second, compare_func);
-        result->next->prev = result;
-        result->prev       = NULL;
+        if (NULL != runs[idx])
+        {
+            carry = merge(runs[idx], carry, list->compare_func);
+        }
     }
-    // 'first' is greater than or equal to 'second'
-    else
+
+    list->head = carry;
+    for (list_node_t * node = carry; NULL != node; node = node->next)
     {
-        result             = second;
-        result->next       = merge(first, second->next, compare_func);
-        result->next->prev = result;
-        result->prev       = NULL;
+        node->prev = prev;
+        prev       = node;
     }
+    list->tail = prev;
 
-END:
-    return result;
-}
-
-static void merge_sort(list_node_t ** head_ref, CMP_F compare_func)
-{
-    list_node_t * head = *head_ref;
-    list_node_t * first_half;
-    list_node_t * second_half;
-
-    if ((NULL == head) || (NULL == head->next))
+    // Every position changed, so the index is rebuilt from scratch
+    if (NULL != list->position_index)
     {
-        return;
+        list_disable_position_index(list);
+        if (E_SUCCESS != list_enable_position_index(list))
+        {
+            print_error("Position index dropped after sort.");
+        }
     }
-
-    split(head, &first_half, &second_half);
-
-    merge_sort(&first_half, compare_func);
-    merge_sort(&second_half, compare_func);
-
-    *head_ref = merge(first_half, second_half, compare_func);
 }
 
 /*** end of file ***/
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include "position_index.h"
+#include "slab_pool.h"
+#include "utilities.h"
+
+/**
+ * @brief A treap node. Nodes are ordered by position, which is implicit in
+ * the subtree sizes, and heap ordered by a random priority that keeps the
+ * tree balanced with high probability.
+ */
+typedef struct index_node
+{
+    struct index_node * left;
+    struct index_node * right;
+    void *              item;
+    uint32_t            priority;
+    uint32_t            count; // Nodes in the subtree rooted here
+} index_node_t;
+
+struct position_index
+{
+    index_node_t * root;
+    slab_pool_t *  node_pool;
+    uint32_t       seed; // xorshift32 state for node priorities
+};
+
+/**
+ * @brief Returns the number of nodes in a subtree, 0 for NULL.
+ *
+ * @param node Pointer to the subtree root.
+ * @return uint32_t Subtree size.
+ */
+static inline uint32_t node_count(index_node_t * node);
+
+/**
+ * @brief Splits a subtree so its first 'position' nodes end up in 'left'
+ * and the rest in 'right'.
+ *
+ * @param node Pointer to the subtree root, may be NULL.
+ * @param position Number of nodes to place in 'left'.
+ * @param left Receives the root of the first part.
+ * @param right Receives the root of the second part.
+ */
+static void split(index_node_t *  node,
+                  uint32_t        position,
+                  index_node_t ** left,
+                  index_node_t ** right);
+
+/**
+ * @brief Joins two subtrees, every node of 'left' coming before every node
+ * of 'right'.
+ *
+ * @param left Pointer to the first subtree, may be NULL.
+ * @param right Pointer to the second subtree, may be NULL.
+ * @return index_node_t* Root of the joined tree.
+ */
+static index_node_t * join(index_node_t * left, index_node_t * right);
+
+/**
+ * @brief Returns every node of a subtree to the pool.
+ *
+ * @param index Pointer to the index.
+ * @param node Pointer to the subtree root, may be NULL.
+ */
+static void release_subtree(position_index_t * index, index_node_t * node);
+
+position_index_t * position_index_new(void)
+{
+    position_index_t * index = NULL;
+
+    index = calloc(1, sizeof(position_index_t));
+    if (NULL == index)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    index->node_pool = slab_pool_new(sizeof(index_node_t), 0);
+    if (NULL == index->node_pool)
+    {
+        print_error("Unable to create node pool.");
+        free(index);
+        index = NULL;
+        goto END;
+    }
+
+    index->root = NULL;
+    index->seed = 0x9E3779B9u;
+
+END:
+    return index;
+}
+
+int position_index_insert(position_index_t * index,
+                          uint32_t           position,
+                          void *             item)
+{
+    int            exit_code = E_FAILURE;
+    index_node_t * node      = NULL;
+    index_node_t * left      = NULL;
+    index_node_t * right     = NULL;
+
+    if ((NULL == index) || (NULL == item))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((position > node_count(index->root)) ||
+        (UINT32_MAX == node_count(index->root)))
+    {
+        print_error("Position out of bounds.");
+        goto END;
+    }
+
+    node = slab_pool_alloc(index->node_pool);
+    if (NULL == node)
+    {
+        print_error("Unable to create index node.");
+        goto END;
+    }
+
+    index->seed ^= index->seed << 13;
+    index->seed ^= index->seed >> 17;
+    index->seed ^= index->seed << 5;
+
+    node->item     = item;
+    node->priority = index->seed;
+    node->count    = 1;
+
+    split(index->root, position, &left, &right);
+    index->root = join(join(left, node), right);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void * position_index_remove(position_index_t * index, uint32_t position)
+{
+    void *         item   = NULL;
+    index_node_t * left   = NULL;
+    index_node_t * middle = NULL;
+    index_node_t * right  = NULL;
+
+    if (NULL == index)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (position >= node_count(index->root))
+    {
+        print_error("Position out of bounds.");
+        goto END;
+    }
+
+    split(index->root, position, &left, &right);
+    split(right, 1, &middle, &right);
+    index->root = join(left, right);
+
+    item = middle->item;
+    slab_pool_free(index->node_pool, middle);
+
+END:
+    return item;
+}
+
+void * position_index_get(position_index_t * index, uint32_t position)
+{
+    void *         item = NULL;
+    index_node_t * node = NULL;
+
+    if (NULL == index)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (position >= node_count(index->root))
+    {
+        print_error("Position out of bounds.");
+        goto END;
+    }
+
+    node = index->root;
+    while (position != node_count(node->left))
+    {
+        if (position < node_count(node->left))
+        {
+            node = node->left;
+        }
+        else
+        {
+            position -= node_count(node->left) + 1;
+            node = node->right;
+        }
+    }
+
+    item = node->item;
+
+END:
+    return item;
+}
+
+uint32_t position_index_size(position_index_t * index)
+{
+    uint32_t size = 0;
+
+    if (NULL == index)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    size = node_count(index->root);
+
+END:
+    return size;
+}
+
+void position_index_clear(position_index_t * index)
+{
+    if (NULL == index)
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    release_subtree(index, index->root);
+    index->root = NULL;
+}
+
+void position_index_destroy(position_index_t ** index_addr)
+{
+    if ((NULL == index_addr) || (NULL == *index_addr))
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    // The pool owns every node, so the tree need not be walked
+    slab_pool_destroy(&(*index_addr)->node_pool);
+    free(*index_addr);
+    *index_addr = NULL;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static inline uint32_t node_count(index_node_t * node)
+{
+    return (NULL == node) ? 0 : node->count;
+}
+
+static void split(index_node_t *  node,
+                  uint32_t        position,
+                  index_node_t ** left,
+                  index_node_t ** right)
+{
+    if (NULL == node)
+    {
+        *left  = NULL;
+        *right = NULL;
+        return;
+    }
+
+    if (position <= node_count(node->left))
+    {
+        split(node->left, position, left, &node->left);
+        *right = node;
+    }
+    else
+    {
+        split(node->right,
+              position - node_count(node->left) - 1,
+              &node->right,
+              right);
+        *left = node;
+    }
+
+    node->count = node_count(node->left) + node_count(node->right) + 1;
+}
+
+static index_node_t * join(index_node_t * left, index_node_t * right)
+{
+    index_node_t * root = NULL;
+
+    if ((NULL == left) || (NULL == right))
+    {
+        return (NULL == left) ? right : left;
+    }
+
+    if (left->priority > right->priority)
+    {
+        left->right = join(left->right, right);
+        root        = left;
+    }
+    else
+    {
+        right->left = join(left, right->left);
+        root        = right;
+    }
+
+    root->count = node_count(root->left) + node_count(root->right) + 1;
+
+    return root;
+}
+
+static void release_subtree(position_index_t * index, index_node_t * node)
+{
+    if (NULL == node)
+    {
+        return;
+    }
+
+    release_subtree(index, node->left);
+    release_subtree(index, node->right);
+    slab_pool_free(index->node_pool, node);
+}
+
+/*** end of file ***/
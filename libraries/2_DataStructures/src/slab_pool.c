@@ -0,0 +1,204 @@
+#include <string.h> // memset()
+
+#include "slab_pool.h"
+#include "utilities.h"
+
+/**
+ * @brief Header at the start of every slab, linking the pool's slabs.
+ */
+typedef struct slab
+{
+    struct slab * next;
+} slab_t;
+
+/**
+ * @brief A released object, reusing its own storage as the free list link.
+ */
+typedef struct free_object
+{
+    struct free_object * next;
+} free_object_t;
+
+struct slab_pool
+{
+    size_t          object_size; // Bytes requested per object
+    size_t          stride;      // Bytes between objects in a slab
+    size_t          per_slab;    // Objects carved from each slab
+    size_t          in_use;      // Objects handed out and not yet freed
+    slab_t *        slabs;       // Every slab, newest first
+    free_object_t * free_list;   // Released objects, most recent first
+    unsigned char * fresh;       // Next never-used object in the newest slab
+    unsigned char * fresh_end;   // End of the newest slab
+};
+
+/**
+ * @brief Allocates a new slab and makes its objects available.
+ *
+ * Objects in a new slab are handed out in address order straight from the
+ * slab rather than being threaded onto the free list up front.
+ *
+ * @param pool pointer to pool
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+static int slab_pool_grow(slab_pool_t * pool);
+
+slab_pool_t * slab_pool_new(size_t object_size, size_t objects_per_slab)
+{
+    slab_pool_t * pool   = NULL;
+    size_t        stride = 0;
+
+    if (0 == object_size)
+    {
+        print_error("Invalid object size.");
+        goto END;
+    }
+
+    // Every object must be able to hold a free list link, and pointer
+    // alignment is kept by rounding the stride up to a whole pointer
+    stride = (object_size < sizeof(free_object_t)) ? sizeof(free_object_t)
+                                                   : object_size;
+    stride = (stride + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+    if (0 == objects_per_slab)
+    {
+        objects_per_slab = (SLAB_POOL_SLAB_BYTES - sizeof(slab_t)) / stride;
+        if (0 == objects_per_slab)
+        {
+            objects_per_slab = 1;
+        }
+    }
+
+    if (((SIZE_MAX - sizeof(slab_t)) / stride) < objects_per_slab)
+    {
+        print_error("Slab too large.");
+        goto END;
+    }
+
+    pool = calloc(1, sizeof(slab_pool_t));
+    if (NULL == pool)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    pool->object_size = object_size;
+    pool->stride      = stride;
+    pool->per_slab    = objects_per_slab;
+
+END:
+    return pool;
+}
+
+void * slab_pool_alloc(slab_pool_t * pool)
+{
+    void * object = NULL;
+
+    if (NULL == pool)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (NULL != pool->free_list)
+    {
+        object          = pool->free_list;
+        pool->free_list = pool->free_list->next;
+    }
+    else
+    {
+        if ((pool->fresh == pool->fresh_end) &&
+            (E_SUCCESS != slab_pool_grow(pool)))
+        {
+            goto END;
+        }
+
+        object = pool->fresh;
+        pool->fresh += pool->stride;
+    }
+
+    memset(object, 0, pool->object_size);
+    pool->in_use++;
+
+END:
+    return object;
+}
+
+void slab_pool_free(slab_pool_t * pool, void * object)
+{
+    free_object_t * released = object;
+
+    if ((NULL == pool) || (NULL == object))
+    {
+        return;
+    }
+
+    released->next  = pool->free_list;
+    pool->free_list = released;
+    pool->in_use--;
+}
+
+size_t slab_pool_in_use(slab_pool_t * pool)
+{
+    size_t in_use = 0;
+
+    if (NULL == pool)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    in_use = pool->in_use;
+
+END:
+    return in_use;
+}
+
+void slab_pool_destroy(slab_pool_t ** pool_addr)
+{
+    slab_t * slab = NULL;
+    slab_t * next = NULL;
+
+    if ((NULL == pool_addr) || (NULL == *pool_addr))
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    slab = (*pool_addr)->slabs;
+    while (NULL != slab)
+    {
+        next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    free(*pool_addr);
+    *pool_addr = NULL;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static int slab_pool_grow(slab_pool_t * pool)
+{
+    int      exit_code = E_FAILURE;
+    slab_t * slab      = NULL;
+
+    slab = malloc(sizeof(slab_t) + (pool->stride * pool->per_slab));
+    if (NULL == slab)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    slab->next  = pool->slabs;
+    pool->slabs = slab;
+
+    pool->fresh     = (unsigned char *)(slab + 1);
+    pool->fresh_end = pool->fresh + (pool->stride * pool->per_slab);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/*** end of file ***/
@@ -0,0 +1,973 @@
+#include <string.h> // memcpy()
+
+#include "sort.h"
+#include "utilities.h"
+
+#define INSERTION_THRESHOLD     24  // Ranges below this use insertion sort
+#define NINTHER_THRESHOLD       128 // Ranges above this use a pseudomedian of 9
+#define PARTIAL_INSERTION_LIMIT 8   // Moves allowed before giving up on a run
+#define RADIX_BUCKETS           256 // One bucket per byte value
+#define SWAP_CHUNK              64  // Bytes swapped per step for large elements
+
+/**
+ * @brief State shared by the introsort helpers.
+ */
+typedef struct sort_ctx
+{
+    unsigned char * base;         // First element of the array
+    size_t          elem_size;    // Size of one element in bytes
+    CMP_F           compare_func; // User comparison function
+    bool            indirect;     // Elements are pointers to the data
+    unsigned char * scratch;      // One element of scratch space
+} sort_ctx_t;
+
+/**
+ * @brief A key and the data it was computed from, sorted together.
+ */
+typedef struct keyed_record
+{
+    uint64_t key;
+    void *   data;
+} keyed_record_t;
+
+/**
+ * @brief Returns true if element 'lhs' orders strictly before 'rhs'.
+ *
+ * @param ctx Sort state.
+ * @param lhs Pointer to the first element.
+ * @param rhs Pointer to the second element.
+ * @return true if compare_func reports LESS_THAN.
+ */
+static bool sort_less(sort_ctx_t *          ctx,
+                      const unsigned char * lhs,
+                      const unsigned char * rhs);
+
+/**
+ * @brief Returns a pointer to the element at 'index'.
+ *
+ * @param ctx Sort state.
+ * @param index Index of the element.
+ * @return Pointer to the element.
+ */
+static unsigned char * sort_elem(sort_ctx_t * ctx, size_t index);
+
+/**
+ * @brief Swaps the elements at two indexes.
+ *
+ * @param ctx Sort state.
+ * @param first Index of the first element.
+ * @param second Index of the second element.
+ */
+static void sort_swap(sort_ctx_t * ctx, size_t first, size_t second);
+
+/**
+ * @brief Orders three elements so that a <= b <= c.
+ *
+ * @param ctx Sort state.
+ * @param a Index of the first element.
+ * @param b Index of the second element.
+ * @param c Index of the third element.
+ */
+static void sort_three(sort_ctx_t * ctx, size_t a, size_t b, size_t c);
+
+/**
+ * @brief Insertion sorts [begin, end).
+ *
+ * @param ctx Sort state.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param leftmost false if the element before 'begin' is known to be no
+ * greater than every element in the range, which removes the bounds check.
+ */
+static void sort_insertion(sort_ctx_t * ctx,
+                           size_t       begin,
+                           size_t       end,
+                           bool         leftmost);
+
+/**
+ * @brief Attempts to insertion sort [begin, end), giving up once more than
+ * PARTIAL_INSERTION_LIMIT elements have been moved.
+ *
+ * @param ctx Sort state.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @return true if the range is now sorted.
+ */
+static bool sort_partial_insertion(sort_ctx_t * ctx, size_t begin, size_t end);
+
+/**
+ * @brief Partitions [begin, end) around the element at 'begin', placing
+ * elements equal to the pivot on the right.
+ *
+ * @param ctx Sort state.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param already_partitioned Set to true if no elements had to be swapped.
+ * @return Final index of the pivot.
+ */
+static size_t sort_partition_right(sort_ctx_t * ctx,
+                                   size_t       begin,
+                                   size_t       end,
+                                   bool *       already_partitioned);
+
+/**
+ * @brief Partitions [begin, end) around the element at 'begin', placing
+ * elements equal to the pivot on the left. Used when the pivot equals the
+ * element before the range, so the whole equal run is finished in one pass.
+ *
+ * @param ctx Sort state.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @return Final index of the pivot.
+ */
+static size_t sort_partition_left(sort_ctx_t * ctx, size_t begin, size_t end);
+
+/**
+ * @brief Heap sorts [begin, end), the fallback that bounds the worst case.
+ *
+ * @param ctx Sort state.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ */
+static void sort_heap(sort_ctx_t * ctx, size_t begin, size_t end);
+
+/**
+ * @brief Restores the heap property below 'root' in a heap of 'count'
+ * elements starting at 'begin'.
+ *
+ * @param ctx Sort state.
+ * @param begin First index of the heap.
+ * @param root Heap position to sift down from.
+ * @param count Number of elements in the heap.
+ */
+static void sort_sift_down(sort_ctx_t * ctx,
+                           size_t       begin,
+                           size_t       root,
+                           size_t       count);
+
+/**
+ * @brief Sorts [begin, end), recursing on the left partition and looping on
+ * the right.
+ *
+ * @param ctx Sort state.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param bad_allowed Unbalanced partitions allowed before falling back to
+ * heap sort.
+ * @param leftmost true if the range starts at the beginning of the array.
+ */
+static void sort_pdq_loop(sort_ctx_t * ctx,
+                          size_t       begin,
+                          size_t       end,
+                          int          bad_allowed,
+                          bool         leftmost);
+
+int sort_introsort(void * base,
+                   size_t count,
+                   size_t elem_size,
+                   CMP_F  compare_func,
+                   bool   indirect)
+{
+    int        exit_code   = E_FAILURE;
+    int        bad_allowed = 0;
+    sort_ctx_t ctx         = { 0 };
+
+    // Nothing to sort, so an empty container's buffer may be NULL
+    if (2 > count)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    if ((NULL == base) || (NULL == compare_func))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 == elem_size) || (indirect && (sizeof(void *) != elem_size)))
+    {
+        print_error("Invalid element size.");
+        goto END;
+    }
+
+    ctx.base         = base;
+    ctx.elem_size    = elem_size;
+    ctx.compare_func = compare_func;
+    ctx.indirect     = indirect;
+    ctx.scratch      = malloc(elem_size);
+    if (NULL == ctx.scratch)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    // Allow log2(count) bad partitions before switching to heap sort
+    for (size_t remaining = count; 1 < remaining; remaining >>= 1)
+    {
+        bad_allowed++;
+    }
+
+    sort_pdq_loop(&ctx, 0, count, bad_allowed, true);
+
+    free(ctx.scratch);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int sort_merge(const void * left,
+               size_t       left_count,
+               const void * right,
+               size_t       right_count,
+               void *       dest,
+               size_t       elem_size,
+               CMP_F        compare_func,
+               bool         indirect)
+{
+    int                   exit_code = E_FAILURE;
+    sort_ctx_t            ctx       = { 0 };
+    const unsigned char * left_pos  = left;
+    const unsigned char * left_end  = NULL;
+    const unsigned char * right_pos = right;
+    const unsigned char * right_end = NULL;
+    unsigned char *       output    = dest;
+
+    // Empty runs may come from empty containers, whose buffer may be NULL
+    if (((NULL == left) && (0 != left_count)) ||
+        ((NULL == right) && (0 != right_count)) ||
+        ((NULL == dest) && (0 != (left_count + right_count))) ||
+        (NULL == compare_func))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    ctx.elem_size    = elem_size;
+    ctx.compare_func = compare_func;
+    ctx.indirect     = indirect;
+
+    left_end  = left_pos + (left_count * elem_size);
+    right_end = right_pos + (right_count * elem_size);
+
+    while ((left_pos < left_end) && (right_pos < right_end))
+    {
+        // Take from the right only when strictly smaller to stay stable
+        if (sort_less(&ctx, right_pos, left_pos))
+        {
+            memcpy(output, right_pos, elem_size);
+            right_pos += elem_size;
+        }
+        else
+        {
+            memcpy(output, left_pos, elem_size);
+            left_pos += elem_size;
+        }
+        output += elem_size;
+    }
+
+    if (left_pos < left_end)
+    {
+        memcpy(output, left_pos, (size_t)(left_end - left_pos));
+        output += left_end - left_pos;
+    }
+
+    if (right_pos < right_end)
+    {
+        memcpy(output, right_pos, (size_t)(right_end - right_pos));
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int sort_radix_u32(uint32_t * values, size_t count)
+{
+    int        exit_code = E_FAILURE;
+    uint32_t * buffer    = NULL;
+    uint32_t * source    = values;
+    uint32_t * target    = NULL;
+    uint32_t * swap      = NULL;
+    size_t     counts[sizeof(uint32_t)][RADIX_BUCKETS] = { { 0 } };
+
+    if (2 > count)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    if (NULL == values)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    buffer = malloc(count * sizeof(uint32_t));
+    if (NULL == buffer)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+    target = buffer;
+
+    // Histogram every byte position in a single pass
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        for (size_t byte = 0; byte < sizeof(uint32_t); byte++)
+        {
+            counts[byte][(values[idx] >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    for (size_t byte = 0; byte < sizeof(uint32_t); byte++)
+    {
+        size_t   offset = 0;
+        size_t * bucket = counts[byte];
+
+        // Every value shares this byte, the pass would not move anything
+        if (count == bucket[(source[0] >> (byte * 8)) & 0xFF])
+        {
+            continue;
+        }
+
+        for (size_t digit = 0; digit < RADIX_BUCKETS; digit++)
+        {
+            size_t digit_count = bucket[digit];
+            bucket[digit]      = offset;
+            offset += digit_count;
+        }
+
+        for (size_t idx = 0; idx < count; idx++)
+        {
+            target[bucket[(source[idx] >> (byte * 8)) & 0xFF]++] = source[idx];
+        }
+
+        swap   = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != values)
+    {
+        memcpy(values, source, count * sizeof(uint32_t));
+    }
+
+    free(buffer);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int sort_radix_i32(int32_t * values, size_t count)
+{
+    int        exit_code       = E_FAILURE;
+    uint32_t * unsigned_values = (uint32_t *)values;
+
+    if (2 > count)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    if (NULL == values)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    // Flipping the sign bit maps signed order onto unsigned order
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        unsigned_values[idx] ^= UINT32_C(0x80000000);
+    }
+
+    exit_code = sort_radix_u32(unsigned_values, count);
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        unsigned_values[idx] ^= UINT32_C(0x80000000);
+    }
+
+END:
+    return exit_code;
+}
+
+int sort_radix_u64(uint64_t * values, size_t count)
+{
+    int        exit_code = E_FAILURE;
+    uint64_t * buffer    = NULL;
+    uint64_t * source    = values;
+    uint64_t * target    = NULL;
+    uint64_t * swap      = NULL;
+    size_t     counts[sizeof(uint64_t)][RADIX_BUCKETS] = { { 0 } };
+
+    if (2 > count)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    if (NULL == values)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    buffer = malloc(count * sizeof(uint64_t));
+    if (NULL == buffer)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+    target = buffer;
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        for (size_t byte = 0; byte < sizeof(uint64_t); byte++)
+        {
+            counts[byte][(values[idx] >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    for (size_t byte = 0; byte < sizeof(uint64_t); byte++)
+    {
+        size_t   offset = 0;
+        size_t * bucket = counts[byte];
+
+        if (count == bucket[(source[0] >> (byte * 8)) & 0xFF])
+        {
+            continue;
+        }
+
+        for (size_t digit = 0; digit < RADIX_BUCKETS; digit++)
+        {
+            size_t digit_count = bucket[digit];
+            bucket[digit]      = offset;
+            offset += digit_count;
+        }
+
+        for (size_t idx = 0; idx < count; idx++)
+        {
+            target[bucket[(source[idx] >> (byte * 8)) & 0xFF]++] = source[idx];
+        }
+
+        swap   = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != values)
+    {
+        memcpy(values, source, count * sizeof(uint64_t));
+    }
+
+    free(buffer);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int sort_radix_i64(int64_t * values, size_t count)
+{
+    int        exit_code       = E_FAILURE;
+    uint64_t * unsigned_values = (uint64_t *)values;
+
+    if (2 > count)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    if (NULL == values)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        unsigned_values[idx] ^= UINT64_C(0x8000000000000000);
+    }
+
+    exit_code = sort_radix_u64(unsigned_values, count);
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        unsigned_values[idx] ^= UINT64_C(0x8000000000000000);
+    }
+
+END:
+    return exit_code;
+}
+
+int sort_radix_keyed(void ** elements, size_t count, SORT_KEY_F key_func)
+{
+    int              exit_code = E_FAILURE;
+    keyed_record_t * records   = NULL;
+    keyed_record_t * source    = NULL;
+    keyed_record_t * target    = NULL;
+    keyed_record_t * swap      = NULL;
+    size_t           counts[sizeof(uint64_t)][RADIX_BUCKETS] = { { 0 } };
+
+    if (2 > count)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    if ((NULL == elements) || (NULL == key_func))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    records = malloc(2 * count * sizeof(keyed_record_t));
+    if (NULL == records)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+    source = records;
+    target = records + count;
+
+    // Compute each key once, histogramming as we go
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        source[idx].key  = key_func(elements[idx]);
+        source[idx].data = elements[idx];
+        for (size_t byte = 0; byte < sizeof(uint64_t); byte++)
+        {
+            counts[byte][(source[idx].key >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    for (size_t byte = 0; byte < sizeof(uint64_t); byte++)
+    {
+        size_t   offset = 0;
+        size_t * bucket = counts[byte];
+
+        if (count == bucket[(source[0].key >> (byte * 8)) & 0xFF])
+        {
+            continue;
+        }
+
+        for (size_t digit = 0; digit < RADIX_BUCKETS; digit++)
+        {
+            size_t digit_count = bucket[digit];
+            bucket[digit]      = offset;
+            offset += digit_count;
+        }
+
+        for (size_t idx = 0; idx < count; idx++)
+        {
+            size_t digit = (source[idx].key >> (byte * 8)) & 0xFF;
+            target[bucket[digit]++] = source[idx];
+        }
+
+        swap   = source;
+        source = target;
+        target = swap;
+    }
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        elements[idx] = source[idx].data;
+    }
+
+    free(records);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static bool sort_less(sort_ctx_t *          ctx,
+                      const unsigned char * lhs,
+                      const unsigned char * rhs)
+{
+    void * lhs_data = (void *)lhs;
+    void * rhs_data = (void *)rhs;
+
+    if (ctx->indirect)
+    {
+        memcpy(&lhs_data, lhs, sizeof(void *));
+        memcpy(&rhs_data, rhs, sizeof(void *));
+    }
+
+    return LESS_THAN == ctx->compare_func(lhs_data, rhs_data);
+}
+
+static unsigned char * sort_elem(sort_ctx_t * ctx, size_t index)
+{
+    return ctx->base + (index * ctx->elem_size);
+}
+
+static void sort_swap(sort_ctx_t * ctx, size_t first, size_t second)
+{
+    unsigned char * lhs = sort_elem(ctx, first);
+    unsigned char * rhs = sort_elem(ctx, second);
+    unsigned char   chunk[SWAP_CHUNK];
+    size_t          remaining = ctx->elem_size;
+
+    while (0 < remaining)
+    {
+        size_t step = (SWAP_CHUNK < remaining) ? SWAP_CHUNK : remaining;
+
+        memcpy(chunk, lhs, step);
+        memcpy(lhs, rhs, step);
+        memcpy(rhs, chunk, step);
+
+        lhs += step;
+        rhs += step;
+        remaining -= step;
+    }
+}
+
+static void sort_three(sort_ctx_t * ctx, size_t a, size_t b, size_t c)
+{
+    if (sort_less(ctx, sort_elem(ctx, b), sort_elem(ctx, a)))
+    {
+        sort_swap(ctx, a, b);
+    }
+
+    if (sort_less(ctx, sort_elem(ctx, c), sort_elem(ctx, b)))
+    {
+        sort_swap(ctx, b, c);
+    }
+
+    if (sort_less(ctx, sort_elem(ctx, b), sort_elem(ctx, a)))
+    {
+        sort_swap(ctx, a, b);
+    }
+}
+
+static void sort_insertion(sort_ctx_t * ctx,
+                           size_t       begin,
+                           size_t       end,
+                           bool         leftmost)
+{
+    size_t elem_size = ctx->elem_size;
+
+    for (size_t current = begin + 1; current < end; current++)
+    {
+        size_t sift = current;
+
+        if (!sort_less(
+                ctx, sort_elem(ctx, current), sort_elem(ctx, current - 1)))
+        {
+            continue;
+        }
+
+        memcpy(ctx->scratch, sort_elem(ctx, current), elem_size);
+        do
+        {
+            memcpy(sort_elem(ctx, sift), sort_elem(ctx, sift - 1), elem_size);
+            sift--;
+        } while ((!leftmost || (sift > begin)) &&
+                 sort_less(ctx, ctx->scratch, sort_elem(ctx, sift - 1)));
+        memcpy(sort_elem(ctx, sift), ctx->scratch, elem_size);
+    }
+}
+
+static bool sort_partial_insertion(sort_ctx_t * ctx, size_t begin, size_t end)
+{
+    size_t elem_size = ctx->elem_size;
+    size_t moved     = 0;
+
+    for (size_t current = begin + 1; current < end; current++)
+    {
+        size_t sift = current;
+
+        if (!sort_less(
+                ctx, sort_elem(ctx, current), sort_elem(ctx, current - 1)))
+        {
+            continue;
+        }
+
+        memcpy(ctx->scratch, sort_elem(ctx, current), elem_size);
+        do
+        {
+            memcpy(sort_elem(ctx, sift), sort_elem(ctx, sift - 1), elem_size);
+            sift--;
+        } while ((sift > begin) &&
+                 sort_less(ctx, ctx->scratch, sort_elem(ctx, sift - 1)));
+        memcpy(sort_elem(ctx, sift), ctx->scratch, elem_size);
+
+        moved += current - sift;
+        if (PARTIAL_INSERTION_LIMIT < moved)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static size_t sort_partition_right(sort_ctx_t * ctx,
+                                   size_t       begin,
+                                   size_t       end,
+                                   bool *       already_partitioned)
+{
+    unsigned char * pivot     = ctx->scratch;
+    size_t          first     = begin;
+    size_t          last      = end;
+    size_t          pivot_pos = 0;
+
+    memcpy(pivot, sort_elem(ctx, begin), ctx->elem_size);
+
+    // The median selection guarantees an element >= pivot before 'end'
+    do
+    {
+        first++;
+    } while (sort_less(ctx, sort_elem(ctx, first), pivot));
+
+    // Without an element < pivot already passed, guard the left scan
+    if ((first - 1) == begin)
+    {
+        while (first < last)
+        {
+            last--;
+            if (sort_less(ctx, sort_elem(ctx, last), pivot))
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        do
+        {
+            last--;
+        } while (!sort_less(ctx, sort_elem(ctx, last), pivot));
+    }
+
+    *already_partitioned = (first >= last);
+
+    while (first < last)
+    {
+        sort_swap(ctx, first, last);
+        do
+        {
+            first++;
+        } while (sort_less(ctx, sort_elem(ctx, first), pivot));
+        do
+        {
+            last--;
+        } while (!sort_less(ctx, sort_elem(ctx, last), pivot));
+    }
+
+    pivot_pos = first - 1;
+    memcpy(sort_elem(ctx, begin), sort_elem(ctx, pivot_pos), ctx->elem_size);
+    memcpy(sort_elem(ctx, pivot_pos), pivot, ctx->elem_size);
+
+    return pivot_pos;
+}
+
+static size_t sort_partition_left(sort_ctx_t * ctx, size_t begin, size_t end)
+{
+    unsigned char * pivot = ctx->scratch;
+    size_t          first = begin;
+    size_t          last  = end;
+
+    memcpy(pivot, sort_elem(ctx, begin), ctx->elem_size);
+
+    do
+    {
+        last--;
+    } while (sort_less(ctx, pivot, sort_elem(ctx, last)));
+
+    if ((last + 1) == end)
+    {
+        while (first < last)
+        {
+            first++;
+            if (sort_less(ctx, pivot, sort_elem(ctx, first)))
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        do
+        {
+            first++;
+        } while (!sort_less(ctx, pivot, sort_elem(ctx, first)));
+    }
+
+    while (first < last)
+    {
+        sort_swap(ctx, first, last);
+        do
+        {
+            last--;
+        } while (sort_less(ctx, pivot, sort_elem(ctx, last)));
+        do
+        {
+            first++;
+        } while (!sort_less(ctx, pivot, sort_elem(ctx, first)));
+    }
+
+    memcpy(sort_elem(ctx, begin), sort_elem(ctx, last), ctx->elem_size);
+    memcpy(sort_elem(ctx, last), pivot, ctx->elem_size);
+
+    return last;
+}
+
+static void sort_heap(sort_ctx_t * ctx, size_t begin, size_t end)
+{
+    size_t count = end - begin;
+
+    for (size_t root = count / 2; 0 < root; root--)
+    {
+        sort_sift_down(ctx, begin, root - 1, count);
+    }
+
+    for (size_t last = count - 1; 0 < last; last--)
+    {
+        sort_swap(ctx, begin, begin + last);
+        sort_sift_down(ctx, begin, 0, last);
+    }
+}
+
+static void sort_sift_down(sort_ctx_t * ctx,
+                           size_t       begin,
+                           size_t       root,
+                           size_t       count)
+{
+    size_t child = (2 * root) + 1;
+
+    while (child < count)
+    {
+        if (((child + 1) < count) &&
+            sort_less(ctx,
+                      sort_elem(ctx, begin + child),
+                      sort_elem(ctx, begin + child + 1)))
+        {
+            child++;
+        }
+
+        if (!sort_less(ctx,
+                       sort_elem(ctx, begin + root),
+                       sort_elem(ctx, begin + child)))
+        {
+            break;
+        }
+
+        sort_swap(ctx, begin + root, begin + child);
+        root  = child;
+        child = (2 * root) + 1;
+    }
+}
+
+static void sort_pdq_loop(sort_ctx_t * ctx,
+                          size_t       begin,
+                          size_t       end,
+                          int          bad_allowed,
+                          bool         leftmost)
+{
+    while (true)
+    {
+        size_t size                = end - begin;
+        size_t half                = size / 2;
+        size_t pivot_pos           = 0;
+        size_t left_size           = 0;
+        size_t right_size          = 0;
+        bool   already_partitioned = false;
+
+        if (INSERTION_THRESHOLD > size)
+        {
+            sort_insertion(ctx, begin, end, leftmost);
+            return;
+        }
+
+        // Move the chosen pivot to 'begin'
+        if (NINTHER_THRESHOLD < size)
+        {
+            sort_three(ctx, begin, begin + half, end - 1);
+            sort_three(ctx, begin + 1, begin + half - 1, end - 2);
+            sort_three(ctx, begin + 2, begin + half + 1, end - 3);
+            sort_three(ctx, begin + half - 1, begin + half, begin + half + 1);
+            sort_swap(ctx, begin, begin + half);
+        }
+        else
+        {
+            sort_three(ctx, begin + half, begin, end - 1);
+        }
+
+        // A pivot equal to its left neighbour means this range starts with
+        // a run of equal elements, all of which can be finished at once
+        if (!leftmost &&
+            !sort_less(ctx, sort_elem(ctx, begin - 1), sort_elem(ctx, begin)))
+        {
+            begin = sort_partition_left(ctx, begin, end) + 1;
+            continue;
+        }
+
+        pivot_pos =
+            sort_partition_right(ctx, begin, end, &already_partitioned);
+        left_size  = pivot_pos - begin;
+        right_size = end - (pivot_pos + 1);
+
+        if ((left_size < (size / 8)) || (right_size < (size / 8)))
+        {
+            bad_allowed--;
+            if (0 == bad_allowed)
+            {
+                sort_heap(ctx, begin, end);
+                return;
+            }
+
+            // Break up patterns that produced the bad partition
+            if (INSERTION_THRESHOLD <= left_size)
+            {
+                sort_swap(ctx, begin, begin + (left_size / 4));
+                sort_swap(ctx, pivot_pos - 1, pivot_pos - (left_size / 4));
+                if (NINTHER_THRESHOLD < left_size)
+                {
+                    sort_swap(ctx, begin + 1, begin + (left_size / 4 + 1));
+                    sort_swap(ctx, begin + 2, begin + (left_size / 4 + 2));
+                    sort_swap(
+                        ctx, pivot_pos - 2, pivot_pos - (left_size / 4 + 1));
+                    sort_swap(
+                        ctx, pivot_pos - 3, pivot_pos - (left_size / 4 + 2));
+                }
+            }
+
+            if (INSERTION_THRESHOLD <= right_size)
+            {
+                sort_swap(
+                    ctx, pivot_pos + 1, pivot_pos + (1 + right_size / 4));
+                sort_swap(ctx, end - 1, end - (right_size / 4));
+                if (NINTHER_THRESHOLD < right_size)
+                {
+                    sort_swap(
+                        ctx, pivot_pos + 2, pivot_pos + (2 + right_size / 4));
+                    sort_swap(
+                        ctx, pivot_pos + 3, pivot_pos + (3 + right_size / 4));
+                    sort_swap(ctx, end - 2, end - (1 + right_size / 4));
+                    sort_swap(ctx, end - 3, end - (2 + right_size / 4));
+                }
+            }
+        }
+        else if (already_partitioned &&
+                 sort_partial_insertion(ctx, begin, pivot_pos) &&
+                 sort_partial_insertion(ctx, pivot_pos + 1, end))
+        {
+            // Both sides were nearly sorted and insertion sort finished them
+            return;
+        }
+
+        sort_pdq_loop(ctx, begin, pivot_pos, bad_allowed, leftmost);
+        begin    = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+/*** end of file ***/
@@ -0,0 +1,229 @@
+#include <stdlib.h> // calloc(), free()
+#include <time.h>   // clock_gettime()
+
+#include "timer_wheel.h"
+#include "utilities.h"
+
+#define MS_PER_SEC 1000U
+#define NS_PER_MS  1000000U
+
+struct timer_wheel
+{
+    intrusive_list_t * slots;      // One list of timers per slot
+    size_t             slot_count;
+    uint64_t           tick_ms;    // Milliseconds per tick
+    uint64_t           next_tick;  // First tick whose slot is not yet expired
+    size_t             size;       // Timers scheduled
+};
+
+timer_wheel_t * timer_wheel_new(size_t   slot_count,
+                                uint64_t tick_ms,
+                                uint64_t now_ms)
+{
+    timer_wheel_t * wheel = NULL;
+
+    if (0 == tick_ms)
+    {
+        print_error("Invalid tick length.");
+        goto END;
+    }
+
+    wheel = calloc(1, sizeof(timer_wheel_t));
+    if (NULL == wheel)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    wheel->slot_count = (0 == slot_count) ? TIMER_WHEEL_DEFAULT_SLOTS
+                                          : slot_count;
+    wheel->tick_ms    = tick_ms;
+    wheel->next_tick  = now_ms / tick_ms;
+
+    wheel->slots = calloc(wheel->slot_count, sizeof(intrusive_list_t));
+    if (NULL == wheel->slots)
+    {
+        print_error("CMR failure.");
+        free(wheel);
+        wheel = NULL;
+        goto END;
+    }
+
+    for (size_t idx = 0; idx < wheel->slot_count; idx++)
+    {
+        intrusive_list_init(&wheel->slots[idx]);
+    }
+
+END:
+    return wheel;
+}
+
+uint64_t timer_wheel_now_ms(void)
+{
+    struct timespec now = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * MS_PER_SEC) +
+           ((uint64_t)now.tv_nsec / NS_PER_MS);
+}
+
+void timer_wheel_entry_init(timer_wheel_entry_t * entry)
+{
+    if (NULL == entry)
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    intrusive_link_init(&entry->link);
+    entry->deadline = 0;
+    entry->slot     = 0;
+}
+
+bool timer_wheel_is_scheduled(timer_wheel_entry_t * entry)
+{
+    return (NULL != entry) && intrusive_link_is_linked(&entry->link);
+}
+
+int timer_wheel_schedule(timer_wheel_t *       wheel,
+                         timer_wheel_entry_t * entry,
+                         uint64_t              deadline_ms)
+{
+    int      exit_code = E_FAILURE;
+    uint64_t tick      = 0;
+
+    if ((NULL == wheel) || (NULL == entry))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (E_SUCCESS != timer_wheel_cancel(wheel, entry))
+    {
+        goto END;
+    }
+
+    // A timer belongs to the tick its deadline ends in, so it is never
+    // expired before the deadline, and overdue timers go to the next one
+    tick = (deadline_ms / wheel->tick_ms) +
+           ((0 != (deadline_ms % wheel->tick_ms)) ? 1 : 0);
+    if (tick < wheel->next_tick)
+    {
+        tick = wheel->next_tick;
+    }
+
+    entry->deadline = deadline_ms;
+    entry->slot     = (size_t)(tick % wheel->slot_count);
+
+    exit_code =
+        intrusive_list_push_tail(&wheel->slots[entry->slot], &entry->link);
+    if (E_SUCCESS == exit_code)
+    {
+        wheel->size++;
+    }
+
+END:
+    return exit_code;
+}
+
+int timer_wheel_cancel(timer_wheel_t * wheel, timer_wheel_entry_t * entry)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == wheel) || (NULL == entry))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+    if (intrusive_link_is_linked(&entry->link))
+    {
+        exit_code =
+            intrusive_list_remove(&wheel->slots[entry->slot], &entry->link);
+        if (E_SUCCESS == exit_code)
+        {
+            wheel->size--;
+        }
+    }
+
+END:
+    return exit_code;
+}
+
+size_t timer_wheel_expire(timer_wheel_t *    wheel,
+                          uint64_t           now_ms,
+                          intrusive_list_t * expired)
+{
+    size_t                expired_count = 0;
+    uint64_t              last_tick     = 0;
+    uint64_t              ticks         = 0;
+    intrusive_list_t *    slot          = NULL;
+    intrusive_link_t *    link          = NULL;
+    intrusive_link_t *    next          = NULL;
+    timer_wheel_entry_t * entry         = NULL;
+
+    if ((NULL == wheel) || (NULL == expired))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    // Only ticks that have fully ended are expired
+    last_tick = now_ms / wheel->tick_ms;
+    if (last_tick < wheel->next_tick)
+    {
+        goto END;
+    }
+
+    // Past one full turn every slot has been due, so each is visited once
+    ticks = last_tick - wheel->next_tick + 1;
+    if (ticks > wheel->slot_count)
+    {
+        ticks = wheel->slot_count;
+    }
+
+    for (uint64_t tick = last_tick + 1 - ticks; tick <= last_tick; tick++)
+    {
+        slot = &wheel->slots[tick % wheel->slot_count];
+
+        // Timers of later turns share the slot and are left in place
+        INTRUSIVE_LIST_FOREACH(slot, link, next)
+        {
+            entry = INTRUSIVE_LIST_ENTRY(link, timer_wheel_entry_t, link);
+            if (entry->deadline <= now_ms)
+            {
+                intrusive_list_remove(slot, link);
+                intrusive_list_push_tail(expired, link);
+                wheel->size--;
+                expired_count++;
+            }
+        }
+    }
+
+    wheel->next_tick = last_tick + 1;
+
+END:
+    return expired_count;
+}
+
+size_t timer_wheel_size(timer_wheel_t * wheel)
+{
+    return (NULL == wheel) ? 0 : wheel->size;
+}
+
+void timer_wheel_destroy(timer_wheel_t ** wheel_addr)
+{
+    if ((NULL == wheel_addr) || (NULL == *wheel_addr))
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    free((*wheel_addr)->slots);
+    free(*wheel_addr);
+    *wheel_addr = NULL;
+}
+
+/*** end of file ***/
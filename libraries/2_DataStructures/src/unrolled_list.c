@@ -0,0 +1,886 @@
+#include <string.h> // memmove(), memcpy()
+
+#include "sort.h"
+#include "unrolled_list.h"
+#include "utilities.h"
+
+/**
+ * @brief Allocates an empty node from the list's node pool.
+ *
+ * @param list Pointer to the list the node will belong to.
+ * @return Pointer to the node, NULL on failure.
+ */
+static unrolled_node_t * unrolled_node_new(unrolled_list_t * list);
+
+/**
+ * @brief Links 'node' into the list directly after 'anchor', or at the head
+ * when 'anchor' is NULL.
+ *
+ * @param list Pointer to the list.
+ * @param anchor Pointer to the node to link after, may be NULL.
+ * @param node Pointer to the unlinked node.
+ */
+static void unrolled_node_link_after(unrolled_list_t * list,
+                                     unrolled_node_t * anchor,
+                                     unrolled_node_t * node);
+
+/**
+ * @brief Unlinks a node from the list and returns it to the node pool. The
+ * data pointers it still holds are not freed.
+ *
+ * @param list Pointer to the list.
+ * @param node Pointer to the node to release.
+ */
+static void unrolled_node_release(unrolled_list_t * list,
+                                  unrolled_node_t * node);
+
+/**
+ * @brief Finds the node holding the element at 'position', walking from
+ * whichever end of the list is nearer.
+ *
+ * @param list Pointer to the list.
+ * @param position Position of the element, less than list->size.
+ * @param offset Receives the element's index within the node.
+ * @return Pointer to the node holding the element.
+ */
+static unrolled_node_t * unrolled_list_locate(unrolled_list_t * list,
+                                              uint32_t          position,
+                                              uint32_t *        offset);
+
+/**
+ * @brief Inserts data at index 'offset' of 'node', splitting the node in two
+ * first when it is full.
+ *
+ * @param list Pointer to the list.
+ * @param node Pointer to the node to insert into.
+ * @param offset Index within the node, at most node->count.
+ * @param data Pointer to the data to insert.
+ * @return int E_SUCCESS for success, E_FAILURE for failure
+ */
+static int unrolled_list_insert_at(unrolled_list_t * list,
+                                   unrolled_node_t * node,
+                                   uint32_t          offset,
+                                   void *            data);
+
+/**
+ * @brief Removes the element at index 'offset' of 'node' and returns it.
+ *
+ * A node left empty is released, and a node left less than half full is
+ * merged with a neighbour when both fit in one node, keeping the list dense.
+ *
+ * @param list Pointer to the list.
+ * @param node Pointer to the node holding the element.
+ * @param offset Index of the element within the node.
+ * @return Pointer to the removed data.
+ */
+static void * unrolled_list_take_at(unrolled_list_t * list,
+                                    unrolled_node_t * node,
+                                    uint32_t          offset);
+
+/**
+ * @brief Moves every element of 'node->next' onto the end of 'node' and
+ * releases the emptied node.
+ *
+ * @param list Pointer to the list.
+ * @param node Pointer to the node to merge into, which must have a next node.
+ */
+static void unrolled_node_merge_next(unrolled_list_t * list,
+                                     unrolled_node_t * node);
+
+unrolled_list_t * unrolled_list_new(FREE_F   free_func,
+                                    CMP_F    comp_func,
+                                    uint32_t node_capacity)
+{
+    unrolled_list_t * new_list  = NULL;
+    size_t            node_size = 0;
+
+    if (0 == node_capacity)
+    {
+        node_capacity = UNROLLED_LIST_NODE_CAPACITY;
+    }
+
+    if ((2 > node_capacity) || (UNROLLED_LIST_MAX_CAPACITY < node_capacity))
+    {
+        print_error("Invalid node capacity.");
+        goto END;
+    }
+
+    new_list = calloc(1, sizeof(unrolled_list_t));
+    if (NULL == new_list)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    node_size = sizeof(unrolled_node_t) + (node_capacity * sizeof(void *));
+
+    new_list->node_pool = slab_pool_new(node_size, 0);
+    if (NULL == new_list->node_pool)
+    {
+        print_error("Unable to create node pool.");
+        free(new_list);
+        new_list = NULL;
+        goto END;
+    }
+
+    new_list->size          = 0;
+    new_list->node_capacity = node_capacity;
+    new_list->head          = NULL;
+    new_list->tail          = NULL;
+    new_list->custom_free   = (NULL == free_func) ? free : free_func;
+    new_list->compare_func  = (NULL == comp_func) ? int_comp : comp_func;
+
+END:
+    return new_list;
+}
+
+int unrolled_list_push_head(unrolled_list_t * list, void * data)
+{
+    int               exit_code = E_FAILURE;
+    unrolled_node_t * node      = NULL;
+
+    if ((NULL == list) || (NULL == data))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    // A full head gets a fresh node in front of it rather than being split,
+    // so repeated pushes fill whole nodes
+    node = list->head;
+    if ((NULL == node) || (list->node_capacity == node->count))
+    {
+        node = unrolled_node_new(list);
+        if (NULL == node)
+        {
+            goto END;
+        }
+
+        unrolled_node_link_after(list, NULL, node);
+    }
+
+    exit_code = unrolled_list_insert_at(list, node, 0, data);
+END:
+    return exit_code;
+}
+
+int unrolled_list_push_tail(unrolled_list_t * list, void * data)
+{
+    int               exit_code = E_FAILURE;
+    unrolled_node_t * node      = NULL;
+
+    if ((NULL == list) || (NULL == data))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    node = list->tail;
+    if ((NULL == node) || (list->node_capacity == node->count))
+    {
+        node = unrolled_node_new(list);
+        if (NULL == node)
+        {
+            goto END;
+        }
+
+        unrolled_node_link_after(list, list->tail, node);
+    }
+
+    exit_code = unrolled_list_insert_at(list, node, node->count, data);
+END:
+    return exit_code;
+}
+
+int unrolled_list_push_position(unrolled_list_t * list,
+                                void *            data,
+                                uint32_t          position)
+{
+    int               exit_code = E_FAILURE;
+    unrolled_node_t * node      = NULL;
+    uint32_t          offset    = 0;
+
+    if ((NULL == list) || (NULL == data))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (position > list->size)
+    {
+        print_error("Position out of bounds.");
+        goto END;
+    }
+
+    if (position == list->size)
+    {
+        exit_code = unrolled_list_push_tail(list, data);
+        goto END;
+    }
+
+    node      = unrolled_list_locate(list, position, &offset);
+    exit_code = unrolled_list_insert_at(list, node, offset, data);
+END:
+    return exit_code;
+}
+
+int unrolled_list_emptycheck(unrolled_list_t * list)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 == list->size)
+    {
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void * unrolled_list_pop_head(unrolled_list_t * list)
+{
+    void * data = NULL;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 == list->size)
+    {
+        print_error("List is empty.");
+        goto END;
+    }
+
+    data = unrolled_list_take_at(list, list->head, 0);
+
+END:
+    return data;
+}
+
+void * unrolled_list_pop_tail(unrolled_list_t * list)
+{
+    void * data = NULL;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 == list->size)
+    {
+        print_error("List is empty.");
+        goto END;
+    }
+
+    data = unrolled_list_take_at(list, list->tail, list->tail->count - 1);
+
+END:
+    return data;
+}
+
+void * unrolled_list_pop_position(unrolled_list_t * list, uint32_t position)
+{
+    void *            data   = NULL;
+    unrolled_node_t * node   = NULL;
+    uint32_t          offset = 0;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (position >= list->size)
+    {
+        print_error("Position out of bounds.");
+        goto END;
+    }
+
+    node = unrolled_list_locate(list, position, &offset);
+    data = unrolled_list_take_at(list, node, offset);
+
+END:
+    return data;
+}
+
+int unrolled_list_remove_head(unrolled_list_t * list)
+{
+    int    exit_code = E_FAILURE;
+    void * data      = NULL;
+
+    data = unrolled_list_pop_head(list);
+    if (NULL == data)
+    {
+        goto END;
+    }
+
+    list->custom_free(data);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int unrolled_list_remove_tail(unrolled_list_t * list)
+{
+    int    exit_code = E_FAILURE;
+    void * data      = NULL;
+
+    data = unrolled_list_pop_tail(list);
+    if (NULL == data)
+    {
+        goto END;
+    }
+
+    list->custom_free(data);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int unrolled_list_remove_position(unrolled_list_t * list, uint32_t position)
+{
+    int    exit_code = E_FAILURE;
+    void * data      = NULL;
+
+    data = unrolled_list_pop_position(list, position);
+    if (NULL == data)
+    {
+        goto END;
+    }
+
+    list->custom_free(data);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void * unrolled_list_peek_head(unrolled_list_t * list)
+{
+    void * data = NULL;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 != list->size)
+    {
+        data = list->head->items[0];
+    }
+
+END:
+    return data;
+}
+
+void * unrolled_list_peek_tail(unrolled_list_t * list)
+{
+    void * data = NULL;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 != list->size)
+    {
+        data = list->tail->items[list->tail->count - 1];
+    }
+
+END:
+    return data;
+}
+
+void * unrolled_list_peek_position(unrolled_list_t * list, uint32_t position)
+{
+    void *            data   = NULL;
+    unrolled_node_t * node   = NULL;
+    uint32_t          offset = 0;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (position >= list->size)
+    {
+        print_error("Position out of bounds.");
+        goto END;
+    }
+
+    node = unrolled_list_locate(list, position, &offset);
+    data = node->items[offset];
+
+END:
+    return data;
+}
+
+int unrolled_list_remove_data(unrolled_list_t * list, void ** item_to_remove)
+{
+    int               exit_code = E_FAILURE;
+    unrolled_node_t * node      = NULL;
+
+    if ((NULL == list) || (NULL == item_to_remove) ||
+        (NULL == *item_to_remove))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        for (uint32_t idx = 0; idx < node->count; idx++)
+        {
+            if (EQUAL == list->compare_func(*item_to_remove, node->items[idx]))
+            {
+                list->custom_free(unrolled_list_take_at(list, node, idx));
+                exit_code = E_SUCCESS;
+                goto END;
+            }
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int unrolled_list_foreach_call(unrolled_list_t * list, ACT_F action_function)
+{
+    int               exit_code = E_FAILURE;
+    unrolled_node_t * node      = NULL;
+
+    if ((NULL == list) || (NULL == action_function))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        // Fetch the next node while this one's elements are processed
+        __builtin_prefetch(node->next);
+
+        for (uint32_t idx = 0; idx < node->count; idx++)
+        {
+            action_function(node->items[idx]);
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void * unrolled_list_find_first_occurrence(unrolled_list_t * list,
+                                           void **           search_data)
+{
+    void *            data = NULL;
+    unrolled_node_t * node = NULL;
+
+    if ((NULL == list) || (NULL == search_data))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        __builtin_prefetch(node->next);
+
+        for (uint32_t idx = 0; idx < node->count; idx++)
+        {
+            if (EQUAL == list->compare_func(*search_data, node->items[idx]))
+            {
+                data = node->items[idx];
+                goto END;
+            }
+        }
+    }
+
+END:
+    return data;
+}
+
+unrolled_list_t * unrolled_list_find_all_occurrences(unrolled_list_t * list,
+                                                     void ** search_data)
+{
+    unrolled_list_t * new_list = NULL;
+    unrolled_node_t * node     = NULL;
+
+    if ((NULL == list) || (NULL == search_data))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    new_list = unrolled_list_new(
+        list->custom_free, list->compare_func, list->node_capacity);
+    if (NULL == new_list)
+    {
+        print_error("Unable to create new list.");
+        goto END;
+    }
+
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        __builtin_prefetch(node->next);
+
+        for (uint32_t idx = 0; idx < node->count; idx++)
+        {
+            if ((EQUAL ==
+                 list->compare_func(*search_data, node->items[idx])) &&
+                (E_SUCCESS !=
+                 unrolled_list_push_tail(new_list, node->items[idx])))
+            {
+                print_error("Unable to push data into list.");
+
+                // The data belongs to 'list', so only the nodes are released
+                while (NULL != new_list->head)
+                {
+                    unrolled_node_release(new_list, new_list->head);
+                }
+                new_list->size = 0;
+                unrolled_list_delete(&new_list);
+                goto END;
+            }
+        }
+    }
+
+END:
+    return new_list;
+}
+
+int unrolled_list_sort(unrolled_list_t * list)
+{
+    int               exit_code = E_FAILURE;
+    void **           items     = NULL;
+    unrolled_node_t * node      = NULL;
+    unrolled_node_t * next      = NULL;
+    uint32_t          copied    = 0;
+    uint32_t          count     = 0;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (2 > list->size)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    items = malloc(list->size * sizeof(void *));
+    if (NULL == items)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    for (node = list->head; NULL != node; node = node->next)
+    {
+        memcpy(items + copied, node->items, node->count * sizeof(void *));
+        copied += node->count;
+    }
+
+    exit_code = sort_introsort(
+        items, list->size, sizeof(void *), list->compare_func, true);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("Unable to sort list.");
+        goto END;
+    }
+
+    // Refill the nodes front to back, releasing any left over
+    copied = 0;
+    node   = list->head;
+    while (NULL != node)
+    {
+        next = node->next;
+
+        if (copied == list->size)
+        {
+            unrolled_node_release(list, node);
+        }
+        else
+        {
+            count = list->size - copied;
+            if (count > list->node_capacity)
+            {
+                count = list->node_capacity;
+            }
+
+            memcpy(node->items, items + copied, count * sizeof(void *));
+            node->count = count;
+            copied += count;
+        }
+
+        node = next;
+    }
+
+END:
+    free(items);
+    return exit_code;
+}
+
+int unrolled_list_clear(unrolled_list_t * list)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == list)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    while (NULL != list->head)
+    {
+        for (uint32_t idx = 0; idx < list->head->count; idx++)
+        {
+            list->custom_free(list->head->items[idx]);
+        }
+
+        unrolled_node_release(list, list->head);
+    }
+
+    list->size = 0;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int unrolled_list_delete(unrolled_list_t ** list_address)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == list_address) || (NULL == *list_address))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = unrolled_list_clear(*list_address);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("Unable to clear list.");
+        goto END;
+    }
+
+    slab_pool_destroy(&(*list_address)->node_pool);
+    free(*list_address);
+    *list_address = NULL;
+
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static unrolled_node_t * unrolled_node_new(unrolled_list_t * list)
+{
+    unrolled_node_t * node = NULL;
+
+    node = slab_pool_alloc(list->node_pool);
+    if (NULL == node)
+    {
+        print_error("Unable to create new node.");
+    }
+
+    return node;
+}
+
+static void unrolled_node_link_after(unrolled_list_t * list,
+                                     unrolled_node_t * anchor,
+                                     unrolled_node_t * node)
+{
+    node->prev = anchor;
+    node->next = (NULL == anchor) ? list->head : anchor->next;
+
+    if (NULL == node->prev)
+    {
+        list->head = node;
+    }
+    else
+    {
+        node->prev->next = node;
+    }
+
+    if (NULL == node->next)
+    {
+        list->tail = node;
+    }
+    else
+    {
+        node->next->prev = node;
+    }
+}
+
+static void unrolled_node_release(unrolled_list_t * list,
+                                  unrolled_node_t * node)
+{
+    if (NULL == node->prev)
+    {
+        list->head = node->next;
+    }
+    else
+    {
+        node->prev->next = node->next;
+    }
+
+    if (NULL == node->next)
+    {
+        list->tail = node->prev;
+    }
+    else
+    {
+        node->next->prev = node->prev;
+    }
+
+    slab_pool_free(list->node_pool, node);
+}
+
+static unrolled_node_t * unrolled_list_locate(unrolled_list_t * list,
+                                              uint32_t          position,
+                                              uint32_t *        offset)
+{
+    unrolled_node_t * node      = NULL;
+    uint32_t          remaining = 0;
+
+    if (position < (list->size / 2))
+    {
+        node = list->head;
+        while (position >= node->count)
+        {
+            position -= node->count;
+            node = node->next;
+        }
+
+        *offset = position;
+    }
+    else
+    {
+        // Count back from the tail, 'remaining' elements lie at or after
+        // the wanted one
+        remaining = list->size - position;
+        node      = list->tail;
+        while (remaining > node->count)
+        {
+            remaining -= node->count;
+            node = node->prev;
+        }
+
+        *offset = node->count - remaining;
+    }
+
+    return node;
+}
+
+static int unrolled_list_insert_at(unrolled_list_t * list,
+                                   unrolled_node_t * node,
+                                   uint32_t          offset,
+                                   void *            data)
+{
+    int               exit_code = E_FAILURE;
+    unrolled_node_t * split     = NULL;
+    uint32_t          keep      = 0;
+
+    if (list->node_capacity == node->count)
+    {
+        split = unrolled_node_new(list);
+        if (NULL == split)
+        {
+            goto END;
+        }
+
+        // Move the upper half into a new node after this one
+        keep = node->count / 2;
+        memcpy(split->items,
+               node->items + keep,
+               (node->count - keep) * sizeof(void *));
+        split->count = node->count - keep;
+        node->count  = keep;
+        unrolled_node_link_after(list, node, split);
+
+        if (offset > keep)
+        {
+            offset -= keep;
+            node = split;
+        }
+    }
+
+    memmove(node->items + offset + 1,
+            node->items + offset,
+            (node->count - offset) * sizeof(void *));
+    node->items[offset] = data;
+    node->count++;
+    list->size++;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static void * unrolled_list_take_at(unrolled_list_t * list,
+                                    unrolled_node_t * node,
+                                    uint32_t          offset)
+{
+    void *   data = node->items[offset];
+    uint32_t half = list->node_capacity / 2;
+
+    node->count--;
+    memmove(node->items + offset,
+            node->items + offset + 1,
+            (node->count - offset) * sizeof(void *));
+    list->size--;
+
+    if (0 == node->count)
+    {
+        unrolled_node_release(list, node);
+    }
+    else if (node->count < half)
+    {
+        if ((NULL != node->next) && ((node->count + node->next->count) <= half))
+        {
+            unrolled_node_merge_next(list, node);
+        }
+        else if ((NULL != node->prev) &&
+                 ((node->count + node->prev->count) <= half))
+        {
+            unrolled_node_merge_next(list, node->prev);
+        }
+    }
+
+    return data;
+}
+
+static void unrolled_node_merge_next(unrolled_list_t * list,
+                                     unrolled_node_t * node)
+{
+    unrolled_node_t * next = node->next;
+
+    memcpy(node->items + node->count,
+           next->items,
+           next->count * sizeof(void *));
+    node->count += next->count;
+    unrolled_node_release(list, next);
+}
+
+/*** end of file ***/
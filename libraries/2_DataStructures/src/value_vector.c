@@ -0,0 +1,906 @@
+#include <limits.h> // INT_MAX
+#include <stdlib.h> // calloc()
+#include <string.h> // memcpy(), memmove()
+
+#include "sort.h"
+#include "utilities.h"
+#include "value_vector.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // SSE2 and AVX2 intrinsics
+#define VALUE_VECTOR_X86
+#endif
+
+#define MIN_CAPACITY     8    // Capacity used when growing from zero
+#define GROWTH_THRESHOLD 4096 // Capacity past which growth slows to 1.5x
+#define BLOCK_ELEMENTS   64   // Elements matched per bitmap word
+
+/**
+ * @brief A search kernel that compares up to BLOCK_ELEMENTS 32-bit values
+ * against 'value' and returns a mask with bit N set if values[N] matches.
+ */
+typedef uint64_t (*MATCH_U32_F)(const uint32_t * values,
+                                size_t           count,
+                                uint32_t         value);
+
+/**
+ * @brief A search kernel that compares up to BLOCK_ELEMENTS 64-bit values
+ * against 'value' and returns a mask with bit N set if values[N] matches.
+ */
+typedef uint64_t (*MATCH_U64_F)(const uint64_t * values,
+                                size_t           count,
+                                uint64_t         value);
+
+/**
+ * @brief Grows the vector so it can hold at least 'min_capacity' elements.
+ *
+ * @param vector Pointer to the vector to be resized.
+ * @param min_capacity The minimum capacity required.
+ * @return Status code indicating success (E_SUCCESS) or failure (E_FAILURE).
+ */
+static int value_vector_resize(value_vector_t * vector, int min_capacity);
+
+/**
+ * @brief Returns a pointer to the element slot at 'index', without checks.
+ *
+ * @param vector Pointer to the vector.
+ * @param index Index of the slot.
+ * @return Pointer to the slot.
+ */
+static unsigned char * value_vector_slot(value_vector_t * vector, int index);
+
+/**
+ * @brief Returns the fastest 32-bit search kernel the CPU supports.
+ *
+ * @return The kernel.
+ */
+static MATCH_U32_F match_u32_kernel(void);
+
+/**
+ * @brief Returns the fastest 64-bit search kernel the CPU supports.
+ *
+ * @return The kernel.
+ */
+static MATCH_U64_F match_u64_kernel(void);
+
+/**
+ * @brief Portable 32-bit search kernel.
+ *
+ * @param values Pointer to the first value of the block.
+ * @param count Number of values in the block, at most BLOCK_ELEMENTS.
+ * @param value The value to search for.
+ * @return Mask of matching positions.
+ */
+static uint64_t match_u32_scalar(const uint32_t * values,
+                                 size_t           count,
+                                 uint32_t         value);
+
+/**
+ * @brief Portable 64-bit search kernel.
+ *
+ * @param values Pointer to the first value of the block.
+ * @param count Number of values in the block, at most BLOCK_ELEMENTS.
+ * @param value The value to search for.
+ * @return Mask of matching positions.
+ */
+static uint64_t match_u64_scalar(const uint64_t * values,
+                                 size_t           count,
+                                 uint64_t         value);
+
+#ifdef VALUE_VECTOR_X86
+/**
+ * @brief SSE2 32-bit search kernel, four values per compare.
+ *
+ * @param values Pointer to the first value of the block.
+ * @param count Number of values in the block, at most BLOCK_ELEMENTS.
+ * @param value The value to search for.
+ * @return Mask of matching positions.
+ */
+static uint64_t match_u32_sse2(const uint32_t * values,
+                               size_t           count,
+                               uint32_t         value);
+
+/**
+ * @brief AVX2 32-bit search kernel, eight values per compare.
+ *
+ * @param values Pointer to the first value of the block.
+ * @param count Number of values in the block, at most BLOCK_ELEMENTS.
+ * @param value The value to search for.
+ * @return Mask of matching positions.
+ */
+static uint64_t match_u32_avx2(const uint32_t * values,
+                               size_t           count,
+                               uint32_t         value);
+
+/**
+ * @brief SSE2 64-bit search kernel, two values per compare.
+ *
+ * @param values Pointer to the first value of the block.
+ * @param count Number of values in the block, at most BLOCK_ELEMENTS.
+ * @param value The value to search for.
+ * @return Mask of matching positions.
+ */
+static uint64_t match_u64_sse2(const uint64_t * values,
+                               size_t           count,
+                               uint64_t         value);
+
+/**
+ * @brief AVX2 64-bit search kernel, four values per compare.
+ *
+ * @param values Pointer to the first value of the block.
+ * @param count Number of values in the block, at most BLOCK_ELEMENTS.
+ * @param value The value to search for.
+ * @return Mask of matching positions.
+ */
+static uint64_t match_u64_avx2(const uint64_t * values,
+                               size_t           count,
+                               uint64_t         value);
+#endif /* VALUE_VECTOR_X86 */
+
+value_vector_t * value_vector_new(size_t elem_size,
+                                  CMP_F  compare_func,
+                                  int    initial_capacity)
+{
+    value_vector_t * new_vector = NULL;
+
+    if ((0 == elem_size) || (0 > initial_capacity))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    new_vector = calloc(1, sizeof(value_vector_t));
+    if (NULL == new_vector)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    new_vector->elem_size    = elem_size;
+    new_vector->compare_func = compare_func;
+
+    if (0 < initial_capacity)
+    {
+        new_vector->data = calloc(initial_capacity, elem_size);
+        if (NULL == new_vector->data)
+        {
+            print_error("CMR failure.");
+            free(new_vector);
+            new_vector = NULL;
+            goto END;
+        }
+        new_vector->capacity = initial_capacity;
+    }
+
+END:
+    return new_vector;
+}
+
+int value_vector_reserve(value_vector_t * vector, int capacity)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == vector)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (capacity <= vector->capacity)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    exit_code = value_vector_resize(vector, capacity);
+
+END:
+    return exit_code;
+}
+
+int value_vector_append(value_vector_t * vector, const void * element)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == vector) || (NULL == element))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (vector->size == vector->capacity)
+    {
+        exit_code = value_vector_resize(vector, vector->size + 1);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+    }
+
+    memcpy(value_vector_slot(vector, vector->size),
+           element,
+           vector->elem_size);
+    vector->size++;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int value_vector_append_many(value_vector_t * vector,
+                             const void *     elements,
+                             int              count)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == vector) || (NULL == elements))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 > count) || (count > (INT_MAX - vector->size)))
+    {
+        print_error("Invalid count.");
+        goto END;
+    }
+
+    if ((vector->size + count) > vector->capacity)
+    {
+        exit_code = value_vector_resize(vector, vector->size + count);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+    }
+
+    memcpy(value_vector_slot(vector, vector->size),
+           elements,
+           (size_t)count * vector->elem_size);
+    vector->size += count;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int value_vector_insert(value_vector_t * vector,
+                        const void *     element,
+                        int              index)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == vector) || (NULL == element))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 > index) || (index > vector->size))
+    {
+        print_error("Position out of bounds.");
+        goto END;
+    }
+
+    if (vector->size == vector->capacity)
+    {
+        exit_code = value_vector_resize(vector, vector->size + 1);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+    }
+
+    memmove(value_vector_slot(vector, index + 1),
+            value_vector_slot(vector, index),
+            (size_t)(vector->size - index) * vector->elem_size);
+    memcpy(value_vector_slot(vector, index), element, vector->elem_size);
+    vector->size++;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int value_vector_pop(value_vector_t * vector, void * element)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == vector)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (0 == vector->size)
+    {
+        print_error("Empty vector.");
+        goto END;
+    }
+
+    vector->size--;
+
+    if (NULL != element)
+    {
+        memcpy(element,
+               value_vector_slot(vector, vector->size),
+               vector->elem_size);
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int value_vector_remove(value_vector_t * vector, int index)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == vector)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 > index) || (index >= vector->size))
+    {
+        print_error("Index out of bounds.");
+        goto END;
+    }
+
+    memmove(value_vector_slot(vector, index),
+            value_vector_slot(vector, index + 1),
+            (size_t)(vector->size - index - 1) * vector->elem_size);
+    vector->size--;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void * value_vector_at(value_vector_t * vector, int index)
+{
+    void * element = NULL;
+
+    if (NULL == vector)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 > index) || (index >= vector->size))
+    {
+        print_error("Index out of bounds.");
+        goto END;
+    }
+
+    element = value_vector_slot(vector, index);
+
+END:
+    return element;
+}
+
+int value_vector_set(value_vector_t * vector, int index, const void * element)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == vector) || (NULL == element))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 > index) || (index >= vector->size))
+    {
+        print_error("Index out of bounds.");
+        goto END;
+    }
+
+    memcpy(value_vector_slot(vector, index), element, vector->elem_size);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int value_vector_find_first(value_vector_t * vector, const void * element)
+{
+    int             found_index = -1;
+    unsigned char * slot        = NULL;
+
+    if ((NULL == vector) || (NULL == element))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    slot = vector->data;
+    for (int idx = 0; idx < vector->size; idx++)
+    {
+        if (NULL == vector->compare_func)
+        {
+            if (0 == memcmp(slot, element, vector->elem_size))
+            {
+                found_index = idx;
+                goto END;
+            }
+        }
+        else if (EQUAL == vector->compare_func(slot, (void *)element))
+        {
+            found_index = idx;
+            goto END;
+        }
+        slot += vector->elem_size;
+    }
+
+END:
+    return found_index;
+}
+
+int value_vector_find_u32(value_vector_t * vector, uint32_t value)
+{
+    int              found_index = -1;
+    MATCH_U32_F      match       = match_u32_kernel();
+    const uint32_t * values      = NULL;
+    size_t           size        = 0;
+
+    if ((NULL == vector) || (sizeof(uint32_t) != vector->elem_size))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    values = (const uint32_t *)vector->data;
+    size   = (size_t)vector->size;
+    for (size_t base = 0; base < size; base += BLOCK_ELEMENTS)
+    {
+        size_t   count = size - base;
+        uint64_t mask  = 0;
+
+        if (BLOCK_ELEMENTS < count)
+        {
+            count = BLOCK_ELEMENTS;
+        }
+
+        mask = match(values + base, count, value);
+        if (0 != mask)
+        {
+            found_index = (int)(base + (size_t)__builtin_ctzll(mask));
+            goto END;
+        }
+    }
+
+END:
+    return found_index;
+}
+
+int value_vector_find_u64(value_vector_t * vector, uint64_t value)
+{
+    int              found_index = -1;
+    MATCH_U64_F      match       = match_u64_kernel();
+    const uint64_t * values      = NULL;
+    size_t           size        = 0;
+
+    if ((NULL == vector) || (sizeof(uint64_t) != vector->elem_size))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    values = (const uint64_t *)vector->data;
+    size   = (size_t)vector->size;
+    for (size_t base = 0; base < size; base += BLOCK_ELEMENTS)
+    {
+        size_t   count = size - base;
+        uint64_t mask  = 0;
+
+        if (BLOCK_ELEMENTS < count)
+        {
+            count = BLOCK_ELEMENTS;
+        }
+
+        mask = match(values + base, count, value);
+        if (0 != mask)
+        {
+            found_index = (int)(base + (size_t)__builtin_ctzll(mask));
+            goto END;
+        }
+    }
+
+END:
+    return found_index;
+}
+
+int value_vector_match_u32(value_vector_t * vector,
+                           uint32_t         value,
+                           uint64_t *       bitmap)
+{
+    int              matches = -1;
+    MATCH_U32_F      match   = match_u32_kernel();
+    const uint32_t * values  = NULL;
+    size_t           size    = 0;
+
+    if ((NULL == vector) || (NULL == bitmap) ||
+        (sizeof(uint32_t) != vector->elem_size))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    matches = 0;
+    values  = (const uint32_t *)vector->data;
+    size    = (size_t)vector->size;
+    for (size_t base = 0; base < size; base += BLOCK_ELEMENTS)
+    {
+        size_t count = size - base;
+
+        if (BLOCK_ELEMENTS < count)
+        {
+            count = BLOCK_ELEMENTS;
+        }
+
+        bitmap[base / BLOCK_ELEMENTS] = match(values + base, count, value);
+        matches += __builtin_popcountll(bitmap[base / BLOCK_ELEMENTS]);
+    }
+
+END:
+    return matches;
+}
+
+int value_vector_match_u64(value_vector_t * vector,
+                           uint64_t         value,
+                           uint64_t *       bitmap)
+{
+    int              matches = -1;
+    MATCH_U64_F      match   = match_u64_kernel();
+    const uint64_t * values  = NULL;
+    size_t           size    = 0;
+
+    if ((NULL == vector) || (NULL == bitmap) ||
+        (sizeof(uint64_t) != vector->elem_size))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    matches = 0;
+    values  = (const uint64_t *)vector->data;
+    size    = (size_t)vector->size;
+    for (size_t base = 0; base < size; base += BLOCK_ELEMENTS)
+    {
+        size_t count = size - base;
+
+        if (BLOCK_ELEMENTS < count)
+        {
+            count = BLOCK_ELEMENTS;
+        }
+
+        bitmap[base / BLOCK_ELEMENTS] = match(values + base, count, value);
+        matches += __builtin_popcountll(bitmap[base / BLOCK_ELEMENTS]);
+    }
+
+END:
+    return matches;
+}
+
+int value_vector_bitmap_indices(const uint64_t * bitmap,
+                                int              size,
+                                int *            indices)
+{
+    int written = 0;
+
+    if ((NULL == bitmap) || (NULL == indices) || (0 > size))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    for (size_t word = 0; word < VALUE_VECTOR_BITMAP_WORDS(size); word++)
+    {
+        uint64_t mask = bitmap[word];
+
+        // Visit only the set bits, lowest first
+        while (0 != mask)
+        {
+            indices[written++] =
+                (int)(word * BLOCK_ELEMENTS) + __builtin_ctzll(mask);
+            mask &= mask - 1;
+        }
+    }
+
+END:
+    return written;
+}
+
+int value_vector_foreach(value_vector_t * vector, ACT_F action_function)
+{
+    int             exit_code = E_FAILURE;
+    unsigned char * slot      = NULL;
+
+    if ((NULL == vector) || (NULL == action_function))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    slot = vector->data;
+    for (int idx = 0; idx < vector->size; idx++)
+    {
+        action_function(slot);
+        slot += vector->elem_size;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int value_vector_sort(value_vector_t * vector)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == vector) || (NULL == vector->compare_func))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = sort_introsort(vector->data,
+                               vector->size,
+                               vector->elem_size,
+                               vector->compare_func,
+                               false);
+
+END:
+    return exit_code;
+}
+
+int value_vector_clear(value_vector_t * vector)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == vector)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    vector->size = 0;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+void value_vector_delete(value_vector_t ** vector)
+{
+    if ((NULL == vector) || (NULL == *vector))
+    {
+        print_error("NULL argument passed.");
+        return;
+    }
+
+    free((*vector)->data);
+    free(*vector);
+    *vector = NULL;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static int value_vector_resize(value_vector_t * vector, int min_capacity)
+{
+    int             exit_code    = E_FAILURE;
+    int             new_capacity = vector->capacity;
+    unsigned char * new_data     = NULL;
+
+    while (new_capacity < min_capacity)
+    {
+        if (MIN_CAPACITY > new_capacity)
+        {
+            new_capacity = MIN_CAPACITY;
+        }
+        else if (GROWTH_THRESHOLD > new_capacity)
+        {
+            new_capacity *= 2;
+        }
+        else if ((INT_MAX - new_capacity / 2) > new_capacity)
+        {
+            new_capacity += new_capacity / 2;
+        }
+        else
+        {
+            new_capacity = min_capacity;
+        }
+    }
+
+    if ((SIZE_MAX / vector->elem_size) < (size_t)new_capacity)
+    {
+        print_error("Capacity overflow.");
+        goto END;
+    }
+
+    new_data = realloc(vector->data, (size_t)new_capacity * vector->elem_size);
+    if (NULL == new_data)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    vector->data     = new_data;
+    vector->capacity = new_capacity;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static unsigned char * value_vector_slot(value_vector_t * vector, int index)
+{
+    return vector->data + ((size_t)index * vector->elem_size);
+}
+
+static MATCH_U32_F match_u32_kernel(void)
+{
+    MATCH_U32_F kernel = match_u32_scalar;
+
+#ifdef VALUE_VECTOR_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernel = match_u32_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        kernel = match_u32_sse2;
+    }
+#endif /* VALUE_VECTOR_X86 */
+
+    return kernel;
+}
+
+static MATCH_U64_F match_u64_kernel(void)
+{
+    MATCH_U64_F kernel = match_u64_scalar;
+
+#ifdef VALUE_VECTOR_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernel = match_u64_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        kernel = match_u64_sse2;
+    }
+#endif /* VALUE_VECTOR_X86 */
+
+    return kernel;
+}
+
+static uint64_t match_u32_scalar(const uint32_t * values,
+                                 size_t           count,
+                                 uint32_t         value)
+{
+    uint64_t mask = 0;
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        mask |= (uint64_t)(values[idx] == value) << idx;
+    }
+
+    return mask;
+}
+
+static uint64_t match_u64_scalar(const uint64_t * values,
+                                 size_t           count,
+                                 uint64_t         value)
+{
+    uint64_t mask = 0;
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        mask |= (uint64_t)(values[idx] == value) << idx;
+    }
+
+    return mask;
+}
+
+#ifdef VALUE_VECTOR_X86
+__attribute__((target("sse2"))) static uint64_t match_u32_sse2(
+    const uint32_t * values, size_t count, uint32_t value)
+{
+    uint64_t mask   = 0;
+    size_t   idx    = 0;
+    __m128i  needle = _mm_set1_epi32((int)value);
+
+    for (; (idx + 4) <= count; idx += 4)
+    {
+        __m128i lanes = _mm_loadu_si128((const __m128i *)(values + idx));
+        __m128i equal = _mm_cmpeq_epi32(lanes, needle);
+
+        mask |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(equal)) << idx;
+    }
+
+    // Finish the block's tail, never shifting by the full 64 bits
+    if (idx < count)
+    {
+        mask |= match_u32_scalar(values + idx, count - idx, value) << idx;
+    }
+
+    return mask;
+}
+
+__attribute__((target("avx2"))) static uint64_t match_u32_avx2(
+    const uint32_t * values, size_t count, uint32_t value)
+{
+    uint64_t mask   = 0;
+    size_t   idx    = 0;
+    __m256i  needle = _mm256_set1_epi32((int)value);
+
+    for (; (idx + 8) <= count; idx += 8)
+    {
+        __m256i lanes = _mm256_loadu_si256((const __m256i *)(values + idx));
+        __m256i equal = _mm256_cmpeq_epi32(lanes, needle);
+
+        mask |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(equal))
+                << idx;
+    }
+
+    if (idx < count)
+    {
+        mask |= match_u32_scalar(values + idx, count - idx, value) << idx;
+    }
+
+    return mask;
+}
+
+__attribute__((target("sse2"))) static uint64_t match_u64_sse2(
+    const uint64_t * values, size_t count, uint64_t value)
+{
+    uint64_t mask   = 0;
+    size_t   idx    = 0;
+    __m128i  needle = _mm_set1_epi64x((long long)value);
+
+    for (; (idx + 2) <= count; idx += 2)
+    {
+        __m128i lanes = _mm_loadu_si128((const __m128i *)(values + idx));
+        __m128i equal = _mm_cmpeq_epi32(lanes, needle);
+
+        // SSE2 has no 64-bit compare, so require both 32-bit halves to match
+        equal = _mm_and_si128(
+            equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+        mask |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(equal)) << idx;
+    }
+
+    if (idx < count)
+    {
+        mask |= match_u64_scalar(values + idx, count - idx, value) << idx;
+    }
+
+    return mask;
+}
+
+__attribute__((target("avx2"))) static uint64_t match_u64_avx2(
+    const uint64_t * values, size_t count, uint64_t value)
+{
+    uint64_t mask   = 0;
+    size_t   idx    = 0;
+    __m256i  needle = _mm256_set1_epi64x((long long)value);
+
+    for (; (idx + 4) <= count; idx += 4)
+    {
+        __m256i lanes = _mm256_loadu_si256((const __m256i *)(values + idx));
+        __m256i equal = _mm256_cmpeq_epi64(lanes, needle);
+
+        mask |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(equal))
+                << idx;
+    }
+
+    if (idx < count)
+    {
+        mask |= match_u64_scalar(values + idx, count - idx, value) << idx;
+    }
+
+    return mask;
+}
+#endif /* VALUE_VECTOR_X86 */
+
+/*** end of file ***/
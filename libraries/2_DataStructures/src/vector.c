@@ -1,5 +1,8 @@
-#include <stdlib.h> // qsort()
-#include <string.h> // memmove()
+#include <limits.h>   // INT_MAX
+#include <stdlib.h>   // calloc()
+#include <string.h>   // memmove()
+#include <sys/mman.h> // mmap(), mremap()
+#include <unistd.h>   // sysconf()
 
 #include "utilities.h"
 #include "vector.h"
@@ -7,15 +10,65 @@
 #define LEFT  0 // Used for shifting elements left
 #define RIGHT 1 // Used for shifting elements right
 
-typedef int (*VECTOR_CMP)(const void *, const void *);
+#define MIN_CAPACITY     8       // Capacity used when growing from zero
+#define GROWTH_THRESHOLD 4096    // Capacity past which growth slows to 1.5x
+#define SHRINK_DIVISOR   4       // Shrink once size falls to capacity / 4
+#define MAP_THRESHOLD    1048576 // Storage bytes past which mremap() is used
 
 /**
- * @brief Resizes the vector, doubling its capacity.
+ * @brief Grows the vector so it can hold at least 'min_capacity' elements.
+ *
+ * Capacity doubles while small and grows by 1.5x past GROWTH_THRESHOLD, so
+ * large vectors do not overshoot by as much. Growth from zero starts at
+ * MIN_CAPACITY.
  *
  * @param vector Pointer to the vector to be resized.
+ * @param min_capacity The minimum capacity required.
  * @return Status code indicating success (E_SUCCESS) or failure (E_FAILURE).
  */
-static int vector_resize(vector_t * vector);
+static int vector_resize(vector_t * vector, int min_capacity);
+
+/**
+ * @brief Shrinks the vector to half its capacity once it is mostly empty.
+ *
+ * The gap between the shrink point (a quarter full) and the new capacity
+ * (half full) stops a vector hovering around one size from reallocating on
+ * every push and pop.
+ *
+ * @param vector Pointer to the vector.
+ */
+static void vector_maybe_shrink(vector_t * vector);
+
+/**
+ * @brief Moves the elements into storage for exactly 'new_capacity'
+ * elements.
+ *
+ * Storage past MAP_THRESHOLD bytes is an anonymous mapping that is resized
+ * with mremap(), which moves page table entries instead of copying.
+ *
+ * @param vector Pointer to the vector.
+ * @param new_capacity The new capacity, at least the vector's size.
+ * @return Status code indicating success (E_SUCCESS) or failure (E_FAILURE).
+ */
+static int vector_set_capacity(vector_t * vector, int new_capacity);
+
+/**
+ * @brief Rounds a mapped storage size up to a whole number of pages.
+ *
+ * @param capacity The number of elements.
+ * @return The size of the mapping in bytes.
+ */
+static size_t vector_map_length(int capacity);
+
+/**
+ * @brief Returns true if the element 'lhs' orders strictly before 'rhs'.
+ *
+ * @param vector Pointer to the vector, for its compare function.
+ * @param lhs The first data pointer.
+ * @param rhs The second data pointer.
+ * @return true if compare_func reports LESS_THAN.
+ */
+static bool vector_less(vector_t * vector, void * lhs, void * rhs);
 
 /**
  * @brief Shifts elements in the vector either to the right or left from a given
@@ -56,6 +109,12 @@ vector_t * vector_new(FREE_F free_func, CMP_F comp_func, int initial_capacity)
         goto END;
     }
 
+    if (0 > initial_capacity)
+    {
+        print_error("Invalid initial capacity.");
+        goto END;
+    }
+
     // Create the vector
     new_vector = calloc(1, sizeof(vector_t));
     if (NULL == new_vector)
@@ -65,16 +124,15 @@ vector_t * vector_new(FREE_F free_func, CMP_F comp_func, int initial_capacity)
     }
 
     // Allocate space for each element
-    new_vector->elements = calloc(initial_capacity, sizeof(void *));
-    if (NULL == new_vector->elements)
+    if (E_SUCCESS != vector_set_capacity(new_vector, initial_capacity))
     {
         free(new_vector);
         new_vector = NULL;
         goto END;
     }
 
-    new_vector->capacity     = initial_capacity;
     new_vector->size         = 0;
+    new_vector->sorted       = true;
     new_vector->custom_free  = free_func;
     new_vector->compare_func = comp_func;
 
@@ -82,6 +140,44 @@ END:
     return new_vector;
 }
 
+int vector_reserve(vector_t * vector, int capacity)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == vector)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (capacity <= vector->capacity)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    exit_code = vector_set_capacity(vector, capacity);
+
+END:
+    return exit_code;
+}
+
+int vector_shrink_to_fit(vector_t * vector)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == vector)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = vector_set_capacity(vector, vector->size);
+
+END:
+    return exit_code;
+}
+
 int vector_append(vector_t * vector, void * data)
 {
     int exit_code = E_FAILURE;
@@ -92,14 +188,53 @@ int vector_append(vector_t * vector, void * data)
         goto END;
     }
 
-    // Insert data at the end of the vector
-    exit_code = vector_insert(vector, data, vector->size);
-    if (E_SUCCESS != exit_code)
+    // Appending never shifts, so skip the insert path entirely
+    if (vector->size == vector->capacity)
+    {
+        exit_code = vector_resize(vector, vector->size + 1);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+    }
+
+    vector->elements[vector->size++] = data;
+    vector->sorted                   = false;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int vector_append_many(vector_t * vector, void ** data, int count)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == vector) || (NULL == data))
     {
-        print_error("Unable to insert element.");
+        print_error("NULL argument passed.");
         goto END;
     }
 
+    if ((0 > count) || (count > (INT_MAX - vector->size)))
+    {
+        print_error("Invalid count.");
+        goto END;
+    }
+
+    if ((vector->size + count) > vector->capacity)
+    {
+        exit_code = vector_resize(vector, vector->size + count);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+    }
+
+    memcpy(&vector->elements[vector->size], data, count * sizeof(void *));
+    vector->size += count;
+    vector->sorted = false;
+
     exit_code = E_SUCCESS;
 END:
     return exit_code;
@@ -123,7 +258,7 @@ int vector_insert(vector_t * vector, void * data, int index)
 
     if (vector->size == vector->capacity)
     {
-        exit_code = vector_resize(vector);
+        exit_code = vector_resize(vector, vector->size + 1);
         if (E_SUCCESS != exit_code)
         {
             goto END;
@@ -138,6 +273,7 @@ int vector_insert(vector_t * vector, void * data, int index)
     }
 
     vector->elements[index] = data;
+    vector->sorted          = false;
 
     exit_code = E_SUCCESS;
 END:
@@ -175,6 +311,12 @@ void * vector_pop(vector_t * vector)
         goto END;
     }
 
+    if (0 == vector->size)
+    {
+        print_error("Empty vector.");
+        goto END;
+    }
+
     temp = vector->elements[vector->size - 1];
 
     exit_code = vector_shift_elements_left(vector, vector->size);
@@ -186,6 +328,8 @@ void * vector_pop(vector_t * vector)
 
     element = temp;
 
+    vector_maybe_shrink(vector);
+
 END:
     return element;
 }
@@ -218,6 +362,8 @@ int vector_remove(vector_t * vector, int index)
 
     vector->custom_free(temp);
 
+    vector_maybe_shrink(vector);
+
     exit_code = E_SUCCESS;
 END:
     return exit_code;
@@ -262,6 +408,7 @@ int vector_set_element(vector_t * vector, void * data, int index)
     }
 
     vector->elements[index] = data;
+    vector->sorted          = false;
 
     exit_code = E_SUCCESS;
 END:
@@ -329,6 +476,19 @@ void * vector_find_first_occurrence(vector_t * vector, void ** search_data)
         goto END;
     }
 
+    if (true == vector->sorted)
+    {
+        int idx = vector_lower_bound(vector, search_data);
+
+        if ((idx < vector->size) &&
+            (EQUAL ==
+             vector->compare_func(search_data, vector->elements[idx])))
+        {
+            found_element = vector->elements[idx];
+        }
+        goto END;
+    }
+
     for (int idx = 0; idx < vector->size; idx++)
     {
         if (EQUAL == vector->compare_func(search_data, vector->elements[idx]))
@@ -345,7 +505,8 @@ END:
 vector_t * vector_find_all_occurrences(vector_t * vector, void ** search_data)
 {
     vector_t * result_vector = NULL;
-    int        exit_code     = E_FAILURE;
+    uint64_t * matches       = NULL;
+    int        match_count   = 0;
 
     if ((NULL == vector) || (NULL == search_data))
     {
@@ -359,11 +520,11 @@ vector_t * vector_find_all_occurrences(vector_t * vector, void ** search_data)
         goto END;
     }
 
-    result_vector =
-        vector_new(vector->custom_free, vector->compare_func, vector->size);
-    if (NULL == result_vector)
+    // Record matches in a bitmap so the result is allocated exactly once
+    matches = calloc((vector->size + 63) / 64, sizeof(uint64_t));
+    if (NULL == matches)
     {
-        print_error("Unable to create result vector.");
+        print_error("CMR failure.");
         goto END;
     }
 
@@ -371,23 +532,40 @@ vector_t * vector_find_all_occurrences(vector_t * vector, void ** search_data)
     {
         if (EQUAL == vector->compare_func(search_data, vector->elements[idx]))
         {
-            exit_code = vector_append(result_vector, vector->elements[idx]);
-            if (E_SUCCESS != exit_code)
-            {
-                print_error("Unable to append element.");
-                vector_delete(&vector);
-                goto END;
-            }
+            matches[idx / 64] |= UINT64_C(1) << (idx % 64);
+            match_count++;
         }
     }
 
-    // If no occurrences were found, free the result vector and return NULL
-    if (0 == result_vector->size)
+    // If no occurrences were found, return NULL
+    if (0 == match_count)
+    {
+        goto END;
+    }
+
+    result_vector =
+        vector_new(vector->custom_free, vector->compare_func, match_count);
+    if (NULL == result_vector)
+    {
+        print_error("Unable to create result vector.");
+        goto END;
+    }
+
+    for (int word = 0; word < ((vector->size + 63) / 64); word++)
     {
-        vector_delete(&result_vector);
+        uint64_t mask = matches[word];
+
+        while (0 != mask)
+        {
+            int idx = (word * 64) + __builtin_ctzll(mask);
+
+            vector_push_unchecked(result_vector, vector->elements[idx]);
+            mask &= mask - 1;
+        }
     }
 
 END:
+    free(matches);
     return result_vector;
 }
 
@@ -401,10 +579,211 @@ int vector_sort(vector_t * vector)
         goto END;
     }
 
-    qsort(vector->elements,
-          vector->size,
-          sizeof(void *),
-          (VECTOR_CMP)vector->compare_func);
+    exit_code = sort_introsort(vector->elements,
+                               vector->size,
+                               sizeof(void *),
+                               vector->compare_func,
+                               true);
+    if (E_SUCCESS == exit_code)
+    {
+        vector->sorted = true;
+    }
+
+END:
+    return exit_code;
+}
+
+int vector_sort_by_key(vector_t * vector, SORT_KEY_F key_func)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == vector) || (NULL == key_func))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    // Key order need not match compare_func order
+    exit_code      = sort_radix_keyed(vector->elements, vector->size, key_func);
+    vector->sorted = false;
+
+END:
+    return exit_code;
+}
+
+int vector_lower_bound(vector_t * vector, void * key)
+{
+    int     index = -1;
+    void ** base  = NULL;
+    int     count = 0;
+
+    if ((NULL == vector) || (NULL == key))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (false == vector->sorted)
+    {
+        print_error("Vector is not sorted.");
+        goto END;
+    }
+
+    if (0 == vector->size)
+    {
+        index = 0;
+        goto END;
+    }
+
+    // Halve the range a fixed number of times, selecting with a conditional
+    // move rather than a branch, and prefetch both candidate midpoints
+    base  = vector->elements;
+    count = vector->size;
+    while (1 < count)
+    {
+        int half = count / 2;
+
+        __builtin_prefetch(&base[half / 2]);
+        __builtin_prefetch(&base[half + (half / 2)]);
+        base = vector_less(vector, base[half], key) ? base + half : base;
+        count -= half;
+    }
+
+    index = (int)(base - vector->elements) + vector_less(vector, *base, key);
+
+END:
+    return index;
+}
+
+int vector_upper_bound(vector_t * vector, void * key)
+{
+    int     index = -1;
+    void ** base  = NULL;
+    int     count = 0;
+
+    if ((NULL == vector) || (NULL == key))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (false == vector->sorted)
+    {
+        print_error("Vector is not sorted.");
+        goto END;
+    }
+
+    if (0 == vector->size)
+    {
+        index = 0;
+        goto END;
+    }
+
+    base  = vector->elements;
+    count = vector->size;
+    while (1 < count)
+    {
+        int half = count / 2;
+
+        __builtin_prefetch(&base[half / 2]);
+        __builtin_prefetch(&base[half + (half / 2)]);
+        base = vector_less(vector, key, base[half]) ? base : base + half;
+        count -= half;
+    }
+
+    index = (int)(base - vector->elements) + !vector_less(vector, key, *base);
+
+END:
+    return index;
+}
+
+int vector_insert_sorted(vector_t * vector, void * data)
+{
+    int exit_code = E_FAILURE;
+    int index     = 0;
+
+    if ((NULL == vector) || (NULL == data))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    index = vector_upper_bound(vector, data);
+    if (0 > index)
+    {
+        goto END;
+    }
+
+    exit_code = vector_insert(vector, data, index);
+    if (E_SUCCESS != exit_code)
+    {
+        goto END;
+    }
+
+    vector->sorted = true;
+
+END:
+    return exit_code;
+}
+
+int vector_merge_sorted(vector_t * dest, vector_t * source)
+{
+    int exit_code = E_FAILURE;
+    int dest_idx  = 0;
+    int src_idx   = 0;
+    int out_idx   = 0;
+
+    if ((NULL == dest) || (NULL == source))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if (dest == source)
+    {
+        print_error("Cannot merge a vector into itself.");
+        goto END;
+    }
+
+    if ((false == dest->sorted) || (false == source->sorted))
+    {
+        print_error("Vector is not sorted.");
+        goto END;
+    }
+
+    if (source->size > (INT_MAX - dest->size))
+    {
+        print_error("Merged vector too large.");
+        goto END;
+    }
+
+    exit_code = vector_reserve(dest, dest->size + source->size);
+    if (E_SUCCESS != exit_code)
+    {
+        goto END;
+    }
+
+    // Merge from the back so the larger elements land in the free tail and
+    // no temporary buffer is needed
+    dest_idx = dest->size - 1;
+    src_idx  = source->size - 1;
+    out_idx  = dest->size + source->size - 1;
+    while (0 <= src_idx)
+    {
+        if ((0 <= dest_idx) && vector_less(dest,
+                                           source->elements[src_idx],
+                                           dest->elements[dest_idx]))
+        {
+            dest->elements[out_idx--] = dest->elements[dest_idx--];
+        }
+        else
+        {
+            dest->elements[out_idx--] = source->elements[src_idx--];
+        }
+    }
+
+    dest->size += source->size;
+    source->size = 0;
 
     exit_code = E_SUCCESS;
 END:
@@ -427,8 +806,9 @@ int vector_clear(vector_t * vector)
         vector->custom_free(vector->elements[idx]);
     }
 
-    // Reset the size
-    vector->size = 0;
+    // Reset the size, an empty vector is trivially sorted
+    vector->size   = 0;
+    vector->sorted = true;
 
     exit_code = E_SUCCESS;
 END:
@@ -454,7 +834,7 @@ void vector_delete(vector_t ** vector)
     }
 
     // Free the elements array
-    free((*vector)->elements);
+    vector_set_capacity(*vector, 0);
 
     // Free the vector itself
     free(*vector);
@@ -470,10 +850,10 @@ END:
  * NOTE: STATIC FUNCTIONS LISTED BELOW
  ***********************************************************************/
 
-static int vector_resize(vector_t * vector)
+static int vector_resize(vector_t * vector, int min_capacity)
 {
-    int     exit_code     = E_FAILURE;
-    void ** resized_array = NULL;
+    int exit_code    = E_FAILURE;
+    int new_capacity = 0;
 
     if (NULL == vector)
     {
@@ -481,23 +861,155 @@ static int vector_resize(vector_t * vector)
         goto END;
     }
 
-    // Attempt to double the capacity of the array vector
-    resized_array =
-        realloc(vector->elements, (vector->capacity * 2) * (sizeof(void *)));
-    if (NULL == resized_array)
+    new_capacity = vector->capacity;
+    while (new_capacity < min_capacity)
+    {
+        if (MIN_CAPACITY > new_capacity)
+        {
+            new_capacity = MIN_CAPACITY;
+        }
+        else if (GROWTH_THRESHOLD > new_capacity)
+        {
+            new_capacity *= 2;
+        }
+        else if ((INT_MAX - new_capacity / 2) > new_capacity)
+        {
+            new_capacity += new_capacity / 2;
+        }
+        else
+        {
+            new_capacity = min_capacity;
+        }
+    }
+
+    exit_code = vector_set_capacity(vector, new_capacity);
+    if (E_SUCCESS != exit_code)
     {
         print_error("Failed to reallocate array vector.");
         goto END;
     }
 
-    vector->capacity *= 2;
-    vector->elements = resized_array;
+END:
+    return exit_code;
+}
+
+static void vector_maybe_shrink(vector_t * vector)
+{
+    int new_capacity = vector->capacity / 2;
+
+    if ((MIN_CAPACITY > new_capacity) ||
+        (vector->size > (vector->capacity / SHRINK_DIVISOR)))
+    {
+        return;
+    }
+
+    // Failing to shrink is harmless, the vector keeps its current storage
+    (void)vector_set_capacity(vector, new_capacity);
+}
+
+static int vector_set_capacity(vector_t * vector, int new_capacity)
+{
+    int     exit_code  = E_FAILURE;
+    void ** p_storage  = NULL;
+    size_t  new_bytes  = (size_t)new_capacity * sizeof(void *);
+    size_t  old_length = 0;
+    size_t  new_length = 0;
+
+    if (new_capacity < vector->size)
+    {
+        print_error("Capacity smaller than size.");
+        goto END;
+    }
+
+    if (true == vector->mapped)
+    {
+        old_length = vector_map_length(vector->capacity);
+    }
+
+    if (MAP_THRESHOLD <= new_bytes)
+    {
+        new_length = vector_map_length(new_capacity);
+        if (true == vector->mapped)
+        {
+            // Let the kernel move the pages instead of copying them
+            p_storage = mremap(
+                vector->elements, old_length, new_length, MREMAP_MAYMOVE);
+        }
+        else
+        {
+            p_storage = mmap(NULL,
+                             new_length,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS,
+                             -1,
+                             0);
+            if (MAP_FAILED != p_storage)
+            {
+                memcpy(p_storage,
+                       vector->elements,
+                       (size_t)vector->size * sizeof(void *));
+                free(vector->elements);
+            }
+        }
+
+        if (MAP_FAILED == p_storage)
+        {
+            print_strerror("vector_set_capacity(): Unable to map storage.");
+            goto END;
+        }
+
+        // Use the whole last page
+        new_capacity   = (int)(new_length / sizeof(void *));
+        vector->mapped = true;
+    }
+    else if (true == vector->mapped)
+    {
+        if (0 != new_capacity)
+        {
+            p_storage = malloc(new_bytes);
+            if (NULL == p_storage)
+            {
+                print_error("CMR failure.");
+                goto END;
+            }
+            memcpy(p_storage,
+                   vector->elements,
+                   (size_t)vector->size * sizeof(void *));
+        }
+
+        munmap(vector->elements, old_length);
+        vector->mapped = false;
+    }
+    else if (0 == new_capacity)
+    {
+        free(vector->elements);
+    }
+    else
+    {
+        p_storage = realloc(vector->elements, new_bytes);
+        if (NULL == p_storage)
+        {
+            print_error("CMR failure.");
+            goto END;
+        }
+    }
+
+    vector->elements = p_storage;
+    vector->capacity = new_capacity;
 
     exit_code = E_SUCCESS;
 END:
     return exit_code;
 }
 
+static size_t vector_map_length(int capacity)
+{
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t bytes     = (size_t)capacity * sizeof(void *);
+
+    return ((bytes + page_size - 1) / page_size) * page_size;
+}
+
 static int vector_shift_elements(vector_t * vector, int index, int direction)
 {
     int     exit_code         = E_FAILURE;
@@ -581,4 +1093,9 @@ static int vector_shift_elements_left(vector_t * vector, int index)
     exit_code = E_SUCCESS;
 END:
     return exit_code;
-}
\ No newline at end of file
+}
+
+static bool vector_less(vector_t * vector, void * lhs, void * rhs)
+{
+    return LESS_THAN == vector->compare_func(lhs, rhs);
+}
@@ -1,6 +1,7 @@
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include "queue.h"
@@ -47,6 +48,31 @@ threadpool_t *threadpool_create(size_t thread_count);
  */
 int threadpool_shutdown(threadpool_t *pool_p);
 
+/**
+ * @brief Sets whether the threads keep running queued jobs once a signal is
+ * caught. By default each thread stops after its current job, dropping what
+ * is queued. When draining, the threads run until threadpool_shutdown(), which
+ * still finishes the work that has already been accepted.
+ *
+ * @param pool_p A valid threadpool instance
+ * @param drain true to keep running jobs after a signal
+ *
+ * @return SUCCESS: SUCCESS
+ *         FAILURE: ERROR
+ */
+int threadpool_set_drain(threadpool_t *pool_p, bool drain);
+
+/**
+ * @brief Waits until no job is queued or running.
+ *
+ * @param pool_p A valid threadpool instance
+ * @param timeout_ms The longest time to wait, in milliseconds
+ *
+ * @return SUCCESS: SUCCESS once the pool is idle
+ *         FAILURE: ERROR, including when the time runs out first
+ */
+int threadpool_wait_idle(threadpool_t *pool_p, unsigned int timeout_ms);
+
 /**
  * @brief Destroy a threadpool. Clean up all resources and memory.
  *
@@ -65,7 +91,8 @@ int threadpool_destroy(threadpool_t **pool_pp);
  * @param job The job to be executed by the pool.
  * @param del_f A user defined function to free and clean up arg_p, if not
  * required, set to NULL. Internal structure of arg will be known to the del_f,
- * and it must safely handle NULL inputs.
+ * and it must safely handle NULL inputs. It is called after the job runs, or
+ * when the pool is destroyed with the job still queued.
  * @param arg_p The argument(s) required by the job, if any. Internal structure
  * of arg will be known to the job.
  *
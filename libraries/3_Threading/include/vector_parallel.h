@@ -0,0 +1,91 @@
+#ifndef VECTOR_PARALLEL_H
+#define VECTOR_PARALLEL_H
+
+#include <stdlib.h>
+
+#include "threadpool.h"
+#include "vector.h"
+
+#define VECTOR_PARALLEL_THRESHOLD  65536 // Smaller vectors are sorted inline
+#define VECTOR_PARALLEL_TASKS      8     // Default number of sort tasks
+#define VECTOR_PARALLEL_MAX_TASKS  64    // Upper bound on sort tasks per call
+#define VECTOR_PARALLEL_GRAIN      4096  // Default elements per chunk
+#define VECTOR_PARALLEL_MAX_CHUNKS 1024  // Upper bound on chunks per call
+
+/**
+ * @brief A function that maps one element to a new data pointer.
+ */
+typedef void * (*MAP_F)(void * data);
+
+/**
+ * @brief Sorts a vector with a parallel merge sort on a threadpool.
+ *
+ * The vector is split into 'task_count' runs that are sorted concurrently
+ * with sort_introsort(), then merged pairwise, each round of merges also
+ * running concurrently. The result is the same order vector_sort() would
+ * produce for distinct keys. Vectors below VECTOR_PARALLEL_THRESHOLD
+ * elements are sorted on the calling thread.
+ *
+ * @param pool_p The pool to run the tasks on. Must not be the pool the caller
+ * is running on, since the caller blocks until the tasks finish.
+ * @param vector The vector to sort.
+ * @param task_count Number of runs to split the vector into, 0 for
+ * VECTOR_PARALLEL_TASKS.
+ *
+ * @return SUCCESS: E_SUCCESS
+ *         FAILURE: E_FAILURE
+ */
+int vector_sort_parallel(threadpool_t * pool_p,
+                         vector_t *     vector,
+                         size_t         task_count);
+
+/**
+ * @brief Applies 'action_function' to every element, splitting the vector
+ * into chunks that run concurrently on a threadpool. Blocks until every
+ * chunk has finished. Elements are visited in no particular order.
+ *
+ * @param vector The vector to iterate over.
+ * @param pool_p The pool to run the chunks on. Must not be the pool the
+ * caller is running on.
+ * @param action_function Function called on each element. Must be safe to
+ * call concurrently on different elements.
+ * @param grain Minimum number of elements per chunk, 0 for
+ * VECTOR_PARALLEL_GRAIN. Raised if it would produce more than
+ * VECTOR_PARALLEL_MAX_CHUNKS chunks.
+ *
+ * @return SUCCESS: E_SUCCESS
+ *         FAILURE: E_FAILURE
+ */
+int vector_iterate_parallel(vector_t *     vector,
+                            threadpool_t * pool_p,
+                            ACT_F          action_function,
+                            size_t         grain);
+
+/**
+ * @brief Stores map_function(element) at the same index of 'output' for
+ * every element of 'vector', running chunks concurrently on a threadpool.
+ * Blocks until every chunk has finished, then sets the size of 'output' to
+ * the size of 'vector'.
+ *
+ * @param vector The vector to map.
+ * @param output A vector with a capacity of at least vector->size. Any
+ * elements already in it are overwritten without being freed.
+ * @param pool_p The pool to run the chunks on. Must not be the pool the
+ * caller is running on.
+ * @param map_function Function returning the result for one element. Must be
+ * safe to call concurrently on different elements.
+ * @param grain Minimum number of elements per chunk, as for
+ * vector_iterate_parallel().
+ *
+ * @return SUCCESS: E_SUCCESS
+ *         FAILURE: E_FAILURE
+ */
+int vector_map_parallel(vector_t *     vector,
+                        vector_t *     output,
+                        threadpool_t * pool_p,
+                        MAP_F          map_function,
+                        size_t         grain);
+
+#endif
+
+/*** end of file ***/
@@ -1,6 +1,8 @@
+#include <errno.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "signal_handler.h"
@@ -13,6 +15,9 @@
 #define EMPTY              0    // Work queue is empty
 #define NOT_EMPTY          1    // Work queue is not empty
 #define KEEP_RUNNING       0    // Default signal for the signal handler
+#define MS_PER_SEC         1000L
+#define NS_PER_MS          1000000L
+#define NS_PER_SEC         1000000000L
 
 /**
  * @brief A struct for a job
@@ -37,9 +42,13 @@ typedef struct threadpool
     pthread_t *     threads;      // The thread list
     pthread_mutex_t mutex;        // The mutex for a queue
     pthread_cond_t  condition;    // Used for signaling threads
+    pthread_cond_t  idle;         // Signaled when no job is queued or running
+    size_t          running;      // The number of jobs being run
+    bool            drain;        // Keep running jobs after a signal
     bool work_mutex_initialized;  // States if work mutex has been initialized
     bool queue_mutex_initialized; // States if queue mutex has been initialized
     bool condition_initialized;   // States if condition has been initialized
+    bool idle_initialized;        // States if idle condition is initialized
     sig_atomic_t signal;          // A shutdown signal for the threadpool ON/OFF
 } threadpool_t;
 
@@ -86,6 +95,14 @@ static job_t * create_job(JOB_F job, FREE_F del_f, void * arg_p);
  */
 static int wait_for_job(threadpool_t * threadpool_p);
 
+/**
+ * @brief Checks whether a caught signal should stop the threads.
+ *
+ * @param threadpool_p The threadpool to check, with its mutex held
+ * @return bool Returns true if the threads should stop
+ */
+static bool signal_caught(threadpool_t * threadpool_p);
+
 /**
  * @brief Gets the next job from a job queue.
  *
@@ -106,6 +123,13 @@ static int get_next_job(threadpool_t ** threadpool_p,
  */
 static int process_job(job_t * job_p);
 
+/**
+ * @brief Frees a job that was never run, calling its delete function first.
+ *
+ * @param job_p The job to free
+ */
+static void drop_job(void * job_p);
+
 threadpool_t * threadpool_create(size_t thread_count)
 {
     threadpool_t * threadpool_p = NULL;
@@ -196,6 +220,64 @@ END:
     return exit_code;
 }
 
+int threadpool_set_drain(threadpool_t * pool_p, bool drain)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == pool_p)
+    {
+        print_error("threadpool_set_drain(): NULL threadpool passed.");
+        goto END;
+    }
+
+    pthread_mutex_lock(&pool_p->mutex);
+    pool_p->drain = drain;
+    pthread_mutex_unlock(&pool_p->mutex);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int threadpool_wait_idle(threadpool_t * pool_p, unsigned int timeout_ms)
+{
+    int             exit_code = E_FAILURE;
+    struct timespec deadline  = { 0 };
+
+    if (NULL == pool_p)
+    {
+        print_error("threadpool_wait_idle(): NULL threadpool passed.");
+        goto END;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t)(timeout_ms / MS_PER_SEC);
+    deadline.tv_nsec += (long)(timeout_ms % MS_PER_SEC) * NS_PER_MS;
+    if (NS_PER_SEC <= deadline.tv_nsec)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= NS_PER_SEC;
+    }
+
+    pthread_mutex_lock(&pool_p->mutex);
+    while ((0 != pool_p->running) ||
+           (EMPTY != queue_emptycheck(pool_p->job_queue)))
+    {
+        if (ETIMEDOUT ==
+            pthread_cond_timedwait(&pool_p->idle, &pool_p->mutex, &deadline))
+        {
+            print_error("threadpool_wait_idle(): Timed out.");
+            pthread_mutex_unlock(&pool_p->mutex);
+            goto END;
+        }
+    }
+    pthread_mutex_unlock(&pool_p->mutex);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
 int threadpool_destroy(threadpool_t ** pool_pp)
 {
     int exit_code = E_FAILURE;
@@ -272,7 +354,8 @@ END:
 
 static int threadpool_setup(threadpool_t * threadpool_p, size_t thread_count)
 {
-    int exit_code = E_FAILURE;
+    int                exit_code  = E_FAILURE;
+    pthread_condattr_t attributes = { 0 };
 
     if (NULL == threadpool_p)
     {
@@ -298,15 +381,27 @@ static int threadpool_setup(threadpool_t * threadpool_p, size_t thread_count)
     }
     threadpool_p->condition_initialized = true;
 
-    // 3. Setup the job queue
-    threadpool_p->job_queue = queue_init(QUEUE_MAX_CAPACITY, NULL);
+    // 3. Setup the idle condition, timed against the monotonic clock
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    exit_code = pthread_cond_init(&threadpool_p->idle, &attributes);
+    pthread_condattr_destroy(&attributes);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("threadpool_create(): Unable to initialize idle cond.");
+        goto END;
+    }
+    threadpool_p->idle_initialized = true;
+
+    // 4. Setup the job queue, which drops any job left in it when destroyed
+    threadpool_p->job_queue = queue_init(QUEUE_MAX_CAPACITY, drop_job);
     if (NULL == threadpool_p->job_queue)
     {
         print_error("threadpool_create(): Unable to initialize queue.");
         goto END;
     }
 
-    // 4. Allocate memory for threads
+    // 5. Allocate memory for threads
     threadpool_p->threads = calloc(thread_count, sizeof(pthread_t));
     if (NULL == threadpool_p->threads)
     {
@@ -339,7 +434,7 @@ static void * start_thread(void * pool_p)
     {
         pthread_mutex_lock(&threadpool_p->mutex);
 
-        if (KEEP_RUNNING != signal_flag_g)
+        if (signal_caught(threadpool_p))
         {
             print_error("start_thread(): Signal caught.");
             pthread_mutex_unlock(&threadpool_p->mutex);
@@ -359,9 +454,20 @@ static void * start_thread(void * pool_p)
             goto END;
         }
 
+        threadpool_p->running++;
         pthread_mutex_unlock(&threadpool_p->mutex);
 
         exit_code = process_job(job_p);
+
+        pthread_mutex_lock(&threadpool_p->mutex);
+        threadpool_p->running--;
+        if ((0 == threadpool_p->running) &&
+            (EMPTY == queue_emptycheck(threadpool_p->job_queue)))
+        {
+            pthread_cond_broadcast(&threadpool_p->idle);
+        }
+        pthread_mutex_unlock(&threadpool_p->mutex);
+
         if (E_SUCCESS != exit_code)
         {
             print_error("start_thread(): Unable to execute job.");
@@ -414,7 +520,7 @@ static int wait_for_job(threadpool_t * threadpool_p)
     while ((EMPTY == queue_emptycheck(threadpool_p->job_queue)) &&
            (SHUTDOWN != threadpool_p->signal))
     {
-        if (KEEP_RUNNING != signal_flag_g)
+        if (signal_caught(threadpool_p))
         {
             print_error("wait_for_job(): Signal caught.");
             goto END;
@@ -434,6 +540,11 @@ END:
     return exit_code;
 }
 
+static bool signal_caught(threadpool_t * threadpool_p)
+{
+    return (KEEP_RUNNING != signal_flag_g) && (!threadpool_p->drain);
+}
+
 static int get_next_job(threadpool_t ** threadpool_p,
                         queue_node_t ** node_p,
                         job_t **        job_p)
@@ -498,6 +609,18 @@ END:
     return exit_code;
 }
 
+static void drop_job(void * job_p)
+{
+    job_t * dropped_p = job_p;
+
+    if (NULL != dropped_p->del_f)
+    {
+        dropped_p->del_f(dropped_p->args_p);
+    }
+
+    free(dropped_p);
+}
+
 static void threadpool_teardown(threadpool_t ** threadpool_pp)
 {
     if ((NULL == threadpool_pp) || (NULL == *threadpool_pp))
@@ -524,7 +647,13 @@ static void threadpool_teardown(threadpool_t ** threadpool_pp)
         pthread_cond_destroy(&(*threadpool_pp)->condition);
     }
 
-    // 4. Destroy the mutex
+    // 4. Destroy the idle condition
+    if (true == (*threadpool_pp)->idle_initialized)
+    {
+        pthread_cond_destroy(&(*threadpool_pp)->idle);
+    }
+
+    // 5. Destroy the mutex
     if (true == (*threadpool_pp)->work_mutex_initialized)
     {
         pthread_mutex_destroy(&(*threadpool_pp)->mutex);
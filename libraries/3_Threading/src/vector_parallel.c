@@ -0,0 +1,604 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "sort.h"
+#include "utilities.h"
+#include "vector_parallel.h"
+
+/**
+ * @brief A countdown latch the caller waits on until every task is done.
+ *
+ */
+typedef struct latch
+{
+    pthread_mutex_t mutex;     // Protects 'remaining'
+    pthread_cond_t  condition; // Signaled when 'remaining' reaches zero
+    size_t          remaining; // Tasks still running
+} latch_t;
+
+/**
+ * @brief One unit of parallel work over the element range [begin, end):
+ * sorting a run, merging the adjacent runs [begin, middle) and [middle, end)
+ * from 'source' into 'dest', or applying a function to each element.
+ *
+ */
+typedef struct vector_task
+{
+    void **   source;       // Elements read by the task
+    void **   dest;         // Merge or map output, unused otherwise
+    size_t    begin;        // First index of the task's range
+    size_t    middle;       // Start of the second run when merging
+    size_t    end;          // One past the last index of the range
+    CMP_F     compare_func; // The vector's compare function, for sorting
+    ACT_F     action_func;  // Function applied by iterate tasks
+    MAP_F     map_func;     // Function applied by map tasks
+    int       result;       // E_SUCCESS or E_FAILURE
+} vector_task_t;
+
+/**
+ * @brief The tasks of one run_tasks() call. Pool jobs and the caller claim
+ * tasks from it until none are left, so tasks the pool never gets to are run
+ * by the caller. Jobs still queued once every task is done keep the batch
+ * alive through their reference, which the pool drops once they run or are
+ * discarded.
+ *
+ */
+typedef struct task_batch
+{
+    JOB_F           job;        // Run on each task
+    vector_task_t * tasks;      // Owned by the caller, valid until 'latch'
+    size_t          count;      // Number of tasks
+    size_t          next;       // Next task to claim
+    size_t          references; // The caller and every queued job
+    latch_t         latch;      // Counted down once per finished task
+} task_batch_t;
+
+/**
+ * @brief Initializes a latch that opens after 'count' count downs.
+ *
+ * @param latch The latch to initialize
+ * @param count The number of tasks to wait for
+ * @return int Returns 0 on success, -1 on failure
+ */
+static int latch_init(latch_t * latch, size_t count);
+
+/**
+ * @brief Marks one task as finished, waking the waiter after the last one.
+ *
+ * @param latch The latch to count down
+ */
+static void latch_count_down(latch_t * latch);
+
+/**
+ * @brief Blocks until every task has counted the latch down, then releases
+ * its resources.
+ *
+ * @param latch The latch to wait on
+ */
+static void latch_wait(latch_t * latch);
+
+/**
+ * @brief Job that sorts one run of the vector in place.
+ *
+ * @param arg_p The vector_task_t describing the run
+ * @return void * Always NULL
+ */
+static void * sort_run_job(void * arg_p);
+
+/**
+ * @brief Job that merges two adjacent runs into the other buffer.
+ *
+ * @param arg_p The vector_task_t describing the runs
+ * @return void * Always NULL
+ */
+static void * merge_runs_job(void * arg_p);
+
+/**
+ * @brief Job that applies the action function to each element of a chunk.
+ *
+ * @param arg_p The vector_task_t describing the chunk
+ * @return void * Always NULL
+ */
+static void * iterate_chunk_job(void * arg_p);
+
+/**
+ * @brief Job that stores the map function's result for each element of a
+ * chunk at the same index of the output.
+ *
+ * @param arg_p The vector_task_t describing the chunk
+ * @return void * Always NULL
+ */
+static void * map_chunk_job(void * arg_p);
+
+/**
+ * @brief Splits [0, size) into chunks of at least 'grain' elements and runs
+ * 'job' on each of them.
+ *
+ * @param pool_p The pool to run the chunks on
+ * @param job The job to run for each chunk
+ * @param template The task every chunk's task is copied from
+ * @param size The number of elements
+ * @param grain The minimum number of elements per chunk, 0 for a default
+ * @return int Returns 0 if every chunk succeeded, -1 otherwise
+ */
+static int run_chunks(threadpool_t *  pool_p,
+                      JOB_F           job,
+                      vector_task_t * template,
+                      size_t          size,
+                      size_t          grain);
+
+/**
+ * @brief Runs 'count' tasks on the pool and waits for all of them. The
+ * calling thread runs tasks too, including every task the pool refuses or
+ * never starts, for example because its threads stopped on a signal.
+ *
+ * @param pool_p The pool to run the tasks on
+ * @param job The job to run for each task
+ * @param tasks The tasks
+ * @param count The number of tasks
+ * @return int Returns 0 if every task succeeded, -1 otherwise
+ */
+static int run_tasks(threadpool_t *  pool_p,
+                     JOB_F           job,
+                     vector_task_t * tasks,
+                     size_t          count);
+
+/**
+ * @brief Runs tasks of a batch until none are left to claim.
+ *
+ * @param batch The batch to claim tasks from
+ */
+static void run_claimed_tasks(task_batch_t * batch);
+
+/**
+ * @brief Pool job that runs tasks of a batch. The pool drops the job's
+ * reference afterwards through release_batch().
+ *
+ * @param arg_p The task_batch_t
+ * @return void * Always NULL
+ */
+static void * run_batch_job(void * arg_p);
+
+/**
+ * @brief Drops a reference to a batch, freeing it with the last one. Also the
+ * delete function of every queued job, so jobs the pool drops release theirs.
+ *
+ * @param batch_p The task_batch_t
+ */
+static void release_batch(void * batch_p);
+
+int vector_sort_parallel(threadpool_t * pool_p,
+                         vector_t *     vector,
+                         size_t         task_count)
+{
+    int           exit_code = E_FAILURE;
+    size_t        size      = 0;
+    size_t        run_count = 0;
+    size_t        merges    = 0;
+    void **       buffer    = NULL;
+    void **       source    = NULL;
+    void **       dest      = NULL;
+    void **       swap      = NULL;
+    size_t        bounds[VECTOR_PARALLEL_MAX_TASKS + 1] = { 0 };
+    vector_task_t tasks[VECTOR_PARALLEL_MAX_TASKS]    = { { 0 } };
+
+    if ((NULL == pool_p) || (NULL == vector))
+    {
+        print_error("vector_sort_parallel(): NULL argument passed.");
+        goto END;
+    }
+
+    size = (size_t)vector->size;
+    if (VECTOR_PARALLEL_THRESHOLD > size)
+    {
+        exit_code = vector_sort(vector);
+        goto END;
+    }
+
+    if (0 == task_count)
+    {
+        task_count = VECTOR_PARALLEL_TASKS;
+    }
+
+    if (VECTOR_PARALLEL_MAX_TASKS < task_count)
+    {
+        task_count = VECTOR_PARALLEL_MAX_TASKS;
+    }
+
+    buffer = malloc(size * sizeof(void *));
+    if (NULL == buffer)
+    {
+        print_error("vector_sort_parallel(): 'buffer' CMR failure.");
+        goto END;
+    }
+
+    // Sort 'task_count' runs of near equal length concurrently
+    run_count = task_count;
+    for (size_t idx = 0; idx <= run_count; idx++)
+    {
+        bounds[idx] = (size * idx) / run_count;
+    }
+
+    for (size_t idx = 0; idx < run_count; idx++)
+    {
+        tasks[idx].source       = vector->elements;
+        tasks[idx].begin        = bounds[idx];
+        tasks[idx].end          = bounds[idx + 1];
+        tasks[idx].compare_func = vector->compare_func;
+    }
+
+    exit_code = run_tasks(pool_p, sort_run_job, tasks, run_count);
+    if (E_SUCCESS != exit_code)
+    {
+        goto END;
+    }
+
+    // Merge adjacent runs pairwise, ping-ponging between the two buffers
+    source = vector->elements;
+    dest   = buffer;
+    while (1 < run_count)
+    {
+        merges = (run_count + 1) / 2;
+        for (size_t idx = 0; idx < merges; idx++)
+        {
+            size_t left = 2 * idx;
+
+            tasks[idx].source       = source;
+            tasks[idx].dest         = dest;
+            tasks[idx].begin        = bounds[left];
+            tasks[idx].middle       = bounds[left + 1];
+            tasks[idx].end          = bounds[left + 1];
+            tasks[idx].compare_func = vector->compare_func;
+            if ((left + 1) < run_count)
+            {
+                tasks[idx].end = bounds[left + 2];
+            }
+        }
+
+        exit_code = run_tasks(pool_p, merge_runs_job, tasks, merges);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+
+        for (size_t idx = 0; idx < merges; idx++)
+        {
+            bounds[idx + 1] = tasks[idx].end;
+        }
+        run_count = merges;
+
+        swap   = source;
+        source = dest;
+        dest   = swap;
+    }
+
+    if (source != vector->elements)
+    {
+        memcpy(vector->elements, source, size * sizeof(void *));
+    }
+    vector->sorted = true;
+
+    exit_code = E_SUCCESS;
+END:
+    free(buffer);
+    return exit_code;
+}
+
+int vector_iterate_parallel(vector_t *     vector,
+                            threadpool_t * pool_p,
+                            ACT_F          action_function,
+                            size_t         grain)
+{
+    int           exit_code = E_FAILURE;
+    vector_task_t template  = { 0 };
+
+    if ((NULL == vector) || (NULL == pool_p) || (NULL == action_function))
+    {
+        print_error("vector_iterate_parallel(): NULL argument passed.");
+        goto END;
+    }
+
+    template.source      = vector->elements;
+    template.action_func = action_function;
+
+    exit_code = run_chunks(
+        pool_p, iterate_chunk_job, &template, (size_t)vector->size, grain);
+
+END:
+    return exit_code;
+}
+
+int vector_map_parallel(vector_t *     vector,
+                        vector_t *     output,
+                        threadpool_t * pool_p,
+                        MAP_F          map_function,
+                        size_t         grain)
+{
+    int           exit_code = E_FAILURE;
+    vector_task_t template  = { 0 };
+
+    if ((NULL == vector) || (NULL == output) || (NULL == pool_p) ||
+        (NULL == map_function))
+    {
+        print_error("vector_map_parallel(): NULL argument passed.");
+        goto END;
+    }
+
+    if (vector->size > output->capacity)
+    {
+        print_error("vector_map_parallel(): Output capacity too small.");
+        goto END;
+    }
+
+    template.source   = vector->elements;
+    template.dest     = output->elements;
+    template.map_func = map_function;
+
+    exit_code = run_chunks(
+        pool_p, map_chunk_job, &template, (size_t)vector->size, grain);
+    if (E_SUCCESS != exit_code)
+    {
+        goto END;
+    }
+
+    output->size   = vector->size;
+    output->sorted = false;
+
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static int latch_init(latch_t * latch, size_t count)
+{
+    int exit_code = E_FAILURE;
+
+    exit_code = pthread_mutex_init(&latch->mutex, NULL);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("latch_init(): Unable to initialize mutex.");
+        goto END;
+    }
+
+    exit_code = pthread_cond_init(&latch->condition, NULL);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("latch_init(): Unable to initialize condition.");
+        pthread_mutex_destroy(&latch->mutex);
+        goto END;
+    }
+
+    latch->remaining = count;
+
+END:
+    return exit_code;
+}
+
+static void latch_count_down(latch_t * latch)
+{
+    pthread_mutex_lock(&latch->mutex);
+    latch->remaining--;
+    if (0 == latch->remaining)
+    {
+        pthread_cond_signal(&latch->condition);
+    }
+    pthread_mutex_unlock(&latch->mutex);
+}
+
+static void latch_wait(latch_t * latch)
+{
+    pthread_mutex_lock(&latch->mutex);
+    while (0 < latch->remaining)
+    {
+        pthread_cond_wait(&latch->condition, &latch->mutex);
+    }
+    pthread_mutex_unlock(&latch->mutex);
+
+    pthread_cond_destroy(&latch->condition);
+    pthread_mutex_destroy(&latch->mutex);
+}
+
+static void * sort_run_job(void * arg_p)
+{
+    vector_task_t * task = arg_p;
+
+    task->result = sort_introsort(task->source + task->begin,
+                                  task->end - task->begin,
+                                  sizeof(void *),
+                                  task->compare_func,
+                                  true);
+
+    return NULL;
+}
+
+static void * merge_runs_job(void * arg_p)
+{
+    vector_task_t * task = arg_p;
+
+    task->result = sort_merge(task->source + task->begin,
+                              task->middle - task->begin,
+                              task->source + task->middle,
+                              task->end - task->middle,
+                              task->dest + task->begin,
+                              sizeof(void *),
+                              task->compare_func,
+                              true);
+
+    return NULL;
+}
+
+static void * iterate_chunk_job(void * arg_p)
+{
+    vector_task_t * task = arg_p;
+
+    for (size_t idx = task->begin; idx < task->end; idx++)
+    {
+        task->action_func(task->source[idx]);
+    }
+
+    task->result = E_SUCCESS;
+    return NULL;
+}
+
+static void * map_chunk_job(void * arg_p)
+{
+    vector_task_t * task = arg_p;
+
+    for (size_t idx = task->begin; idx < task->end; idx++)
+    {
+        task->dest[idx] = task->map_func(task->source[idx]);
+    }
+
+    task->result = E_SUCCESS;
+    return NULL;
+}
+
+static int run_chunks(threadpool_t *  pool_p,
+                      JOB_F           job,
+                      vector_task_t * template,
+                      size_t          size,
+                      size_t          grain)
+{
+    int             exit_code   = E_FAILURE;
+    size_t          chunk_count = 0;
+    vector_task_t * tasks       = NULL;
+
+    if (0 == size)
+    {
+        exit_code = E_SUCCESS;
+        goto END;
+    }
+
+    if (0 == grain)
+    {
+        grain = VECTOR_PARALLEL_GRAIN;
+    }
+
+    // Coarsen the grain rather than queue an unbounded number of chunks
+    chunk_count = (size + grain - 1) / grain;
+    if (VECTOR_PARALLEL_MAX_CHUNKS < chunk_count)
+    {
+        chunk_count = VECTOR_PARALLEL_MAX_CHUNKS;
+    }
+
+    tasks = calloc(chunk_count, sizeof(vector_task_t));
+    if (NULL == tasks)
+    {
+        print_error("run_chunks(): 'tasks' CMR failure.");
+        goto END;
+    }
+
+    for (size_t idx = 0; idx < chunk_count; idx++)
+    {
+        tasks[idx]       = *template;
+        tasks[idx].begin = (size * idx) / chunk_count;
+        tasks[idx].end   = (size * (idx + 1)) / chunk_count;
+    }
+
+    exit_code = run_tasks(pool_p, job, tasks, chunk_count);
+
+END:
+    free(tasks);
+    return exit_code;
+}
+
+static int run_tasks(threadpool_t *  pool_p,
+                     JOB_F           job,
+                     vector_task_t * tasks,
+                     size_t          count)
+{
+    int            exit_code = E_FAILURE;
+    task_batch_t * batch     = NULL;
+
+    batch = calloc(1, sizeof(task_batch_t));
+    if (NULL == batch)
+    {
+        print_error("run_tasks(): 'batch' CMR failure.");
+        goto END;
+    }
+
+    exit_code = latch_init(&batch->latch, count);
+    if (E_SUCCESS != exit_code)
+    {
+        free(batch);
+        goto END;
+    }
+
+    batch->job        = job;
+    batch->tasks      = tasks;
+    batch->count      = count;
+    batch->references = 1;
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        tasks[idx].result = E_FAILURE;
+    }
+
+    // One job per task at most, a refused job leaves its share to the caller
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        __atomic_add_fetch(&batch->references, 1, __ATOMIC_RELAXED);
+        if (E_SUCCESS !=
+            threadpool_add_job(pool_p, run_batch_job, release_batch, batch))
+        {
+            __atomic_sub_fetch(&batch->references, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+
+    // Only tasks a pool thread has started are waited for
+    run_claimed_tasks(batch);
+    latch_wait(&batch->latch);
+    release_batch(batch);
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        if (E_SUCCESS != tasks[idx].result)
+        {
+            print_error("run_tasks(): A task failed.");
+            exit_code = E_FAILURE;
+            goto END;
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static void run_claimed_tasks(task_batch_t * batch)
+{
+    size_t idx = 0;
+
+    for (;;)
+    {
+        idx = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED);
+        if (batch->count <= idx)
+        {
+            break;
+        }
+
+        batch->job(&batch->tasks[idx]);
+        latch_count_down(&batch->latch);
+    }
+}
+
+static void * run_batch_job(void * arg_p)
+{
+    run_claimed_tasks(arg_p);
+
+    return NULL;
+}
+
+static void release_batch(void * batch_p)
+{
+    task_batch_t * batch = batch_p;
+
+    if (0 == __atomic_sub_fetch(&batch->references, 1, __ATOMIC_ACQ_REL))
+    {
+        free(batch);
+    }
+}
+
+/*** end of file ***/
@@ -0,0 +1,118 @@
+/**
+ * @file conn_reader.h
+ *
+ * @brief A per-connection read buffer that splits a byte stream into
+ * protocol items.
+ *
+ * The reader refills its buffer with one large recv() whenever an item is
+ * not complete yet, so a protocol made of many small fields costs one system
+ * call per buffer rather than one per field. Items are handed out as views
+ * into the buffer instead of being copied. A view stays valid until the next
+ * read from the same reader, which may move the buffered bytes.
+ *
+ * On a non-blocking socket a read that runs out of data returns
+ * CONN_READER_AGAIN and keeps what it has buffered, so the same call can be
+ * repeated once the socket is readable again. This suits handlers run by the
+ * reactor, which can keep the reader in their connection's user data and
+ * return with keep_alive set. Such a handler should keep reading items until
+ * it gets CONN_READER_AGAIN, as bytes already buffered do not make the socket
+ * readable again.
+ */
+#ifndef _CONN_READER_H
+#define _CONN_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CONN_READER_DEFAULT_CAPACITY (size_t)(64 * 1024) // Buffer size
+#define CONN_READER_CLOSED           1 // Peer closed between two items
+#define CONN_READER_AGAIN            2 // Non-blocking socket has no data yet
+
+typedef struct conn_reader conn_reader_t;
+
+/**
+ * @brief A read-only view of bytes inside a reader's buffer.
+ */
+typedef struct conn_view
+{
+    const uint8_t * data_p;
+    size_t          length;
+} conn_view_t;
+
+/**
+ * @brief Creates a reader for a connected socket.
+ *
+ * @param socket The socket to read from. It is not closed by the reader.
+ * @param capacity Size of the buffer, which bounds the largest item that can
+ * be read, 0 for CONN_READER_DEFAULT_CAPACITY.
+ *
+ * @return Pointer to the reader on success, NULL on failure.
+ */
+conn_reader_t * conn_reader_create(int socket, size_t capacity);
+
+/**
+ * @brief Frees a reader and its buffer.
+ *
+ * @param reader_pp Pointer to the reader pointer, set to NULL.
+ */
+void conn_reader_destroy(conn_reader_t ** reader_pp);
+
+/**
+ * @brief Returns the number of bytes received but not yet read.
+ *
+ * @param reader_p Pointer to the reader.
+ *
+ * @return The number of buffered bytes, 0 for a NULL reader.
+ */
+size_t conn_reader_buffered(conn_reader_t * reader_p);
+
+/**
+ * @brief Reads exactly 'length' bytes.
+ *
+ * @param reader_p Pointer to the reader.
+ * @param length Number of bytes to read, at most the reader's capacity.
+ * @param view_p Set to the bytes read.
+ *
+ * @return E_SUCCESS, CONN_READER_CLOSED, CONN_READER_AGAIN, or E_FAILURE on
+ * error, including the peer closing part way through the item.
+ */
+int conn_read_exact(conn_reader_t * reader_p,
+                    size_t          length,
+                    conn_view_t *   view_p);
+
+/**
+ * @brief Reads up to and including the first occurrence of a delimiter.
+ *
+ * @param reader_p Pointer to the reader.
+ * @param delim_p Pointer to the delimiter bytes.
+ * @param delim_length Length of the delimiter, at least 1.
+ * @param view_p Set to the bytes read, delimiter included.
+ *
+ * @return E_SUCCESS, CONN_READER_CLOSED, CONN_READER_AGAIN, or E_FAILURE on
+ * error, including a full buffer without the delimiter.
+ */
+int conn_read_until(conn_reader_t * reader_p,
+                    const void *    delim_p,
+                    size_t          delim_length,
+                    conn_view_t *   view_p);
+
+/**
+ * @brief Reads a frame made of a big-endian length followed by that many
+ * bytes.
+ *
+ * @param reader_p Pointer to the reader.
+ * @param prefix_length Size of the length field in bytes: 1, 2, 4 or 8.
+ * @param max_length Largest frame body accepted; longer frames are an error.
+ * @param view_p Set to the frame body, without the length field.
+ *
+ * @return E_SUCCESS, CONN_READER_CLOSED, CONN_READER_AGAIN, or E_FAILURE on
+ * error, including a frame that does not fit the limit or the buffer.
+ */
+int conn_read_frame(conn_reader_t * reader_p,
+                    size_t          prefix_length,
+                    size_t          max_length,
+                    conn_view_t *   view_p);
+
+#endif /* _CONN_READER_H */
+
+/*** end of file ***/
@@ -0,0 +1,117 @@
+/**
+ * @file conn_writer.h
+ *
+ * @brief A per-connection output buffer that gathers small writes and sends
+ * them together.
+ *
+ * Each write is queued rather than sent. Small writes are copied into the
+ * writer's buffer, back to back, and writes made by reference queue the
+ * caller's own memory. The queue goes out in one sendmsg() when the caller
+ * flushes, when the queued bytes reach the threshold, or when the queue runs
+ * out of entries. A handler answering pipelined requests can therefore queue
+ * every reply and flush once when it runs out of requests, instead of
+ * sending once per reply.
+ *
+ * The writer can also set TCP_CORK, so the kernel holds back partial
+ * segments across flushes until the cork is removed, and TCP_NODELAY, so the
+ * last small segment of a reply is not held back waiting for an ACK.
+ */
+#ifndef _CONN_WRITER_H
+#define _CONN_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CONN_WRITER_DEFAULT_THRESHOLD (size_t)(64 * 1024) // Flush size
+#define CONN_WRITER_MAX_IOV           64 // Queue entries before a flush
+
+typedef struct conn_writer conn_writer_t;
+
+/**
+ * @brief Creates a writer for a connected socket.
+ *
+ * @param socket The socket to write to. It is not closed by the writer.
+ * @param threshold Number of queued bytes that triggers a flush, which is
+ * also the size of the copy buffer, 0 for CONN_WRITER_DEFAULT_THRESHOLD.
+ *
+ * @return Pointer to the writer on success, NULL on failure.
+ */
+conn_writer_t * conn_writer_create(int socket, size_t threshold);
+
+/**
+ * @brief Frees a writer. Queued bytes that were not flushed are dropped.
+ *
+ * @param writer_pp Pointer to the writer pointer, set to NULL.
+ */
+void conn_writer_destroy(conn_writer_t ** writer_pp);
+
+/**
+ * @brief Returns the number of bytes queued but not yet sent.
+ *
+ * @param writer_p Pointer to the writer.
+ *
+ * @return The number of queued bytes, 0 for a NULL writer.
+ */
+size_t conn_writer_pending(conn_writer_t * writer_p);
+
+/**
+ * @brief Queues a copy of 'length' bytes. Data larger than the copy buffer
+ * is sent straight away, after whatever was queued before it.
+ *
+ * @param writer_p Pointer to the writer.
+ * @param data_p Pointer to the bytes, free to be reused on return.
+ * @param length Number of bytes.
+ *
+ * @return E_SUCCESS on success, E_FAILURE if a flush it caused failed.
+ */
+int conn_write(conn_writer_t * writer_p, const void * data_p, size_t length);
+
+/**
+ * @brief Queues 'length' bytes without copying them.
+ *
+ * @param writer_p Pointer to the writer.
+ * @param data_p Pointer to the bytes, which must stay unchanged until the
+ * next flush returns.
+ * @param length Number of bytes.
+ *
+ * @return E_SUCCESS on success, E_FAILURE if a flush it caused failed.
+ */
+int conn_write_ref(conn_writer_t * writer_p,
+                   const void *    data_p,
+                   size_t          length);
+
+/**
+ * @brief Sends everything queued with as few system calls as possible,
+ * blocking until it has all been handed to the kernel.
+ *
+ * @param writer_p Pointer to the writer.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure. The queue is emptied
+ * either way, as the connection cannot be written to after a failure.
+ */
+int conn_writer_flush(conn_writer_t * writer_p);
+
+/**
+ * @brief Sets or clears TCP_CORK on the socket. Clearing it flushes the
+ * queue first, so the kernel sends the tail at once.
+ *
+ * @param writer_p Pointer to the writer.
+ * @param cork true to hold back partial segments, false to release them.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+int conn_writer_set_cork(conn_writer_t * writer_p, bool cork);
+
+/**
+ * @brief Sets or clears TCP_NODELAY on the socket.
+ *
+ * @param writer_p Pointer to the writer.
+ * @param nodelay true to send small segments without waiting for an ACK.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+int conn_writer_set_nodelay(conn_writer_t * writer_p, bool nodelay);
+
+#endif /* _CONN_WRITER_H */
+
+/*** end of file ***/
@@ -1,18 +1,23 @@
 #ifndef _SOCKET_IO_H
 #define _SOCKET_IO_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 #define MIN_SOCKET 3 // The lowest allowable user-defined socket
-#define MAX_BYTES \
-    (size_t)1400 // Max number of bytes to send or received at once
+#define ZEROCOPY_MIN_BYTES \
+    (size_t)(16 * 1024) // Smaller sends are cheaper to copy than to pin
+#define MAX_PASSED_FDS 253 // Descriptors one message can carry, SCM_MAX_FD
 
 /**
  * @brief Sends the specified number of bytes to a given socket.
  *
  * This function handles sending data over a specified socket. It ensures that
- * the arguments are valid and then utilizes the socket_io function to manage
- * the actual sending of data, processing it in chunks as defined by MAX_BYTES.
+ * the arguments are valid and then hands the kernel everything that is left
+ * on each call, repeating after partial writes and interrupted calls until
+ * every byte has been sent.
  *
  * @param socket The socket descriptor for sending data.
  * @param buffer_p A pointer to the buffer containing the data to send.
@@ -26,9 +31,9 @@ int send_data(int socket, void * buffer_p, size_t bytes_to_send);
  * @brief Receives the specified number of bytes from a given socket.
  *
  * This function handles receiving data over a specified socket. It ensures that
- * the arguments are valid and then utilizes the socket_io function to manage
- * the actual receiving of data, processing it in chunks as defined by
- * MAX_BYTES.
+ * the arguments are valid and then asks the kernel for everything that is
+ * still missing on each call, repeating after partial reads and interrupted
+ * calls until the buffer is full.
  *
  * @param socket The socket descriptor for receiving data.
  * @param buffer_p A pointer to the buffer where the received data will be
@@ -39,4 +44,137 @@ int send_data(int socket, void * buffer_p, size_t bytes_to_send);
  */
 int recv_data(int socket, void * buffer_p, size_t bytes_to_recv);
 
+/**
+ * @brief Sends the contents of several buffers to a given socket, in order,
+ * with as few system calls as the kernel allows.
+ *
+ * Lets a header and a body go out together without first being copied into
+ * one contiguous buffer. The array is advanced in place past the bytes that
+ * have been sent, so its contents are unspecified afterwards.
+ *
+ * @param socket The socket descriptor for sending data.
+ * @param iov_p A pointer to the array of buffers to send.
+ * @param iov_count The number of buffers in the array, at most IOV_MAX.
+ * @return E_SUCCESS on successful completion of the send operation or E_FAILURE
+ * in case of an error.
+ */
+int send_datav(int socket, struct iovec * iov_p, int iov_count);
+
+/**
+ * @brief Fills several buffers from a given socket, in order, with as few
+ * system calls as the kernel allows.
+ *
+ * Every buffer is filled completely. The array is advanced in place past the
+ * bytes that have been received, so its contents are unspecified afterwards.
+ *
+ * @param socket The socket descriptor for receiving data.
+ * @param iov_p A pointer to the array of buffers to fill.
+ * @param iov_count The number of buffers in the array, at most IOV_MAX.
+ * @return E_SUCCESS on successful completion of the receive operation or
+ * E_FAILURE in case of an error.
+ */
+int recv_datav(int socket, struct iovec * iov_p, int iov_count);
+
+/**
+ * @brief Sends part of a file to a given socket without copying it through
+ * user space.
+ *
+ * Regular files go out with sendfile(). Pipes, and files sendfile() refuses,
+ * are moved with splice(), through an intermediate pipe when the source is
+ * not one itself. The file's own offset is left untouched, except for pipes,
+ * which have none and are read from their current position.
+ *
+ * @param socket The socket descriptor for sending data.
+ * @param file_fd The descriptor of the file or pipe to send from.
+ * @param offset The offset in the file of the first byte to send, ignored
+ * for pipes.
+ * @param length The number of bytes to send.
+ * @return E_SUCCESS on successful completion of the send operation or E_FAILURE
+ * in case of an error, including the file ending early.
+ */
+int send_file_range(int socket, int file_fd, off_t offset, size_t length);
+
+/**
+ * @brief Allows MSG_ZEROCOPY sends on a socket. Must be called before
+ * send_data_zerocopy() can avoid copying.
+ *
+ * @param socket The socket descriptor.
+ * @return E_SUCCESS on success or E_FAILURE if the kernel does not support it.
+ */
+int enable_zerocopy(int socket);
+
+/**
+ * @brief Sends a buffer with MSG_ZEROCOPY, so the kernel transmits straight
+ * from the caller's pages instead of copying them.
+ *
+ * The kernel numbers each zero-copy send call on a socket, starting at 0,
+ * and later reports through the socket's error queue which calls it has
+ * finished with. '*next_id_p' holds the number the next call will get; it
+ * starts at 0 for a new socket and is advanced for every call made here. The
+ * buffer must not be changed or freed until reap_zerocopy() reports that
+ * every call up to '*next_id_p' has completed.
+ *
+ * Buffers shorter than ZEROCOPY_MIN_BYTES, and whatever remains once the
+ * kernel runs out of memory for pending notifications, are sent by copying
+ * with send_data() and take no ids.
+ *
+ * @param socket The socket descriptor, with enable_zerocopy() applied.
+ * @param buffer_p A pointer to the buffer containing the data to send.
+ * @param bytes_to_send The total number of bytes to send.
+ * @param next_id_p A pointer to the socket's next completion id.
+ * @return E_SUCCESS on successful completion of the send operation or E_FAILURE
+ * in case of an error.
+ */
+int send_data_zerocopy(int        socket,
+                       void *     buffer_p,
+                       size_t     bytes_to_send,
+                       uint32_t * next_id_p);
+
+/**
+ * @brief Reads every pending zero-copy completion from a socket's error
+ * queue without blocking.
+ *
+ * Completions are reported when the socket polls with POLLERR.
+ *
+ * @param socket The socket descriptor.
+ * @param completed_p A pointer to the number of calls known to be complete,
+ * that is one past the highest completed id. Raised as completions arrive.
+ * @param copied_p Set to true if the kernel had to copy any of the reported
+ * sends after all, which makes zero-copy a loss on this path; may be NULL.
+ * @return The number of completion notifications read, or E_FAILURE on error.
+ */
+int reap_zerocopy(int socket, uint32_t * completed_p, bool * copied_p);
+
+/**
+ * @brief Passes open file descriptors to another process over a Unix domain
+ * socket.
+ *
+ * The descriptors go out as SCM_RIGHTS ancillary data on a single byte of
+ * data. The receiver gets its own descriptors for the same open files, so
+ * the sender may close its copies as soon as this returns.
+ *
+ * @param socket The connected Unix domain socket.
+ * @param fds_p A pointer to the descriptors to pass.
+ * @param fd_count The number of descriptors, 1 to MAX_PASSED_FDS.
+ * @return E_SUCCESS on successful completion of the send operation or E_FAILURE
+ * in case of an error.
+ */
+int send_fds(int socket, const int * fds_p, size_t fd_count);
+
+/**
+ * @brief Receives file descriptors passed with send_fds().
+ *
+ * The descriptors are created close-on-exec. If more arrive than fit in the
+ * array, the kernel closes the rest and the call fails, closing the ones it
+ * did receive.
+ *
+ * @param socket The connected Unix domain socket.
+ * @param fds_p A pointer to the array the descriptors are stored in.
+ * @param max_count The size of the array, 1 to MAX_PASSED_FDS.
+ * @param count_p A pointer set to the number of descriptors received.
+ * @return E_SUCCESS on successful completion of the receive operation or
+ * E_FAILURE in case of an error.
+ */
+int recv_fds(int socket, int * fds_p, size_t max_count, size_t * count_p);
+
 #endif
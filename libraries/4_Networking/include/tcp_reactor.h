@@ -0,0 +1,106 @@
+/**
+ * @file tcp_reactor.h
+ *
+ * @brief An edge-triggered epoll reactor for TCP client connections.
+ *
+ * Client sockets are spread across a small number of I/O threads, each
+ * waiting on its own epoll instance. Sockets are registered with
+ * EPOLLONESHOT, so when one becomes readable it is disarmed and a single job
+ * is queued on the threadpool to run the request handler. Idle connections
+ * therefore cost a file descriptor and a small struct rather than a thread.
+ * After the handler returns, the socket is re-armed if the handler set
+ * client_data_t.keep_alive and closed otherwise.
+ *
+ * With an idle timeout, each I/O thread keeps its armed connections on a
+ * timer wheel and closes those that stay unreadable for longer, so clients
+ * that go quiet do not hold their descriptors and buffers forever.
+ * Connections whose handler is running are not on the wheel.
+ */
+#ifndef _TCP_REACTOR_H
+#define _TCP_REACTOR_H
+
+#include <stdlib.h>
+
+#include "tcp_server.h"
+#include "threadpool.h"
+
+#define TCP_REACTOR_MAX_EVENTS 64  // Default events taken per epoll_wait()
+#define TCP_REACTOR_WAIT_MS    250 // Longest wait before checking for stop
+
+typedef struct tcp_reactor tcp_reactor_t;
+
+/**
+ * @brief Creates a reactor and starts its I/O threads.
+ *
+ * @param threadpool_p The pool request handlers run on. Must outlive the
+ * reactor and must be shut down between tcp_reactor_stop() and
+ * tcp_reactor_destroy().
+ * @param io_threads Number of I/O threads, at least 1.
+ * @param max_events Events taken per epoll_wait() call, 0 for
+ * TCP_REACTOR_MAX_EVENTS.
+ * @param idle_timeout_ms Longest a connection may wait for its next request
+ * before it is closed, 0 for no limit.
+ * @param client_request_handler Called with the connection's client_data_t
+ * each time its socket becomes readable.
+ * @param client_data_free_func Called with the connection's client_data_t
+ * once, just before the connection is closed, may be NULL.
+ *
+ * @return Pointer to the reactor on success, NULL on failure.
+ */
+tcp_reactor_t * tcp_reactor_create(
+    threadpool_t *           threadpool_p,
+    size_t                   io_threads,
+    int                      max_events,
+    unsigned int             idle_timeout_ms,
+    client_request_handler_t client_request_handler,
+    client_data_free_func_t  client_data_free_func);
+
+/**
+ * @brief Hands a connected client socket to the reactor, which owns and
+ * closes it from then on.
+ *
+ * @param reactor_p Pointer to the reactor.
+ * @param client_fd The connected socket, closed on failure as well.
+ * @param user_data_p Stored in the connection's client_data_t.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+int tcp_reactor_add_client(tcp_reactor_t * reactor_p,
+                           int             client_fd,
+                           void *          user_data_p);
+
+/**
+ * @brief Stops and joins the I/O threads. No new requests are dispatched
+ * afterwards, but handlers already queued still run and may re-arm their
+ * connections.
+ *
+ * @param reactor_p Pointer to the reactor.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+int tcp_reactor_stop(tcp_reactor_t * reactor_p);
+
+/**
+ * @brief Shuts down the socket of every open connection, so handlers
+ * blocked reading or writing one return at once. The connections stay open
+ * until their handler finishes or tcp_reactor_destroy() closes them.
+ *
+ * @param reactor_p Pointer to the reactor.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+int tcp_reactor_shutdown_clients(tcp_reactor_t * reactor_p);
+
+/**
+ * @brief Closes every remaining connection and frees the reactor. Stops it
+ * first if tcp_reactor_stop() has not been called.
+ *
+ * @param reactor_pp Pointer to the reactor pointer, set to NULL.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+int tcp_reactor_destroy(tcp_reactor_t ** reactor_pp);
+
+#endif /* _TCP_REACTOR_H */
+
+/*** end of file ***/
@@ -6,11 +6,18 @@
 #ifndef _TCP_SERVER_H
 #define _TCP_SERVER_H
 
+#include <stdbool.h>
+
 #include "threadpool.h"
 
 #define SIG_SHUTDOWN 1
 
-typedef struct config config_t;
+#define TCP_SERVER_DEFAULT_IO_THREADS 1    // Reactor I/O threads by default
+#define TCP_SERVER_RECV_SIZE          4096 // Bytes read per message handler run
+#define TCP_SERVER_DEFAULT_LISTENERS  1    // Listening sockets by default
+
+typedef struct config   config_t;
+typedef struct listener listener_t;
 
 typedef void * (*client_request_handler_t)(void *);
 typedef void (*client_data_free_func_t)(void *);
@@ -29,14 +36,130 @@ typedef struct server
     client_request_handler_t client_request_handler;
     client_data_free_func_t  client_data_free_func;
     config_t *               settings_p;
+    listener_t *             listeners_p;
+    size_t                   listener_count;
+    int                      handoff_socket; // Unix socket, -1 if not used
+    bool                     handed_off;     // Listeners passed to a new server
+    int                      takeover_socket; // Server taken over from, -1
+                                              // once it is acknowledged
+    size_t                   ready_listeners; // Listeners set up and serving
 } server_t;
 
+/**
+ * @brief Data handed to the client request handler.
+ *
+ * 'keep_alive' applies in TCP_SERVER_MODE_REACTOR and to message handlers. It
+ * is false each time the handler is called; a handler that wants to serve
+ * further requests on the same connection sets it to true before returning,
+ * otherwise the connection is closed.
+ */
 typedef struct client_data
 {
     int    client_fd;
     void * user_data_p;
+    bool   keep_alive;
 } client_data_t;
 
+/**
+ * @brief A growable buffer a message handler writes its reply into.
+ */
+typedef struct tcp_reply
+{
+    unsigned char * data_p;
+    size_t          length;
+    size_t          capacity;
+} tcp_reply_t;
+
+/**
+ * @brief A handler that is given the bytes received on a connection instead
+ * of the socket itself, and answers by appending to 'reply_p'.
+ *
+ * Requests arrive as they were read, so one call may hold part of a message
+ * or several messages. 'keep_alive' in 'client_p' works as for the reactor:
+ * it is false on entry and the connection is closed after the reply is sent
+ * unless the handler sets it.
+ */
+typedef void (*tcp_message_handler_t)(client_data_t * client_p,
+                                      const void *    request_p,
+                                      size_t          request_length,
+                                      tcp_reply_t *   reply_p);
+
+/**
+ * @brief How the server runs client request handlers.
+ */
+typedef enum tcp_server_mode
+{
+    // Each connection is handed to a pool thread for its whole life, so the
+    // number of open connections is limited to the number of threads
+    TCP_SERVER_MODE_THREAD_PER_CONNECTION,
+    // Connections are multiplexed on epoll by a few I/O threads and the
+    // handler runs on a pool thread only when a connection is readable
+    TCP_SERVER_MODE_REACTOR,
+    // Accept, receive and send run on io_uring and only message handlers are
+    // dispatched to the pool. Falls back to TCP_SERVER_MODE_REACTOR when the
+    // kernel does not support the io_uring features used
+    TCP_SERVER_MODE_URING,
+} tcp_server_mode_t;
+
+/**
+ * @brief Settings for start_tcp_server_ex(). Initialise with
+ * tcp_server_options_init() before changing individual fields.
+ *
+ * The timeouts close connections whose client stalls, so a slow or silent
+ * client cannot hold a worker or a connection forever; 0 disables each.
+ *  - The read and write timeouts bound each receive and send a handler makes
+ *    on the socket, through SO_RCVTIMEO and SO_SNDTIMEO. A receive or send
+ *    that runs out of time fails with EAGAIN.
+ *  - The idle timeout bounds the wait for the next request. The reactor and
+ *    io_uring modes enforce it with a timer wheel in their event loop. In
+ *    thread per connection mode a handler waiting for the next request
+ *    cannot be told from one reading a request, so receives there wait no
+ *    longer than the shorter of the read and idle timeouts.
+ *  - In TCP_SERVER_MODE_URING handlers do not touch the socket, so the read
+ *    timeout does not apply and the write timeout bounds sending each reply.
+ *
+ * With a drain timeout, a shutdown signal stops accepting and closes the
+ * listening sockets, then lets requests already accepted finish, queued ones
+ * included. Connections whose handler is still running when the timeout runs
+ * out are shut down so it returns. Without one, queued requests are dropped.
+ * In thread per connection mode a handler waiting for the next request on a
+ * kept-alive connection counts as running.
+ *
+ * With a handoff path, a restarted server takes over the listening sockets
+ * of the one running, so no connection is refused in between:
+ *  - On start, the server connects to the Unix socket at the path. If a
+ *    server answers, it receives that server's listening sockets through
+ *    SCM_RIGHTS and keeps their number of listeners, instead of binding.
+ *  - It then binds the path itself, replacing the old server's socket file.
+ *  - Once every listener of the new server is set up, it acknowledges the
+ *    handoff. The server that passed its sockets on then shuts down as on
+ *    SIGINT, draining if it has a drain timeout, while the new one accepts.
+ *  - If the new server fails before acknowledging, the old one keeps serving
+ *    and binds the path again.
+ */
+typedef struct tcp_server_options
+{
+    tcp_server_mode_t mode;           // How handlers are run
+    size_t            worker_threads; // Threads running handlers, at least 2
+    size_t            io_threads;     // Reactor threads per listener
+    int               max_events;     // Reactor events per wait, 0 = default
+    size_t            listeners;      // Sockets sharing the port through
+                                      // SO_REUSEPORT, each with its own
+                                      // acceptor thread, reactor or ring
+    tcp_message_handler_t message_handler; // Used instead of the request
+                                           // handler when set, required for
+                                           // TCP_SERVER_MODE_URING
+    unsigned int read_timeout_ms;  // Longest wait per receive, 0 = none
+    unsigned int write_timeout_ms; // Longest wait per send, 0 = none
+    unsigned int idle_timeout_ms;  // Longest wait between requests, 0 = none
+    int backlog; // Pending connections queued per listener by the kernel,
+                 // 0 = net.core.somaxconn
+    unsigned int drain_timeout_ms; // Time accepted requests get to finish on
+                                   // shutdown, 0 = drop them
+    const char * handoff_path;     // Unix socket listening sockets are passed
+                                   // over on restart, NULL = none
+} tcp_server_options_t;
+
 /**
  * @brief Starts the TCP server and handles incoming client connections.
  *
@@ -64,6 +187,53 @@ int start_tcp_server(char *                   port_p,
                      client_data_free_func_t  client_data_free_func,
                      void *                   user_data_p);
 
+/**
+ * @brief Fills in the default server options: thread per connection mode,
+ * one worker thread per online CPU (at least 2),
+ * TCP_SERVER_DEFAULT_IO_THREADS reactor threads, no timeouts, the system's
+ * largest listen backlog, no draining and no handoff.
+ *
+ * @param options_p Pointer to the options to initialise.
+ */
+void tcp_server_options_init(tcp_server_options_t * options_p);
+
+/**
+ * @brief Appends bytes to a message handler's reply.
+ *
+ * @param reply_p Pointer to the reply.
+ * @param data_p Pointer to the bytes to append.
+ * @param length Number of bytes to append.
+ *
+ * @return Returns E_SUCCESS on success and E_FAILURE on error.
+ */
+int tcp_reply_append(tcp_reply_t * reply_p, const void * data_p, size_t length);
+
+/**
+ * @brief Starts the TCP server with the given options and handles incoming
+ * client connections until a shutdown signal is received.
+ *
+ * In TCP_SERVER_MODE_REACTOR the handler is called once per readable event
+ * rather than once per connection, and should handle the request that is
+ * ready and return. See client_data_t for how to keep the connection open.
+ * The client data free function is called once, when the connection closes.
+ *
+ * @param port_p Pointer to a string representing the port number on which the
+ * server will listen for incoming connections.
+ * @param options_p Pointer to the server options.
+ * @param client_request_handler Function pointer for handling client requests,
+ * may be NULL when options_p->message_handler is set.
+ * @param client_data_free_func Function pointer for freeing client data.
+ * @param user_data_p Pointer to user-defined data that can be passed to each
+ * client handler.
+ *
+ * @return Returns E_SUCCESS on successful execution and E_FAILURE on error.
+ */
+int start_tcp_server_ex(char *                       port_p,
+                        const tcp_server_options_t * options_p,
+                        client_request_handler_t     client_request_handler,
+                        client_data_free_func_t      client_data_free_func,
+                        void *                       user_data_p);
+
 #endif /* _TCP_SERVER_NEW_H */
 
 /*** end of file ***/
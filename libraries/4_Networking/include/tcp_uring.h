@@ -0,0 +1,118 @@
+/**
+ * @file tcp_uring.h
+ *
+ * @brief An io_uring engine for TCP servers whose handlers work on received
+ * bytes rather than on the socket.
+ *
+ * A single thread owns the ring. Connections are taken with one multishot
+ * accept, and each connection keeps one multishot receive armed that draws
+ * its buffers from a ring of provided buffers registered with the kernel, so
+ * neither accepting nor reading costs a system call per event. Received bytes
+ * are handed to a tcp_message_handler_t on the threadpool, one job per
+ * connection at a time, and the reply it builds is sent from the ring. A
+ * reply that ends the connection is sent as a SEND linked to a SHUTDOWN, so
+ * the kernel closes the stream as soon as the last byte is queued. Finished
+ * jobs wake the ring through an eventfd read that is always armed.
+ *
+ * Idle and send timeouts are kept on a timer wheel that the ring thread
+ * checks at every wake. A connection waiting for its next request runs
+ * against the idle timeout and one with a send in flight against the send
+ * timeout; when either expires the socket is shut down, which ends its
+ * receive and any send, and the connection is freed as usual.
+ *
+ * Bytes that arrive while a connection's job runs are held for its next job,
+ * up to TCP_URING_MAX_INPUT; a client that sends more is shut down. An accept
+ * that fails for lack of descriptors or memory is not armed again until a
+ * connection closes or the next tick, so the ring does not spin on the error.
+ *
+ * The kernel interface is used directly through its system calls, so no
+ * library is needed; tcp_uring_supported() checks at runtime that the running
+ * kernel provides every operation the engine relies on.
+ */
+#ifndef _TCP_URING_H
+#define _TCP_URING_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "tcp_server.h"
+#include "threadpool.h"
+
+#define TCP_URING_ENTRIES      256  // Submission queue entries
+#define TCP_URING_CQ_ENTRIES   4096 // Completion queue entries
+#define TCP_URING_BUFFER_COUNT 256  // Provided receive buffers, power of two
+#define TCP_URING_BUFFER_SIZE  4096 // Bytes per provided receive buffer
+#define TCP_URING_TICK_MS      250  // Longest wait before checking for stop
+#define TCP_URING_MAX_INPUT    (size_t)(1024 * 1024) // Held while a job runs
+
+typedef struct tcp_uring tcp_uring_t;
+
+/**
+ * @brief Checks whether the running kernel supports io_uring with multishot
+ * accept and receive, provided buffer rings and linked send and shutdown.
+ *
+ * @return true if tcp_uring_create() can be expected to succeed.
+ */
+bool tcp_uring_supported(void);
+
+/**
+ * @brief Creates the ring, registers its receive buffers and arms accepting
+ * on the listening socket. Must be called from the thread that will call
+ * tcp_uring_run().
+ *
+ * @param listening_socket A bound socket that is already listening. It is
+ * not closed by the engine.
+ * @param threadpool_p The pool message handlers run on. Must outlive the
+ * engine and must be shut down between tcp_uring_run() returning and
+ * tcp_uring_destroy().
+ * @param idle_timeout_ms Longest a connection may wait for its next request
+ * before it is closed, 0 for no limit.
+ * @param write_timeout_ms Longest a reply may take to be sent before the
+ * connection is closed, 0 for no limit.
+ * @param drain_timeout_ms Longest tcp_uring_run() keeps going after a
+ * shutdown signal so requests being handled can send their reply, 0 to
+ * return at once.
+ * @param message_handler Called with the bytes received on a connection.
+ * @param client_data_free_func Called with the connection's client_data_t
+ * once, just before the connection is closed, may be NULL.
+ * @param user_data_p Stored in each connection's client_data_t.
+ *
+ * @return Pointer to the engine on success, NULL on failure.
+ */
+tcp_uring_t * tcp_uring_create(int                     listening_socket,
+                               threadpool_t *          threadpool_p,
+                               unsigned int            idle_timeout_ms,
+                               unsigned int            write_timeout_ms,
+                               unsigned int            drain_timeout_ms,
+                               tcp_message_handler_t   message_handler,
+                               client_data_free_func_t client_data_free_func,
+                               void *                  user_data_p);
+
+/**
+ * @brief Serves connections until a shutdown signal is received or an error
+ * occurs. On shutdown it stops accepting, so another process sharing the
+ * listening socket receives every new connection, and only returns once the
+ * ring no longer accepts on the socket. With a drain timeout it
+ * then answers the request each connection has in progress or on its way,
+ * closing the connection after the reply, and runs until every connection
+ * is closed or the timeout runs out.
+ *
+ * @param uring_p Pointer to the engine.
+ *
+ * @return E_SUCCESS on shutdown, E_FAILURE on error.
+ */
+int tcp_uring_run(tcp_uring_t * uring_p);
+
+/**
+ * @brief Closes every remaining connection, tears down the ring and frees
+ * the engine.
+ *
+ * @param uring_pp Pointer to the engine pointer, set to NULL.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+int tcp_uring_destroy(tcp_uring_t ** uring_pp);
+
+#endif /* _TCP_URING_H */
+
+/*** end of file ***/
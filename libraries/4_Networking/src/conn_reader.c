@@ -0,0 +1,348 @@
+#include <errno.h>      // Access 'errno' global variable
+#include <stdbool.h>    // bool
+#include <stdlib.h>     // calloc(), malloc(), free()
+#include <string.h>     // memmem(), memmove()
+#include <sys/socket.h> // recv()
+
+#include "conn_reader.h"
+#include "socket_io.h"
+#include "utilities.h"
+
+struct conn_reader
+{
+    int       socket;
+    uint8_t * buffer_p;
+    size_t    capacity;
+    size_t    start; // First byte not yet read
+    size_t    end;   // One past the last buffered byte
+};
+
+/**
+ * @brief Receives as much as fits after the buffered bytes, first moving
+ * them to the front of the buffer if the tail is full.
+ *
+ * @param reader_p Pointer to the reader.
+ *
+ * @return E_SUCCESS when bytes arrived, CONN_READER_CLOSED if the peer
+ * closed with nothing buffered, CONN_READER_AGAIN if a non-blocking socket
+ * has no data, or E_FAILURE on error.
+ */
+static int fill(conn_reader_t * reader_p);
+
+/**
+ * @brief Receives until at least 'length' bytes are buffered.
+ *
+ * @param reader_p Pointer to the reader.
+ * @param length Number of bytes needed, at most the reader's capacity.
+ *
+ * @return As for fill().
+ */
+static int fill_to(conn_reader_t * reader_p, size_t length);
+
+/**
+ * @brief Hands out the next 'length' buffered bytes as a view and marks
+ * them read.
+ *
+ * @param reader_p Pointer to the reader.
+ * @param length Number of bytes, no more than are buffered.
+ * @param view_p Set to the bytes.
+ */
+static void take(conn_reader_t * reader_p, size_t length, conn_view_t * view_p);
+
+conn_reader_t * conn_reader_create(int socket, size_t capacity)
+{
+    conn_reader_t * reader_p = NULL;
+
+    if (MIN_SOCKET > socket)
+    {
+        print_error("conn_reader_create(): Invalid socket.");
+        goto END;
+    }
+
+    reader_p = calloc(1, sizeof(conn_reader_t));
+    if (NULL == reader_p)
+    {
+        print_error("conn_reader_create(): reader_p - CMR failure.");
+        goto END;
+    }
+
+    reader_p->socket   = socket;
+    reader_p->capacity = (0 == capacity) ? CONN_READER_DEFAULT_CAPACITY
+                                         : capacity;
+
+    reader_p->buffer_p = malloc(reader_p->capacity);
+    if (NULL == reader_p->buffer_p)
+    {
+        print_error("conn_reader_create(): buffer_p - CMR failure.");
+        free(reader_p);
+        reader_p = NULL;
+    }
+
+END:
+    return reader_p;
+}
+
+void conn_reader_destroy(conn_reader_t ** reader_pp)
+{
+    if ((NULL == reader_pp) || (NULL == *reader_pp))
+    {
+        print_error("conn_reader_destroy(): NULL argument passed.");
+        return;
+    }
+
+    free((*reader_pp)->buffer_p);
+    free(*reader_pp);
+    *reader_pp = NULL;
+}
+
+size_t conn_reader_buffered(conn_reader_t * reader_p)
+{
+    return (NULL == reader_p) ? 0 : reader_p->end - reader_p->start;
+}
+
+int conn_read_exact(conn_reader_t * reader_p,
+                    size_t          length,
+                    conn_view_t *   view_p)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == reader_p) || (NULL == view_p))
+    {
+        print_error("conn_read_exact(): NULL argument passed.");
+        goto END;
+    }
+
+    if (reader_p->capacity < length)
+    {
+        print_error("conn_read_exact(): Length exceeds buffer capacity.");
+        goto END;
+    }
+
+    exit_code = fill_to(reader_p, length);
+    if (E_SUCCESS == exit_code)
+    {
+        take(reader_p, length, view_p);
+    }
+
+END:
+    return exit_code;
+}
+
+int conn_read_until(conn_reader_t * reader_p,
+                    const void *    delim_p,
+                    size_t          delim_length,
+                    conn_view_t *   view_p)
+{
+    int       exit_code = E_FAILURE;
+    size_t    searched  = 0; // Buffered bytes known not to start a match
+    uint8_t * match_p   = NULL;
+
+    if ((NULL == reader_p) || (NULL == delim_p) || (NULL == view_p))
+    {
+        print_error("conn_read_until(): NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 == delim_length) || (reader_p->capacity < delim_length))
+    {
+        print_error("conn_read_until(): Invalid delimiter length.");
+        goto END;
+    }
+
+    for (;;)
+    {
+        match_p = memmem(reader_p->buffer_p + reader_p->start + searched,
+                         reader_p->end - reader_p->start - searched,
+                         delim_p,
+                         delim_length);
+        if (NULL != match_p)
+        {
+            take(reader_p,
+                 (size_t)(match_p - (reader_p->buffer_p + reader_p->start)) +
+                     delim_length,
+                 view_p);
+            exit_code = E_SUCCESS;
+            goto END;
+        }
+
+        // A match may still start in the last delim_length - 1 bytes
+        if ((reader_p->end - reader_p->start) >= delim_length)
+        {
+            searched = reader_p->end - reader_p->start - delim_length + 1;
+        }
+
+        if ((reader_p->end - reader_p->start) == reader_p->capacity)
+        {
+            print_error("conn_read_until(): Delimiter not found in buffer.");
+            exit_code = E_FAILURE;
+            goto END;
+        }
+
+        exit_code = fill(reader_p);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+    }
+
+END:
+    return exit_code;
+}
+
+int conn_read_frame(conn_reader_t * reader_p,
+                    size_t          prefix_length,
+                    size_t          max_length,
+                    conn_view_t *   view_p)
+{
+    int       exit_code = E_FAILURE;
+    uint64_t  length    = 0;
+    uint8_t * prefix_p  = NULL;
+
+    if ((NULL == reader_p) || (NULL == view_p))
+    {
+        print_error("conn_read_frame(): NULL argument passed.");
+        goto END;
+    }
+
+    if ((1 != prefix_length) && (2 != prefix_length) &&
+        (4 != prefix_length) && (8 != prefix_length))
+    {
+        print_error("conn_read_frame(): Invalid prefix length.");
+        goto END;
+    }
+
+    // The prefix is only consumed together with the body, so a read that
+    // has to be repeated starts from the prefix again
+    exit_code = fill_to(reader_p, prefix_length);
+    if (E_SUCCESS != exit_code)
+    {
+        goto END;
+    }
+
+    prefix_p = reader_p->buffer_p + reader_p->start;
+    for (size_t idx = 0; idx < prefix_length; idx++)
+    {
+        length = (length << 8) | prefix_p[idx];
+    }
+
+    if ((max_length < length) ||
+        ((reader_p->capacity - prefix_length) < length))
+    {
+        print_error("conn_read_frame(): Frame too large.");
+        exit_code = E_FAILURE;
+        goto END;
+    }
+
+    exit_code = fill_to(reader_p, prefix_length + (size_t)length);
+    if (CONN_READER_CLOSED == exit_code)
+    {
+        print_error("conn_read_frame(): Connection closed mid-frame.");
+        exit_code = E_FAILURE;
+    }
+
+    if (E_SUCCESS == exit_code)
+    {
+        reader_p->start += prefix_length;
+        take(reader_p, (size_t)length, view_p);
+    }
+
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static int fill(conn_reader_t * reader_p)
+{
+    int     exit_code = E_FAILURE;
+    ssize_t received  = 0;
+    size_t  buffered  = reader_p->end - reader_p->start;
+
+    if (reader_p->capacity == reader_p->end)
+    {
+        memmove(reader_p->buffer_p,
+                reader_p->buffer_p + reader_p->start,
+                buffered);
+        reader_p->start = 0;
+        reader_p->end   = buffered;
+    }
+
+    do
+    {
+        errno    = 0;
+        received = recv(reader_p->socket,
+                        reader_p->buffer_p + reader_p->end,
+                        reader_p->capacity - reader_p->end,
+                        0);
+    } while ((0 > received) && (EINTR == errno));
+
+    if (0 > received)
+    {
+        if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+        {
+            exit_code = CONN_READER_AGAIN;
+            goto END;
+        }
+
+        print_strerror("fill(): recv() failed.");
+        goto END;
+    }
+
+    if (0 == received)
+    {
+        if (0 == buffered)
+        {
+            exit_code = CONN_READER_CLOSED;
+            goto END;
+        }
+
+        print_error("fill(): Connection closed mid-item.");
+        goto END;
+    }
+
+    reader_p->end += (size_t)received;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int fill_to(conn_reader_t * reader_p, size_t length)
+{
+    int exit_code = E_SUCCESS;
+
+    // Make room for the whole item up front, so the fills below never have
+    // to move it again
+    if ((reader_p->capacity - reader_p->start) < length)
+    {
+        memmove(reader_p->buffer_p,
+                reader_p->buffer_p + reader_p->start,
+                reader_p->end - reader_p->start);
+        reader_p->end -= reader_p->start;
+        reader_p->start = 0;
+    }
+
+    while ((E_SUCCESS == exit_code) &&
+           ((reader_p->end - reader_p->start) < length))
+    {
+        exit_code = fill(reader_p);
+    }
+
+    return exit_code;
+}
+
+static void take(conn_reader_t * reader_p, size_t length, conn_view_t * view_p)
+{
+    view_p->data_p = reader_p->buffer_p + reader_p->start;
+    view_p->length = length;
+    reader_p->start += length;
+
+    // An empty buffer starts over at the front, keeping later reads large
+    if (reader_p->start == reader_p->end)
+    {
+        reader_p->start = 0;
+        reader_p->end   = 0;
+    }
+}
+
+/*** end of file ***/
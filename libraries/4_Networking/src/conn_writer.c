@@ -0,0 +1,319 @@
+#include <errno.h>       // Access 'errno' global variable
+#include <netinet/in.h>  // IPPROTO_TCP
+#include <netinet/tcp.h> // TCP_CORK, TCP_NODELAY
+#include <stdint.h>      // uint8_t
+#include <stdlib.h>      // calloc(), malloc(), free()
+#include <string.h>      // memcpy()
+#include <sys/socket.h>  // setsockopt()
+#include <sys/uio.h>     // struct iovec
+
+#include "conn_writer.h"
+#include "socket_io.h"
+#include "utilities.h"
+
+struct conn_writer
+{
+    int          socket;
+    uint8_t *    buffer_p;  // Holds the bytes of copied writes
+    size_t       capacity;  // Size of buffer_p and the flush threshold
+    size_t       used;      // Bytes of buffer_p already queued
+    size_t       pending;   // Bytes queued in total
+    int          iov_count; // Entries of iov in use
+    struct iovec iov[CONN_WRITER_MAX_IOV];
+};
+
+/**
+ * @brief Adds an entry to the queue, flushing first if the queue is full.
+ *
+ * @param writer_p Pointer to the writer.
+ * @param data_p Pointer to the bytes.
+ * @param length Number of bytes.
+ *
+ * @return E_SUCCESS on success, E_FAILURE if the flush failed.
+ */
+static int queue(conn_writer_t * writer_p, const void * data_p, size_t length);
+
+/**
+ * @brief Flushes once the queued bytes reach the writer's threshold.
+ *
+ * @param writer_p Pointer to the writer.
+ *
+ * @return E_SUCCESS on success, E_FAILURE if the flush failed.
+ */
+static int flush_if_full(conn_writer_t * writer_p);
+
+/**
+ * @brief Sets a boolean TCP level option on the writer's socket.
+ *
+ * @param writer_p Pointer to the writer.
+ * @param option The option, TCP_CORK or TCP_NODELAY.
+ * @param enable Whether to set or clear it.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int set_tcp_option(conn_writer_t * writer_p, int option, bool enable);
+
+conn_writer_t * conn_writer_create(int socket, size_t threshold)
+{
+    conn_writer_t * writer_p = NULL;
+
+    if (MIN_SOCKET > socket)
+    {
+        print_error("conn_writer_create(): Invalid socket.");
+        goto END;
+    }
+
+    writer_p = calloc(1, sizeof(conn_writer_t));
+    if (NULL == writer_p)
+    {
+        print_error("conn_writer_create(): writer_p - CMR failure.");
+        goto END;
+    }
+
+    writer_p->socket   = socket;
+    writer_p->capacity = (0 == threshold) ? CONN_WRITER_DEFAULT_THRESHOLD
+                                          : threshold;
+
+    writer_p->buffer_p = malloc(writer_p->capacity);
+    if (NULL == writer_p->buffer_p)
+    {
+        print_error("conn_writer_create(): buffer_p - CMR failure.");
+        free(writer_p);
+        writer_p = NULL;
+    }
+
+END:
+    return writer_p;
+}
+
+void conn_writer_destroy(conn_writer_t ** writer_pp)
+{
+    if ((NULL == writer_pp) || (NULL == *writer_pp))
+    {
+        print_error("conn_writer_destroy(): NULL argument passed.");
+        return;
+    }
+
+    free((*writer_pp)->buffer_p);
+    free(*writer_pp);
+    *writer_pp = NULL;
+}
+
+size_t conn_writer_pending(conn_writer_t * writer_p)
+{
+    return (NULL == writer_p) ? 0 : writer_p->pending;
+}
+
+int conn_write(conn_writer_t * writer_p, const void * data_p, size_t length)
+{
+    int            exit_code = E_FAILURE;
+    struct iovec * last_p    = NULL;
+
+    if ((NULL == writer_p) || (NULL == data_p))
+    {
+        print_error("conn_write(): NULL argument passed.");
+        goto END;
+    }
+
+    // Too big to copy: send it in the same call as what is queued before it
+    if (writer_p->capacity < length)
+    {
+        exit_code = queue(writer_p, data_p, length);
+        if (E_SUCCESS == exit_code)
+        {
+            exit_code = conn_writer_flush(writer_p);
+        }
+
+        goto END;
+    }
+
+    if ((writer_p->capacity - writer_p->used) < length)
+    {
+        if (E_SUCCESS != conn_writer_flush(writer_p))
+        {
+            goto END;
+        }
+    }
+
+    // A copy that follows another copy extends its queue entry
+    if (0 < writer_p->iov_count)
+    {
+        last_p = &writer_p->iov[writer_p->iov_count - 1];
+        if (((uint8_t *)last_p->iov_base + last_p->iov_len) ==
+            (writer_p->buffer_p + writer_p->used))
+        {
+            memcpy(writer_p->buffer_p + writer_p->used, data_p, length);
+            last_p->iov_len += length;
+            writer_p->used += length;
+            writer_p->pending += length;
+            exit_code = flush_if_full(writer_p);
+            goto END;
+        }
+    }
+
+    // Flush a full queue before copying, as flushing starts the buffer over
+    if (CONN_WRITER_MAX_IOV == writer_p->iov_count)
+    {
+        if (E_SUCCESS != conn_writer_flush(writer_p))
+        {
+            goto END;
+        }
+    }
+
+    memcpy(writer_p->buffer_p + writer_p->used, data_p, length);
+    exit_code = queue(writer_p, writer_p->buffer_p + writer_p->used, length);
+    if (E_SUCCESS == exit_code)
+    {
+        writer_p->used += length;
+        exit_code = flush_if_full(writer_p);
+    }
+
+END:
+    return exit_code;
+}
+
+int conn_write_ref(conn_writer_t * writer_p,
+                   const void *    data_p,
+                   size_t          length)
+{
+    int exit_code = E_FAILURE;
+
+    if ((NULL == writer_p) || (NULL == data_p))
+    {
+        print_error("conn_write_ref(): NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = queue(writer_p, data_p, length);
+    if (E_SUCCESS == exit_code)
+    {
+        exit_code = flush_if_full(writer_p);
+    }
+
+END:
+    return exit_code;
+}
+
+int conn_writer_flush(conn_writer_t * writer_p)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == writer_p)
+    {
+        print_error("conn_writer_flush(): NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+    if (0 < writer_p->iov_count)
+    {
+        exit_code =
+            send_datav(writer_p->socket, writer_p->iov, writer_p->iov_count);
+    }
+
+    writer_p->iov_count = 0;
+    writer_p->used      = 0;
+    writer_p->pending   = 0;
+
+END:
+    return exit_code;
+}
+
+int conn_writer_set_cork(conn_writer_t * writer_p, bool cork)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == writer_p)
+    {
+        print_error("conn_writer_set_cork(): NULL argument passed.");
+        goto END;
+    }
+
+    if ((!cork) && (E_SUCCESS != conn_writer_flush(writer_p)))
+    {
+        goto END;
+    }
+
+    exit_code = set_tcp_option(writer_p, TCP_CORK, cork);
+
+END:
+    return exit_code;
+}
+
+int conn_writer_set_nodelay(conn_writer_t * writer_p, bool nodelay)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == writer_p)
+    {
+        print_error("conn_writer_set_nodelay(): NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = set_tcp_option(writer_p, TCP_NODELAY, nodelay);
+
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static int queue(conn_writer_t * writer_p, const void * data_p, size_t length)
+{
+    int exit_code = E_SUCCESS;
+
+    if (0 == length)
+    {
+        goto END;
+    }
+
+    if (CONN_WRITER_MAX_IOV == writer_p->iov_count)
+    {
+        exit_code = conn_writer_flush(writer_p);
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+    }
+
+    // The bytes are only read, the cast is for struct iovec's sake
+    writer_p->iov[writer_p->iov_count].iov_base = (void *)data_p;
+    writer_p->iov[writer_p->iov_count].iov_len  = length;
+    writer_p->iov_count++;
+    writer_p->pending += length;
+
+END:
+    return exit_code;
+}
+
+static int flush_if_full(conn_writer_t * writer_p)
+{
+    int exit_code = E_SUCCESS;
+
+    if (writer_p->capacity <= writer_p->pending)
+    {
+        exit_code = conn_writer_flush(writer_p);
+    }
+
+    return exit_code;
+}
+
+static int set_tcp_option(conn_writer_t * writer_p, int option, bool enable)
+{
+    int exit_code = E_FAILURE;
+    int value     = enable ? 1 : 0;
+
+    errno = 0;
+    if (0 > setsockopt(
+                writer_p->socket, IPPROTO_TCP, option, &value, sizeof(value)))
+    {
+        print_strerror("set_tcp_option(): setsockopt() failed.");
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/*** end of file ***/
@@ -1,6 +1,14 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -8,28 +16,60 @@
 #include "utilities.h"
 
 /**
- * @brief Calculates the chunk size to be processed, based on the remaining
- * bytes and a defined maximum.
+ * @brief Validates the arguments of a vectored transfer and totals the bytes
+ * it covers.
  *
- * This function computes the size of the next chunk to be processed in data
- * transfer. The size will be the lesser of the remaining bytes and the defined
- * maximum (MAX_BYTES).
+ * @param socket The socket descriptor.
+ * @param iov_p A pointer to the array of buffers.
+ * @param iov_count The number of buffers in the array.
+ * @param total_p Receives the number of bytes covered by the buffers.
+ * @return E_SUCCESS if the transfer can go ahead or E_FAILURE otherwise.
+ */
+static int check_iov(int            socket,
+                     struct iovec * iov_p,
+                     int            iov_count,
+                     size_t *       total_p);
+
+/**
+ * @brief Moves a message's buffers past the bytes already transferred,
+ * dropping the buffers that are complete.
+ *
+ * @param message_p A pointer to the message whose buffers are advanced.
+ * @param bytes The number of bytes transferred.
+ */
+static void advance_iov(struct msghdr * message_p, size_t bytes);
+
+/**
+ * @brief Moves bytes from a pipe to a socket with splice().
  *
- * @param bytes_to_process The total number of bytes to process.
- * @param bytes_processed The number of bytes already processed.
- * @return The size of the next chunk to be processed.
+ * @param pipe_fd The read end of the pipe.
+ * @param socket The socket descriptor for sending data.
+ * @param length The number of bytes to move.
+ * @return E_SUCCESS on success or E_FAILURE on error, including the pipe
+ * ending early.
  */
-static size_t calculate_chunk(size_t bytes_to_process, size_t bytes_processed);
+static int splice_to_socket(int pipe_fd, int socket, size_t length);
+
+/**
+ * @brief Moves part of a file to a socket with splice(), through a pipe
+ * created for the transfer.
+ *
+ * @param socket The socket descriptor for sending data.
+ * @param file_fd The descriptor of the file to send from.
+ * @param offset The offset in the file of the first byte to send.
+ * @param length The number of bytes to send.
+ * @return E_SUCCESS on success or E_FAILURE on error, including the file
+ * ending early.
+ */
+static int splice_file(int socket, int file_fd, off_t offset, size_t length);
 
 // Covers [4.1.13] - send()
 // Covers [4.8.1] - Handle partial reads and writes
 int send_data(int socket, void * buffer_p, size_t bytes_to_send)
 {
     int       exit_code        = E_FAILURE;
-    size_t    chunk            = 0;
     ssize_t   byte_result      = 0;
     size_t    total_bytes_sent = 0;
-    uint8_t * byte_buffer      = NULL;
     uint8_t * position         = NULL;
 
     if (NULL == buffer_p)
@@ -52,15 +92,20 @@ int send_data(int socket, void * buffer_p, size_t bytes_to_send)
 
     while (total_bytes_sent < bytes_to_send)
     {
-        // Only allow MAX_BYTES to be sent at a time
-        chunk = calculate_chunk(bytes_to_send, total_bytes_sent);
-
-        byte_buffer = (uint8_t *)buffer_p;
-        position    = byte_buffer + total_bytes_sent;
+        // Offer everything that is left and let the kernel take what fits
+        position = (uint8_t *)buffer_p + total_bytes_sent;
 
-        byte_result = send(socket, position, chunk, 0);
+        errno       = 0;
+        byte_result =
+            send(socket, position, bytes_to_send - total_bytes_sent, 0);
         if (E_FAILURE == byte_result)
         {
+            // A signal arrived before anything was sent, so just retry
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
             print_error("Error sending data.");
             goto END;
         }
@@ -90,10 +135,8 @@ END:
 int recv_data(int socket, void * buffer_p, size_t bytes_to_recv)
 {
     int       exit_code            = E_FAILURE;
-    size_t    chunk                = 0;
     ssize_t   byte_result          = 0;
     size_t    total_bytes_received = 0;
-    uint8_t * byte_buffer          = NULL;
     uint8_t * position             = NULL;
 
     if (NULL == buffer_p)
@@ -116,15 +159,20 @@ int recv_data(int socket, void * buffer_p, size_t bytes_to_recv)
 
     while (total_bytes_received < bytes_to_recv)
     {
-        // Only allow MAX_BYTES to be received at a time
-        chunk = calculate_chunk(bytes_to_recv, total_bytes_received);
-
-        byte_buffer = (uint8_t *)buffer_p;
-        position    = byte_buffer + total_bytes_received;
+        // Ask for everything that is missing and take what has arrived
+        position = (uint8_t *)buffer_p + total_bytes_received;
 
-        byte_result = recv(socket, position, chunk, 0);
+        errno       = 0;
+        byte_result = recv(
+            socket, position, bytes_to_recv - total_bytes_received, 0);
         if (E_FAILURE == byte_result)
         {
+            // A signal arrived before anything was received, so just retry
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
             print_error("Error receiving data.");
             goto END;
         }
@@ -150,19 +198,647 @@ END:
     return exit_code;
 }
 
-static size_t calculate_chunk(size_t bytes_to_process, size_t bytes_processed)
+int send_datav(int socket, struct iovec * iov_p, int iov_count)
+{
+    int           exit_code   = E_FAILURE;
+    ssize_t       byte_result = 0;
+    size_t        remaining   = 0;
+    struct msghdr message     = { 0 };
+
+    if (E_SUCCESS != check_iov(socket, iov_p, iov_count, &remaining))
+    {
+        goto END;
+    }
+
+    message.msg_iov    = iov_p;
+    message.msg_iovlen = (size_t)iov_count;
+
+    while (0 < remaining)
+    {
+        errno       = 0;
+        byte_result = sendmsg(socket, &message, 0);
+        if (E_FAILURE == byte_result)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            print_error("Error sending data.");
+            goto END;
+        }
+
+        if (0 == byte_result)
+        {
+            print_error("Connection closed unexpectedly.");
+            goto END;
+        }
+
+        remaining -= (size_t)byte_result;
+        advance_iov(&message, (size_t)byte_result);
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int recv_datav(int socket, struct iovec * iov_p, int iov_count)
+{
+    int           exit_code   = E_FAILURE;
+    ssize_t       byte_result = 0;
+    size_t        remaining   = 0;
+    struct msghdr message     = { 0 };
+
+    if (E_SUCCESS != check_iov(socket, iov_p, iov_count, &remaining))
+    {
+        goto END;
+    }
+
+    message.msg_iov    = iov_p;
+    message.msg_iovlen = (size_t)iov_count;
+
+    while (0 < remaining)
+    {
+        errno       = 0;
+        byte_result = recvmsg(socket, &message, 0);
+        if (E_FAILURE == byte_result)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            print_error("Error receiving data.");
+            goto END;
+        }
+
+        if (0 == byte_result)
+        {
+            print_error("Connection closed unexpectedly.");
+            goto END;
+        }
+
+        remaining -= (size_t)byte_result;
+        advance_iov(&message, (size_t)byte_result);
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int send_file_range(int socket, int file_fd, off_t offset, size_t length)
+{
+    int         exit_code        = E_FAILURE;
+    ssize_t     byte_result      = 0;
+    size_t      total_bytes_sent = 0;
+    struct stat file_stat        = { 0 };
+
+    if (0 == length)
+    {
+        print_error("Nothing to send.");
+        goto END;
+    }
+
+    if ((MIN_SOCKET > socket) || (0 > file_fd) || (0 > offset))
+    {
+        print_error("Invalid argument passed.");
+        goto END;
+    }
+
+    if (E_FAILURE == fstat(file_fd, &file_stat))
+    {
+        print_error("Unable to stat file.");
+        goto END;
+    }
+
+    if (S_ISFIFO(file_stat.st_mode))
+    {
+        exit_code = splice_to_socket(file_fd, socket, length);
+        goto END;
+    }
+
+    while (total_bytes_sent < length)
+    {
+        // The kernel advances 'offset', the file's own offset is not used
+        errno       = 0;
+        byte_result =
+            sendfile(socket, file_fd, &offset, length - total_bytes_sent);
+        if (E_FAILURE == byte_result)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            // Files that cannot be mapped for sendfile() can still be spliced
+            if (((EINVAL == errno) || (ENOSYS == errno)) &&
+                (0 == total_bytes_sent))
+            {
+                exit_code = splice_file(socket, file_fd, offset, length);
+                goto END;
+            }
+
+            print_error("Error sending file.");
+            goto END;
+        }
+
+        if (0 == byte_result)
+        {
+            print_error("File ended unexpectedly.");
+            goto END;
+        }
+
+        total_bytes_sent += (size_t)byte_result;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int enable_zerocopy(int socket)
+{
+    int exit_code = E_FAILURE;
+    int optval    = 1;
+
+    if (MIN_SOCKET > socket)
+    {
+        print_error("Invalid socket.");
+        goto END;
+    }
+
+    if (E_FAILURE ==
+        setsockopt(socket, SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof(optval)))
+    {
+        print_error("Unable to enable zero-copy sends.");
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int send_data_zerocopy(int        socket,
+                       void *     buffer_p,
+                       size_t     bytes_to_send,
+                       uint32_t * next_id_p)
+{
+    int       exit_code        = E_FAILURE;
+    ssize_t   byte_result      = 0;
+    size_t    total_bytes_sent = 0;
+    uint8_t * position         = NULL;
+
+    if ((NULL == buffer_p) || (NULL == next_id_p))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    // Pinning pages and reading the notification back costs more than
+    // copying a small buffer
+    if (ZEROCOPY_MIN_BYTES > bytes_to_send)
+    {
+        exit_code = send_data(socket, buffer_p, bytes_to_send);
+        goto END;
+    }
+
+    if (MIN_SOCKET > socket)
+    {
+        print_error("Invalid socket.");
+        goto END;
+    }
+
+    while (total_bytes_sent < bytes_to_send)
+    {
+        position = (uint8_t *)buffer_p + total_bytes_sent;
+
+        errno       = 0;
+        byte_result = send(
+            socket, position, bytes_to_send - total_bytes_sent, MSG_ZEROCOPY);
+        if (E_FAILURE == byte_result)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            // Too many notifications are pending, copy the rest instead
+            if (ENOBUFS == errno)
+            {
+                exit_code = send_data(
+                    socket, position, bytes_to_send - total_bytes_sent);
+                goto END;
+            }
+
+            print_error("Error sending data.");
+            goto END;
+        }
+
+        if (0 == byte_result)
+        {
+            print_error("Connection closed unexpectedly.");
+            goto END;
+        }
+
+        (*next_id_p)++;
+        total_bytes_sent += (size_t)byte_result;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int reap_zerocopy(int socket, uint32_t * completed_p, bool * copied_p)
+{
+    int                        count = 0;
+    struct msghdr              message;
+    struct cmsghdr *           cmsg_p  = NULL;
+    struct sock_extended_err * error_p = NULL;
+    uint8_t control[CMSG_SPACE(sizeof(struct sock_extended_err)) +
+                    CMSG_SPACE(sizeof(struct sockaddr_in6))];
+
+    if (NULL == completed_p)
+    {
+        print_error("NULL argument passed.");
+        count = E_FAILURE;
+        goto END;
+    }
+
+    for (;;)
+    {
+        message                = (struct msghdr){ 0 };
+        message.msg_control    = control;
+        message.msg_controllen = sizeof(control);
+
+        errno = 0;
+        if (E_FAILURE == recvmsg(socket, &message, MSG_ERRQUEUE | MSG_DONTWAIT))
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            if ((EAGAIN == errno) || (EWOULDBLOCK == errno))
+            {
+                break; // Queue drained
+            }
+
+            print_error("Error reading completions.");
+            count = E_FAILURE;
+            goto END;
+        }
+
+        for (cmsg_p = CMSG_FIRSTHDR(&message); NULL != cmsg_p;
+             cmsg_p = CMSG_NXTHDR(&message, cmsg_p))
+        {
+            if (!(((SOL_IP == cmsg_p->cmsg_level) &&
+                   (IP_RECVERR == cmsg_p->cmsg_type)) ||
+                  ((SOL_IPV6 == cmsg_p->cmsg_level) &&
+                   (IPV6_RECVERR == cmsg_p->cmsg_type))))
+            {
+                continue;
+            }
+
+            error_p = (struct sock_extended_err *)CMSG_DATA(cmsg_p);
+            if ((0 != error_p->ee_errno) ||
+                (SO_EE_ORIGIN_ZEROCOPY != error_p->ee_origin))
+            {
+                continue;
+            }
+
+            // Each notification covers the ids ee_info to ee_data. Ids wrap,
+            // so compare them by their difference.
+            if (0 < (int32_t)(error_p->ee_data + 1 - *completed_p))
+            {
+                *completed_p = error_p->ee_data + 1;
+            }
+
+            if ((NULL != copied_p) &&
+                (0 != (error_p->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)))
+            {
+                *copied_p = true;
+            }
+
+            count++;
+        }
+    }
+
+END:
+    return count;
+}
+
+int send_fds(int socket, const int * fds_p, size_t fd_count)
+{
+    int              exit_code = E_FAILURE;
+    uint8_t          byte      = 0;
+    struct iovec     iov       = { .iov_base = &byte, .iov_len = 1 };
+    struct msghdr    message   = { 0 };
+    struct cmsghdr * cmsg_p    = NULL;
+    union
+    {
+        struct cmsghdr align; // CMSG_FIRSTHDR() needs it aligned
+        uint8_t        buffer[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)];
+    } control;
+
+    if (NULL == fds_p)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 == fd_count) || (MAX_PASSED_FDS < fd_count))
+    {
+        print_error("Invalid descriptor count.");
+        goto END;
+    }
+
+    message.msg_iov        = &iov;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.buffer;
+    message.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+
+    cmsg_p             = CMSG_FIRSTHDR(&message);
+    cmsg_p->cmsg_level = SOL_SOCKET;
+    cmsg_p->cmsg_type  = SCM_RIGHTS;
+    cmsg_p->cmsg_len   = CMSG_LEN(sizeof(int) * fd_count);
+    memcpy(CMSG_DATA(cmsg_p), fds_p, sizeof(int) * fd_count);
+
+    for (;;)
+    {
+        errno = 0;
+        if (E_FAILURE != sendmsg(socket, &message, MSG_NOSIGNAL))
+        {
+            break;
+        }
+
+        if (EINTR != errno)
+        {
+            print_error("Error passing descriptors.");
+            goto END;
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int recv_fds(int socket, int * fds_p, size_t max_count, size_t * count_p)
+{
+    int              exit_code   = E_FAILURE;
+    ssize_t          byte_result = 0;
+    size_t           received    = 0;
+    uint8_t          byte        = 0;
+    struct iovec     iov         = { .iov_base = &byte, .iov_len = 1 };
+    struct msghdr    message     = { 0 };
+    struct cmsghdr * cmsg_p      = NULL;
+    union
+    {
+        struct cmsghdr align; // CMSG_FIRSTHDR() needs it aligned
+        uint8_t        buffer[CMSG_SPACE(sizeof(int) * MAX_PASSED_FDS)];
+    } control;
+
+    if ((NULL == fds_p) || (NULL == count_p))
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 == max_count) || (MAX_PASSED_FDS < max_count))
+    {
+        print_error("Invalid descriptor count.");
+        goto END;
+    }
+
+    *count_p               = 0;
+    message.msg_iov        = &iov;
+    message.msg_iovlen     = 1;
+    message.msg_control    = control.buffer;
+    message.msg_controllen = CMSG_SPACE(sizeof(int) * max_count);
+
+    do
+    {
+        errno       = 0;
+        byte_result = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+    } while ((E_FAILURE == byte_result) && (EINTR == errno));
+
+    if (E_FAILURE == byte_result)
+    {
+        print_error("Error receiving descriptors.");
+        goto END;
+    }
+
+    if (0 == byte_result)
+    {
+        print_error("Connection closed unexpectedly.");
+        goto END;
+    }
+
+    for (cmsg_p = CMSG_FIRSTHDR(&message); NULL != cmsg_p;
+         cmsg_p = CMSG_NXTHDR(&message, cmsg_p))
+    {
+        if ((SOL_SOCKET == cmsg_p->cmsg_level) &&
+            (SCM_RIGHTS == cmsg_p->cmsg_type))
+        {
+            received = (cmsg_p->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds_p, CMSG_DATA(cmsg_p), sizeof(int) * received);
+            break;
+        }
+    }
+
+    if (0 != (message.msg_flags & MSG_CTRUNC))
+    {
+        print_error("Too many descriptors passed.");
+        for (size_t idx = 0; idx < received; idx++)
+        {
+            close(fds_p[idx]);
+        }
+
+        goto END;
+    }
+
+    if (0 == received)
+    {
+        print_error("No descriptors passed.");
+        goto END;
+    }
+
+    *count_p  = received;
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int check_iov(int            socket,
+                     struct iovec * iov_p,
+                     int            iov_count,
+                     size_t *       total_p)
+{
+    int    exit_code = E_FAILURE;
+    size_t total     = 0;
+
+    if (NULL == iov_p)
+    {
+        print_error("NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 >= iov_count) || (IOV_MAX < iov_count))
+    {
+        print_error("Invalid buffer count.");
+        goto END;
+    }
+
+    if (MIN_SOCKET > socket)
+    {
+        print_error("Invalid socket.");
+        goto END;
+    }
+
+    for (int idx = 0; idx < iov_count; idx++)
+    {
+        if ((NULL == iov_p[idx].iov_base) && (0 != iov_p[idx].iov_len))
+        {
+            print_error("NULL argument passed.");
+            goto END;
+        }
+
+        // The kernel reports the bytes moved as an ssize_t
+        if (iov_p[idx].iov_len > ((size_t)SSIZE_MAX - total))
+        {
+            print_error("Buffers are too large.");
+            goto END;
+        }
+
+        total += iov_p[idx].iov_len;
+    }
+
+    if (0 == total)
+    {
+        print_error("Nothing to transfer.");
+        goto END;
+    }
+
+    *total_p  = total;
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static void advance_iov(struct msghdr * message_p, size_t bytes)
+{
+    while ((0 < message_p->msg_iovlen) &&
+           (bytes >= message_p->msg_iov->iov_len))
+    {
+        bytes -= message_p->msg_iov->iov_len;
+        message_p->msg_iov++;
+        message_p->msg_iovlen--;
+    }
+
+    if (0 != bytes)
+    {
+        message_p->msg_iov->iov_base =
+            (uint8_t *)message_p->msg_iov->iov_base + bytes;
+        message_p->msg_iov->iov_len -= bytes;
+    }
+}
+
+static int splice_to_socket(int pipe_fd, int socket, size_t length)
+{
+    int     exit_code         = E_FAILURE;
+    ssize_t byte_result       = 0;
+    size_t  total_bytes_moved = 0;
+
+    while (total_bytes_moved < length)
+    {
+        errno       = 0;
+        byte_result = splice(
+            pipe_fd, NULL, socket, NULL, length - total_bytes_moved, 0);
+        if (E_FAILURE == byte_result)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            print_error("Error splicing data.");
+            goto END;
+        }
+
+        if (0 == byte_result)
+        {
+            print_error("Pipe ended unexpectedly.");
+            goto END;
+        }
+
+        total_bytes_moved += (size_t)byte_result;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int splice_file(int socket, int file_fd, off_t offset, size_t length)
 {
-    size_t chunk           = 0;
-    size_t bytes_remaining = (bytes_to_process - bytes_processed);
+    int     exit_code         = E_FAILURE;
+    int     pipe_fds[2]       = { -1, -1 };
+    ssize_t byte_result       = 0;
+    size_t  total_bytes_moved = 0;
 
-    if (MAX_BYTES < bytes_remaining)
+    if (E_FAILURE == pipe2(pipe_fds, O_CLOEXEC))
     {
-        chunk = MAX_BYTES;
+        print_error("Unable to create pipe.");
+        goto END;
     }
-    else
+
+    while (total_bytes_moved < length)
+    {
+        // Fill the pipe with as much as it holds, then drain it to the socket
+        errno       = 0;
+        byte_result = splice(file_fd,
+                             &offset,
+                             pipe_fds[1],
+                             NULL,
+                             length - total_bytes_moved,
+                             SPLICE_F_MOVE);
+        if (E_FAILURE == byte_result)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            print_error("Error splicing file.");
+            goto END;
+        }
+
+        if (0 == byte_result)
+        {
+            print_error("File ended unexpectedly.");
+            goto END;
+        }
+
+        if (E_SUCCESS !=
+            splice_to_socket(pipe_fds[0], socket, (size_t)byte_result))
+        {
+            goto END;
+        }
+
+        total_bytes_moved += (size_t)byte_result;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    if (0 <= pipe_fds[0])
     {
-        chunk = bytes_remaining;
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
     }
 
-    return chunk;
+    return exit_code;
 }
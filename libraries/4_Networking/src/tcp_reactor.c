@@ -0,0 +1,586 @@
+#include <errno.h>      // Access 'errno' global variable
+#include <pthread.h>    // pthread_create(), pthread_join()
+#include <stdbool.h>    // bool
+#include <stdio.h>      // printf()
+#include <sys/epoll.h>  // epoll_create1(), epoll_ctl(), epoll_wait()
+#include <sys/socket.h> // shutdown()
+#include <unistd.h>     // close()
+
+#include "intrusive_list.h"
+#include "signal_handler.h"
+#include "slab_pool.h"
+#include "tcp_reactor.h"
+#include "timer_wheel.h"
+#include "utilities.h"
+
+// Client sockets are disarmed after every event and re-armed by the worker
+// that handled it, so at most one handler runs per connection at a time
+#define CLIENT_EVENTS (EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT)
+
+typedef struct io_thread io_thread_t;
+
+/**
+ * @brief State for one client connection.
+ */
+typedef struct tcp_connection
+{
+    client_data_t       client;  // Handed to the request handler
+    intrusive_link_t    link;    // Entry in the owning I/O thread's list
+    io_thread_t *       owner_p; // I/O thread whose epoll set holds the socket
+    timer_wheel_entry_t timer;   // Idle deadline while the socket is armed
+} tcp_connection_t;
+
+/**
+ * @brief An I/O thread and the connections registered with it.
+ */
+struct io_thread
+{
+    pthread_t        thread;
+    int              epoll_fd;
+    bool             started;         // 'thread' was created, not yet joined
+    pthread_mutex_t  mutex;           // Guards the list, timers and pool
+    intrusive_list_t connections;     // Every open connection of this thread
+    timer_wheel_t *  idle_timers;     // Armed connections, NULL if no timeout
+    slab_pool_t *    connection_pool; // Where the connections are allocated
+    tcp_reactor_t *  reactor_p;
+};
+
+struct tcp_reactor
+{
+    io_thread_t *            io_threads;
+    size_t                   io_thread_count;
+    size_t                   next_thread; // Round robin cursor, acceptor only
+    int                      max_events;
+    unsigned int             idle_timeout_ms;
+    int                      running;     // Accessed with __atomic builtins
+    threadpool_t *           threadpool_p;
+    client_request_handler_t client_request_handler;
+    client_data_free_func_t  client_data_free_func;
+};
+
+/**
+ * @brief Waits for events on one I/O thread's epoll set and queues a job
+ * for each readable connection until the reactor is stopped. If the thread
+ * cannot go on, the connections it owns would never be served again, so it
+ * stops the whole server.
+ *
+ * @param args_p Pointer to the io_thread_t.
+ *
+ * @return Always NULL.
+ */
+static void * run_io_thread(void * args_p);
+
+/**
+ * @brief Threadpool job that runs the request handler for one ready
+ * connection, then re-arms or closes it.
+ *
+ * @param args_p Pointer to the tcp_connection_t.
+ *
+ * @return The request handler's return value.
+ */
+static void * serve_connection(void * args_p);
+
+/**
+ * @brief Unregisters, closes and frees a connection, calling the client
+ * data free function first.
+ *
+ * @param connection_p Pointer to the connection.
+ */
+static void close_connection(tcp_connection_t * connection_p);
+
+/**
+ * @brief Starts a connection's idle timer. The owning I/O thread's mutex must
+ * be held and the thread must have a timer wheel.
+ *
+ * @param connection_p Pointer to the connection.
+ */
+static void arm_idle_timer(tcp_connection_t * connection_p);
+
+/**
+ * @brief Closes every connection of an I/O thread whose idle timer expired.
+ *
+ * @param thread_p Pointer to the I/O thread, which must have a timer wheel.
+ */
+static void reap_idle(io_thread_t * thread_p);
+
+tcp_reactor_t * tcp_reactor_create(
+    threadpool_t *           threadpool_p,
+    size_t                   io_threads,
+    int                      max_events,
+    unsigned int             idle_timeout_ms,
+    client_request_handler_t client_request_handler,
+    client_data_free_func_t  client_data_free_func)
+{
+    tcp_reactor_t * reactor_p = NULL;
+    io_thread_t *   thread_p  = NULL;
+
+    if ((NULL == threadpool_p) || (NULL == client_request_handler))
+    {
+        print_error("tcp_reactor_create(): NULL argument passed.");
+        goto END;
+    }
+
+    if ((0 == io_threads) || (0 > max_events))
+    {
+        print_error("tcp_reactor_create(): Invalid thread or event count.");
+        goto END;
+    }
+
+    reactor_p = calloc(1, sizeof(tcp_reactor_t));
+    if (NULL == reactor_p)
+    {
+        print_error("tcp_reactor_create(): reactor_p - CMR failure.");
+        goto END;
+    }
+
+    reactor_p->io_threads = calloc(io_threads, sizeof(io_thread_t));
+    if (NULL == reactor_p->io_threads)
+    {
+        print_error("tcp_reactor_create(): io_threads - CMR failure.");
+        free(reactor_p);
+        reactor_p = NULL;
+        goto END;
+    }
+
+    reactor_p->io_thread_count = io_threads;
+    reactor_p->max_events = (0 == max_events) ? TCP_REACTOR_MAX_EVENTS
+                                              : max_events;
+    reactor_p->idle_timeout_ms        = idle_timeout_ms;
+    reactor_p->running                = true;
+    reactor_p->threadpool_p           = threadpool_p;
+    reactor_p->client_request_handler = client_request_handler;
+    reactor_p->client_data_free_func  = client_data_free_func;
+
+    for (size_t idx = 0; idx < io_threads; idx++)
+    {
+        thread_p            = &reactor_p->io_threads[idx];
+        thread_p->reactor_p = reactor_p;
+        intrusive_list_init(&thread_p->connections);
+        pthread_mutex_init(&thread_p->mutex, NULL);
+
+        errno              = 0;
+        thread_p->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (0 > thread_p->epoll_fd)
+        {
+            print_strerror("tcp_reactor_create(): epoll_create1() failed.");
+            tcp_reactor_destroy(&reactor_p);
+            goto END;
+        }
+
+        thread_p->connection_pool =
+            slab_pool_new(sizeof(tcp_connection_t), 0);
+        if (NULL == thread_p->connection_pool)
+        {
+            print_error("tcp_reactor_create(): Unable to create pool.");
+            tcp_reactor_destroy(&reactor_p);
+            goto END;
+        }
+
+        // Timers tick at the epoll_wait() timeout, the loop's own resolution
+        if (0 != idle_timeout_ms)
+        {
+            thread_p->idle_timers = timer_wheel_new(
+                0, TCP_REACTOR_WAIT_MS, timer_wheel_now_ms());
+            if (NULL == thread_p->idle_timers)
+            {
+                print_error("tcp_reactor_create(): Unable to create timers.");
+                tcp_reactor_destroy(&reactor_p);
+                goto END;
+            }
+        }
+
+        if (E_SUCCESS != pthread_create(
+                             &thread_p->thread, NULL, run_io_thread, thread_p))
+        {
+            print_error("tcp_reactor_create(): Unable to start I/O thread.");
+            tcp_reactor_destroy(&reactor_p);
+            goto END;
+        }
+
+        thread_p->started = true;
+    }
+
+END:
+    return reactor_p;
+}
+
+int tcp_reactor_add_client(tcp_reactor_t * reactor_p,
+                           int             client_fd,
+                           void *          user_data_p)
+{
+    int                exit_code    = E_FAILURE;
+    tcp_connection_t * connection_p = NULL;
+    io_thread_t *      thread_p     = NULL;
+    struct epoll_event event        = { 0 };
+    bool               added        = false;
+
+    if (NULL == reactor_p)
+    {
+        print_error("tcp_reactor_add_client(): NULL argument passed.");
+        close(client_fd);
+        goto END;
+    }
+
+    thread_p = &reactor_p->io_threads[reactor_p->next_thread];
+    reactor_p->next_thread =
+        (reactor_p->next_thread + 1) % reactor_p->io_thread_count;
+
+    // Track the connection before it can fire, so a handler that closes it
+    // straight away always finds it on the list. The idle timer starts with
+    // it and covers the wait for the first request.
+    pthread_mutex_lock(&thread_p->mutex);
+    connection_p = slab_pool_alloc(thread_p->connection_pool);
+    if (NULL == connection_p)
+    {
+        pthread_mutex_unlock(&thread_p->mutex);
+        print_error("tcp_reactor_add_client(): connection_p - CMR failure.");
+        close(client_fd);
+        goto END;
+    }
+
+    connection_p->client.client_fd   = client_fd;
+    connection_p->client.user_data_p = user_data_p;
+    connection_p->owner_p            = thread_p;
+    intrusive_link_init(&connection_p->link);
+    timer_wheel_entry_init(&connection_p->timer);
+
+    event.events   = CLIENT_EVENTS;
+    event.data.ptr = connection_p;
+
+    intrusive_list_push_tail(&thread_p->connections, &connection_p->link);
+    if (NULL != thread_p->idle_timers)
+    {
+        arm_idle_timer(connection_p);
+    }
+
+    errno = 0;
+    added = (0 == epoll_ctl(
+                      thread_p->epoll_fd, EPOLL_CTL_ADD, client_fd, &event));
+    pthread_mutex_unlock(&thread_p->mutex);
+
+    if (!added)
+    {
+        print_strerror("tcp_reactor_add_client(): epoll_ctl() failed.");
+        close_connection(connection_p);
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int tcp_reactor_stop(tcp_reactor_t * reactor_p)
+{
+    int exit_code = E_FAILURE;
+
+    if (NULL == reactor_p)
+    {
+        print_error("tcp_reactor_stop(): NULL argument passed.");
+        goto END;
+    }
+
+    __atomic_store_n(&reactor_p->running, false, __ATOMIC_RELEASE);
+
+    exit_code = E_SUCCESS;
+    for (size_t idx = 0; idx < reactor_p->io_thread_count; idx++)
+    {
+        if (!reactor_p->io_threads[idx].started)
+        {
+            continue;
+        }
+
+        if (E_SUCCESS != pthread_join(reactor_p->io_threads[idx].thread, NULL))
+        {
+            print_error("tcp_reactor_stop(): Unable to join I/O thread.");
+            exit_code = E_FAILURE;
+        }
+
+        reactor_p->io_threads[idx].started = false;
+    }
+
+END:
+    return exit_code;
+}
+
+int tcp_reactor_shutdown_clients(tcp_reactor_t * reactor_p)
+{
+    int                exit_code    = E_FAILURE;
+    io_thread_t *      thread_p     = NULL;
+    intrusive_link_t * link_p       = NULL;
+    intrusive_link_t * next_p       = NULL;
+    tcp_connection_t * connection_p = NULL;
+
+    if (NULL == reactor_p)
+    {
+        print_error("tcp_reactor_shutdown_clients(): NULL argument passed.");
+        goto END;
+    }
+
+    for (size_t idx = 0; idx < reactor_p->io_thread_count; idx++)
+    {
+        thread_p = &reactor_p->io_threads[idx];
+
+        pthread_mutex_lock(&thread_p->mutex);
+        INTRUSIVE_LIST_FOREACH(&thread_p->connections, link_p, next_p)
+        {
+            connection_p = INTRUSIVE_LIST_ENTRY(link_p, tcp_connection_t, link);
+            shutdown(connection_p->client.client_fd, SHUT_RDWR);
+        }
+        pthread_mutex_unlock(&thread_p->mutex);
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int tcp_reactor_destroy(tcp_reactor_t ** reactor_pp)
+{
+    int                exit_code = E_FAILURE;
+    tcp_reactor_t *    reactor_p = NULL;
+    io_thread_t *      thread_p  = NULL;
+    intrusive_link_t * link_p    = NULL;
+
+    if ((NULL == reactor_pp) || (NULL == *reactor_pp))
+    {
+        print_error("tcp_reactor_destroy(): NULL argument passed.");
+        goto END;
+    }
+
+    reactor_p = *reactor_pp;
+    exit_code = tcp_reactor_stop(reactor_p);
+
+    for (size_t idx = 0; idx < reactor_p->io_thread_count; idx++)
+    {
+        thread_p = &reactor_p->io_threads[idx];
+
+        while (NULL !=
+               (link_p = intrusive_list_peek_head(&thread_p->connections)))
+        {
+            close_connection(
+                INTRUSIVE_LIST_ENTRY(link_p, tcp_connection_t, link));
+        }
+
+        if (NULL != thread_p->idle_timers)
+        {
+            timer_wheel_destroy(&thread_p->idle_timers);
+        }
+
+        if (NULL != thread_p->connection_pool)
+        {
+            slab_pool_destroy(&thread_p->connection_pool);
+        }
+
+        if (0 < thread_p->epoll_fd)
+        {
+            close(thread_p->epoll_fd);
+        }
+
+        pthread_mutex_destroy(&thread_p->mutex);
+    }
+
+    free(reactor_p->io_threads);
+    free(reactor_p);
+    *reactor_pp = NULL;
+
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static void * run_io_thread(void * args_p)
+{
+    io_thread_t *        thread_p     = args_p;
+    tcp_reactor_t *      reactor_p    = thread_p->reactor_p;
+    struct epoll_event * events       = NULL;
+    tcp_connection_t *   connection_p = NULL;
+    int                  ready        = 0;
+    int                  exit_code    = E_FAILURE;
+
+    events = calloc((size_t)reactor_p->max_events, sizeof(struct epoll_event));
+    if (NULL == events)
+    {
+        print_error("run_io_thread(): events - CMR failure.");
+        goto END;
+    }
+
+    while (__atomic_load_n(&reactor_p->running, __ATOMIC_ACQUIRE))
+    {
+        errno = 0;
+        ready = epoll_wait(thread_p->epoll_fd,
+                           events,
+                           reactor_p->max_events,
+                           TCP_REACTOR_WAIT_MS);
+        if (0 > ready)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            print_strerror("run_io_thread(): epoll_wait() failed.");
+            goto END;
+        }
+
+        for (int idx = 0; idx < ready; idx++)
+        {
+            connection_p = events[idx].data.ptr;
+
+            // The connection is busy until its handler re-arms it
+            if (NULL != thread_p->idle_timers)
+            {
+                pthread_mutex_lock(&thread_p->mutex);
+                timer_wheel_cancel(thread_p->idle_timers, &connection_p->timer);
+                pthread_mutex_unlock(&thread_p->mutex);
+            }
+
+            // A hang up or error with nothing left to read needs no handler
+            if (0 == (events[idx].events & EPOLLIN))
+            {
+                close_connection(connection_p);
+                continue;
+            }
+
+            if (E_SUCCESS != threadpool_add_job(reactor_p->threadpool_p,
+                                                serve_connection,
+                                                NULL,
+                                                connection_p))
+            {
+                print_error("run_io_thread(): Unable to add job to pool.");
+                close_connection(connection_p);
+            }
+        }
+
+        if (NULL != thread_p->idle_timers)
+        {
+            reap_idle(thread_p);
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("run_io_thread(): I/O thread failed, stopping server.");
+        signal_flag_g = SIGINT;
+    }
+
+    free(events);
+    return NULL;
+}
+
+static void * serve_connection(void * args_p)
+{
+    tcp_connection_t * connection_p = args_p;
+    io_thread_t *      thread_p     = connection_p->owner_p;
+    tcp_reactor_t *    reactor_p    = thread_p->reactor_p;
+    struct epoll_event event        = { 0 };
+    void *             result_p     = NULL;
+    bool               timed        = (NULL != thread_p->idle_timers);
+    bool               rearmed      = false;
+
+    connection_p->client.keep_alive = false;
+    result_p = reactor_p->client_request_handler(&connection_p->client);
+
+    if (connection_p->client.keep_alive)
+    {
+        event.events   = CLIENT_EVENTS;
+        event.data.ptr = connection_p;
+
+        // The timer starts together with the socket being armed, so the I/O
+        // thread cannot reap the connection before this job is done with it
+        if (timed)
+        {
+            pthread_mutex_lock(&thread_p->mutex);
+            arm_idle_timer(connection_p);
+        }
+
+        // Re-arming reports data that arrived while the handler ran
+        errno   = 0;
+        rearmed = (0 == epoll_ctl(thread_p->epoll_fd,
+                                  EPOLL_CTL_MOD,
+                                  connection_p->client.client_fd,
+                                  &event));
+
+        if (timed)
+        {
+            pthread_mutex_unlock(&thread_p->mutex);
+        }
+
+        if (rearmed)
+        {
+            goto END;
+        }
+
+        print_strerror("serve_connection(): epoll_ctl() failed.");
+    }
+
+    close_connection(connection_p);
+
+END:
+    return result_p;
+}
+
+static void close_connection(tcp_connection_t * connection_p)
+{
+    io_thread_t *   thread_p  = connection_p->owner_p;
+    tcp_reactor_t * reactor_p = thread_p->reactor_p;
+
+    if (NULL != reactor_p->client_data_free_func)
+    {
+        reactor_p->client_data_free_func(&connection_p->client);
+    }
+
+    // Unlisted before the socket is closed, so tcp_reactor_shutdown_clients()
+    // never shuts down a descriptor number that has already been reused
+    pthread_mutex_lock(&thread_p->mutex);
+    intrusive_list_remove(&thread_p->connections, &connection_p->link);
+    if (NULL != thread_p->idle_timers)
+    {
+        timer_wheel_cancel(thread_p->idle_timers, &connection_p->timer);
+    }
+    pthread_mutex_unlock(&thread_p->mutex);
+
+    // Closing the socket also removes it from the epoll set, so the
+    // connection is only freed afterwards
+    close(connection_p->client.client_fd);
+
+    pthread_mutex_lock(&thread_p->mutex);
+    slab_pool_free(thread_p->connection_pool, connection_p);
+    pthread_mutex_unlock(&thread_p->mutex);
+}
+
+static void arm_idle_timer(tcp_connection_t * connection_p)
+{
+    io_thread_t * thread_p = connection_p->owner_p;
+
+    timer_wheel_schedule(thread_p->idle_timers,
+                         &connection_p->timer,
+                         timer_wheel_now_ms() +
+                             thread_p->reactor_p->idle_timeout_ms);
+}
+
+static void reap_idle(io_thread_t * thread_p)
+{
+    intrusive_list_t   expired;
+    intrusive_link_t * link_p = NULL;
+
+    intrusive_list_init(&expired);
+
+    pthread_mutex_lock(&thread_p->mutex);
+    (void)timer_wheel_expire(
+        thread_p->idle_timers, timer_wheel_now_ms(), &expired);
+    pthread_mutex_unlock(&thread_p->mutex);
+
+    // Expired connections are armed and idle, so no job holds them and only
+    // this thread could dispatch one
+    while (NULL != (link_p = intrusive_list_pop_head(&expired)))
+    {
+        close_connection(
+            INTRUSIVE_LIST_ENTRY(link_p, tcp_connection_t, timer.link));
+    }
+}
+
+/*** end of file ***/
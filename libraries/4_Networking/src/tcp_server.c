@@ -1,19 +1,31 @@
 #include <arpa/inet.h> // bind(), accept()
 #include <errno.h>     // Access 'errno' global variable
+#include <fcntl.h>     // fcntl()
 #include <netdb.h>     // getaddrinfo() struct
+#include <poll.h>      // poll()
+#include <pthread.h>   // pthread_create(), pthread_join()
 #include <stdio.h>     // printf(), fprintf()
 #include <stdlib.h>    // calloc(), free()
 #include <string.h>    // strerror()
-#include <unistd.h>    // close()
+#include <sys/time.h>  // struct timeval
+#include <sys/un.h>    // struct sockaddr_un
+#include <unistd.h>    // close(), sysconf(), unlink()
 
+#include "intrusive_list.h"
 #include "signal_handler.h"
+#include "slab_pool.h"
 #include "socket_io.h"
+#include "tcp_reactor.h"
 #include "tcp_server.h"
+#include "tcp_uring.h"
 #include "utilities.h"
 
 #define INVALID_SOCKET (-1)         // Indicates an invalid socket descriptor
-#define BACKLOG_SIZE 10             // Maximum number of pending client connections
+#define SOMAXCONN_PATH "/proc/sys/net/core/somaxconn" // Kernel backlog limit
 #define MAX_CLIENT_ADDRESS_SIZE 100 // Size for storing client address strings
+#define MS_PER_SEC 1000             // Milliseconds per second
+#define US_PER_MS 1000              // Microseconds per millisecond
+#define HANDOFF_ACK 0x06 // Sent by a new server once its listeners are set up
 
 /**
  * @struct config
@@ -33,6 +45,61 @@ struct config
     struct sockaddr_storage client_address; // Stores client address
     int client_fd;                          // Socket for accepting connections
     socklen_t client_len;                   // Length of client address structure
+    bool reuse_port;                        // Share the port with SO_REUSEPORT
+    bool inherited;                         // Taken over from a previous server
+};
+
+/**
+ * @brief Lets a tcp_message_handler_t run on the socket based modes.
+ *
+ * A pointer to it stands in for the user data while the server runs, and
+ * serve_messages() and free_message_client() swap the user's data back in
+ * around each call.
+ */
+typedef struct message_adapter
+{
+    tcp_message_handler_t message_handler;
+    client_data_free_func_t client_data_free_func;
+    void *user_data_p;
+    bool loop; // Keep serving while keep_alive is set, thread mode only
+} message_adapter_t;
+
+/**
+ * @brief Everything a thread per connection job needs, allocated as one
+ * object from its listener's pool.
+ */
+typedef struct client_slot
+{
+    tcp_server_job_t job;  // First, so the job pointer is the slot pointer
+    client_data_t client;  // The job's argument
+    listener_t *owner_p;   // Listener whose pool the slot came from
+    intrusive_link_t link; // On the listener's 'clients' until closed
+} client_slot_t;
+
+/**
+ * @struct listener
+ * @brief  One listening socket and the thread accepting on it.
+ *
+ * With more than one listener every socket is bound to the same port with
+ * SO_REUSEPORT and the kernel spreads new connections across them. Each
+ * listener runs the accept loop of the server's mode on its own thread, with
+ * its own reactor or ring, while the threadpool is shared.
+ */
+struct listener
+{
+    config_t config;                       // Socket and accepted client details
+    server_t *server_p;                    // Server the listener belongs to
+    const tcp_server_options_t *options_p; // Options the server started with
+    void *user_data_p;                     // Passed to each handler
+    message_adapter_t *adapter_p;          // Set when serving a message handler
+    tcp_reactor_t *reactor_p;              // Freed after the pool shuts down
+    tcp_uring_t *uring_p;                  // Freed after the pool shuts down
+    slab_pool_t *client_pool_p;            // Thread per connection job slots
+    intrusive_list_t clients;              // Slots of open connections
+    pthread_mutex_t client_pool_mutex;     // Guards the pool and 'clients'
+    pthread_t thread;                      // Acceptor thread, except listener 0
+    bool started;                          // 'thread' was created, not joined
+    int exit_code;                         // Result of the accept loop
 };
 
 /**
@@ -69,21 +136,260 @@ static int configure_server_address(config_t *config_p, char *port_p);
 static int create_listening_socket(config_t *config_p);
 
 /**
- * @brief Accepts a new client connection on the server's listening socket.
+ * @brief Makes a listening socket non-blocking, so pending connections can
+ * be drained without the last accept blocking.
+ *
+ * @param listening_socket The listening socket.
+ *
+ * @return Returns E_SUCCESS on success, or E_FAILURE on error.
+ */
+static int set_nonblocking(int listening_socket);
+
+/**
+ * @brief Waits for connections on the listening socket, giving up after
+ * TCP_REACTOR_WAIT_MS so shutdown signals are noticed promptly.
+ *
+ * @param config_p Pointer to the config_t structure holding the listening
+ *        socket.
+ *
+ * @return Returns E_SUCCESS when connections may be pending or the wait
+ *         timed out, SIG_SHUTDOWN if a shutdown signal is received, or
+ *         E_FAILURE on error.
+ */
+static int wait_for_connection(config_t *config_p);
+
+/**
+ * @brief Accepts one pending client connection on a non-blocking listening
+ * socket.
  *
- * This function waits for a client to connect to the server's listening socket.
  * Upon a successful connection, it stores the client's file descriptor and
- * address information in the provided config_t structure. The function also
- * handles shutdown signals during its wait.
+ * address information in the provided config_t structure. The client socket
+ * is left blocking for the handlers that read and write it directly.
  *
  * @param config_p Pointer to the config_t structure containing the server's
  *        listening socket and client address information.
  *
- * @return Returns E_SUCCESS if a new connection is successfully accepted,
- *         SIG_SHUTDOWN if a shutdown signal is received, or E_FAILURE on error.
+ * @return Returns E_SUCCESS if a new connection is accepted, or E_FAILURE
+ *         when none is pending or accept4() failed.
  */
 static int accept_new_connection(config_t *config_p);
 
+/**
+ * @brief Checks whether a shutdown signal has been received.
+ *
+ * @return Returns true once SIGINT or SIGUSR1 has been received.
+ */
+static bool shutdown_requested(void);
+
+/**
+ * @brief Takes over the listening sockets of a running server through the
+ * Unix socket at the handoff path.
+ *
+ * The connection to the running server is kept open, and it keeps serving
+ * until listener_ready() acknowledges the handoff over it.
+ *
+ * @param path_p The handoff path.
+ * @param fds_p Pointer to an array of MAX_PASSED_FDS sockets to fill in.
+ * @param count_p Set to the number of sockets received.
+ * @param socket_p Set to the connection to the running server.
+ *
+ * @return Returns E_SUCCESS if the sockets were received, or E_FAILURE if no
+ *         server answered or the handoff failed.
+ */
+static int take_over_listeners(const char *path_p,
+                               int *fds_p,
+                               size_t *count_p,
+                               int *socket_p);
+
+/**
+ * @brief Binds and listens on a Unix socket at the handoff path, replacing
+ * whatever file a previous server left there.
+ *
+ * @param path_p The handoff path.
+ *
+ * @return Returns the listening Unix socket, or INVALID_SOCKET on error.
+ */
+static int open_handoff(const char *path_p);
+
+/**
+ * @brief Waits on the handoff socket for a new server and passes it every
+ * listening socket. Once the new server acknowledges, this server shuts down
+ * as on SIGINT; otherwise it keeps serving and binds the handoff path again.
+ *
+ * @param args_p Pointer to the server_t.
+ *
+ * @return Always NULL.
+ */
+static void *serve_handoff(void *args_p);
+
+/**
+ * @brief Waits for a new server to acknowledge that it serves the sockets it
+ * was passed.
+ *
+ * @param new_server The connection to the new server.
+ *
+ * @return Returns E_SUCCESS once acknowledged, or E_FAILURE if the new server
+ *         closed the connection first or a shutdown signal is received.
+ */
+static int wait_for_handoff_ack(int new_server);
+
+/**
+ * @brief Records that a listener is set up and about to serve. Once every
+ * listener is, the server taken over from, if any, is told it may stop.
+ *
+ * @param listener_p Pointer to the listener.
+ */
+static void listener_ready(listener_t *listener_p);
+
+/**
+ * @brief Closes the listening sockets and waits for the requests already
+ * accepted to finish. When the timeout runs out first, the connections still
+ * being served are shut down so their handlers return.
+ *
+ * @param server_p Pointer to the server, with every listener stopped.
+ * @param timeout_ms Longest wait in milliseconds.
+ */
+static void drain_server(server_t *server_p, unsigned int timeout_ms);
+
+/**
+ * @brief Closes the connections of thread per connection jobs that were
+ * dropped from the queue when the pool shut down, calling the client data
+ * free function for each.
+ *
+ * @param listener_p Pointer to the listener, after the pool shut down.
+ */
+static void close_dropped_clients(listener_t *listener_p);
+
+/**
+ * @brief Returns the listen backlog to use when none is configured: the
+ * kernel's limit from SOMAXCONN_PATH, or SOMAXCONN if it cannot be read.
+ *
+ * @return The backlog.
+ */
+static int default_backlog(void);
+
+/**
+ * @brief Applies the read and write timeouts of the options to an accepted
+ * client socket.
+ *
+ * In thread per connection mode the idle timeout also bounds receives, as
+ * there is no event loop to enforce it separately.
+ *
+ * @param client_fd The accepted socket.
+ * @param options_p Pointer to the server options.
+ *
+ * @return Returns E_SUCCESS on success, or E_FAILURE on error.
+ */
+static int set_client_timeouts(int client_fd,
+                               const tcp_server_options_t *options_p);
+
+/**
+ * @brief Runs every listener until a shutdown signal is received or one of
+ * them fails, then shuts the threadpool down and destroys the listeners'
+ * reactors and rings.
+ *
+ * The calling thread serves the first listener and each other listener gets
+ * a thread of its own.
+ *
+ * @param server_p Pointer to the initialized server.
+ *
+ * @return Returns E_SUCCESS if every listener shut down cleanly, or
+ * E_FAILURE if any of them failed.
+ */
+static int run_listeners(server_t *server_p);
+
+/**
+ * @brief Runs the accept loop of the server's mode on one listener and
+ * records its result, stopping the server if the loop failed.
+ *
+ * @param args_p Pointer to the listener_t.
+ *
+ * @return Always NULL.
+ */
+static void *run_listener(void *args_p);
+
+/**
+ * @brief Takes a listener whose accept loop failed out of service. Its socket
+ * stops listening at once, so the kernel hands new connections to the other
+ * listeners, and those are stopped as on SIGINT so the error reaches the
+ * caller.
+ *
+ * @param listener_p Pointer to the failed listener.
+ */
+static void stop_failed_listener(listener_t *listener_p);
+
+/**
+ * @brief Runs the thread per connection accept loop until a shutdown signal
+ * is received or an error occurs.
+ *
+ * The listening socket is made non-blocking and every pending connection is
+ * accepted each time it polls readable. Each accepted connection is handed to
+ * a pool thread, which runs the client request handler once and then closes
+ * the connection. The job and client data come from the listener's pool
+ * rather than from two allocations per connection.
+ *
+ * @param listener_p Pointer to the listener to accept on.
+ *
+ * @return Returns E_SUCCESS on shutdown, or E_FAILURE on error.
+ */
+static int serve_thread_per_connection(listener_t *listener_p);
+
+/**
+ * @brief Runs the reactor accept loop until a shutdown signal is received or
+ * an error occurs.
+ *
+ * The listening socket is made non-blocking and polled with a timeout so
+ * shutdown signals are noticed promptly. Every pending connection is accepted
+ * and handed to the listener's tcp_reactor_t, which dispatches ready
+ * requests to the server's threadpool. The reactor is only stopped here;
+ * run_listeners() destroys it once the threadpool is shut down.
+ *
+ * @param listener_p Pointer to the listener to accept on.
+ *
+ * @return Returns E_SUCCESS on shutdown, or E_FAILURE on error.
+ */
+static int serve_reactor(listener_t *listener_p);
+
+/**
+ * @brief Runs the io_uring engine until a shutdown signal is received or an
+ * error occurs.
+ *
+ * When the kernel lacks the io_uring features the engine needs, or the
+ * engine cannot be created, the listener falls back to serve_reactor() with
+ * the message handler adapter. As with the reactor, run_listeners() destroys
+ * the engine once the threadpool is shut down.
+ *
+ * @param listener_p Pointer to the listener to accept on.
+ *
+ * @return Returns E_SUCCESS on shutdown, or E_FAILURE on error.
+ */
+static int serve_uring(listener_t *listener_p);
+
+/**
+ * @brief Client request handler that serves a message handler on a blocking
+ * socket.
+ *
+ * Each pass reads once from the socket, runs the message handler on what was
+ * read and sends the reply. In thread per connection mode it keeps going
+ * while the handler sets keep_alive; under the reactor it returns after one
+ * pass and the reactor re-arms the connection.
+ *
+ * @param args_p Pointer to the client_data_t, whose user data is the
+ * message_adapter_t.
+ *
+ * @return Always NULL.
+ */
+static void *serve_messages(void *args_p);
+
+/**
+ * @brief Client data free function that calls the user's one with the
+ * user's data swapped back in.
+ *
+ * @param args_p Pointer to the client_data_t, whose user data is the
+ * message_adapter_t.
+ */
+static void free_message_client(void *args_p);
+
 /**
  * @brief Prints the address of a connected client.
  *
@@ -127,6 +433,11 @@ static void *handle_client_request(void *args_p);
  * server will listen for incoming connections.
  * @param max_connections The maximum number of concurrent connections the
  * server should handle.
+ * @param listener_count Number of listening sockets to open on the port.
+ * @param backlog Pending connections queued per listening socket, 0 or less
+ *        for default_backlog().
+ * @param inherited_p Listening sockets taken over from a previous server, one
+ *        per listener, or NULL to open new ones. They are closed on failure.
  * @param client_request_handler Pointer to the function that will handle client
  *        requests. This function should be of the form `void *(*)(void *)`.
  * @param client_data_free_func Pointer to the function used to free client
@@ -137,6 +448,9 @@ static void *handle_client_request(void *args_p);
  */
 static server_t *init_server(char *port_p,
                              size_t max_connections,
+                             size_t listener_count,
+                             int backlog,
+                             const int *inherited_p,
                              client_request_handler_t client_request_handler,
                              client_data_free_func_t client_data_free_func);
 
@@ -155,241 +469,1221 @@ static server_t *init_server(char *port_p,
  */
 static int destroy_server(server_t **server_p);
 
-static server_t *init_server(char *port_p,
-                             size_t max_connections,
-                             client_request_handler_t client_request_handler,
-                             client_data_free_func_t client_data_free_func)
+static server_t *init_server(char *port_p,
+                             size_t max_connections,
+                             size_t listener_count,
+                             int backlog,
+                             const int *inherited_p,
+                             client_request_handler_t client_request_handler,
+                             client_data_free_func_t client_data_free_func)
+{
+    int exit_code = E_FAILURE;
+    threadpool_t *threadpool_p = NULL;
+    listener_t *listeners_p = NULL;
+    config_t *config_p = NULL;
+    server_t *server_p = NULL;
+    size_t opened = 0;
+
+    if ((NULL == port_p) || (NULL == client_request_handler))
+    {
+        print_error("init_server(): NULL argument passed.");
+        goto END;
+    }
+
+    if (2 > max_connections)
+    {
+        print_error("init_server(): Max connections must be 2 or more.");
+        goto END;
+    }
+
+    if (0 == listener_count)
+    {
+        print_error("init_server(): At least one listener is needed.");
+        goto END;
+    }
+
+    threadpool_p = threadpool_create(max_connections);
+    if (NULL == threadpool_p)
+    {
+        print_error("init_server(): Unable to create threadpool.");
+        goto END;
+    }
+
+    listeners_p = calloc(listener_count, sizeof(listener_t));
+    if (NULL == listeners_p)
+    {
+        print_error("init_server(): listeners_p - CMR failure.");
+        goto END;
+    }
+
+    for (size_t idx = 0; idx < listener_count; idx++)
+    {
+        intrusive_list_init(&listeners_p[idx].clients);
+        pthread_mutex_init(&listeners_p[idx].client_pool_mutex, NULL);
+    }
+
+    if (0 >= backlog)
+    {
+        backlog = default_backlog();
+    }
+
+    for (opened = 0; opened < listener_count; opened++)
+    {
+        config_p = &listeners_p[opened].config;
+        config_p->reuse_port = (1 < listener_count);
+
+        if (NULL != inherited_p)
+        {
+            config_p->listening_socket = inherited_p[opened];
+            config_p->inherited = true;
+        }
+        else
+        {
+            exit_code = configure_server_address(config_p, port_p);
+            if (E_SUCCESS != exit_code)
+            {
+                print_error(
+                    "init_server(): Unable to configure server address.");
+                goto END;
+            }
+        }
+
+        // Activate listening mode for the server's socket, allowing it to
+        // queue up to 'backlog' connection requests at a time, so bursts of
+        // connections wait in the kernel rather than being dropped. An
+        // inherited socket is already listening and only takes the backlog.
+        errno = 0;
+        exit_code = listen(config_p->listening_socket, backlog);
+        if (E_SUCCESS != exit_code)
+        {
+            print_strerror("init_server(): listen() failed.");
+
+            // An inherited socket is closed with the rest of them below
+            if (NULL == inherited_p)
+            {
+                close(config_p->listening_socket);
+            }
+            goto END;
+        }
+    }
+
+    server_p = calloc(1, sizeof(server_t));
+    if (NULL == server_p)
+    {
+        print_error("init_server(): server_p - CMR failure.");
+        exit_code = E_FAILURE;
+        goto END;
+    }
+
+    server_p->listening_socket = listeners_p[0].config.listening_socket;
+    server_p->threadpool_p = threadpool_p;
+    server_p->client_request_handler = client_request_handler;
+    server_p->client_data_free_func = client_data_free_func;
+    server_p->settings_p = &listeners_p[0].config;
+    server_p->listeners_p = listeners_p;
+    server_p->listener_count = listener_count;
+    server_p->handoff_socket = INVALID_SOCKET;
+    server_p->takeover_socket = INVALID_SOCKET;
+
+END:
+    if (E_SUCCESS != exit_code)
+    {
+        for (size_t idx = 0; idx < opened; idx++)
+        {
+            close(listeners_p[idx].config.listening_socket);
+        }
+
+        for (size_t idx = opened;
+             (NULL != inherited_p) && (idx < listener_count);
+             idx++)
+        {
+            close(inherited_p[idx]);
+        }
+
+        for (size_t idx = 0; (NULL != listeners_p) && (idx < listener_count);
+             idx++)
+        {
+            pthread_mutex_destroy(&listeners_p[idx].client_pool_mutex);
+        }
+
+        free(listeners_p);
+        listeners_p = NULL;
+
+        threadpool_destroy(&threadpool_p);
+        threadpool_p = NULL;
+
+        free(server_p);
+        server_p = NULL;
+    }
+
+    return server_p;
+}
+
+void tcp_server_options_init(tcp_server_options_t *options_p)
+{
+    long cpu_count = 0;
+
+    if (NULL == options_p)
+    {
+        print_error("tcp_server_options_init(): NULL argument passed.");
+        return;
+    }
+
+    cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    options_p->mode = TCP_SERVER_MODE_THREAD_PER_CONNECTION;
+    options_p->worker_threads =
+        ((long)MIN_THREADS > cpu_count) ? MIN_THREADS : (size_t)cpu_count;
+    options_p->io_threads = TCP_SERVER_DEFAULT_IO_THREADS;
+    options_p->listeners = TCP_SERVER_DEFAULT_LISTENERS;
+    options_p->max_events = 0;
+    options_p->message_handler = NULL;
+    options_p->read_timeout_ms = 0;
+    options_p->write_timeout_ms = 0;
+    options_p->idle_timeout_ms = 0;
+    options_p->backlog = 0;
+    options_p->drain_timeout_ms = 0;
+    options_p->handoff_path = NULL;
+}
+
+int tcp_reply_append(tcp_reply_t *reply_p, const void *data_p, size_t length)
+{
+    int exit_code = E_FAILURE;
+    unsigned char *grown_p = NULL;
+    size_t capacity = 0;
+
+    if ((NULL == reply_p) || ((NULL == data_p) && (0 != length)))
+    {
+        print_error("tcp_reply_append(): NULL argument passed.");
+        goto END;
+    }
+
+    if (length > (reply_p->capacity - reply_p->length))
+    {
+        capacity = (0 == reply_p->capacity) ? TCP_SERVER_RECV_SIZE
+                                            : reply_p->capacity;
+        while ((capacity - reply_p->length) < length)
+        {
+            if ((SIZE_MAX / 2) < capacity)
+            {
+                print_error("tcp_reply_append(): Reply is too large.");
+                goto END;
+            }
+
+            capacity *= 2;
+        }
+
+        grown_p = realloc(reply_p->data_p, capacity);
+        if (NULL == grown_p)
+        {
+            print_error("tcp_reply_append(): data_p - CMR failure.");
+            goto END;
+        }
+
+        reply_p->data_p = grown_p;
+        reply_p->capacity = capacity;
+    }
+
+    if (0 != length)
+    {
+        memcpy(reply_p->data_p + reply_p->length, data_p, length);
+        reply_p->length += length;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+int start_tcp_server(char *port_p,
+                     size_t max_connections,
+                     client_request_handler_t client_request_handler,
+                     client_data_free_func_t client_data_free_func,
+                     void *user_data_p)
+{
+    tcp_server_options_t options;
+
+    tcp_server_options_init(&options);
+    options.worker_threads = max_connections;
+
+    return start_tcp_server_ex(port_p,
+                               &options,
+                               client_request_handler,
+                               client_data_free_func,
+                               user_data_p);
+}
+
+int start_tcp_server_ex(char *port_p,
+                        const tcp_server_options_t *options_p,
+                        client_request_handler_t client_request_handler,
+                        client_data_free_func_t client_data_free_func,
+                        void *user_data_p)
+{
+    int exit_code = E_FAILURE;
+    server_t *server_p = NULL;
+    message_adapter_t adapter = {0};
+    void *handler_data_p = user_data_p;
+    int inherited[MAX_PASSED_FDS] = {0};
+    size_t listener_count = 0;
+    bool took_over = false;
+    int takeover_socket = INVALID_SOCKET;
+
+    if ((NULL == port_p) || (NULL == options_p) || (NULL == user_data_p) ||
+        ((NULL == client_request_handler) &&
+         (NULL == options_p->message_handler)))
+    {
+        print_error("start_server(): NULL argument passed.");
+        goto END;
+    }
+
+    if ((TCP_SERVER_MODE_URING == options_p->mode) &&
+        (NULL == options_p->message_handler))
+    {
+        print_error("start_server(): io_uring mode needs a message handler.");
+        goto END;
+    }
+
+    if (2 > options_p->worker_threads)
+    {
+        print_error("start_server(): Max connections must be 2 or more.");
+        goto END;
+    }
+
+    if (0 == options_p->listeners)
+    {
+        print_error("start_server(): At least one listener is needed.");
+        goto END;
+    }
+
+    if ((NULL != options_p->handoff_path) &&
+        (MAX_PASSED_FDS < options_p->listeners))
+    {
+        print_error("start_server(): Too many listeners to hand off.");
+        goto END;
+    }
+
+    // The io_uring mode needs the I/O threads if it has to fall back
+    if ((TCP_SERVER_MODE_THREAD_PER_CONNECTION != options_p->mode) &&
+        (0 == options_p->io_threads))
+    {
+        print_error("start_server(): Reactor needs at least one I/O thread.");
+        goto END;
+    }
+
+    if (NULL != options_p->message_handler)
+    {
+        adapter.message_handler = options_p->message_handler;
+        adapter.client_data_free_func = client_data_free_func;
+        adapter.user_data_p = user_data_p;
+        adapter.loop = (TCP_SERVER_MODE_THREAD_PER_CONNECTION ==
+                        options_p->mode);
+
+        client_request_handler = serve_messages;
+        client_data_free_func = free_message_client;
+        handler_data_p = &adapter;
+    }
+
+    // Keep the previous server's sockets, and so its number of listeners
+    if (NULL != options_p->handoff_path)
+    {
+        took_over = (E_SUCCESS == take_over_listeners(options_p->handoff_path,
+                                                      inherited,
+                                                      &listener_count,
+                                                      &takeover_socket));
+    }
+
+    server_p = init_server(port_p,
+                           options_p->worker_threads,
+                           took_over ? listener_count : options_p->listeners,
+                           options_p->backlog,
+                           took_over ? inherited : NULL,
+                           client_request_handler,
+                           client_data_free_func);
+    if (NULL == server_p)
+    {
+        print_error("start_server(): Failed to initialize server.");
+        goto END;
+    }
+
+    // Handed to the server, which acknowledges once its listeners run
+    server_p->takeover_socket = takeover_socket;
+    takeover_socket = INVALID_SOCKET;
+
+    if (took_over)
+    {
+        printf("Took over %zu listening sockets.\n", listener_count);
+    }
+
+    // Queued requests still run after a shutdown signal, until the drain
+    threadpool_set_drain(server_p->threadpool_p,
+                         (0 != options_p->drain_timeout_ms));
+
+    for (size_t idx = 0; idx < server_p->listener_count; idx++)
+    {
+        server_p->listeners_p[idx].server_p = server_p;
+        server_p->listeners_p[idx].options_p = options_p;
+        server_p->listeners_p[idx].user_data_p = handler_data_p;
+        server_p->listeners_p[idx].adapter_p =
+            (NULL != options_p->message_handler) ? &adapter : NULL;
+    }
+
+    if (NULL != options_p->handoff_path)
+    {
+        server_p->handoff_socket = open_handoff(options_p->handoff_path);
+        if (INVALID_SOCKET == server_p->handoff_socket)
+        {
+            print_error("start_server(): Unable to open handoff socket.");
+            destroy_server(&server_p);
+            goto END;
+        }
+    }
+
+    printf("Waiting for client connections...\n");
+
+    exit_code = run_listeners(server_p);
+
+    if (E_SUCCESS != destroy_server(&server_p))
+    {
+        print_error("start_server(): Failed to destroy server.");
+        exit_code = E_FAILURE;
+    }
+
+END:
+    // Without an acknowledgement the previous server keeps serving
+    if (INVALID_SOCKET != takeover_socket)
+    {
+        close(takeover_socket);
+    }
+
+    return exit_code;
+}
+
+static int run_listeners(server_t *server_p)
+{
+    int exit_code = E_SUCCESS;
+    listener_t *listener_p = NULL;
+    const tcp_server_options_t *options_p = server_p->listeners_p[0].options_p;
+    pthread_t handoff_thread;
+    bool handoff_started = false;
+
+    if (INVALID_SOCKET != server_p->handoff_socket)
+    {
+        handoff_started = (E_SUCCESS == pthread_create(&handoff_thread,
+                                                       NULL,
+                                                       serve_handoff,
+                                                       server_p));
+        if (!handoff_started)
+        {
+            print_error("run_listeners(): Unable to start handoff thread.");
+        }
+    }
+
+    for (size_t idx = 1; idx < server_p->listener_count; idx++)
+    {
+        listener_p = &server_p->listeners_p[idx];
+
+        if (E_SUCCESS !=
+            pthread_create(&listener_p->thread, NULL, run_listener, listener_p))
+        {
+            print_error("run_listeners(): Unable to start listener thread.");
+            listener_p->exit_code = E_FAILURE;
+            stop_failed_listener(listener_p);
+            continue;
+        }
+
+        listener_p->started = true;
+    }
+
+    run_listener(&server_p->listeners_p[0]);
+
+    for (size_t idx = 0; idx < server_p->listener_count; idx++)
+    {
+        listener_p = &server_p->listeners_p[idx];
+
+        if (listener_p->started)
+        {
+            pthread_join(listener_p->thread, NULL);
+            listener_p->started = false;
+        }
+
+        if (E_SUCCESS != listener_p->exit_code)
+        {
+            exit_code = E_FAILURE;
+        }
+    }
+
+    if (handoff_started)
+    {
+        pthread_join(handoff_thread, NULL);
+    }
+
+    if (0 != options_p->drain_timeout_ms)
+    {
+        drain_server(server_p, options_p->drain_timeout_ms);
+    }
+
+    // Let queued and running handlers finish before the reactors and rings
+    // free the connections they use. The pool may only be shut down once, so
+    // this happens after every listener has stopped.
+    threadpool_shutdown(server_p->threadpool_p);
+
+    for (size_t idx = 0; idx < server_p->listener_count; idx++)
+    {
+        listener_p = &server_p->listeners_p[idx];
+
+        if (NULL != listener_p->reactor_p)
+        {
+            tcp_reactor_destroy(&listener_p->reactor_p);
+        }
+
+        if (NULL != listener_p->uring_p)
+        {
+            tcp_uring_destroy(&listener_p->uring_p);
+        }
+
+        if (NULL != listener_p->client_pool_p)
+        {
+            close_dropped_clients(listener_p);
+            slab_pool_destroy(&listener_p->client_pool_p);
+        }
+    }
+
+    return exit_code;
+}
+
+static void *run_listener(void *args_p)
+{
+    listener_t *listener_p = args_p;
+    tcp_server_mode_t mode = listener_p->options_p->mode;
+
+    if (TCP_SERVER_MODE_URING == mode)
+    {
+        listener_p->exit_code = serve_uring(listener_p);
+    }
+    else if (TCP_SERVER_MODE_REACTOR == mode)
+    {
+        listener_p->exit_code = serve_reactor(listener_p);
+    }
+    else
+    {
+        listener_p->exit_code = serve_thread_per_connection(listener_p);
+    }
+
+    if (E_SUCCESS != listener_p->exit_code)
+    {
+        stop_failed_listener(listener_p);
+    }
+
+    return NULL;
+}
+
+static void stop_failed_listener(listener_t *listener_p)
+{
+    config_t *config_p = &listener_p->config;
+
+    print_error("stop_failed_listener(): Listener failed, stopping server.");
+
+    // Stop the other listeners first, so the handoff thread does not pass
+    // this socket on once it is closed
+    signal_flag_g = SIGINT;
+
+    if (INVALID_SOCKET != config_p->listening_socket)
+    {
+        // shutdown() takes the socket out of the port's SO_REUSEPORT group
+        // even while a ring's accept still holds a reference to it. A socket
+        // taken over is shared with the previous server, which keeps serving
+        // on it, so it is only closed
+        if (!config_p->inherited)
+        {
+            shutdown(config_p->listening_socket, SHUT_RDWR);
+        }
+        close(config_p->listening_socket);
+        config_p->listening_socket = INVALID_SOCKET;
+    }
+}
+
+static int serve_thread_per_connection(listener_t *listener_p)
+{
+    int exit_code = E_FAILURE;
+    server_t *server_p = listener_p->server_p;
+    config_t *config_p = &listener_p->config;
+    client_slot_t *slot_p = NULL;
+
+    listener_p->client_pool_p = slab_pool_new(sizeof(client_slot_t), 0);
+    if (NULL == listener_p->client_pool_p)
+    {
+        print_error("start_server(): Unable to create client pool.");
+        goto END;
+    }
+
+    if (E_SUCCESS != set_nonblocking(config_p->listening_socket))
+    {
+        goto END;
+    }
+
+    listener_ready(listener_p);
+
+    // Main loop to handle incoming client connections
+    for (;;)
+    {
+        exit_code = wait_for_connection(config_p);
+        if (SIG_SHUTDOWN == exit_code)
+        {
+            exit_code = E_SUCCESS;
+            goto END;
+        }
+
+        if (E_SUCCESS != exit_code)
+        {
+            goto END;
+        }
+
+        // Accept everything that is pending before polling again
+        while (E_SUCCESS == accept_new_connection(config_p))
+        {
+            // A socket whose timeouts cannot be set is served without them
+            (void)set_client_timeouts(config_p->client_fd,
+                                      listener_p->options_p);
+
+            pthread_mutex_lock(&listener_p->client_pool_mutex);
+            slot_p = slab_pool_alloc(listener_p->client_pool_p);
+            if (NULL != slot_p)
+            {
+                intrusive_list_push_tail(&listener_p->clients, &slot_p->link);
+            }
+            pthread_mutex_unlock(&listener_p->client_pool_mutex);
+            // A client that cannot be taken on is turned away, and the
+            // server keeps serving the others
+            if (NULL == slot_p)
+            {
+                print_error("start_server(): slot_p - CMR failure.");
+                close(config_p->client_fd);
+                continue;
+            }
+
+            // Set up client data and the job that serves it
+            slot_p->owner_p = listener_p;
+            slot_p->client.client_fd = config_p->client_fd;
+            slot_p->client.user_data_p = listener_p->user_data_p;
+            slot_p->job.client_function = server_p->client_request_handler;
+            slot_p->job.free_function = server_p->client_data_free_func;
+            slot_p->job.args_p = &slot_p->client;
+
+            // Add new job to the thread pool
+            exit_code = threadpool_add_job(server_p->threadpool_p,
+                                           handle_client_request,
+                                           NULL,
+                                           &slot_p->job);
+            if (E_SUCCESS != exit_code)
+            {
+                print_error("start_server(): Unable to add job to threadpool.");
+                pthread_mutex_lock(&listener_p->client_pool_mutex);
+                intrusive_list_remove(&listener_p->clients, &slot_p->link);
+                slab_pool_free(listener_p->client_pool_p, slot_p);
+                pthread_mutex_unlock(&listener_p->client_pool_mutex);
+                close(config_p->client_fd);
+                continue;
+            }
+
+            // Print client address for logging
+            print_client_address(config_p);
+        }
+    }
+
+END:
+    return exit_code;
+}
+
+static int serve_reactor(listener_t *listener_p)
+{
+    int exit_code = E_FAILURE;
+    server_t *server_p = listener_p->server_p;
+    config_t *config_p = &listener_p->config;
+    tcp_reactor_t *reactor_p = NULL;
+
+    if (E_SUCCESS != set_nonblocking(config_p->listening_socket))
+    {
+        goto END;
+    }
+
+    reactor_p = tcp_reactor_create(server_p->threadpool_p,
+                                   listener_p->options_p->io_threads,
+                                   listener_p->options_p->max_events,
+                                   listener_p->options_p->idle_timeout_ms,
+                                   server_p->client_request_handler,
+                                   server_p->client_data_free_func);
+    if (NULL == reactor_p)
+    {
+        print_error("serve_reactor(): Unable to create reactor.");
+        goto END;
+    }
+
+    listener_p->reactor_p = reactor_p;
+    listener_ready(listener_p);
+
+    for (;;)
+    {
+        exit_code = wait_for_connection(config_p);
+        if (SIG_SHUTDOWN == exit_code)
+        {
+            exit_code = E_SUCCESS;
+            goto STOP;
+        }
+
+        if (E_SUCCESS != exit_code)
+        {
+            goto STOP;
+        }
+
+        // Accept everything that is pending before polling again
+        while (E_SUCCESS == accept_new_connection(config_p))
+        {
+            print_client_address(config_p);
+            (void)set_client_timeouts(config_p->client_fd,
+                                      listener_p->options_p);
+
+            // The reactor closes the socket itself if it cannot take it
+            (void)tcp_reactor_add_client(
+                reactor_p, config_p->client_fd, listener_p->user_data_p);
+        }
+    }
+
+STOP:
+    // Stop dispatching; what is left is closed once queued handlers finish
+    tcp_reactor_stop(reactor_p);
+
+END:
+    return exit_code;
+}
+
+static int serve_uring(listener_t *listener_p)
+{
+    int exit_code = E_FAILURE;
+    message_adapter_t *adapter_p = listener_p->adapter_p;
+
+    if (tcp_uring_supported())
+    {
+        listener_p->uring_p =
+            tcp_uring_create(listener_p->config.listening_socket,
+                             listener_p->server_p->threadpool_p,
+                             listener_p->options_p->idle_timeout_ms,
+                             listener_p->options_p->write_timeout_ms,
+                             listener_p->options_p->drain_timeout_ms,
+                             adapter_p->message_handler,
+                             adapter_p->client_data_free_func,
+                             adapter_p->user_data_p);
+    }
+
+    if (NULL == listener_p->uring_p)
+    {
+        printf("io_uring unavailable, serving with the reactor.\n");
+        exit_code = serve_reactor(listener_p);
+        goto END;
+    }
+
+    listener_ready(listener_p);
+    exit_code = tcp_uring_run(listener_p->uring_p);
+
+END:
+    return exit_code;
+}
+
+static int destroy_server(server_t **server_p)
+{
+    int exit_code = E_FAILURE;
+    if ((NULL == server_p) || (NULL == (*server_p)))
+    {
+        print_error("destroy_server(): NULL argument passed.");
+        goto END;
+    }
+
+    exit_code = threadpool_destroy(&(*server_p)->threadpool_p);
+    if (E_SUCCESS != exit_code)
+    {
+        print_error("destroy_server(): Unable to destroy threadpool.");
+    }
+
+    for (size_t idx = 0; idx < (*server_p)->listener_count; idx++)
+    {
+        // Already closed if the server drained
+        if (INVALID_SOCKET !=
+            (*server_p)->listeners_p[idx].config.listening_socket)
+        {
+            close((*server_p)->listeners_p[idx].config.listening_socket);
+        }
+
+        pthread_mutex_destroy(
+            &(*server_p)->listeners_p[idx].client_pool_mutex);
+    }
+
+    if (INVALID_SOCKET != (*server_p)->handoff_socket)
+    {
+        close((*server_p)->handoff_socket);
+
+        // Once handed off, the path belongs to the new server
+        if (!(*server_p)->handed_off)
+        {
+            unlink((*server_p)->listeners_p[0].options_p->handoff_path);
+        }
+    }
+
+    // Closed after the path is unlinked, so the server taken over from can
+    // bind it again as soon as it sees the handoff failed
+    if (INVALID_SOCKET != (*server_p)->takeover_socket)
+    {
+        close((*server_p)->takeover_socket);
+    }
+
+    free((*server_p)->listeners_p);
+    (*server_p)->listeners_p = NULL;
+    (*server_p)->settings_p = NULL;
+
+    free(*server_p);
+    *server_p = NULL;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int set_nonblocking(int listening_socket)
 {
     int exit_code = E_FAILURE;
-    threadpool_t *threadpool_p = NULL;
-    config_t *config_p = NULL;
-    server_t *server_p = NULL;
+    int flags = 0;
 
-    if ((NULL == port_p) || (NULL == client_request_handler))
+    errno = 0;
+    flags = fcntl(listening_socket, F_GETFL);
+    if ((0 > flags) ||
+        (0 > fcntl(listening_socket, F_SETFL, flags | O_NONBLOCK)))
     {
-        print_error("init_server(): NULL argument passed.");
+        print_strerror("set_nonblocking(): fcntl() failed.");
         goto END;
     }
 
-    if (2 > max_connections)
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int wait_for_connection(config_t *config_p)
+{
+    int exit_code = E_FAILURE;
+    struct pollfd listener = {.fd = config_p->listening_socket,
+                              .events = POLLIN};
+
+    if (shutdown_requested())
     {
-        print_error("init_server(): Max connections must be 2 or more.");
+        printf("\nShutdown signal received.\n");
+        exit_code = SIG_SHUTDOWN;
         goto END;
     }
 
-    threadpool_p = threadpool_create(max_connections);
-    if (NULL == threadpool_p)
+    errno = 0;
+    if ((0 > poll(&listener, 1, TCP_REACTOR_WAIT_MS)) && (EINTR != errno))
     {
-        print_error("init_server(): Unable to create threadpool.");
+        print_strerror("wait_for_connection(): poll() failed.");
         goto END;
     }
 
-    config_p = calloc(1, sizeof(config_t));
-    if (NULL == config_p)
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int accept_new_connection(config_t *config_p)
+{
+    int exit_code = E_FAILURE;
+
+    for (;;)
+    {
+        config_p->client_len = sizeof(config_p->client_address);
+
+        errno = 0;
+        config_p->client_fd =
+            accept4(config_p->listening_socket,
+                    (struct sockaddr *)&config_p->client_address,
+                    &config_p->client_len,
+                    SOCK_CLOEXEC);
+        if (INVALID_SOCKET < config_p->client_fd)
+        {
+            exit_code = E_SUCCESS;
+            goto END;
+        }
+
+        // A client that gave up while queued is skipped, not an error
+        if ((EINTR != errno) && (ECONNABORTED != errno))
+        {
+            break;
+        }
+    }
+
+    if ((EAGAIN != errno) && (EWOULDBLOCK != errno))
+    {
+        print_strerror("accept_new_connection(): accept4() failed.");
+    }
+
+END:
+    return exit_code;
+}
+
+static int default_backlog(void)
+{
+    int backlog = SOMAXCONN;
+    int configured = 0;
+    FILE *file_p = NULL;
+
+    file_p = fopen(SOMAXCONN_PATH, "r");
+    if (NULL == file_p)
     {
-        print_error("init_server(): config_p - CMR failure.");
         goto END;
     }
 
-    exit_code = configure_server_address(config_p, port_p);
-    if (E_SUCCESS != exit_code)
+    if ((1 == fscanf(file_p, "%d", &configured)) && (0 < configured))
+    {
+        backlog = configured;
+    }
+
+    fclose(file_p);
+
+END:
+    return backlog;
+}
+
+static bool shutdown_requested(void)
+{
+    return (signal_flag_g == SIGINT) || (signal_flag_g == SIGUSR1);
+}
+
+static int take_over_listeners(const char *path_p,
+                               int *fds_p,
+                               size_t *count_p,
+                               int *socket_p)
+{
+    int exit_code = E_FAILURE;
+    int handoff_socket = INVALID_SOCKET;
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+
+    if (sizeof(address.sun_path) <= strlen(path_p))
     {
-        print_error("init_server(): Unable to configure server address.");
+        print_error("take_over_listeners(): Handoff path is too long.");
         goto END;
     }
 
-    // Activate listening mode for the server's socket, allowing it to queue up
-    // to 'BACKLOG_SIZE' connection requests at a time.
+    strcpy(address.sun_path, path_p);
+
     errno = 0;
-    exit_code = listen(config_p->listening_socket, BACKLOG_SIZE);
-    if (E_SUCCESS != exit_code)
+    handoff_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (INVALID_SOCKET == handoff_socket)
     {
-        print_strerror("init_server(): listen() failed.");
+        print_strerror("take_over_listeners(): socket() failed.");
         goto END;
     }
 
-    server_p = calloc(1, sizeof(server_t));
-    if (NULL == server_p)
+    // No server to take over from is the normal case for a first start
+    errno = 0;
+    if (0 > connect(handoff_socket,
+                    (struct sockaddr *)&address,
+                    sizeof(address)))
     {
-        print_error("init_server(): server_p - CMR failure.");
-        exit_code = E_FAILURE;
+        if ((ENOENT != errno) && (ECONNREFUSED != errno))
+        {
+            print_strerror("take_over_listeners(): connect() failed.");
+        }
+
         goto END;
     }
 
-    server_p->listening_socket = config_p->listening_socket;
-    server_p->threadpool_p = threadpool_p;
-    server_p->client_request_handler = client_request_handler;
-    server_p->client_data_free_func = client_data_free_func;
-    server_p->settings_p = config_p;
-
-END:
+    exit_code = recv_fds(handoff_socket, fds_p, MAX_PASSED_FDS, count_p);
     if (E_SUCCESS != exit_code)
     {
-        free(config_p);
-        config_p = NULL;
+        print_error("take_over_listeners(): No listening sockets received.");
+        goto END;
+    }
 
-        threadpool_destroy(&threadpool_p);
-        threadpool_p = NULL;
+    *socket_p = handoff_socket;
+    handoff_socket = INVALID_SOCKET;
 
-        free(server_p);
-        server_p = NULL;
+END:
+    if (INVALID_SOCKET != handoff_socket)
+    {
+        close(handoff_socket);
     }
 
-    return server_p;
+    return exit_code;
 }
 
-int start_tcp_server(char *port_p,
-                     size_t max_connections,
-                     client_request_handler_t client_request_handler,
-                     client_data_free_func_t client_data_free_func,
-                     void *user_data_p)
+static int open_handoff(const char *path_p)
 {
-    int exit_code = E_FAILURE;
-    server_t *server_p = NULL;
-    client_data_t *client_data_p = NULL;
-    tcp_server_job_t *new_job_p = NULL;
+    int handoff_socket = INVALID_SOCKET;
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
 
-    if ((NULL == port_p) || (NULL == client_request_handler) ||
-        (NULL == user_data_p))
+    if (sizeof(address.sun_path) <= strlen(path_p))
     {
-        print_error("start_server(): NULL argument passed.");
+        print_error("open_handoff(): Handoff path is too long.");
         goto END;
     }
 
-    if (2 > max_connections)
+    strcpy(address.sun_path, path_p);
+
+    errno = 0;
+    handoff_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (INVALID_SOCKET == handoff_socket)
     {
-        print_error("start_server(): Max connections must be 2 or more.");
+        print_strerror("open_handoff(): socket() failed.");
         goto END;
     }
 
-    server_p = init_server(
-        port_p, max_connections, client_request_handler, client_data_free_func);
-    if (NULL == server_p)
+    // The file is left by the previous server, which no longer needs it
+    unlink(path_p);
+
+    errno = 0;
+    if ((0 > bind(handoff_socket,
+                  (struct sockaddr *)&address,
+                  sizeof(address))) ||
+        (0 > listen(handoff_socket, 1)))
     {
-        print_error("start_server(): Failed to initialize server.");
-        goto END;
+        print_strerror("open_handoff(): Unable to listen on handoff path.");
+        close(handoff_socket);
+        handoff_socket = INVALID_SOCKET;
     }
 
-    printf("Waiting for client connections...\n");
+END:
+    return handoff_socket;
+}
 
-    // Main loop to handle incoming client connections
-    for (;;)
+static void *serve_handoff(void *args_p)
+{
+    server_t *server_p = args_p;
+    struct pollfd handoff = {.fd = server_p->handoff_socket, .events = POLLIN};
+    int fds[MAX_PASSED_FDS] = {0};
+    int new_server = INVALID_SOCKET;
+    int ready = 0;
+
+    for (size_t idx = 0; idx < server_p->listener_count; idx++)
+    {
+        fds[idx] = server_p->listeners_p[idx].config.listening_socket;
+    }
+
+    while (!shutdown_requested())
     {
-        if ((signal_flag_g == SIGINT) || (signal_flag_g) == SIGUSR1)
+        errno = 0;
+        ready = poll(&handoff, 1, TCP_REACTOR_WAIT_MS);
+        if ((0 > ready) && (EINTR != errno))
         {
-            printf("\nShutdown signal received.\n");
-            goto SHUTDOWN;
+            print_strerror("serve_handoff(): poll() failed.");
+            break;
         }
 
-        exit_code = accept_new_connection(server_p->settings_p);
-        if (E_SUCCESS != exit_code)
+        if (0 >= ready)
+        {
+            continue;
+        }
+
+        new_server =
+            accept4(server_p->handoff_socket, NULL, NULL, SOCK_CLOEXEC);
+        if (INVALID_SOCKET == new_server)
         {
-            print_error("start_server(): Unable to accept new connection.");
-            goto SHUTDOWN;
+            continue;
         }
 
-        client_data_p = calloc(1, sizeof(client_data_t));
-        if (NULL == client_data_p)
+        if ((E_SUCCESS ==
+             send_fds(new_server, fds, server_p->listener_count)) &&
+            (E_SUCCESS == wait_for_handoff_ack(new_server)))
         {
-            print_error("start_server(): client_data_p - CMR failure.");
-            goto SHUTDOWN;
+            printf("\nListening sockets handed over.\n");
+            server_p->handed_off = true;
+
+            // The new server accepts from here on, so stop as SIGINT would
+            signal_flag_g = SIGINT;
         }
+        else if (!shutdown_requested())
+        {
+            printf("\nHandoff failed, still serving.\n");
 
-        // Set up client data
-        client_data_p->client_fd = server_p->settings_p->client_fd;
-        client_data_p->user_data_p = user_data_p;
+            // The new server may have replaced the path before it failed
+            close(server_p->handoff_socket);
+            server_p->handoff_socket = open_handoff(
+                server_p->listeners_p[0].options_p->handoff_path);
+            handoff.fd = server_p->handoff_socket;
+        }
 
-        new_job_p = calloc(1, sizeof(tcp_server_job_t));
-        if (NULL == new_job_p)
+        close(new_server);
+        if (INVALID_SOCKET == server_p->handoff_socket)
         {
-            print_error("start_server(): new_job_p - CMR failure.");
-            free(client_data_p);
-            client_data_p = NULL;
-            goto SHUTDOWN;
+            print_error("serve_handoff(): Unable to open handoff socket.");
+            break;
         }
+    }
 
-        // Initialize the new job
-        new_job_p->client_function = client_request_handler;
-        new_job_p->free_function = client_data_free_func;
-        new_job_p->args_p = client_data_p;
+    return NULL;
+}
 
-        // Add new job to the thread pool
-        exit_code = threadpool_add_job(
-            server_p->threadpool_p, handle_client_request, NULL, new_job_p);
-        if (E_SUCCESS != exit_code)
+static int wait_for_handoff_ack(int new_server)
+{
+    int exit_code = E_FAILURE;
+    struct pollfd reply = {.fd = new_server, .events = POLLIN};
+    unsigned char ack = 0;
+    int ready = 0;
+
+    // The new server may take a while to set up, this one serves meanwhile
+    while (!shutdown_requested())
+    {
+        errno = 0;
+        ready = poll(&reply, 1, TCP_REACTOR_WAIT_MS);
+        if ((0 > ready) && (EINTR != errno))
+        {
+            print_strerror("wait_for_handoff_ack(): poll() failed.");
+            break;
+        }
+
+        if (0 >= ready)
+        {
+            continue;
+        }
+
+        // Anything but the acknowledgement, the connection closing included,
+        // means the new server is not serving
+        if ((1 == recv(new_server, &ack, 1, 0)) && (HANDOFF_ACK == ack))
         {
-            print_error("start_server(): Unable to add job to threadpool.");
-            goto SHUTDOWN;
+            exit_code = E_SUCCESS;
         }
 
-        // Print client address for logging
-        print_client_address(server_p->settings_p);
+        break;
     }
 
-SHUTDOWN:
-    exit_code = destroy_server(&server_p);
-    if (E_SUCCESS != exit_code)
+    return exit_code;
+}
+
+static void listener_ready(listener_t *listener_p)
+{
+    server_t *server_p = listener_p->server_p;
+    unsigned char ack = HANDOFF_ACK;
+
+    // Only the last listener to get here sees every one ready
+    if ((server_p->listener_count !=
+         __atomic_add_fetch(&server_p->ready_listeners, 1, __ATOMIC_ACQ_REL)) ||
+        (INVALID_SOCKET == server_p->takeover_socket))
     {
-        print_error("start_server(): Failed to destroy server.");
-        goto END;
+        return;
     }
 
-END:
-    return exit_code;
+    errno = 0;
+    if (1 != send(server_p->takeover_socket, &ack, 1, MSG_NOSIGNAL))
+    {
+        print_strerror("listener_ready(): Unable to acknowledge handoff.");
+    }
+
+    close(server_p->takeover_socket);
+    server_p->takeover_socket = INVALID_SOCKET;
 }
 
-static int destroy_server(server_t **server_p)
+static void drain_server(server_t *server_p, unsigned int timeout_ms)
 {
-    int exit_code = E_FAILURE;
-    if ((NULL == server_p) || (NULL == (*server_p)))
+    listener_t *listener_p = NULL;
+    intrusive_link_t *link_p = NULL;
+    intrusive_link_t *next_p = NULL;
+    client_slot_t *slot_p = NULL;
+
+    // New connections are refused, or left to the server taking over
+    for (size_t idx = 0; idx < server_p->listener_count; idx++)
     {
-        print_error("destroy_server(): NULL argument passed.");
-        goto END;
+        close(server_p->listeners_p[idx].config.listening_socket);
+        server_p->listeners_p[idx].config.listening_socket = INVALID_SOCKET;
     }
 
-    exit_code = threadpool_destroy(&(*server_p)->threadpool_p);
-    if (E_SUCCESS != exit_code)
+    printf("Draining connections...\n");
+    if (E_SUCCESS == threadpool_wait_idle(server_p->threadpool_p, timeout_ms))
     {
-        print_error("destroy_server(): Unable to destroy threadpool.");
+        return;
     }
 
-    close((*server_p)->listening_socket);
+    printf("Drain timed out, closing busy connections.\n");
+    for (size_t idx = 0; idx < server_p->listener_count; idx++)
+    {
+        listener_p = &server_p->listeners_p[idx];
 
-    free((*server_p)->settings_p);
-    (*server_p)->settings_p = NULL;
+        pthread_mutex_lock(&listener_p->client_pool_mutex);
+        INTRUSIVE_LIST_FOREACH(&listener_p->clients, link_p, next_p)
+        {
+            slot_p = INTRUSIVE_LIST_ENTRY(link_p, client_slot_t, link);
+            shutdown(slot_p->client.client_fd, SHUT_RDWR);
+        }
+        pthread_mutex_unlock(&listener_p->client_pool_mutex);
 
-    free(*server_p);
-    *server_p = NULL;
+        // io_uring handlers never block on their socket
+        if (NULL != listener_p->reactor_p)
+        {
+            tcp_reactor_shutdown_clients(listener_p->reactor_p);
+        }
+    }
+}
 
-    exit_code = E_SUCCESS;
-END:
-    return exit_code;
+static void close_dropped_clients(listener_t *listener_p)
+{
+    intrusive_link_t *link_p = NULL;
+    client_slot_t *slot_p = NULL;
+
+    while (NULL != (link_p = intrusive_list_pop_head(&listener_p->clients)))
+    {
+        slot_p = INTRUSIVE_LIST_ENTRY(link_p, client_slot_t, link);
+
+        if (NULL != slot_p->job.free_function)
+        {
+            slot_p->job.free_function(slot_p->job.args_p);
+        }
+
+        close(slot_p->client.client_fd);
+        slab_pool_free(listener_p->client_pool_p, slot_p);
+    }
 }
 
-static int accept_new_connection(config_t *config_p)
+static int set_client_timeouts(int client_fd,
+                               const tcp_server_options_t *options_p)
 {
     int exit_code = E_FAILURE;
-    config_p->client_len = sizeof(config_p->client_address);
+    unsigned int read_ms = options_p->read_timeout_ms;
+    unsigned int write_ms = options_p->write_timeout_ms;
+    struct timeval timeout = {0};
 
-    // Attempt to accept a new client connection using the listening socket.
-    // If the accept() function returns an invalid client fd, check for shutdown
-    // signals (SIGINT or SIGUSR1).
-    errno = 0;
-    config_p->client_fd = accept(config_p->listening_socket,
-                                 (struct sockaddr *)&config_p->client_address,
-                                 &config_p->client_len);
-    if (INVALID_SOCKET >= config_p->client_fd)
+    if ((TCP_SERVER_MODE_THREAD_PER_CONNECTION == options_p->mode) &&
+        (0 != options_p->idle_timeout_ms) &&
+        ((0 == read_ms) || (options_p->idle_timeout_ms < read_ms)))
     {
-        if ((signal_flag_g == SIGINT) || (signal_flag_g == SIGUSR1))
+        read_ms = options_p->idle_timeout_ms;
+    }
+
+    if (0 != read_ms)
+    {
+        timeout.tv_sec = read_ms / MS_PER_SEC;
+        timeout.tv_usec = (read_ms % MS_PER_SEC) * US_PER_MS;
+
+        errno = 0;
+        if (0 > setsockopt(client_fd,
+                           SOL_SOCKET,
+                           SO_RCVTIMEO,
+                           &timeout,
+                           sizeof(timeout)))
         {
-            printf("\nShutdown signal received.\n");
-            exit_code = SIG_SHUTDOWN;
+            print_strerror("set_client_timeouts(): setsockopt() failed.");
             goto END;
         }
+    }
 
-        perror("accept_new_connection(): accept() failed.");
-        exit_code = E_FAILURE;
-        goto END;
+    if (0 != write_ms)
+    {
+        timeout.tv_sec = write_ms / MS_PER_SEC;
+        timeout.tv_usec = (write_ms % MS_PER_SEC) * US_PER_MS;
+
+        errno = 0;
+        if (0 > setsockopt(client_fd,
+                           SOL_SOCKET,
+                           SO_SNDTIMEO,
+                           &timeout,
+                           sizeof(timeout)))
+        {
+            print_strerror("set_client_timeouts(): setsockopt() failed.");
+            goto END;
+        }
     }
 
     exit_code = E_SUCCESS;
@@ -512,6 +1806,23 @@ static int create_listening_socket(config_t *config_p)
         goto END;
     }
 
+    // Let the other listeners bind the same port; the kernel then balances
+    // incoming connections across their sockets
+    if (config_p->reuse_port)
+    {
+        sock_opt_check = setsockopt(config_p->listening_socket,
+                                    SOL_SOCKET,
+                                    SO_REUSEPORT,
+                                    &optval,
+                                    sizeof(optval));
+        if (0 > sock_opt_check)
+        {
+            perror("create_listening_socket(): setsockopt() failed.");
+            exit_code = E_FAILURE;
+            goto END;
+        }
+    }
+
     exit_code = E_SUCCESS;
 END:
     return exit_code;
@@ -537,8 +1848,10 @@ static void print_client_address(config_t *config_p)
 static void *handle_client_request(void *args_p)
 {
     tcp_server_job_t *job_p = NULL;
-    client_data_t *data_p = NULL;
+    client_slot_t *slot_p = NULL;
+    listener_t *listener_p = NULL;
     void *result_p = NULL;
+    int client_fd = INVALID_SOCKET;
 
     if (NULL == args_p)
     {
@@ -547,6 +1860,8 @@ static void *handle_client_request(void *args_p)
     }
 
     job_p = (tcp_server_job_t *)args_p;
+    slot_p = (client_slot_t *)job_p;
+    listener_p = slot_p->owner_p;
 
     // Execute the custom function
     result_p = job_p->client_function(job_p->args_p);
@@ -557,16 +1872,81 @@ static void *handle_client_request(void *args_p)
         job_p->free_function(job_p->args_p);
     }
 
-    data_p = (client_data_t *)job_p->args_p;
-    close(data_p->client_fd);
-
-    free(data_p);
-    data_p = NULL;
-    free(job_p);
+    // Unlisted before the socket is closed, so drain_server() never shuts
+    // down a descriptor number that has already been reused
+    client_fd = slot_p->client.client_fd;
+    pthread_mutex_lock(&listener_p->client_pool_mutex);
+    intrusive_list_remove(&listener_p->clients, &slot_p->link);
+    slab_pool_free(listener_p->client_pool_p, slot_p);
+    pthread_mutex_unlock(&listener_p->client_pool_mutex);
+    slot_p = NULL;
     job_p = NULL;
 
+    close(client_fd);
+
 END:
     return result_p;
 }
 
+static void *serve_messages(void *args_p)
+{
+    client_data_t *client_p = args_p;
+    message_adapter_t *adapter_p = client_p->user_data_p;
+    unsigned char request[TCP_SERVER_RECV_SIZE];
+    tcp_reply_t reply = {0};
+    ssize_t received = 0;
+
+    client_p->user_data_p = adapter_p->user_data_p;
+
+    do
+    {
+        client_p->keep_alive = false;
+        reply.length = 0;
+
+        errno = 0;
+        received = recv(client_p->client_fd, request, sizeof(request), 0);
+        if (0 > received)
+        {
+            // Interrupted before anything arrived, the request is still there
+            client_p->keep_alive = (EINTR == errno);
+            continue;
+        }
+
+        if (0 == received)
+        {
+            break; // Peer closed the connection
+        }
+
+        adapter_p->message_handler(
+            client_p, request, (size_t)received, &reply);
+
+        if ((0 != reply.length) &&
+            (E_SUCCESS !=
+             send_data(client_p->client_fd, reply.data_p, reply.length)))
+        {
+            print_error("serve_messages(): Unable to send reply.");
+            client_p->keep_alive = false;
+        }
+        // A shutdown lets the request in hand finish, not the next one
+    } while (adapter_p->loop && client_p->keep_alive && !shutdown_requested());
+
+    free(reply.data_p);
+    client_p->user_data_p = adapter_p;
+
+    return NULL;
+}
+
+static void free_message_client(void *args_p)
+{
+    client_data_t *client_p = args_p;
+    message_adapter_t *adapter_p = client_p->user_data_p;
+
+    if (NULL != adapter_p->client_data_free_func)
+    {
+        client_p->user_data_p = adapter_p->user_data_p;
+        adapter_p->client_data_free_func(client_p);
+        client_p->user_data_p = adapter_p;
+    }
+}
+
 /*** end of file ***/
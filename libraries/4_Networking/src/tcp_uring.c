@@ -0,0 +1,1518 @@
+#include <errno.h>            // Access 'errno' global variable
+#include <linux/io_uring.h>   // io_uring structures and constants
+#include <pthread.h>          // pthread_mutex_lock(), pthread_mutex_unlock()
+#include <stdint.h>           // uint64_t, uintptr_t
+#include <stdio.h>            // printf()
+#include <string.h>           // memset(), memcpy()
+#include <sys/eventfd.h>      // eventfd(), eventfd_write()
+#include <sys/mman.h>         // mmap(), munmap()
+#include <sys/socket.h>       // shutdown()
+#include <sys/syscall.h>      // __NR_io_uring_setup and friends
+#include <unistd.h>           // close(), syscall()
+
+#include "intrusive_list.h"
+#include "signal_handler.h"
+#include "slab_pool.h"
+#include "tcp_uring.h"
+#include "timer_wheel.h"
+#include "utilities.h"
+
+#define BUFFER_GROUP 0 // Provided buffer group id used for every receive
+#define OP_MASK      (uint64_t)7 // Low bits of user_data holding the op
+
+// Completions carry the operation in the low bits of user_data and the
+// connection, which the slab pool aligns to at least 8 bytes, in the rest
+typedef enum uring_op
+{
+    OP_ACCEPT = 0,
+    OP_RECV,
+    OP_SEND,
+    OP_SHUTDOWN,
+    OP_WAKE,
+    OP_TICK,
+    OP_CANCEL,
+} uring_op_t;
+
+/**
+ * @brief State for one client connection. Only the ring thread touches it,
+ * except for 'client', 'request_p' and 'reply' while a job is running.
+ */
+typedef struct uring_connection
+{
+    client_data_t       client;    // Handed to the message handler
+    intrusive_link_t    link;      // Entry in the engine's connection list
+    intrusive_link_t    done_link; // Entry in the finished job list
+    tcp_uring_t *       uring_p;
+    unsigned char *     input_p;   // Received since the last dispatch
+    size_t              input_length;
+    size_t              input_capacity;
+    unsigned char *     request_p; // Bytes the running job is handling
+    size_t              request_length;
+    size_t              request_capacity;
+    tcp_reply_t         reply;
+    size_t              reply_sent;
+    unsigned int        pending;   // Operations in flight on the ring
+    bool                busy;      // A job or its reply is in progress
+    bool                closing;   // No further requests are dispatched
+    timer_wheel_entry_t timer;     // Idle or send deadline
+} uring_connection_t;
+
+struct tcp_uring
+{
+    int                        ring_fd;
+    void *                     ring_p;       // SQ and CQ rings, mapped once
+    size_t                     ring_size;
+    struct io_uring_sqe *      sqes;
+    size_t                     sqes_size;
+    unsigned int *             sq_head;
+    unsigned int *             sq_tail;
+    unsigned int               sq_mask;
+    unsigned int               sq_entries;
+    unsigned int               sq_local_tail; // Queued but not yet published
+    unsigned int *             cq_head;
+    unsigned int *             cq_tail;
+    unsigned int               cq_mask;
+    struct io_uring_cqe *      cqes;
+    struct io_uring_buf_ring * buffer_ring_p;
+    size_t                     buffer_ring_size;
+    uint16_t                   buffer_tail;
+    unsigned char *            buffers_p;
+    int                        listening_socket;
+    int                        wake_fd;
+    uint64_t                   wake_value;
+    struct __kernel_timespec   tick;
+    pthread_mutex_t            done_mutex;  // Guards 'done'
+    intrusive_list_t           done;        // Connections whose job finished
+    intrusive_list_t           connections; // Every open connection
+    timer_wheel_t *            timers;      // NULL without timeouts
+    slab_pool_t *              connection_pool; // Ring thread only
+    unsigned int               idle_timeout_ms;
+    unsigned int               write_timeout_ms;
+    unsigned int               drain_timeout_ms;
+    bool                       accepting; // The multishot accept is armed
+    bool                       accept_paused; // Out of descriptors or memory
+    bool                       accept_resume; // Try again after the pause
+    bool                       stopping;  // Set once shutdown has begun
+    bool                       draining;  // Stopping with a drain timeout
+    threadpool_t *             threadpool_p;
+    tcp_message_handler_t      message_handler;
+    client_data_free_func_t    client_data_free_func;
+    void *                     user_data_p;
+};
+
+/**
+ * @brief Maps the submission and completion rings of a new ring.
+ *
+ * @param uring_p Pointer to the engine, 'ring_fd' set.
+ * @param params_p Pointer to the parameters io_uring_setup() filled in.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int map_rings(tcp_uring_t * uring_p, struct io_uring_params * params_p);
+
+/**
+ * @brief Registers the provided buffer ring and fills it with every receive
+ * buffer.
+ *
+ * @param uring_p Pointer to the engine.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int register_buffers(tcp_uring_t * uring_p);
+
+/**
+ * @brief Hands a receive buffer back to the kernel.
+ *
+ * @param uring_p Pointer to the engine.
+ * @param buffer_id Id of the buffer, as reported in the completion.
+ */
+static void recycle_buffer(tcp_uring_t * uring_p, uint16_t buffer_id);
+
+/**
+ * @brief Publishes queued submissions and optionally waits for at least one
+ * completion.
+ *
+ * @param uring_p Pointer to the engine.
+ * @param wait Whether to wait for a completion.
+ *
+ * @return E_SUCCESS on success or interruption, E_FAILURE on failure.
+ */
+static int submit(tcp_uring_t * uring_p, bool wait);
+
+/**
+ * @brief Makes sure 'count' submission entries can be taken without a
+ * submit in between, submitting what is queued if needed.
+ *
+ * @param uring_p Pointer to the engine.
+ * @param count Number of entries needed.
+ *
+ * @return E_SUCCESS on success, E_FAILURE if the queue stays full.
+ */
+static int reserve_sqes(tcp_uring_t * uring_p, unsigned int count);
+
+/**
+ * @brief Takes the next submission entry, cleared, and tags it.
+ *
+ * @param uring_p Pointer to the engine.
+ * @param op The operation the entry will hold.
+ * @param connection_p The connection it is for, NULL for engine operations.
+ *
+ * @return Pointer to the entry, NULL if the queue stays full.
+ */
+static struct io_uring_sqe * get_sqe(tcp_uring_t *        uring_p,
+                                     uring_op_t           op,
+                                     uring_connection_t * connection_p);
+
+/**
+ * @brief Arms the multishot accept on the listening socket.
+ *
+ * @param uring_p Pointer to the engine.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int arm_accept(tcp_uring_t * uring_p);
+
+/**
+ * @brief Arms the accept again after it was paused by a resource error,
+ * unless the engine is shutting down.
+ *
+ * @param uring_p Pointer to the engine.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int resume_accept(tcp_uring_t * uring_p);
+
+/**
+ * @brief Cancels the multishot accept, so connections queued on the
+ * listening socket are left to whoever else accepts on it.
+ *
+ * @param uring_p Pointer to the engine.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int cancel_accept(tcp_uring_t * uring_p);
+
+/**
+ * @brief Gives idle connections one tick for a request already on its way
+ * before they are closed. Every other connection is closed after its next
+ * reply.
+ *
+ * @param uring_p Pointer to the engine.
+ */
+static void begin_drain(tcp_uring_t * uring_p);
+
+/**
+ * @brief Arms the read on the eventfd workers signal finished jobs on.
+ *
+ * @param uring_p Pointer to the engine.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int arm_wake(tcp_uring_t * uring_p);
+
+/**
+ * @brief Arms the timeout that bounds each wait, so signals are noticed.
+ *
+ * @param uring_p Pointer to the engine.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int arm_tick(tcp_uring_t * uring_p);
+
+/**
+ * @brief Arms a multishot receive on a connection.
+ *
+ * @param connection_p Pointer to the connection.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int arm_recv(uring_connection_t * connection_p);
+
+/**
+ * @brief Queues the unsent part of a connection's reply, linked to a
+ * shutdown of the socket when the connection is closing.
+ *
+ * @param connection_p Pointer to the connection.
+ *
+ * @return E_SUCCESS on success, E_FAILURE on failure.
+ */
+static int queue_send(uring_connection_t * connection_p);
+
+/**
+ * @brief Handles one completion.
+ *
+ * @param uring_p Pointer to the engine.
+ * @param cqe_p Pointer to a copy of the completion.
+ *
+ * @return E_SUCCESS unless the engine cannot continue.
+ */
+static int handle_completion(tcp_uring_t *         uring_p,
+                             struct io_uring_cqe * cqe_p);
+
+/**
+ * @brief Creates a connection for an accepted socket and starts receiving.
+ *
+ * @param uring_p Pointer to the engine.
+ * @param client_fd The accepted socket, closed on failure.
+ */
+static void add_connection(tcp_uring_t * uring_p, int client_fd);
+
+/**
+ * @brief Handles a receive completion.
+ *
+ * @param connection_p Pointer to the connection.
+ * @param cqe_p Pointer to the completion.
+ */
+static void on_recv(uring_connection_t * connection_p,
+                    struct io_uring_cqe * cqe_p);
+
+/**
+ * @brief Handles a send completion, sending the rest of a short write.
+ *
+ * @param connection_p Pointer to the connection.
+ * @param result The completion result.
+ */
+static void on_send(uring_connection_t * connection_p, int result);
+
+/**
+ * @brief Takes every finished job off the done list and sends its reply.
+ *
+ * @param uring_p Pointer to the engine.
+ */
+static void on_wake(tcp_uring_t * uring_p);
+
+/**
+ * @brief Queues a job for the bytes received so far on a connection.
+ *
+ * @param connection_p Pointer to the connection, not busy.
+ */
+static void dispatch(uring_connection_t * connection_p);
+
+/**
+ * @brief Threadpool job that runs the message handler for one connection
+ * and hands the connection back to the ring thread.
+ *
+ * @param args_p Pointer to the uring_connection_t.
+ *
+ * @return Always NULL.
+ */
+static void * run_message_handler(void * args_p);
+
+/**
+ * @brief Ends the current request of a connection once its reply, if any,
+ * has been sent, and dispatches any bytes that arrived meanwhile.
+ *
+ * @param connection_p Pointer to the connection.
+ */
+static void end_request(uring_connection_t * connection_p);
+
+/**
+ * @brief Shuts the socket down so its receive ends, used when a shutdown
+ * cannot go through the ring.
+ *
+ * @param connection_p Pointer to the connection.
+ */
+static void shutdown_connection(uring_connection_t * connection_p);
+
+/**
+ * @brief Frees a connection that has nothing in flight and no job running.
+ *
+ * @param connection_p Pointer to the connection.
+ */
+static void release_if_idle(uring_connection_t * connection_p);
+
+/**
+ * @brief Restarts a connection's timer with a new timeout, or stops it.
+ *
+ * @param connection_p Pointer to the connection.
+ * @param timeout_ms Milliseconds from now, 0 to stop the timer.
+ */
+static void set_timer(uring_connection_t * connection_p,
+                      unsigned int         timeout_ms);
+
+/**
+ * @brief Shuts down every connection whose timer expired.
+ *
+ * @param uring_p Pointer to the engine, which must have a timer wheel.
+ */
+static void reap_expired(tcp_uring_t * uring_p);
+
+/**
+ * @brief Closes and frees a connection, calling the client data free
+ * function first.
+ *
+ * @param connection_p Pointer to the connection.
+ */
+static void free_connection(uring_connection_t * connection_p);
+
+bool tcp_uring_supported(void)
+{
+    // Every opcode the engine submits. SEND_ZC is never used, but it arrived
+    // in the same release as multishot receive, which the probe cannot see
+    static const unsigned char required_ops[] = {
+        IORING_OP_ACCEPT,   IORING_OP_RECV,    IORING_OP_SEND,
+        IORING_OP_SHUTDOWN, IORING_OP_READ,    IORING_OP_TIMEOUT,
+        IORING_OP_ASYNC_CANCEL, IORING_OP_SEND_ZC,
+    };
+    struct io_uring_params  params    = { 0 };
+    struct io_uring_probe * probe_p   = NULL;
+    bool                    supported = false;
+    int                     ring_fd   = -1;
+
+    ring_fd = (int)syscall(__NR_io_uring_setup, 2, &params);
+    if (0 > ring_fd)
+    {
+        goto END;
+    }
+
+    probe_p = calloc(1,
+                     sizeof(struct io_uring_probe) +
+                         (IORING_OP_LAST * sizeof(struct io_uring_probe_op)));
+    if (NULL == probe_p)
+    {
+        print_error("tcp_uring_supported(): probe_p - CMR failure.");
+        goto END;
+    }
+
+    if (0 > syscall(__NR_io_uring_register,
+                    ring_fd,
+                    IORING_REGISTER_PROBE,
+                    probe_p,
+                    IORING_OP_LAST))
+    {
+        goto END;
+    }
+
+    supported = (0 != (params.features & IORING_FEAT_SINGLE_MMAP)) &&
+                (0 != (params.features & IORING_FEAT_NODROP));
+
+    for (size_t idx = 0; idx < sizeof(required_ops); idx++)
+    {
+        if ((required_ops[idx] > probe_p->last_op) ||
+            (0 == (probe_p->ops[required_ops[idx]].flags &
+                   IO_URING_OP_SUPPORTED)))
+        {
+            supported = false;
+        }
+    }
+
+END:
+    free(probe_p);
+    if (0 <= ring_fd)
+    {
+        close(ring_fd);
+    }
+
+    return supported;
+}
+
+tcp_uring_t * tcp_uring_create(int                     listening_socket,
+                               threadpool_t *          threadpool_p,
+                               unsigned int            idle_timeout_ms,
+                               unsigned int            write_timeout_ms,
+                               unsigned int            drain_timeout_ms,
+                               tcp_message_handler_t   message_handler,
+                               client_data_free_func_t client_data_free_func,
+                               void *                  user_data_p)
+{
+    tcp_uring_t *          uring_p = NULL;
+    struct io_uring_params params  = { 0 };
+
+    if ((NULL == threadpool_p) || (NULL == message_handler))
+    {
+        print_error("tcp_uring_create(): NULL argument passed.");
+        goto END;
+    }
+
+    uring_p = calloc(1, sizeof(tcp_uring_t));
+    if (NULL == uring_p)
+    {
+        print_error("tcp_uring_create(): uring_p - CMR failure.");
+        goto END;
+    }
+
+    uring_p->ring_fd               = -1;
+    uring_p->wake_fd               = -1;
+    uring_p->listening_socket      = listening_socket;
+    uring_p->threadpool_p          = threadpool_p;
+    uring_p->idle_timeout_ms       = idle_timeout_ms;
+    uring_p->write_timeout_ms      = write_timeout_ms;
+    uring_p->drain_timeout_ms      = drain_timeout_ms;
+    uring_p->message_handler       = message_handler;
+    uring_p->client_data_free_func = client_data_free_func;
+    uring_p->user_data_p           = user_data_p;
+    uring_p->tick.tv_nsec          = TCP_URING_TICK_MS * 1000000L;
+    intrusive_list_init(&uring_p->done);
+    intrusive_list_init(&uring_p->connections);
+    pthread_mutex_init(&uring_p->done_mutex, NULL);
+
+    // Only this thread submits, so the kernel can skip locking the ring and
+    // defer completion work until the next wait
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL |
+                   IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    params.cq_entries = TCP_URING_CQ_ENTRIES;
+
+    errno            = 0;
+    uring_p->ring_fd = (int)syscall(__NR_io_uring_setup, TCP_URING_ENTRIES,
+                                    &params);
+    if (0 > uring_p->ring_fd)
+    {
+        print_strerror("tcp_uring_create(): io_uring_setup() failed.");
+        goto FAIL;
+    }
+
+    if ((E_SUCCESS != map_rings(uring_p, &params)) ||
+        (E_SUCCESS != register_buffers(uring_p)))
+    {
+        goto FAIL;
+    }
+
+    errno            = 0;
+    uring_p->wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (0 > uring_p->wake_fd)
+    {
+        print_strerror("tcp_uring_create(): eventfd() failed.");
+        goto FAIL;
+    }
+
+    uring_p->connection_pool = slab_pool_new(sizeof(uring_connection_t), 0);
+    if (NULL == uring_p->connection_pool)
+    {
+        print_error("tcp_uring_create(): Unable to create pool.");
+        goto FAIL;
+    }
+
+    // Timers tick with the ring's own wait timeout. Draining uses them to
+    // close idle connections
+    if ((0 != idle_timeout_ms) || (0 != write_timeout_ms) ||
+        (0 != drain_timeout_ms))
+    {
+        uring_p->timers =
+            timer_wheel_new(0, TCP_URING_TICK_MS, timer_wheel_now_ms());
+        if (NULL == uring_p->timers)
+        {
+            print_error("tcp_uring_create(): Unable to create timers.");
+            goto FAIL;
+        }
+    }
+
+    if ((E_SUCCESS != arm_accept(uring_p)) ||
+        (E_SUCCESS != arm_wake(uring_p)) || (E_SUCCESS != arm_tick(uring_p)))
+    {
+        goto FAIL;
+    }
+
+    goto END;
+
+FAIL:
+    tcp_uring_destroy(&uring_p);
+END:
+    return uring_p;
+}
+
+int tcp_uring_run(tcp_uring_t * uring_p)
+{
+    int                   exit_code = E_FAILURE;
+    unsigned int          head      = 0;
+    struct io_uring_cqe   cqe       = { 0 };
+    uint64_t              deadline  = 0;
+
+    if (NULL == uring_p)
+    {
+        print_error("tcp_uring_run(): NULL argument passed.");
+        goto END;
+    }
+
+    for (;;)
+    {
+        if (!uring_p->stopping &&
+            ((signal_flag_g == SIGINT) || (signal_flag_g == SIGUSR1)))
+        {
+            printf("\nShutdown signal received.\n");
+            if (E_SUCCESS != cancel_accept(uring_p))
+            {
+                goto END;
+            }
+
+            uring_p->stopping = true;
+            deadline = timer_wheel_now_ms() + uring_p->drain_timeout_ms;
+            if (0 != uring_p->drain_timeout_ms)
+            {
+                uring_p->draining = true;
+                begin_drain(uring_p);
+            }
+        }
+
+        if (uring_p->accept_resume && (E_SUCCESS != resume_accept(uring_p)))
+        {
+            goto END;
+        }
+
+        // The accept's final completion is waited for, so the caller may
+        // close the listening socket once this returns. The tick bounds each
+        // wait, so the deadline is checked in time
+        if (uring_p->stopping && !uring_p->accepting &&
+            (!uring_p->draining ||
+             intrusive_list_is_empty(&uring_p->connections) ||
+             (timer_wheel_now_ms() >= deadline)))
+        {
+            exit_code = E_SUCCESS;
+            goto END;
+        }
+
+        if (E_SUCCESS != submit(uring_p, true))
+        {
+            goto END;
+        }
+
+        head = *uring_p->cq_head;
+        while (head != __atomic_load_n(uring_p->cq_tail, __ATOMIC_ACQUIRE))
+        {
+            // Copy the entry out so the kernel may reuse its slot while it
+            // is handled
+            cqe = uring_p->cqes[head & uring_p->cq_mask];
+            head++;
+            __atomic_store_n(uring_p->cq_head, head, __ATOMIC_RELEASE);
+
+            if (E_SUCCESS != handle_completion(uring_p, &cqe))
+            {
+                goto END;
+            }
+        }
+    }
+
+END:
+    return exit_code;
+}
+
+int tcp_uring_destroy(tcp_uring_t ** uring_pp)
+{
+    int                exit_code = E_FAILURE;
+    tcp_uring_t *      uring_p   = NULL;
+    intrusive_link_t * link_p    = NULL;
+
+    if ((NULL == uring_pp) || (NULL == *uring_pp))
+    {
+        print_error("tcp_uring_destroy(): NULL argument passed.");
+        goto END;
+    }
+
+    uring_p = *uring_pp;
+
+    // Closing the ring cancels everything still in flight, so the buffers
+    // and connections below are no longer referenced by the kernel
+    if (0 <= uring_p->ring_fd)
+    {
+        close(uring_p->ring_fd);
+    }
+
+    if (NULL != uring_p->ring_p)
+    {
+        munmap(uring_p->ring_p, uring_p->ring_size);
+    }
+
+    if (NULL != uring_p->sqes)
+    {
+        munmap(uring_p->sqes, uring_p->sqes_size);
+    }
+
+    if (NULL != uring_p->buffer_ring_p)
+    {
+        munmap(uring_p->buffer_ring_p, uring_p->buffer_ring_size);
+    }
+
+    while (NULL !=
+           (link_p = intrusive_list_peek_head(&uring_p->connections)))
+    {
+        free_connection(
+            INTRUSIVE_LIST_ENTRY(link_p, uring_connection_t, link));
+    }
+
+    if (NULL != uring_p->timers)
+    {
+        timer_wheel_destroy(&uring_p->timers);
+    }
+
+    if (NULL != uring_p->connection_pool)
+    {
+        slab_pool_destroy(&uring_p->connection_pool);
+    }
+
+    if (0 <= uring_p->wake_fd)
+    {
+        close(uring_p->wake_fd);
+    }
+
+    pthread_mutex_destroy(&uring_p->done_mutex);
+    free(uring_p->buffers_p);
+    free(uring_p);
+    *uring_pp = NULL;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static int map_rings(tcp_uring_t * uring_p, struct io_uring_params * params_p)
+{
+    int             exit_code = E_FAILURE;
+    unsigned char * ring_p    = NULL;
+    unsigned int *  array_p   = NULL;
+    size_t          cq_size   = 0;
+
+    if (0 == (params_p->features & IORING_FEAT_SINGLE_MMAP))
+    {
+        print_error("map_rings(): Kernel does not map rings together.");
+        goto END;
+    }
+
+    uring_p->ring_size =
+        params_p->sq_off.array + (params_p->sq_entries * sizeof(unsigned int));
+    cq_size = params_p->cq_off.cqes +
+              (params_p->cq_entries * sizeof(struct io_uring_cqe));
+    if (cq_size > uring_p->ring_size)
+    {
+        uring_p->ring_size = cq_size;
+    }
+
+    errno  = 0;
+    ring_p = mmap(NULL,
+                  uring_p->ring_size,
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE,
+                  uring_p->ring_fd,
+                  IORING_OFF_SQ_RING);
+    if (MAP_FAILED == ring_p)
+    {
+        print_strerror("map_rings(): mmap() of rings failed.");
+        goto END;
+    }
+
+    uring_p->ring_p    = ring_p;
+    uring_p->sqes_size = params_p->sq_entries * sizeof(struct io_uring_sqe);
+
+    errno          = 0;
+    uring_p->sqes = mmap(NULL,
+                         uring_p->sqes_size,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE,
+                         uring_p->ring_fd,
+                         IORING_OFF_SQES);
+    if (MAP_FAILED == uring_p->sqes)
+    {
+        print_strerror("map_rings(): mmap() of entries failed.");
+        uring_p->sqes = NULL;
+        goto END;
+    }
+
+    uring_p->sq_head    = (unsigned int *)(ring_p + params_p->sq_off.head);
+    uring_p->sq_tail    = (unsigned int *)(ring_p + params_p->sq_off.tail);
+    uring_p->sq_mask = *(unsigned int *)(ring_p + params_p->sq_off.ring_mask);
+    uring_p->sq_entries = params_p->sq_entries;
+    uring_p->cq_head    = (unsigned int *)(ring_p + params_p->cq_off.head);
+    uring_p->cq_tail    = (unsigned int *)(ring_p + params_p->cq_off.tail);
+    uring_p->cq_mask = *(unsigned int *)(ring_p + params_p->cq_off.ring_mask);
+    uring_p->cqes = (struct io_uring_cqe *)(ring_p + params_p->cq_off.cqes);
+    uring_p->sq_local_tail = *uring_p->sq_tail;
+
+    // Entries are always filled in ring order, so the indirection array can
+    // map each slot to itself once
+    array_p = (unsigned int *)(ring_p + params_p->sq_off.array);
+    for (unsigned int idx = 0; idx < params_p->sq_entries; idx++)
+    {
+        array_p[idx] = idx;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int register_buffers(tcp_uring_t * uring_p)
+{
+    int                     exit_code    = E_FAILURE;
+    struct io_uring_buf_reg registration = { 0 };
+    void *                  ring_p       = NULL;
+
+    // The kernel requires the buffer ring to be page aligned
+    uring_p->buffer_ring_size =
+        TCP_URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+
+    errno  = 0;
+    ring_p = mmap(NULL,
+                  uring_p->buffer_ring_size,
+                  PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS,
+                  -1,
+                  0);
+    if (MAP_FAILED == ring_p)
+    {
+        print_strerror("register_buffers(): mmap() failed.");
+        goto END;
+    }
+
+    uring_p->buffer_ring_p = ring_p;
+
+    uring_p->buffers_p =
+        malloc((size_t)TCP_URING_BUFFER_COUNT * TCP_URING_BUFFER_SIZE);
+    if (NULL == uring_p->buffers_p)
+    {
+        print_error("register_buffers(): buffers_p - CMR failure.");
+        goto END;
+    }
+
+    registration.ring_addr    = (uint64_t)(uintptr_t)ring_p;
+    registration.ring_entries = TCP_URING_BUFFER_COUNT;
+    registration.bgid         = BUFFER_GROUP;
+
+    errno = 0;
+    if (0 > syscall(__NR_io_uring_register,
+                    uring_p->ring_fd,
+                    IORING_REGISTER_PBUF_RING,
+                    &registration,
+                    1))
+    {
+        print_strerror("register_buffers(): io_uring_register() failed.");
+        goto END;
+    }
+
+    for (uint16_t idx = 0; idx < TCP_URING_BUFFER_COUNT; idx++)
+    {
+        recycle_buffer(uring_p, idx);
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static void recycle_buffer(tcp_uring_t * uring_p, uint16_t buffer_id)
+{
+    struct io_uring_buf * buffer_p = NULL;
+
+    buffer_p = &uring_p->buffer_ring_p
+                    ->bufs[uring_p->buffer_tail & (TCP_URING_BUFFER_COUNT - 1)];
+    buffer_p->addr = (uint64_t)(uintptr_t)(uring_p->buffers_p +
+                                           ((size_t)buffer_id *
+                                            TCP_URING_BUFFER_SIZE));
+    buffer_p->len  = TCP_URING_BUFFER_SIZE;
+    buffer_p->bid  = buffer_id;
+
+    uring_p->buffer_tail++;
+    __atomic_store_n(&uring_p->buffer_ring_p->tail,
+                     uring_p->buffer_tail,
+                     __ATOMIC_RELEASE);
+}
+
+static int submit(tcp_uring_t * uring_p, bool wait)
+{
+    int          exit_code = E_FAILURE;
+    unsigned int to_submit = 0;
+
+    __atomic_store_n(
+        uring_p->sq_tail, uring_p->sq_local_tail, __ATOMIC_RELEASE);
+    to_submit = uring_p->sq_local_tail -
+                __atomic_load_n(uring_p->sq_head, __ATOMIC_ACQUIRE);
+
+    errno = 0;
+    if (0 > syscall(__NR_io_uring_enter,
+                    uring_p->ring_fd,
+                    to_submit,
+                    wait ? 1 : 0,
+                    wait ? IORING_ENTER_GETEVENTS : 0,
+                    NULL,
+                    0))
+    {
+        // Interrupted waits and a full completion queue are resolved by
+        // reaping completions and trying again
+        if ((EINTR != errno) && (EAGAIN != errno) && (EBUSY != errno))
+        {
+            print_strerror("submit(): io_uring_enter() failed.");
+            goto END;
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int reserve_sqes(tcp_uring_t * uring_p, unsigned int count)
+{
+    int exit_code = E_FAILURE;
+
+    if ((uring_p->sq_local_tail -
+         __atomic_load_n(uring_p->sq_head, __ATOMIC_ACQUIRE)) + count >
+        uring_p->sq_entries)
+    {
+        if (E_SUCCESS != submit(uring_p, false))
+        {
+            goto END;
+        }
+
+        if ((uring_p->sq_local_tail -
+             __atomic_load_n(uring_p->sq_head, __ATOMIC_ACQUIRE)) + count >
+            uring_p->sq_entries)
+        {
+            print_error("reserve_sqes(): Submission queue is full.");
+            goto END;
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static struct io_uring_sqe * get_sqe(tcp_uring_t *        uring_p,
+                                     uring_op_t           op,
+                                     uring_connection_t * connection_p)
+{
+    struct io_uring_sqe * sqe_p = NULL;
+
+    if (E_SUCCESS != reserve_sqes(uring_p, 1))
+    {
+        goto END;
+    }
+
+    sqe_p = &uring_p->sqes[uring_p->sq_local_tail & uring_p->sq_mask];
+    uring_p->sq_local_tail++;
+
+    memset(sqe_p, 0, sizeof(struct io_uring_sqe));
+    sqe_p->user_data = (uint64_t)(uintptr_t)connection_p | (uint64_t)op;
+
+END:
+    return sqe_p;
+}
+
+static int arm_accept(tcp_uring_t * uring_p)
+{
+    int                   exit_code = E_FAILURE;
+    struct io_uring_sqe * sqe_p     = NULL;
+
+    sqe_p = get_sqe(uring_p, OP_ACCEPT, NULL);
+    if (NULL == sqe_p)
+    {
+        goto END;
+    }
+
+    sqe_p->opcode       = IORING_OP_ACCEPT;
+    sqe_p->fd           = uring_p->listening_socket;
+    sqe_p->ioprio       = IORING_ACCEPT_MULTISHOT;
+    sqe_p->accept_flags = SOCK_CLOEXEC;
+
+    uring_p->accepting = true;
+    exit_code          = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int resume_accept(tcp_uring_t * uring_p)
+{
+    int exit_code = E_SUCCESS;
+
+    uring_p->accept_paused = false;
+    uring_p->accept_resume = false;
+    if (!uring_p->stopping && !uring_p->accepting)
+    {
+        exit_code = arm_accept(uring_p);
+    }
+
+    return exit_code;
+}
+
+static int cancel_accept(tcp_uring_t * uring_p)
+{
+    int                   exit_code = E_FAILURE;
+    struct io_uring_sqe * sqe_p     = NULL;
+
+    sqe_p = get_sqe(uring_p, OP_CANCEL, NULL);
+    if (NULL == sqe_p)
+    {
+        goto END;
+    }
+
+    sqe_p->opcode       = IORING_OP_ASYNC_CANCEL;
+    sqe_p->fd           = uring_p->listening_socket;
+    sqe_p->cancel_flags = IORING_ASYNC_CANCEL_FD;
+
+    exit_code = submit(uring_p, false);
+END:
+    return exit_code;
+}
+
+static void begin_drain(tcp_uring_t * uring_p)
+{
+    intrusive_link_t *   link_p       = NULL;
+    intrusive_link_t *   next_p       = NULL;
+    uring_connection_t * connection_p = NULL;
+
+    INTRUSIVE_LIST_FOREACH(&uring_p->connections, link_p, next_p)
+    {
+        connection_p = INTRUSIVE_LIST_ENTRY(link_p, uring_connection_t, link);
+
+        // A busy connection is closed by on_wake() once its reply is sent
+        if (!connection_p->busy)
+        {
+            set_timer(connection_p, TCP_URING_TICK_MS);
+        }
+    }
+}
+
+static int arm_wake(tcp_uring_t * uring_p)
+{
+    int                   exit_code = E_FAILURE;
+    struct io_uring_sqe * sqe_p     = NULL;
+
+    sqe_p = get_sqe(uring_p, OP_WAKE, NULL);
+    if (NULL == sqe_p)
+    {
+        goto END;
+    }
+
+    sqe_p->opcode = IORING_OP_READ;
+    sqe_p->fd     = uring_p->wake_fd;
+    sqe_p->addr   = (uint64_t)(uintptr_t)&uring_p->wake_value;
+    sqe_p->len    = sizeof(uring_p->wake_value);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int arm_tick(tcp_uring_t * uring_p)
+{
+    int                   exit_code = E_FAILURE;
+    struct io_uring_sqe * sqe_p     = NULL;
+
+    sqe_p = get_sqe(uring_p, OP_TICK, NULL);
+    if (NULL == sqe_p)
+    {
+        goto END;
+    }
+
+    sqe_p->opcode = IORING_OP_TIMEOUT;
+    sqe_p->fd     = -1;
+    sqe_p->addr   = (uint64_t)(uintptr_t)&uring_p->tick;
+    sqe_p->len    = 1;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int arm_recv(uring_connection_t * connection_p)
+{
+    int                   exit_code = E_FAILURE;
+    struct io_uring_sqe * sqe_p     = NULL;
+
+    sqe_p = get_sqe(connection_p->uring_p, OP_RECV, connection_p);
+    if (NULL == sqe_p)
+    {
+        goto END;
+    }
+
+    sqe_p->opcode    = IORING_OP_RECV;
+    sqe_p->fd        = connection_p->client.client_fd;
+    sqe_p->ioprio    = IORING_RECV_MULTISHOT;
+    sqe_p->flags     = IOSQE_BUFFER_SELECT;
+    sqe_p->buf_group = BUFFER_GROUP;
+
+    connection_p->pending++;
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int queue_send(uring_connection_t * connection_p)
+{
+    int                   exit_code = E_FAILURE;
+    tcp_uring_t *         uring_p   = connection_p->uring_p;
+    struct io_uring_sqe * sqe_p     = NULL;
+    size_t                remaining = 0;
+
+    // Both entries of a linked pair must go to the kernel in one submit
+    if (E_SUCCESS != reserve_sqes(uring_p, connection_p->closing ? 2 : 1))
+    {
+        goto END;
+    }
+
+    remaining = connection_p->reply.length - connection_p->reply_sent;
+    if (UINT32_MAX < remaining)
+    {
+        remaining = UINT32_MAX;
+    }
+
+    sqe_p            = get_sqe(uring_p, OP_SEND, connection_p);
+    sqe_p->opcode    = IORING_OP_SEND;
+    sqe_p->fd        = connection_p->client.client_fd;
+    sqe_p->addr      = (uint64_t)(uintptr_t)(connection_p->reply.data_p +
+                                        connection_p->reply_sent);
+    sqe_p->len       = (uint32_t)remaining;
+    sqe_p->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+    connection_p->pending++;
+    set_timer(connection_p, uring_p->write_timeout_ms);
+
+    if (connection_p->closing)
+    {
+        // Runs only once every byte is sent; a short or failed send cancels
+        // it instead
+        sqe_p->flags |= IOSQE_IO_LINK;
+
+        sqe_p         = get_sqe(uring_p, OP_SHUTDOWN, connection_p);
+        sqe_p->opcode = IORING_OP_SHUTDOWN;
+        sqe_p->fd     = connection_p->client.client_fd;
+        sqe_p->len    = SHUT_RDWR;
+        connection_p->pending++;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int handle_completion(tcp_uring_t *         uring_p,
+                             struct io_uring_cqe * cqe_p)
+{
+    int                  exit_code    = E_FAILURE;
+    uring_op_t           op           = OP_ACCEPT;
+    uring_connection_t * connection_p = NULL;
+
+    op = (uring_op_t)(cqe_p->user_data & OP_MASK);
+    connection_p =
+        (uring_connection_t *)(uintptr_t)(cqe_p->user_data & ~OP_MASK);
+
+    switch (op)
+    {
+        case OP_ACCEPT:
+            if (0 <= cqe_p->res)
+            {
+                add_connection(uring_p, cqe_p->res);
+            }
+            else if ((-EINVAL == cqe_p->res) || (-EBADF == cqe_p->res) ||
+                     (-ENOTSOCK == cqe_p->res))
+            {
+                errno = -cqe_p->res;
+                print_strerror("tcp_uring_run(): accept failed.");
+                goto END;
+            }
+            else if ((-EMFILE == cqe_p->res) || (-ENFILE == cqe_p->res) ||
+                     (-ENOBUFS == cqe_p->res) || (-ENOMEM == cqe_p->res))
+            {
+                // Arming again at once would fail the same way
+                errno = -cqe_p->res;
+                print_strerror("tcp_uring_run(): accept paused.");
+                uring_p->accept_paused = true;
+            }
+
+            if (0 != (cqe_p->flags & IORING_CQE_F_MORE))
+            {
+                break;
+            }
+
+            // The accept has ended. It is armed again unless it was
+            // cancelled, paused or the engine is shutting down
+            uring_p->accepting = false;
+            if (!uring_p->stopping && !uring_p->accept_paused &&
+                (-ECANCELED != cqe_p->res) &&
+                (E_SUCCESS != arm_accept(uring_p)))
+            {
+                goto END;
+            }
+            break;
+
+        case OP_RECV:
+            connection_p->pending -= (0 == (cqe_p->flags & IORING_CQE_F_MORE));
+            on_recv(connection_p, cqe_p);
+            break;
+
+        case OP_SEND:
+            connection_p->pending--;
+            on_send(connection_p, cqe_p->res);
+            break;
+
+        case OP_SHUTDOWN:
+            connection_p->pending--;
+
+            // A shutdown cancelled by a short send is queued again with the
+            // rest of the reply; any other failure is retried directly
+            if ((0 > cqe_p->res) && (-ECANCELED != cqe_p->res))
+            {
+                shutdown_connection(connection_p);
+            }
+
+            release_if_idle(connection_p);
+            break;
+
+        case OP_WAKE:
+            if (E_SUCCESS != arm_wake(uring_p))
+            {
+                goto END;
+            }
+
+            on_wake(uring_p);
+            break;
+
+        case OP_TICK:
+            if (E_SUCCESS != arm_tick(uring_p))
+            {
+                goto END;
+            }
+
+            if (NULL != uring_p->timers)
+            {
+                reap_expired(uring_p);
+            }
+
+            // Descriptors may also have been freed outside this engine
+            uring_p->accept_resume = uring_p->accept_paused;
+            break;
+
+        case OP_CANCEL:
+            break;
+
+        default:
+            print_error("tcp_uring_run(): Unknown completion.");
+            goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static void add_connection(tcp_uring_t * uring_p, int client_fd)
+{
+    uring_connection_t * connection_p = NULL;
+
+    connection_p = slab_pool_alloc(uring_p->connection_pool);
+    if (NULL == connection_p)
+    {
+        print_error("add_connection(): connection_p - CMR failure.");
+        close(client_fd);
+        return;
+    }
+
+    connection_p->client.client_fd   = client_fd;
+    connection_p->client.user_data_p = uring_p->user_data_p;
+    connection_p->uring_p            = uring_p;
+    intrusive_link_init(&connection_p->link);
+    intrusive_link_init(&connection_p->done_link);
+    timer_wheel_entry_init(&connection_p->timer);
+    intrusive_list_push_tail(&uring_p->connections, &connection_p->link);
+
+    if (E_SUCCESS != arm_recv(connection_p))
+    {
+        free_connection(connection_p);
+        return;
+    }
+
+    // Accepts completed before the cancel are served like idle connections
+    set_timer(connection_p,
+              uring_p->draining ? TCP_URING_TICK_MS
+                                : uring_p->idle_timeout_ms);
+}
+
+static void on_recv(uring_connection_t * connection_p,
+                    struct io_uring_cqe * cqe_p)
+{
+    tcp_uring_t *   uring_p   = connection_p->uring_p;
+    unsigned char * buffer_p  = NULL;
+    unsigned char * grown_p   = NULL;
+    size_t          capacity  = 0;
+    uint16_t        buffer_id = 0;
+    bool            ended     = (0 == (cqe_p->flags & IORING_CQE_F_MORE));
+
+    if (0 != (cqe_p->flags & IORING_CQE_F_BUFFER))
+    {
+        buffer_id = (uint16_t)(cqe_p->flags >> IORING_CQE_BUFFER_SHIFT);
+        buffer_p  = uring_p->buffers_p +
+                   ((size_t)buffer_id * TCP_URING_BUFFER_SIZE);
+
+        // Input only builds up while a job runs, so a client that keeps
+        // sending without waiting for replies is cut off here
+        if (TCP_URING_MAX_INPUT - connection_p->input_length <
+            (size_t)cqe_p->res)
+        {
+            print_error("on_recv(): Input limit reached.");
+            connection_p->closing = true;
+            shutdown_connection(connection_p);
+        }
+
+        capacity = connection_p->input_capacity;
+        while (capacity < connection_p->input_length + (size_t)cqe_p->res)
+        {
+            capacity = (0 == capacity) ? TCP_URING_BUFFER_SIZE : capacity * 2;
+        }
+
+        if (!connection_p->closing &&
+            (capacity != connection_p->input_capacity))
+        {
+            grown_p = realloc(connection_p->input_p, capacity);
+            if (NULL == grown_p)
+            {
+                print_error("on_recv(): input_p - CMR failure.");
+                connection_p->closing = true;
+                shutdown_connection(connection_p);
+            }
+            else
+            {
+                connection_p->input_p        = grown_p;
+                connection_p->input_capacity = capacity;
+            }
+        }
+
+        if (!connection_p->closing)
+        {
+            memcpy(connection_p->input_p + connection_p->input_length,
+                   buffer_p,
+                   (size_t)cqe_p->res);
+            connection_p->input_length += (size_t)cqe_p->res;
+        }
+
+        // The bytes are copied out, so the buffer can take the next segment
+        recycle_buffer(uring_p, buffer_id);
+    }
+
+    // The kernel ends a multishot receive when the peer closes and on
+    // errors, but also when it runs out of buffers or completion space, in
+    // which case the connection is still open and receiving is re-armed
+    if (ended && ((0 < cqe_p->res) || (-ENOBUFS == cqe_p->res)) &&
+        !connection_p->closing &&
+        (E_SUCCESS != arm_recv(connection_p)))
+    {
+        connection_p->closing = true;
+        shutdown_connection(connection_p);
+    }
+
+    if (!connection_p->busy && !connection_p->closing &&
+        (0 != connection_p->input_length))
+    {
+        dispatch(connection_p);
+    }
+
+    release_if_idle(connection_p);
+}
+
+static void on_send(uring_connection_t * connection_p, int result)
+{
+    if (0 > result)
+    {
+        connection_p->closing = true;
+        shutdown_connection(connection_p);
+        end_request(connection_p);
+        return;
+    }
+
+    connection_p->reply_sent += (size_t)result;
+    if (connection_p->reply_sent < connection_p->reply.length)
+    {
+        if (E_SUCCESS != queue_send(connection_p))
+        {
+            connection_p->closing = true;
+            shutdown_connection(connection_p);
+            end_request(connection_p);
+        }
+
+        return;
+    }
+
+    end_request(connection_p);
+}
+
+static void on_wake(tcp_uring_t * uring_p)
+{
+    intrusive_list_t     finished;
+    intrusive_link_t *   link_p       = NULL;
+    uring_connection_t * connection_p = NULL;
+
+    intrusive_list_init(&finished);
+
+    pthread_mutex_lock(&uring_p->done_mutex);
+    intrusive_list_splice_tail(&finished, &uring_p->done);
+    pthread_mutex_unlock(&uring_p->done_mutex);
+
+    while (NULL != (link_p = intrusive_list_pop_head(&finished)))
+    {
+        connection_p = INTRUSIVE_LIST_ENTRY(link_p, uring_connection_t,
+                                            done_link);
+
+        if (!connection_p->client.keep_alive || uring_p->draining)
+        {
+            connection_p->closing = true;
+        }
+
+        connection_p->reply_sent = 0;
+        if ((0 != connection_p->reply.length) &&
+            (E_SUCCESS == queue_send(connection_p)))
+        {
+            continue;
+        }
+
+        // Nothing to send, or the send could not be queued
+        if (connection_p->closing)
+        {
+            shutdown_connection(connection_p);
+        }
+
+        end_request(connection_p);
+    }
+}
+
+static void dispatch(uring_connection_t * connection_p)
+{
+    unsigned char * swap_p   = connection_p->request_p;
+    size_t          capacity = connection_p->request_capacity;
+
+    // Hand the received bytes to the job and keep the job's old buffer for
+    // whatever arrives while it runs
+    connection_p->request_p        = connection_p->input_p;
+    connection_p->request_length   = connection_p->input_length;
+    connection_p->request_capacity = connection_p->input_capacity;
+    connection_p->input_p          = swap_p;
+    connection_p->input_length     = 0;
+    connection_p->input_capacity   = capacity;
+    connection_p->busy             = true;
+
+    // Time spent in the handler is not the client's
+    set_timer(connection_p, 0);
+
+    if (E_SUCCESS != threadpool_add_job(connection_p->uring_p->threadpool_p,
+                                        run_message_handler,
+                                        NULL,
+                                        connection_p))
+    {
+        print_error("dispatch(): Unable to add job to pool.");
+        connection_p->busy    = false;
+        connection_p->closing = true;
+        shutdown_connection(connection_p);
+    }
+}
+
+static void * run_message_handler(void * args_p)
+{
+    uring_connection_t * connection_p = args_p;
+    tcp_uring_t *        uring_p      = connection_p->uring_p;
+    bool                 wake         = false;
+
+    connection_p->client.keep_alive = false;
+    connection_p->reply.length      = 0;
+    uring_p->message_handler(&connection_p->client,
+                             connection_p->request_p,
+                             connection_p->request_length,
+                             &connection_p->reply);
+
+    pthread_mutex_lock(&uring_p->done_mutex);
+    wake = intrusive_list_is_empty(&uring_p->done);
+    intrusive_list_push_tail(&uring_p->done, &connection_p->done_link);
+    pthread_mutex_unlock(&uring_p->done_mutex);
+
+    // A non-empty list already has a wake on its way, and the ring thread
+    // takes the whole list at once
+    if (wake && (0 > eventfd_write(uring_p->wake_fd, 1)))
+    {
+        print_strerror("run_message_handler(): eventfd_write() failed.");
+    }
+
+    return NULL;
+}
+
+static void end_request(uring_connection_t * connection_p)
+{
+    connection_p->busy = false;
+
+    if (!connection_p->closing && (0 != connection_p->input_length))
+    {
+        dispatch(connection_p);
+    }
+    else if (connection_p->closing)
+    {
+        set_timer(connection_p, 0);
+    }
+    else
+    {
+        set_timer(connection_p, connection_p->uring_p->idle_timeout_ms);
+    }
+
+    release_if_idle(connection_p);
+}
+
+static void shutdown_connection(uring_connection_t * connection_p)
+{
+    // A connection the peer already reset reports ENOTCONN, which is fine
+    (void)shutdown(connection_p->client.client_fd, SHUT_RDWR);
+}
+
+static void release_if_idle(uring_connection_t * connection_p)
+{
+    if ((0 == connection_p->pending) && !connection_p->busy)
+    {
+        free_connection(connection_p);
+    }
+}
+
+static void free_connection(uring_connection_t * connection_p)
+{
+    tcp_uring_t * uring_p = connection_p->uring_p;
+
+    intrusive_list_remove(&uring_p->connections, &connection_p->link);
+    set_timer(connection_p, 0);
+    uring_p->accept_resume = uring_p->accept_paused;
+
+    if (NULL != uring_p->client_data_free_func)
+    {
+        uring_p->client_data_free_func(&connection_p->client);
+    }
+
+    close(connection_p->client.client_fd);
+    free(connection_p->input_p);
+    free(connection_p->request_p);
+    free(connection_p->reply.data_p);
+    slab_pool_free(uring_p->connection_pool, connection_p);
+}
+
+static void set_timer(uring_connection_t * connection_p,
+                      unsigned int         timeout_ms)
+{
+    timer_wheel_t * timers_p = connection_p->uring_p->timers;
+
+    if (NULL == timers_p)
+    {
+        return;
+    }
+
+    if (0 == timeout_ms)
+    {
+        timer_wheel_cancel(timers_p, &connection_p->timer);
+        return;
+    }
+
+    timer_wheel_schedule(timers_p,
+                         &connection_p->timer,
+                         timer_wheel_now_ms() + timeout_ms);
+}
+
+static void reap_expired(tcp_uring_t * uring_p)
+{
+    intrusive_list_t     expired;
+    intrusive_link_t *   link_p       = NULL;
+    uring_connection_t * connection_p = NULL;
+
+    intrusive_list_init(&expired);
+    (void)timer_wheel_expire(uring_p->timers, timer_wheel_now_ms(), &expired);
+
+    // Shutting the socket down ends the receive and any send in flight with
+    // an error or end of stream, and their completions free the connection
+    while (NULL != (link_p = intrusive_list_pop_head(&expired)))
+    {
+        connection_p =
+            INTRUSIVE_LIST_ENTRY(link_p, uring_connection_t, timer.link);
+        connection_p->closing = true;
+        shutdown_connection(connection_p);
+    }
+}
+
+/*** end of file ***/
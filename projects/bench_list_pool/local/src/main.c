@@ -0,0 +1,269 @@
+/**
+ * @file main.c
+ *
+ * @brief Compares push and pop throughput of a list_t whose nodes come from
+ * malloc() with one whose nodes come from a slab pool.
+ *
+ * Usage: bench_list_pool [element count] [rounds]
+ *
+ * Fill and drain pushes every element onto the tail and then pops them all
+ * from the head, so each round allocates and frees 'count' nodes. Steady
+ * queue keeps QUEUE_DEPTH elements in the list and pushes one for every one
+ * it pops, which is the pattern of a work queue.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "linked_list.h"
+#include "utilities.h"
+
+#define DEFAULT_COUNT  (1 << 20)
+#define DEFAULT_ROUNDS 20
+#define QUEUE_DEPTH    64
+#define NS_PER_SEC     1000000000ULL
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return uint64_t The current time in nanoseconds.
+ */
+static uint64_t now_ns(void);
+
+/**
+ * @brief Stands in as the list's free function, as every node points at the
+ * same static value.
+ *
+ * @param data Unused.
+ */
+static void keep_element(void * data);
+
+/**
+ * @brief Pops the head of the list and releases its node.
+ *
+ * @param list The list.
+ * @return int E_SUCCESS, or E_FAILURE if the list was empty.
+ */
+static int pop_and_release(list_t * list);
+
+/**
+ * @brief Pushes 'count' elements onto the tail, then pops them all.
+ *
+ * @param list The list, empty on entry and on return.
+ * @param count Number of elements.
+ * @param rounds Number of rounds.
+ * @return int E_SUCCESS or E_FAILURE.
+ */
+static int fill_and_drain(list_t * list, int count, int rounds);
+
+/**
+ * @brief Pushes and pops 'count' elements each round, keeping QUEUE_DEPTH of
+ * them in the list.
+ *
+ * @param list The list, empty on entry and on return.
+ * @param count Number of elements.
+ * @param rounds Number of rounds.
+ * @return int E_SUCCESS or E_FAILURE.
+ */
+static int steady_queue(list_t * list, int count, int rounds);
+
+/**
+ * @brief Times a workload on a malloc() list and on a pooled list, and prints
+ * both with the pooled list's speedup.
+ *
+ * @param name Name of the workload.
+ * @param workload The workload.
+ * @param count Number of elements.
+ * @param rounds Number of rounds.
+ * @return int E_SUCCESS or E_FAILURE.
+ */
+static int compare(const char * name,
+                   int (*workload)(list_t *, int, int),
+                   int count,
+                   int rounds);
+
+static int value_g = 0;
+
+int main(int argc, char ** argv)
+{
+    int exit_code = E_FAILURE;
+    int count     = DEFAULT_COUNT;
+    int rounds    = DEFAULT_ROUNDS;
+
+    if (1 < argc)
+    {
+        count = atoi(argv[1]);
+    }
+    if (2 < argc)
+    {
+        rounds = atoi(argv[2]);
+    }
+
+    if ((0 >= count) || (0 >= rounds))
+    {
+        fprintf(stderr, "Usage: %s [element count] [rounds]\n", argv[0]);
+        goto END;
+    }
+
+    printf("%d elements, %d rounds, ns per push and pop pair\n\n",
+           count,
+           rounds);
+
+    if ((E_SUCCESS !=
+         compare("fill and drain", fill_and_drain, count, rounds)) ||
+        (E_SUCCESS != compare("steady queue", steady_queue, count, rounds)))
+    {
+        goto END;
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static uint64_t now_ns(void)
+{
+    struct timespec now = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * NS_PER_SEC) + (uint64_t)now.tv_nsec;
+}
+
+static void keep_element(void * data)
+{
+    (void)data;
+}
+
+static int pop_and_release(list_t * list)
+{
+    int           exit_code = E_FAILURE;
+    list_node_t * node      = list_pop_head(list);
+
+    if (NULL == node)
+    {
+        goto END;
+    }
+
+    list_node_release(list, node);
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int fill_and_drain(list_t * list, int count, int rounds)
+{
+    int exit_code = E_FAILURE;
+
+    for (int round = 0; round < rounds; round++)
+    {
+        for (int idx = 0; idx < count; idx++)
+        {
+            if (E_SUCCESS != list_push_tail(list, &value_g))
+            {
+                goto END;
+            }
+        }
+
+        for (int idx = 0; idx < count; idx++)
+        {
+            if (E_SUCCESS != pop_and_release(list))
+            {
+                goto END;
+            }
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int steady_queue(list_t * list, int count, int rounds)
+{
+    int exit_code = E_FAILURE;
+
+    for (int idx = 0; idx < QUEUE_DEPTH; idx++)
+    {
+        if (E_SUCCESS != list_push_tail(list, &value_g))
+        {
+            goto END;
+        }
+    }
+
+    for (int round = 0; round < rounds; round++)
+    {
+        for (int idx = 0; idx < count; idx++)
+        {
+            if ((E_SUCCESS != list_push_tail(list, &value_g)) ||
+                (E_SUCCESS != pop_and_release(list)))
+            {
+                goto END;
+            }
+        }
+    }
+
+    for (int idx = 0; idx < QUEUE_DEPTH; idx++)
+    {
+        if (E_SUCCESS != pop_and_release(list))
+        {
+            goto END;
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static int compare(const char * name,
+                   int (*workload)(list_t *, int, int),
+                   int count,
+                   int rounds)
+{
+    int      exit_code = E_FAILURE;
+    uint64_t start     = 0;
+    uint64_t baseline  = 0;
+    uint64_t elapsed   = 0;
+    double   pairs     = (double)count * rounds;
+    list_t * plain     = list_new(keep_element, NULL);
+    list_t * pooled    = list_new_pooled(keep_element, NULL, 0);
+
+    if ((NULL == plain) || (NULL == pooled))
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    start = now_ns();
+    if (E_SUCCESS != workload(plain, count, rounds))
+    {
+        goto END;
+    }
+    baseline = now_ns() - start;
+
+    start = now_ns();
+    if (E_SUCCESS != workload(pooled, count, rounds))
+    {
+        goto END;
+    }
+    elapsed = now_ns() - start;
+
+    printf("%s\n", name);
+    printf("  %-16s %8.2f ns\n", "list_new", (double)baseline / pairs);
+    printf("  %-16s %8.2f ns  %6.2fx\n",
+           "list_new_pooled",
+           (double)elapsed / pairs,
+           (double)baseline / (double)((0 == elapsed) ? 1 : elapsed));
+
+    exit_code = E_SUCCESS;
+END:
+    list_delete(&plain);
+    list_delete(&pooled);
+    return exit_code;
+}
+
+/*** end of file ***/
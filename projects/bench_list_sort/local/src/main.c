@@ -0,0 +1,436 @@
+/**
+ * @file main.c
+ *
+ * @brief Compares the recursive merge sort list_sort() used to be with the
+ * bottom-up merge sort of list_sort() and the array sort of list_sort_array().
+ *
+ * Usage: bench_list_sort [element count] [rounds] [seed]
+ *
+ * Each sort gets its own list of 'count' nodes. Before every round the nodes
+ * are given the same random keys in the same order, so all three sorts see
+ * identical inputs. The recursive sort recurses once per node, so the whole
+ * benchmark runs on a thread whose stack is sized for the element count.
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "linked_list.h"
+#include "utilities.h"
+
+#define DEFAULT_COUNT   (1 << 20)
+#define DEFAULT_ROUNDS  5
+#define DEFAULT_SEED    1
+#define NS_PER_SEC      1000000000ULL
+#define NS_PER_MSEC     1000000.0
+#define FRAME_BYTES     256
+#define STACK_BASE      (1 << 20)
+
+typedef int (*SORT_F)(list_t *);
+
+typedef struct bench_t
+{
+    int   count;
+    int   rounds;
+    int * keys;
+    int   exit_code;
+} bench_t;
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return uint64_t The current time in nanoseconds.
+ */
+static uint64_t now_ns(void);
+
+/**
+ * @brief Stands in as the list's free function, as the keys belong to the
+ * benchmark.
+ *
+ * @param data Unused.
+ */
+static void keep_element(void * data);
+
+/**
+ * @brief Splits a list in two halves. Copied from the recursive sort.
+ *
+ * @param head Head of the list.
+ * @param first_half Receives the first half.
+ * @param second_half Receives the second half.
+ */
+static void split(list_node_t *  head,
+                  list_node_t ** first_half,
+                  list_node_t ** second_half);
+
+/**
+ * @brief Merges two sorted lists, recursing once per node. Copied from the
+ * recursive sort.
+ *
+ * @param first First sorted list.
+ * @param second Second sorted list.
+ * @param compare_func Compare function.
+ * @return list_node_t* Head of the merged list.
+ */
+static list_node_t * merge(list_node_t * first,
+                           list_node_t * second,
+                           CMP_F         compare_func);
+
+/**
+ * @brief Recursive top-down merge sort. Copied from the recursive sort.
+ *
+ * @param head_ref Head of the list, replaced by the sorted head.
+ * @param compare_func Compare function.
+ */
+static void merge_sort(list_node_t ** head_ref, CMP_F compare_func);
+
+/**
+ * @brief Sorts a list the way list_sort() did before it became iterative.
+ *
+ * @param list The list.
+ * @return int E_SUCCESS or E_FAILURE.
+ */
+static int recursive_sort(list_t * list);
+
+/**
+ * @brief Gives the nodes of a list the benchmark keys in their original
+ * order.
+ *
+ * @param list The list.
+ * @param keys The keys, one per node.
+ */
+static void reset_keys(list_t * list, int * keys);
+
+/**
+ * @brief Checks that the list runs from head to tail in ascending order and
+ * that the tail pointer is the last node.
+ *
+ * @param list The list.
+ * @return int E_SUCCESS if sorted, E_FAILURE otherwise.
+ */
+static int check_sorted(list_t * list);
+
+/**
+ * @brief Times a sort over every round and prints its time per sort.
+ *
+ * @param name Name of the sort.
+ * @param sort The sort.
+ * @param bench The benchmark parameters.
+ * @param baseline Time of the recursive sort, 0 if this is it.
+ * @param elapsed_p Receives the total time.
+ * @return int E_SUCCESS or E_FAILURE.
+ */
+static int time_sort(const char * name,
+                     SORT_F       sort,
+                     bench_t *    bench,
+                     uint64_t     baseline,
+                     uint64_t *   elapsed_p);
+
+/**
+ * @brief Runs the three sorts, on the thread with the large stack.
+ *
+ * @param arg The benchmark parameters.
+ * @return void* NULL.
+ */
+static void * run_bench(void * arg);
+
+int main(int argc, char ** argv)
+{
+    int            exit_code = E_FAILURE;
+    bench_t        bench     = { DEFAULT_COUNT, DEFAULT_ROUNDS, NULL, 0 };
+    int            seed      = DEFAULT_SEED;
+    pthread_t      thread    = { 0 };
+    pthread_attr_t attr      = { 0 };
+
+    if (1 < argc)
+    {
+        bench.count = atoi(argv[1]);
+    }
+    if (2 < argc)
+    {
+        bench.rounds = atoi(argv[2]);
+    }
+    if (3 < argc)
+    {
+        seed = atoi(argv[3]);
+    }
+
+    if ((0 >= bench.count) || (0 >= bench.rounds))
+    {
+        fprintf(stderr,
+                "Usage: %s [element count] [rounds] [seed]\n",
+                argv[0]);
+        goto END;
+    }
+
+    bench.keys      = calloc((size_t)bench.count, sizeof(*bench.keys));
+    bench.exit_code = E_FAILURE;
+    if (NULL == bench.keys)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    srand((unsigned int)seed);
+    for (int idx = 0; idx < bench.count; idx++)
+    {
+        bench.keys[idx] = rand();
+    }
+
+    if ((0 != pthread_attr_init(&attr)) ||
+        (0 != pthread_attr_setstacksize(
+                  &attr,
+                  ((size_t)bench.count * FRAME_BYTES) + STACK_BASE)) ||
+        (0 != pthread_create(&thread, &attr, run_bench, &bench)))
+    {
+        print_error("Unable to start the benchmark thread.");
+        goto END;
+    }
+
+    pthread_join(thread, NULL);
+    exit_code = bench.exit_code;
+END:
+    pthread_attr_destroy(&attr);
+    free(bench.keys);
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static uint64_t now_ns(void)
+{
+    struct timespec now = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * NS_PER_SEC) + (uint64_t)now.tv_nsec;
+}
+
+static void keep_element(void * data)
+{
+    (void)data;
+}
+
+static void split(list_node_t *  head,
+                  list_node_t ** first_half,
+                  list_node_t ** second_half)
+{
+    list_node_t * slow = head;
+    list_node_t * fast = head->next;
+
+    while (NULL != fast)
+    {
+        fast = fast->next;
+        if (NULL != fast)
+        {
+            slow = slow->next;
+            fast = fast->next;
+        }
+    }
+
+    *first_half  = head;
+    *second_half = slow->next;
+    slow->next   = NULL;
+}
+
+static list_node_t * merge(list_node_t * first,
+                           list_node_t * second,
+                           CMP_F         compare_func)
+{
+    list_node_t * result = NULL;
+
+    if (NULL == first)
+    {
+        result = second;
+        goto END;
+    }
+
+    if (NULL == second)
+    {
+        result = first;
+        goto END;
+    }
+
+    if (LESS_THAN == compare_func(first->data, second->data))
+    {
+        result             = first;
+        result->next       = merge(first->next, second, compare_func);
+        result->next->prev = result;
+        result->prev       = NULL;
+    }
+    else
+    {
+        result             = second;
+        result->next       = merge(first, second->next, compare_func);
+        result->next->prev = result;
+        result->prev       = NULL;
+    }
+
+END:
+    return result;
+}
+
+static void merge_sort(list_node_t ** head_ref, CMP_F compare_func)
+{
+    list_node_t * head = *head_ref;
+    list_node_t * first_half;
+    list_node_t * second_half;
+
+    if ((NULL == head) || (NULL == head->next))
+    {
+        return;
+    }
+
+    split(head, &first_half, &second_half);
+
+    merge_sort(&first_half, compare_func);
+    merge_sort(&second_half, compare_func);
+
+    *head_ref = merge(first_half, second_half, compare_func);
+}
+
+static int recursive_sort(list_t * list)
+{
+    list_node_t * node = NULL;
+
+    merge_sort(&(list->head), list->compare_func);
+
+    // The old sort left the tail pointer stale; walk to it so the list stays
+    // usable between rounds.
+    node = list->head;
+    while ((NULL != node) && (NULL != node->next))
+    {
+        node = node->next;
+    }
+    list->tail = node;
+
+    return E_SUCCESS;
+}
+
+static void reset_keys(list_t * list, int * keys)
+{
+    int idx = 0;
+
+    for (list_node_t * node = list->head; NULL != node; node = node->next)
+    {
+        node->data = &keys[idx];
+        idx++;
+    }
+}
+
+static int check_sorted(list_t * list)
+{
+    int           exit_code = E_FAILURE;
+    list_node_t * node      = list->head;
+
+    while ((NULL != node) && (NULL != node->next))
+    {
+        if (*(int *)node->data > *(int *)node->next->data)
+        {
+            goto END;
+        }
+        node = node->next;
+    }
+
+    if (node == list->tail)
+    {
+        exit_code = E_SUCCESS;
+    }
+END:
+    return exit_code;
+}
+
+static int time_sort(const char * name,
+                     SORT_F       sort,
+                     bench_t *    bench,
+                     uint64_t     baseline,
+                     uint64_t *   elapsed_p)
+{
+    int      exit_code = E_FAILURE;
+    uint64_t start     = 0;
+    uint64_t elapsed   = 0;
+    list_t * list      = list_new(keep_element, int_comp);
+
+    if (NULL == list)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    for (int idx = 0; idx < bench->count; idx++)
+    {
+        if (E_SUCCESS != list_push_tail(list, &bench->keys[idx]))
+        {
+            goto END;
+        }
+    }
+
+    for (int round = 0; round < bench->rounds; round++)
+    {
+        reset_keys(list, bench->keys);
+
+        start = now_ns();
+        if (E_SUCCESS != sort(list))
+        {
+            goto END;
+        }
+        elapsed += now_ns() - start;
+
+        if (E_SUCCESS != check_sorted(list))
+        {
+            fprintf(stderr, "%s left the list unsorted\n", name);
+            goto END;
+        }
+    }
+
+    printf("  %-16s %8.2f ms",
+           name,
+           (double)elapsed / bench->rounds / NS_PER_MSEC);
+    if (0 != baseline)
+    {
+        printf("  %6.2fx",
+               (double)baseline / (double)((0 == elapsed) ? 1 : elapsed));
+    }
+    printf("\n");
+
+    *elapsed_p = elapsed;
+    exit_code  = E_SUCCESS;
+END:
+    list_delete(&list);
+    return exit_code;
+}
+
+static void * run_bench(void * arg)
+{
+    bench_t * bench    = arg;
+    uint64_t  baseline = 0;
+    uint64_t  elapsed  = 0;
+
+    printf("%d elements, %d rounds, ms per sort\n\n",
+           bench->count,
+           bench->rounds);
+
+    if ((E_SUCCESS != time_sort("recursive merge",
+                                recursive_sort,
+                                bench,
+                                0,
+                                &baseline)) ||
+        (E_SUCCESS !=
+         time_sort("list_sort", list_sort, bench, baseline, &elapsed)) ||
+        (E_SUCCESS != time_sort(
+                          "list_sort_array",
+                          list_sort_array,
+                          bench,
+                          baseline,
+                          &elapsed)))
+    {
+        goto END;
+    }
+
+    bench->exit_code = E_SUCCESS;
+END:
+    return NULL;
+}
+
+/*** end of file ***/
@@ -0,0 +1,548 @@
+/**
+ * @file main.c
+ *
+ * @brief Counts the system calls the TCP server makes per echo request, to
+ * compare the reactor and io_uring engines.
+ *
+ * Usage: bench_tcp_syscalls [reactor|uring|thread] [connections] [requests]
+ *
+ * The server runs in a child process traced with ptrace, every thread
+ * included. Requests go out in rounds: one request on every keep-alive
+ * connection, then every reply is read. The first round is not counted, so
+ * accepts and connection setup are left out. Every system call the server
+ * enters from the second round until the last reply arrives is counted.
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "signal_handler.h"
+#include "tcp_server.h"
+#include "tcp_uring.h"
+#include "utilities.h"
+
+#define DEFAULT_CONNECTIONS 50
+#define DEFAULT_REQUESTS    10000
+#define SERVER_PORT         "39042"
+#define SERVER_PORT_NUMBER  39042
+#define SERVER_WORKERS      4
+#define CONNECT_ATTEMPTS    500
+#define CONNECT_RETRY_NS    10000000L
+#define MAX_SYSCALL         512
+#define REQUEST             "syscalls\n"
+#define REQUEST_LENGTH      (sizeof(REQUEST) - 1)
+#define REPORT_MIN_RATE     0.01
+
+/**
+ * @brief The client side of a run, shared with the load thread.
+ */
+typedef struct load
+{
+    pid_t server;      // The traced server process
+    int   connections; // Keep-alive connections to spread requests over
+    int   requests;    // Requests counted, spread over rounds
+    int   measuring;   // Set while counted requests are in flight
+    int   result;      // E_SUCCESS once every request got its reply
+} load_t;
+
+/**
+ * @brief A system call reported by name.
+ */
+typedef struct syscall_name
+{
+    long         number;
+    const char * name;
+} syscall_name_t;
+
+/**
+ * @brief Runs the echo server in the traced child, after stopping so the
+ * tracer can set its options.
+ *
+ * @param mode The server mode.
+ * @param connections Number of client connections, sizes the pool in thread
+ * per connection mode.
+ */
+static void run_server(tcp_server_mode_t mode, int connections);
+
+/**
+ * @brief Message handler that echoes each request and keeps the connection.
+ *
+ * @param client_p The client.
+ * @param request_p The bytes received.
+ * @param request_length Number of bytes received.
+ * @param reply_p The reply.
+ */
+static void echo_message(client_data_t * client_p,
+                         const void *    request_p,
+                         size_t          request_length,
+                         tcp_reply_t *   reply_p);
+
+/**
+ * @brief Load thread: connects, sends the requests and then stops the server
+ * with SIGINT.
+ *
+ * @param arg_p The load_t.
+ * @return void * Always NULL.
+ */
+static void * run_load(void * arg_p);
+
+/**
+ * @brief Connects to the server, retrying while it starts up.
+ *
+ * @return int The connected socket, or -1 on failure.
+ */
+static int connect_to_server(void);
+
+/**
+ * @brief Sends one request on each of the first 'count' connections, then
+ * waits for every whole echo.
+ *
+ * @param sockets The connections.
+ * @param count Number of connections used.
+ * @return int E_SUCCESS or E_FAILURE.
+ */
+static int send_round(const int * sockets, int count);
+
+/**
+ * @brief Resumes every stopped server thread until the server exits,
+ * counting the system calls entered while 'load_p->measuring' is set.
+ *
+ * @param load_p The run.
+ * @param counts Entries per system call number, MAX_SYSCALL of them.
+ * @return long The number of system calls counted.
+ */
+static long trace_server(load_t * load_p, long * counts);
+
+/**
+ * @brief Prints the count per request of every system call made at least
+ * REPORT_MIN_RATE times per request.
+ *
+ * @param counts Entries per system call number.
+ * @param total Number of system calls counted.
+ * @param requests Number of requests counted.
+ */
+static void report(const long * counts, long total, int requests);
+
+/**
+ * @brief Looks up the name of a system call.
+ *
+ * @param number The system call number.
+ * @return const char * Its name, or NULL when it is not in the table.
+ */
+static const char * syscall_to_name(long number);
+
+static const syscall_name_t syscall_names_g[] = {
+    { SYS_read, "read" },
+    { SYS_write, "write" },
+    { SYS_close, "close" },
+    { SYS_sendto, "sendto" },
+    { SYS_recvfrom, "recvfrom" },
+    { SYS_sendmsg, "sendmsg" },
+    { SYS_recvmsg, "recvmsg" },
+    { SYS_accept4, "accept4" },
+    { SYS_shutdown, "shutdown" },
+    { SYS_setsockopt, "setsockopt" },
+    { SYS_epoll_wait, "epoll_wait" },
+    { SYS_epoll_pwait, "epoll_pwait" },
+    { SYS_epoll_ctl, "epoll_ctl" },
+    { SYS_futex, "futex" },
+    { SYS_sched_yield, "sched_yield" },
+    { SYS_io_uring_enter, "io_uring_enter" },
+    { SYS_mmap, "mmap" },
+    { SYS_munmap, "munmap" },
+    { SYS_brk, "brk" },
+    { SYS_madvise, "madvise" },
+    { SYS_rt_sigprocmask, "rt_sigprocmask" },
+    { SYS_clock_gettime, "clock_gettime" },
+    { SYS_clock_nanosleep, "clock_nanosleep" },
+    { SYS_nanosleep, "nanosleep" },
+};
+
+int main(int argc, char ** argv)
+{
+    int               exit_code           = E_FAILURE;
+    int               status              = 0;
+    long              total               = 0;
+    long              counts[MAX_SYSCALL] = { 0 };
+    const char *      mode_name           = "reactor";
+    tcp_server_mode_t mode                = TCP_SERVER_MODE_REACTOR;
+    pthread_t         load_thread         = { 0 };
+    load_t            load                = { 0 };
+
+    load.connections = DEFAULT_CONNECTIONS;
+    load.requests    = DEFAULT_REQUESTS;
+    load.result      = E_FAILURE;
+
+    if (1 < argc)
+    {
+        mode_name = argv[1];
+    }
+    if (2 < argc)
+    {
+        load.connections = atoi(argv[2]);
+    }
+    if (3 < argc)
+    {
+        load.requests = atoi(argv[3]);
+    }
+
+    if (0 == strcmp(mode_name, "uring"))
+    {
+        mode = TCP_SERVER_MODE_URING;
+    }
+    else if (0 == strcmp(mode_name, "thread"))
+    {
+        mode = TCP_SERVER_MODE_THREAD_PER_CONNECTION;
+    }
+    else if (0 != strcmp(mode_name, "reactor"))
+    {
+        load.connections = 0;
+    }
+
+    if ((0 >= load.connections) || (0 >= load.requests))
+    {
+        fprintf(stderr,
+                "Usage: %s [reactor|uring|thread] [connections] [requests]\n",
+                argv[0]);
+        goto END;
+    }
+
+    if ((TCP_SERVER_MODE_URING == mode) && (false == tcp_uring_supported()))
+    {
+        printf("io_uring is not supported, the server uses the reactor\n");
+    }
+
+    load.server = fork();
+    if (-1 == load.server)
+    {
+        perror("fork()");
+        goto END;
+    }
+    if (0 == load.server)
+    {
+        run_server(mode, load.connections);
+    }
+
+    // The child stops itself once it is traced
+    if ((load.server != waitpid(load.server, &status, 0)) ||
+        (false == WIFSTOPPED(status)) ||
+        (-1 == ptrace(PTRACE_SETOPTIONS,
+                      load.server,
+                      NULL,
+                      PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE |
+                          PTRACE_O_EXITKILL)))
+    {
+        perror("ptrace()");
+        kill(load.server, SIGKILL);
+        goto END;
+    }
+
+    if (0 != pthread_create(&load_thread, NULL, run_load, &load))
+    {
+        print_error("Unable to start the load thread.");
+        kill(load.server, SIGKILL);
+        goto END;
+    }
+
+    // ptrace requests are only accepted from the thread that forked
+    total = trace_server(&load, counts);
+    pthread_join(load_thread, NULL);
+
+    if (E_SUCCESS != load.result)
+    {
+        fprintf(stderr, "The load did not complete.\n");
+        goto END;
+    }
+
+    printf("%s, %d connections, %d requests\n\n",
+           mode_name,
+           load.connections,
+           load.requests);
+    report(counts, total, load.requests);
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static void run_server(tcp_server_mode_t mode, int connections)
+{
+    int                  exit_code = E_FAILURE;
+    tcp_server_options_t options   = { 0 };
+
+    if ((-1 == ptrace(PTRACE_TRACEME, 0, NULL, NULL)) ||
+        (0 != raise(SIGSTOP)) || (E_SUCCESS != signal_action_setup()))
+    {
+        _exit(EXIT_FAILURE);
+    }
+
+    tcp_server_options_init(&options);
+    options.mode            = mode;
+    options.message_handler = echo_message;
+    options.worker_threads  = SERVER_WORKERS;
+    if (TCP_SERVER_MODE_THREAD_PER_CONNECTION == mode)
+    {
+        // Every kept-alive connection holds a worker
+        options.worker_threads = (size_t)connections + 1;
+    }
+
+    // The server requires user data, which the echo handler does not use
+    exit_code =
+        start_tcp_server_ex(SERVER_PORT, &options, NULL, NULL, &options);
+    _exit((E_SUCCESS == exit_code) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static void echo_message(client_data_t * client_p,
+                         const void *    request_p,
+                         size_t          request_length,
+                         tcp_reply_t *   reply_p)
+{
+    if (E_SUCCESS == tcp_reply_append(reply_p, request_p, request_length))
+    {
+        client_p->keep_alive = true;
+    }
+}
+
+static void * run_load(void * arg_p)
+{
+    load_t * load_p  = arg_p;
+    int *    sockets = calloc((size_t)load_p->connections, sizeof(int));
+    int      opened  = 0;
+
+    if (NULL == sockets)
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    for (; opened < load_p->connections; opened++)
+    {
+        sockets[opened] = connect_to_server();
+        if (-1 == sockets[opened])
+        {
+            goto END;
+        }
+    }
+
+    if (E_SUCCESS != send_round(sockets, opened))
+    {
+        goto END;
+    }
+
+    __atomic_store_n(&load_p->measuring, 1, __ATOMIC_SEQ_CST);
+    for (int sent = 0; sent < load_p->requests; sent += load_p->connections)
+    {
+        if (E_SUCCESS !=
+            send_round(sockets,
+                       (load_p->requests - sent < load_p->connections)
+                           ? load_p->requests - sent
+                           : load_p->connections))
+        {
+            goto END;
+        }
+    }
+    __atomic_store_n(&load_p->measuring, 0, __ATOMIC_SEQ_CST);
+
+    load_p->result = E_SUCCESS;
+END:
+    __atomic_store_n(&load_p->measuring, 0, __ATOMIC_SEQ_CST);
+    for (int idx = 0; (NULL != sockets) && (idx < opened); idx++)
+    {
+        close(sockets[idx]);
+    }
+    free(sockets);
+    kill(load_p->server, SIGINT);
+    return NULL;
+}
+
+static int connect_to_server(void)
+{
+    int                socket_fd = -1;
+    int                one       = 1;
+    struct sockaddr_in address   = { 0 };
+    struct timespec    retry     = { .tv_nsec = CONNECT_RETRY_NS };
+
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(SERVER_PORT_NUMBER);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    for (int attempt = 0; attempt < CONNECT_ATTEMPTS; attempt++)
+    {
+        socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (-1 == socket_fd)
+        {
+            break;
+        }
+
+        if (0 == connect(socket_fd,
+                         (struct sockaddr *)&address,
+                         sizeof(address)))
+        {
+            setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            goto END;
+        }
+
+        close(socket_fd);
+        socket_fd = -1;
+        nanosleep(&retry, NULL);
+    }
+
+    print_error("Unable to connect to the server.");
+END:
+    return socket_fd;
+}
+
+static int send_round(const int * sockets, int count)
+{
+    int     exit_code = E_FAILURE;
+    size_t  received  = 0;
+    ssize_t result    = 0;
+    char    reply[REQUEST_LENGTH];
+
+    for (int idx = 0; idx < count; idx++)
+    {
+        if (REQUEST_LENGTH !=
+            (size_t)send(sockets[idx], REQUEST, REQUEST_LENGTH, MSG_NOSIGNAL))
+        {
+            goto END;
+        }
+    }
+
+    for (int idx = 0; idx < count; idx++)
+    {
+        for (received = 0; received < REQUEST_LENGTH; received += result)
+        {
+            result = recv(sockets[idx],
+                          reply + received,
+                          REQUEST_LENGTH - received,
+                          0);
+            if (0 >= result)
+            {
+                goto END;
+            }
+        }
+    }
+
+    exit_code = E_SUCCESS;
+END:
+    return exit_code;
+}
+
+static long trace_server(load_t * load_p, long * counts)
+{
+    long                         total   = 0;
+    int                          status  = 0;
+    int                          deliver = 0;
+    pid_t                        thread  = load_p->server;
+    struct __ptrace_syscall_info info    = { 0 };
+
+    ptrace(PTRACE_SYSCALL, thread, NULL, NULL);
+    for (;;)
+    {
+        thread = waitpid(-1, &status, __WALL);
+        if (-1 == thread)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            // ECHILD once the server has exited
+            break;
+        }
+
+        if (false == WIFSTOPPED(status))
+        {
+            continue;
+        }
+
+        deliver = WSTOPSIG(status);
+        if ((SIGTRAP | 0x80) == deliver)
+        {
+            if ((0 != __atomic_load_n(&load_p->measuring, __ATOMIC_SEQ_CST)) &&
+                (0 < ptrace(PTRACE_GET_SYSCALL_INFO,
+                            thread,
+                            (void *)sizeof(info),
+                            &info)) &&
+                (PTRACE_SYSCALL_INFO_ENTRY == info.op))
+            {
+                if (MAX_SYSCALL > info.entry.nr)
+                {
+                    counts[info.entry.nr]++;
+                }
+                total++;
+            }
+            deliver = 0;
+        }
+        else if ((SIGTRAP == deliver) || (SIGSTOP == deliver))
+        {
+            // Clone events and the stop new threads start with
+            deliver = 0;
+        }
+
+        ptrace(PTRACE_SYSCALL, thread, NULL, (void *)(intptr_t)deliver);
+    }
+
+    return total;
+}
+
+static void report(const long * counts, long total, int requests)
+{
+    const char * name = NULL;
+
+    printf("  %-16s %8.3f per request\n", "total", (double)total / requests);
+    for (long number = 0; number < MAX_SYSCALL; number++)
+    {
+        if (REPORT_MIN_RATE > (double)counts[number] / requests)
+        {
+            continue;
+        }
+
+        name = syscall_to_name(number);
+        if (NULL == name)
+        {
+            printf("  syscall %-8ld %8.3f\n",
+                   number,
+                   (double)counts[number] / requests);
+        }
+        else
+        {
+            printf("  %-16s %8.3f\n", name, (double)counts[number] / requests);
+        }
+    }
+}
+
+static const char * syscall_to_name(long number)
+{
+    const char * name = NULL;
+
+    for (size_t idx = 0;
+         idx < sizeof(syscall_names_g) / sizeof(syscall_names_g[0]);
+         idx++)
+    {
+        if (number == syscall_names_g[idx].number)
+        {
+            name = syscall_names_g[idx].name;
+            break;
+        }
+    }
+
+    return name;
+}
+
+/*** end of file ***/
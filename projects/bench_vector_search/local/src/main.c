@@ -0,0 +1,221 @@
+/**
+ * @file main.c
+ *
+ * @brief Compares the compare-function search of vector_t and value_vector_t
+ * with the SIMD kernels of value_vector_t.
+ *
+ * Usage: bench_vector_search [element count] [rounds]
+ *
+ * Every 97th element holds the match value, so find-all returns about 1% of
+ * the elements. Find-first searches for a value that is absent, which makes
+ * every path scan the whole vector.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "comparisons.h"
+#include "utilities.h"
+#include "value_vector.h"
+#include "vector.h"
+
+#define DEFAULT_COUNT  (1 << 20)
+#define DEFAULT_ROUNDS 50
+#define MATCH_STRIDE   97
+#define MATCH_VALUE    0U
+#define NS_PER_SEC     1000000000ULL
+#define NS_PER_MS      1000000.0
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return uint64_t The current time in nanoseconds.
+ */
+static uint64_t now_ns(void);
+
+/**
+ * @brief Stands in as the vector's free function, as its elements point into
+ * the value vector and are not owned.
+ *
+ * @param data Unused.
+ */
+static void keep_element(void * data);
+
+/**
+ * @brief Prints one result line, with the speedup over 'baseline_ns'.
+ *
+ * @param name Name of the path measured.
+ * @param total_ns Time taken by every round.
+ * @param rounds Number of rounds.
+ * @param baseline_ns Time of the path compared against.
+ * @param checksum Result of the last round, printed to check paths agree.
+ */
+static void report(const char * name,
+                   uint64_t     total_ns,
+                   int          rounds,
+                   uint64_t     baseline_ns,
+                   long         checksum);
+
+int main(int argc, char ** argv)
+{
+    int              exit_code = E_FAILURE;
+    int              count     = DEFAULT_COUNT;
+    int              rounds    = DEFAULT_ROUNDS;
+    uint32_t         value     = 0;
+    uint32_t         missing   = 0;
+    uint64_t         start     = 0;
+    uint64_t         baseline  = 0;
+    uint64_t         elapsed   = 0;
+    long             checksum  = 0;
+    value_vector_t * values    = NULL;
+    vector_t *       pointers  = NULL;
+    vector_t *       found     = NULL;
+    uint64_t *       bitmap    = NULL;
+    int *            indices   = NULL;
+
+    if (1 < argc)
+    {
+        count = atoi(argv[1]);
+    }
+    if (2 < argc)
+    {
+        rounds = atoi(argv[2]);
+    }
+
+    if ((0 >= count) || (0 >= rounds))
+    {
+        fprintf(stderr, "Usage: %s [element count] [rounds]\n", argv[0]);
+        goto END;
+    }
+
+    values   = value_vector_new(sizeof(uint32_t), NULL, count);
+    pointers = vector_new(keep_element, int_comp, count);
+    bitmap   = calloc(VALUE_VECTOR_BITMAP_WORDS(count), sizeof(uint64_t));
+    indices  = calloc((size_t)count, sizeof(int));
+    if ((NULL == values) || (NULL == pointers) || (NULL == bitmap) ||
+        (NULL == indices))
+    {
+        print_error("CMR failure.");
+        goto END;
+    }
+
+    for (int idx = 0; idx < count; idx++)
+    {
+        value = (0 == (idx % MATCH_STRIDE)) ? MATCH_VALUE : (uint32_t)idx;
+        if (E_SUCCESS != value_vector_append(values, &value))
+        {
+            goto END;
+        }
+    }
+
+    for (int idx = 0; idx < count; idx++)
+    {
+        if (E_SUCCESS != vector_append(pointers, value_vector_at(values, idx)))
+        {
+            goto END;
+        }
+    }
+
+    missing = (uint32_t)count;
+    value   = MATCH_VALUE;
+
+    printf("%d elements, %d rounds, ms per search\n\n", count, rounds);
+    printf("find first, value absent\n");
+
+    start = now_ns();
+    for (int round = 0; round < rounds; round++)
+    {
+        checksum = (NULL == vector_find_first_occurrence(
+                                pointers, (void **)&missing)) ? -1 : 0;
+    }
+    baseline = now_ns() - start;
+    report("vector_find_first_occurrence", baseline, rounds, baseline,
+           checksum);
+
+    start = now_ns();
+    for (int round = 0; round < rounds; round++)
+    {
+        checksum = value_vector_find_first(values, &missing);
+    }
+    elapsed = now_ns() - start;
+    report("value_vector_find_first", elapsed, rounds, baseline, checksum);
+
+    start = now_ns();
+    for (int round = 0; round < rounds; round++)
+    {
+        checksum = value_vector_find_u32(values, missing);
+    }
+    elapsed = now_ns() - start;
+    report("value_vector_find_u32", elapsed, rounds, baseline, checksum);
+
+    printf("\nfind all, 1 in %d elements matches\n", MATCH_STRIDE);
+
+    start = now_ns();
+    for (int round = 0; round < rounds; round++)
+    {
+        found    = vector_find_all_occurrences(pointers, (void **)&value);
+        checksum = vector_size(found);
+        vector_delete(&found);
+    }
+    baseline = now_ns() - start;
+    report("vector_find_all_occurrences", baseline, rounds, baseline,
+           checksum);
+
+    start = now_ns();
+    for (int round = 0; round < rounds; round++)
+    {
+        checksum = value_vector_match_u32(values, value, bitmap);
+    }
+    elapsed = now_ns() - start;
+    report("value_vector_match_u32", elapsed, rounds, baseline, checksum);
+
+    start = now_ns();
+    for (int round = 0; round < rounds; round++)
+    {
+        (void)value_vector_match_u32(values, value, bitmap);
+        checksum = value_vector_bitmap_indices(bitmap, count, indices);
+    }
+    elapsed = now_ns() - start;
+    report("  + value_vector_bitmap_indices", elapsed, rounds, baseline,
+           checksum);
+
+    exit_code = E_SUCCESS;
+END:
+    vector_delete(&pointers);
+    value_vector_delete(&values);
+    free(bitmap);
+    free(indices);
+    return exit_code;
+}
+
+/*** NOTE: STATIC FUNCTIONS LISTED BELOW ***/
+
+static uint64_t now_ns(void)
+{
+    struct timespec now = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * NS_PER_SEC) + (uint64_t)now.tv_nsec;
+}
+
+static void keep_element(void * data)
+{
+    (void)data;
+}
+
+static void report(const char * name,
+                   uint64_t     total_ns,
+                   int          rounds,
+                   uint64_t     baseline_ns,
+                   long         checksum)
+{
+    printf("  %-32s %9.3f ms  %6.1fx  (result %ld)\n",
+           name,
+           ((double)total_ns / rounds) / NS_PER_MS,
+           (double)baseline_ns / (double)((0 == total_ns) ? 1 : total_ns),
+           checksum);
+}
+
+/*** end of file ***/
@@ -0,0 +1,258 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "concurrent_map.h"
+#include "utilities.h"
+}
+
+#define THREAD_COUNT    4
+#define KEYS_PER_THREAD 1000
+#define ENTRY_MAGIC     0x5a5a5a5a
+#define FREED_MAGIC     0x0badf00d
+
+static std::atomic<int> freed_g{ 0 };
+
+// Poisons the entry before freeing it, so a reader that sees a freed entry
+// fails its check even without a sanitizer
+static void count_free(void * data)
+{
+    *static_cast<int *>(data) = FREED_MAGIC;
+    free(data);
+    freed_g++;
+}
+
+static int * new_entry(int value)
+{
+    int * entry = static_cast<int *>(malloc(sizeof(int)));
+
+    if (nullptr != entry)
+    {
+        *entry = value;
+    }
+
+    return entry;
+}
+
+static void make_key(char * key, size_t size, int owner, int idx)
+{
+    snprintf(key, size, "t%d-k%d", owner, idx);
+}
+
+// Every thread adds its own keys while looking up keys the others have added,
+// so lookups run against chains that are being extended
+TEST(ConcurrentMap, ConcurrentInsertAndLookup)
+{
+    concurrent_map_t *       map = concurrent_map_new(0, 64, count_free);
+    std::vector<std::thread> threads;
+    std::atomic<int>         misses{ 0 };
+
+    ASSERT_NE(nullptr, map);
+
+    for (int owner = 0; owner < THREAD_COUNT; owner++)
+    {
+        threads.emplace_back(
+            [map, owner, &misses]()
+            {
+                char   key[32] = {};
+                int *  found   = nullptr;
+                int    peer    = (owner + 1) % THREAD_COUNT;
+
+                for (int idx = 0; idx < KEYS_PER_THREAD; idx++)
+                {
+                    make_key(key, sizeof(key), owner, idx);
+                    if (E_SUCCESS !=
+                        concurrent_map_add(
+                            map, new_entry((owner * KEYS_PER_THREAD) + idx),
+                            key))
+                    {
+                        misses++;
+                    }
+
+                    found =
+                        static_cast<int *>(concurrent_map_lookup(map, key));
+                    if ((nullptr == found) ||
+                        ((owner * KEYS_PER_THREAD) + idx != *found))
+                    {
+                        misses++;
+                    }
+
+                    // A peer's key is either absent or carries its own value
+                    make_key(key, sizeof(key), peer, idx);
+                    found =
+                        static_cast<int *>(concurrent_map_lookup(map, key));
+                    if ((nullptr != found) &&
+                        ((peer * KEYS_PER_THREAD) + idx != *found))
+                    {
+                        misses++;
+                    }
+                }
+            });
+    }
+
+    for (std::thread & thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(0, misses.load());
+    EXPECT_EQ(static_cast<size_t>(THREAD_COUNT * KEYS_PER_THREAD),
+              concurrent_map_count(map));
+
+    for (int owner = 0; owner < THREAD_COUNT; owner++)
+    {
+        for (int idx = 0; idx < KEYS_PER_THREAD; idx++)
+        {
+            char  key[32] = {};
+            int * found   = nullptr;
+
+            make_key(key, sizeof(key), owner, idx);
+            found = static_cast<int *>(concurrent_map_lookup(map, key));
+            ASSERT_NE(nullptr, found);
+            EXPECT_EQ((owner * KEYS_PER_THREAD) + idx, *found);
+        }
+    }
+
+    EXPECT_EQ(E_SUCCESS, concurrent_map_destroy(&map));
+}
+
+// Removed entries are held back until a full batch is retired, then freed
+// together; destroy frees whatever is still waiting
+TEST(ConcurrentMap, RemoveThenReclaim)
+{
+    concurrent_map_t * map     = concurrent_map_new(4, 16, count_free);
+    char               key[32] = {};
+
+    ASSERT_NE(nullptr, map);
+    freed_g = 0;
+
+    for (int idx = 0; idx < CMAP_RETIRE_BATCH + 1; idx++)
+    {
+        make_key(key, sizeof(key), 0, idx);
+        ASSERT_EQ(E_SUCCESS, concurrent_map_add(map, new_entry(idx), key));
+    }
+
+    for (int idx = 0; idx < CMAP_RETIRE_BATCH - 1; idx++)
+    {
+        make_key(key, sizeof(key), 0, idx);
+        ASSERT_EQ(E_SUCCESS, concurrent_map_remove(map, key));
+        EXPECT_EQ(nullptr, concurrent_map_lookup(map, key));
+    }
+    EXPECT_EQ(0, freed_g.load());
+
+    make_key(key, sizeof(key), 0, CMAP_RETIRE_BATCH - 1);
+    ASSERT_EQ(E_SUCCESS, concurrent_map_remove(map, key));
+    EXPECT_EQ(CMAP_RETIRE_BATCH, freed_g.load());
+    EXPECT_EQ(E_FAILURE, concurrent_map_remove(map, key));
+    EXPECT_EQ(1U, concurrent_map_count(map));
+
+    EXPECT_EQ(E_SUCCESS, concurrent_map_destroy(&map));
+    EXPECT_EQ(CMAP_RETIRE_BATCH + 1, freed_g.load());
+}
+
+typedef struct race
+{
+    concurrent_map_t * map;
+    char *             last_key;
+    std::atomic<bool>  entered;
+    std::atomic<bool>  removing;
+    int                seen_before;
+    int                seen_after;
+    int                freed_inside;
+} race_t;
+
+// Stays inside the read until the remover has unlinked the key that
+// completes a batch, then checks the entry it holds is still intact
+static void hold_entry(void * data, void * context)
+{
+    race_t * race = static_cast<race_t *>(context);
+
+    race->seen_before = *static_cast<int *>(data);
+    race->entered     = true;
+
+    while (!race->removing)
+    {
+        std::this_thread::yield();
+    }
+
+    while (nullptr != concurrent_map_lookup(race->map, race->last_key))
+    {
+        std::this_thread::yield();
+    }
+
+    race->freed_inside = freed_g.load();
+    race->seen_after   = *static_cast<int *>(data);
+}
+
+// A reader holding an entry that is removed and reclaimed underneath it must
+// keep seeing live memory until its read ends
+TEST(ConcurrentMap, RemoveRacingReader)
+{
+    concurrent_map_t * map      = concurrent_map_new(4, 16, count_free);
+    char               key[32]  = {};
+    char               last[32] = {};
+    race_t             race     = {};
+
+    ASSERT_NE(nullptr, map);
+    freed_g = 0;
+
+    for (int idx = 0; idx < CMAP_RETIRE_BATCH; idx++)
+    {
+        make_key(key, sizeof(key), 0, idx);
+        ASSERT_EQ(E_SUCCESS,
+                  concurrent_map_add(map, new_entry(ENTRY_MAGIC), key));
+    }
+
+    make_key(last, sizeof(last), 0, CMAP_RETIRE_BATCH - 1);
+    race.map      = map;
+    race.last_key = last;
+
+    std::thread reader(
+        [&race]()
+        {
+            char held[32] = {};
+
+            make_key(held, sizeof(held), 0, 0);
+            concurrent_map_read(race.map, held, hold_entry, &race);
+        });
+
+    while (!race.entered)
+    {
+        std::this_thread::yield();
+    }
+
+    // Remove the held entry and the rest of its batch from another thread
+    std::thread remover(
+        [&race]()
+        {
+            char doomed[32] = {};
+
+            for (int idx = 0; idx < CMAP_RETIRE_BATCH - 1; idx++)
+            {
+                make_key(doomed, sizeof(doomed), 0, idx);
+                concurrent_map_remove(race.map, doomed);
+            }
+
+            race.removing = true;
+            concurrent_map_remove(race.map, race.last_key);
+        });
+
+    reader.join();
+    remover.join();
+
+    EXPECT_EQ(ENTRY_MAGIC, race.seen_before);
+    EXPECT_EQ(ENTRY_MAGIC, race.seen_after);
+    EXPECT_EQ(0, race.freed_inside);
+    EXPECT_EQ(CMAP_RETIRE_BATCH, freed_g.load());
+    EXPECT_EQ(0U, concurrent_map_count(map));
+
+    EXPECT_EQ(E_SUCCESS, concurrent_map_destroy(&map));
+}
+
+/*** end of file ***/
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include "conn_reader.h"
+#include "socket_io.h"
+#include "utilities.h"
+}
+
+#define SMALL_CAPACITY 8
+
+// fds[0] is written by the test, fds[1] is read by the reader and does not
+// block, so a read that runs out of bytes returns CONN_READER_AGAIN
+class ConnReader : public ::testing::Test
+{
+  protected:
+    int fds[2] = { -1, -1 };
+
+    void SetUp() override
+    {
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        ASSERT_EQ(0, fcntl(fds[1], F_SETFL, O_NONBLOCK));
+    }
+
+    void TearDown() override
+    {
+        close_writer();
+        close(fds[1]);
+    }
+
+    void close_writer(void)
+    {
+        if (-1 != fds[0])
+        {
+            close(fds[0]);
+            fds[0] = -1;
+        }
+    }
+
+    void put(const std::string & bytes)
+    {
+        ASSERT_EQ(E_SUCCESS,
+                  send_data(fds[0],
+                            const_cast<char *>(bytes.data()),
+                            bytes.size()));
+    }
+};
+
+static std::string text(const conn_view_t & view)
+{
+    return std::string(reinterpret_cast<const char *>(view.data_p),
+                       view.length);
+}
+
+static std::string frame(const std::string & body)
+{
+    std::string bytes(4, '\0');
+
+    bytes[2] = static_cast<char>(body.size() >> 8);
+    bytes[3] = static_cast<char>(body.size() & 0xff);
+
+    return bytes + body;
+}
+
+// A frame that arrives a few bytes at a time, split inside the prefix and
+// inside the body, is only handed out once complete
+TEST_F(ConnReader, PartialFrames)
+{
+    conn_reader_t * reader = conn_reader_create(fds[1], 0);
+    conn_view_t     view   = {};
+    std::string     bytes  = frame("hello world") + frame("next");
+
+    ASSERT_NE(nullptr, reader);
+    EXPECT_EQ(CONN_READER_AGAIN, conn_read_frame(reader, 4, 64, &view));
+
+    put(bytes.substr(0, 2));
+    EXPECT_EQ(CONN_READER_AGAIN, conn_read_frame(reader, 4, 64, &view));
+    put(bytes.substr(2, 5));
+    EXPECT_EQ(CONN_READER_AGAIN, conn_read_frame(reader, 4, 64, &view));
+    EXPECT_EQ(7U, conn_reader_buffered(reader));
+
+    put(bytes.substr(7));
+    ASSERT_EQ(E_SUCCESS, conn_read_frame(reader, 4, 64, &view));
+    EXPECT_EQ("hello world", text(view));
+    ASSERT_EQ(E_SUCCESS, conn_read_frame(reader, 4, 64, &view));
+    EXPECT_EQ("next", text(view));
+
+    // The peer closing between frames is reported as such
+    close_writer();
+    EXPECT_EQ(CONN_READER_CLOSED, conn_read_frame(reader, 4, 64, &view));
+
+    conn_reader_destroy(&reader);
+}
+
+// The peer closing part way through a frame is an error, not a close
+TEST_F(ConnReader, CloseMidFrameFails)
+{
+    conn_reader_t * reader = conn_reader_create(fds[1], 0);
+    conn_view_t     view   = {};
+
+    ASSERT_NE(nullptr, reader);
+    put(frame("truncated").substr(0, 8));
+    close_writer();
+
+    EXPECT_EQ(E_FAILURE, conn_read_frame(reader, 4, 64, &view));
+    conn_reader_destroy(&reader);
+}
+
+// Frames longer than max_length, or than the buffer can hold, are rejected
+// from their prefix, before the body is waited for
+TEST_F(ConnReader, RejectsFramesOverMaxLength)
+{
+    conn_reader_t * reader = conn_reader_create(fds[1], 64);
+    conn_view_t     view   = {};
+
+    ASSERT_NE(nullptr, reader);
+
+    put(frame(std::string(33, 'x')));
+    EXPECT_EQ(E_FAILURE, conn_read_frame(reader, 4, 32, &view));
+
+    // The prefix was not consumed, so a larger limit accepts the same frame
+    ASSERT_EQ(E_SUCCESS, conn_read_frame(reader, 4, 33, &view));
+    EXPECT_EQ(33U, view.length);
+
+    // 61 bytes of body and 4 of prefix do not fit a 64 byte buffer
+    put(frame(std::string(61, 'y')).substr(0, 4));
+    EXPECT_EQ(E_FAILURE, conn_read_frame(reader, 4, 1024, &view));
+
+    conn_reader_destroy(&reader);
+}
+
+// A delimiter split across two arrivals is found once its second half is in
+TEST_F(ConnReader, DelimiterSpanningRefills)
+{
+    conn_reader_t * reader = conn_reader_create(fds[1], 0);
+    conn_view_t     view   = {};
+
+    ASSERT_NE(nullptr, reader);
+
+    put("GET /\r");
+    EXPECT_EQ(CONN_READER_AGAIN, conn_read_until(reader, "\r\n", 2, &view));
+    put("\nHost");
+    ASSERT_EQ(E_SUCCESS, conn_read_until(reader, "\r\n", 2, &view));
+    EXPECT_EQ("GET /\r\n", text(view));
+    EXPECT_EQ(4U, conn_reader_buffered(reader));
+
+    put(": a\r\n");
+    ASSERT_EQ(E_SUCCESS, conn_read_until(reader, "\r\n", 2, &view));
+    EXPECT_EQ("Host: a\r\n", text(view));
+
+    conn_reader_destroy(&reader);
+}
+
+// In a buffer that only just fits each line, the unread bytes are moved to
+// the front between refills, including a delimiter that straddles the move
+TEST_F(ConnReader, SmallBufferCompactsBetweenLines)
+{
+    conn_reader_t * reader  = conn_reader_create(fds[1], SMALL_CAPACITY);
+    conn_view_t     view    = {};
+    const char *    lines[] = { "ab\r\n", "cdef\r\n", "g\r\n", "hijkl\r\n" };
+
+    ASSERT_NE(nullptr, reader);
+
+    for (const char * line : lines)
+    {
+        put(line);
+    }
+
+    for (const char * line : lines)
+    {
+        ASSERT_EQ(E_SUCCESS, conn_read_until(reader, "\r\n", 2, &view));
+        EXPECT_EQ(line, text(view));
+    }
+
+    // A full buffer without the delimiter cannot make progress
+    put("123456789");
+    EXPECT_EQ(E_FAILURE, conn_read_until(reader, "\r\n", 2, &view));
+
+    conn_reader_destroy(&reader);
+}
+
+// Fixed-size reads hand out exactly the bytes asked for, and a read larger
+// than the buffer is refused
+TEST_F(ConnReader, ReadExact)
+{
+    conn_reader_t * reader = conn_reader_create(fds[1], SMALL_CAPACITY);
+    conn_view_t     view   = {};
+
+    ASSERT_NE(nullptr, reader);
+
+    put("0123456789A");
+    ASSERT_EQ(E_SUCCESS, conn_read_exact(reader, 3, &view));
+    EXPECT_EQ("012", text(view));
+    ASSERT_EQ(E_SUCCESS, conn_read_exact(reader, SMALL_CAPACITY, &view));
+    EXPECT_EQ("3456789A", text(view));
+    EXPECT_EQ(CONN_READER_AGAIN, conn_read_exact(reader, 1, &view));
+    EXPECT_EQ(E_FAILURE, conn_read_exact(reader, SMALL_CAPACITY + 1, &view));
+
+    conn_reader_destroy(&reader);
+}
+
+/*** end of file ***/
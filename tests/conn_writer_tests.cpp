@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include "conn_writer.h"
+#include "socket_io.h"
+#include "utilities.h"
+}
+
+#define SMALL_THRESHOLD 64
+
+// fds[0] is written by the writer, fds[1] is read back by the test
+class ConnWriter : public ::testing::Test
+{
+  protected:
+    int fds[2] = { -1, -1 };
+
+    void SetUp() override
+    {
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    }
+
+    void TearDown() override
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    // Returns whatever has arrived so far, without waiting for more
+    std::string arrived(void)
+    {
+        std::string bytes;
+        char        chunk[4096];
+        ssize_t     received = 0;
+
+        for (;;)
+        {
+            received = recv(fds[1], chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (0 >= received)
+            {
+                break;
+            }
+            bytes.append(chunk, static_cast<size_t>(received));
+        }
+
+        return bytes;
+    }
+};
+
+// Small writes stay queued until the flush, then arrive in order
+TEST_F(ConnWriter, QueuesUntilFlush)
+{
+    conn_writer_t * writer = conn_writer_create(fds[0], 0);
+    const char      body[] = "body";
+
+    ASSERT_NE(nullptr, writer);
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, "head ", 5));
+    ASSERT_EQ(E_SUCCESS, conn_write_ref(writer, body, 4));
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, " tail", 5));
+    EXPECT_EQ(14U, conn_writer_pending(writer));
+    EXPECT_EQ("", arrived());
+
+    ASSERT_EQ(E_SUCCESS, conn_writer_flush(writer));
+    EXPECT_EQ(0U, conn_writer_pending(writer));
+    EXPECT_EQ("head body tail", arrived());
+
+    // Flushing an empty queue sends nothing
+    ASSERT_EQ(E_SUCCESS, conn_writer_flush(writer));
+    EXPECT_EQ("", arrived());
+
+    conn_writer_destroy(&writer);
+}
+
+// The queue flushes itself once the queued bytes reach the threshold, by copy
+// or by reference, and not a byte before
+TEST_F(ConnWriter, FlushesAtThreshold)
+{
+    conn_writer_t * writer = conn_writer_create(fds[0], SMALL_THRESHOLD);
+    std::string     first(SMALL_THRESHOLD - 1, 'a');
+    std::string     second(SMALL_THRESHOLD - 1, 'b');
+
+    ASSERT_NE(nullptr, writer);
+
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, first.data(), first.size()));
+    EXPECT_EQ("", arrived());
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, "!", 1));
+    EXPECT_EQ(0U, conn_writer_pending(writer));
+    EXPECT_EQ(first + "!", arrived());
+
+    ASSERT_EQ(E_SUCCESS, conn_write_ref(writer, second.data(), second.size()));
+    EXPECT_EQ("", arrived());
+    ASSERT_EQ(E_SUCCESS, conn_write_ref(writer, "?", 1));
+    EXPECT_EQ(0U, conn_writer_pending(writer));
+    EXPECT_EQ(second + "?", arrived());
+
+    conn_writer_destroy(&writer);
+}
+
+// A copy that no longer fits the buffer sends the queue first, and one
+// larger than the buffer goes out at once behind what was queued
+TEST_F(ConnWriter, LargeWritesKeepOrder)
+{
+    conn_writer_t * writer = conn_writer_create(fds[0], SMALL_THRESHOLD);
+    std::string     half(SMALL_THRESHOLD / 2, 'h');
+    std::string     large(SMALL_THRESHOLD * 2, 'L');
+
+    ASSERT_NE(nullptr, writer);
+
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, half.data(), half.size()));
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, "xyz", 3));
+    EXPECT_EQ("", arrived());
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, half.data(), half.size()));
+    EXPECT_EQ(half + "xyz", arrived());
+    EXPECT_EQ(half.size(), conn_writer_pending(writer));
+
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, large.data(), large.size()));
+    EXPECT_EQ(0U, conn_writer_pending(writer));
+    EXPECT_EQ(half + large, arrived());
+
+    conn_writer_destroy(&writer);
+}
+
+// Alternating copies and references take one queue entry each. The queue
+// holds CONN_WRITER_MAX_IOV of them and the next write flushes it, whichever
+// kind it is
+TEST_F(ConnWriter, FlushesAtMaxEntries)
+{
+    conn_writer_t * writer = conn_writer_create(fds[0], 0);
+    std::string     refs(CONN_WRITER_MAX_IOV, '\0');
+    std::string     expected;
+
+    ASSERT_NE(nullptr, writer);
+
+    for (int idx = 0; idx < CONN_WRITER_MAX_IOV; idx++)
+    {
+        char byte = static_cast<char>('A' + (idx % 26));
+
+        if (0 == idx % 2)
+        {
+            ASSERT_EQ(E_SUCCESS, conn_write(writer, &byte, 1));
+        }
+        else
+        {
+            refs[idx] = byte;
+            ASSERT_EQ(E_SUCCESS, conn_write_ref(writer, &refs[idx], 1));
+        }
+        expected += byte;
+    }
+    EXPECT_EQ(static_cast<size_t>(CONN_WRITER_MAX_IOV),
+              conn_writer_pending(writer));
+    EXPECT_EQ("", arrived());
+
+    ASSERT_EQ(E_SUCCESS, conn_write(writer, "+", 1));
+    EXPECT_EQ(expected, arrived());
+    EXPECT_EQ(1U, conn_writer_pending(writer));
+
+    // The same holds when the entry that overflows is a reference
+    for (int idx = 1; idx < CONN_WRITER_MAX_IOV; idx++)
+    {
+        ASSERT_EQ(E_SUCCESS, conn_write_ref(writer, "-", 1));
+    }
+    EXPECT_EQ("", arrived());
+    ASSERT_EQ(E_SUCCESS, conn_write_ref(writer, "=", 1));
+    EXPECT_EQ("+" + std::string(CONN_WRITER_MAX_IOV - 1, '-'), arrived());
+
+    ASSERT_EQ(E_SUCCESS, conn_writer_flush(writer));
+    EXPECT_EQ("=", arrived());
+
+    conn_writer_destroy(&writer);
+}
+
+/*** end of file ***/
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include "hash_table.h"
+#include "utilities.h"
+}
+
+#define CHAIN_LENGTH   8
+#define SNAPSHOT_KEYS  32
+#define HEADER_SIZE    32 // Size of the snapshot header, before the buckets
+
+#define SAMPLER_SEEDS  32
+
+// A single slot puts every entry in one chain, with the first added at its
+// head, so the head is the only entry a head-only sampler could pick. The
+// access times and the sampler are set explicitly so every run draws the
+// same samples, and each seed is checked on its own table
+TEST(HashTableSampledLru, EvictsEntriesBehindChainHead)
+{
+    char keys[CHAIN_LENGTH + 1][8] = {};
+
+    for (int idx = 0; idx <= CHAIN_LENGTH; idx++)
+    {
+        snprintf(keys[idx], sizeof(keys[idx]), "key%d", idx);
+    }
+
+    for (uint64_t seed = 1; seed <= SAMPLER_SEEDS; seed++)
+    {
+        hash_table_t * table   = hash_table_init(1, free);
+        int            evicted = 0;
+
+        ASSERT_NE(nullptr, table);
+        ASSERT_EQ(E_SUCCESS,
+                  hash_table_set_expiry(
+                      table, CHAIN_LENGTH, 0, EVICT_SAMPLED_LRU));
+
+        for (int idx = 0; idx < CHAIN_LENGTH; idx++)
+        {
+            ASSERT_EQ(E_SUCCESS, hash_table_add(table, malloc(1), keys[idx]));
+        }
+
+        // Older keys were used longer ago, and the head was used last
+        for (node_t * node = table->table[0]; nullptr != node;
+             node          = node->next)
+        {
+            node->last_access = static_cast<uint64_t>(atoi(node->key + 3));
+        }
+        table->table[0]->last_access = CHAIN_LENGTH;
+        ASSERT_STREQ(keys[0], table->table[0]->key);
+
+        table->rng_state = seed;
+        ASSERT_EQ(E_SUCCESS,
+                  hash_table_add(table, malloc(1), keys[CHAIN_LENGTH]));
+
+        EXPECT_EQ(static_cast<uint32_t>(CHAIN_LENGTH), table->count);
+        EXPECT_NE(nullptr, hash_table_lookup(table, keys[0]))
+            << "seed " << seed;
+        EXPECT_NE(nullptr, hash_table_lookup(table, keys[CHAIN_LENGTH]));
+        for (int idx = 1; idx < CHAIN_LENGTH; idx++)
+        {
+            evicted += (nullptr == hash_table_lookup(table, keys[idx]));
+        }
+        EXPECT_EQ(1, evicted) << "seed " << seed;
+
+        hash_table_destroy(&table);
+    }
+}
+
+static int serialize_int(void * data, void ** buffer_p, size_t * length_p)
+{
+    *buffer_p = malloc(sizeof(int));
+    if (nullptr == *buffer_p)
+    {
+        return E_FAILURE;
+    }
+
+    memcpy(*buffer_p, data, sizeof(int));
+    *length_p = sizeof(int);
+    return E_SUCCESS;
+}
+
+static void * deserialize_int(const void * buffer, size_t length)
+{
+    int * value = nullptr;
+
+    if (sizeof(int) == length)
+    {
+        value = static_cast<int *>(malloc(sizeof(int)));
+        if (nullptr != value)
+        {
+            memcpy(value, buffer, sizeof(int));
+        }
+    }
+
+    return value;
+}
+
+// Saves a table of SNAPSHOT_KEYS ints spread over 'slots' slots to a new file
+// whose name is written to 'path'. The caller unlinks it
+static void save_snapshot(uint32_t slots, char * path, size_t size)
+{
+    hash_table_t * table   = hash_table_init(slots, free);
+    char           key[16] = {};
+    int            fd      = -1;
+
+    snprintf(path, size, "/tmp/hash_table_tests_XXXXXX");
+    fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+
+    ASSERT_NE(nullptr, table);
+    for (int idx = 0; idx < SNAPSHOT_KEYS; idx++)
+    {
+        int * value = static_cast<int *>(malloc(sizeof(int)));
+
+        ASSERT_NE(nullptr, value);
+        *value = idx * 3;
+        snprintf(key, sizeof(key), "key%d", idx);
+        ASSERT_EQ(E_SUCCESS, hash_table_add(table, value, key));
+    }
+
+    ASSERT_EQ(E_SUCCESS, hash_table_save(table, path, serialize_int));
+    hash_table_destroy(&table);
+}
+
+TEST(HashTableSnapshot, RoundTrip)
+{
+    char                 path[64] = {};
+    char                 key[16]  = {};
+    hash_table_image_t * image    = nullptr;
+
+    save_snapshot(7, path, sizeof(path));
+    image = hash_table_load_mmap(path, deserialize_int);
+    ASSERT_NE(nullptr, image);
+
+    for (int idx = 0; idx < SNAPSHOT_KEYS; idx++)
+    {
+        int *        copy   = nullptr;
+        const void * view   = nullptr;
+        size_t       length = 0;
+
+        snprintf(key, sizeof(key), "key%d", idx);
+        view = hash_table_image_peek(image, key, &length);
+        ASSERT_NE(nullptr, view);
+        EXPECT_EQ(sizeof(int), length);
+
+        copy = static_cast<int *>(hash_table_image_lookup(image, key));
+        ASSERT_NE(nullptr, copy);
+        EXPECT_EQ(idx * 3, *copy);
+        free(copy);
+    }
+
+    snprintf(key, sizeof(key), "missing");
+    EXPECT_EQ(nullptr, hash_table_image_lookup(image, key));
+
+    EXPECT_EQ(E_SUCCESS, hash_table_image_close(&image));
+    unlink(path);
+}
+
+TEST(HashTableSnapshot, TruncatedImageFailsToLoad)
+{
+    char        path[64] = {};
+    struct stat info     = {};
+
+    save_snapshot(7, path, sizeof(path));
+    ASSERT_EQ(0, stat(path, &info));
+    ASSERT_EQ(0, truncate(path, info.st_size - 8));
+
+    EXPECT_EQ(nullptr, hash_table_load_mmap(path, deserialize_int));
+    unlink(path);
+}
+
+// With a single slot every entry is in one chain, starting at the bucket's
+// offset. Pointing the first entry back at itself would loop a lookup forever
+TEST(HashTableSnapshot, BackwardChainLinkFailsToLoad)
+{
+    char     path[64] = {};
+    uint64_t head     = 0;
+    int      fd       = -1;
+
+    save_snapshot(1, path, sizeof(path));
+    fd = open(path, O_RDWR);
+    ASSERT_NE(-1, fd);
+
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(head)),
+              pread(fd, &head, sizeof(head), HEADER_SIZE));
+    ASSERT_NE(0U, head);
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(head)),
+              pwrite(fd, &head, sizeof(head), static_cast<off_t>(head)));
+    close(fd);
+
+    EXPECT_EQ(nullptr, hash_table_load_mmap(path, deserialize_int));
+    unlink(path);
+}
+
+/*** end of file ***/
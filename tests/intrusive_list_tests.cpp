@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <list>
+#include <vector>
+
+extern "C"
+{
+#include "intrusive_list.h"
+#include "utilities.h"
+}
+
+#define ITEM_COUNT  64
+#define MODEL_STEPS 4000
+
+typedef struct item
+{
+    int              id;
+    intrusive_link_t first_link;
+    intrusive_link_t second_link;
+} item_t;
+
+static item_t items_g[ITEM_COUNT];
+
+static intrusive_link_t * first_link(int idx)
+{
+    return &items_g[idx].first_link;
+}
+
+static intrusive_link_t * second_link(int idx)
+{
+    return &items_g[idx].second_link;
+}
+
+static void init_items(void)
+{
+    for (int idx = 0; idx < ITEM_COUNT; idx++)
+    {
+        items_g[idx].id = idx;
+        intrusive_link_init(first_link(idx));
+        intrusive_link_init(second_link(idx));
+    }
+}
+
+// Walks the list both ways checking the links and the size, and returns
+// the ids from head to tail
+static std::vector<int> ids_of(intrusive_list_t * list)
+{
+    std::vector<int>   ids;
+    std::vector<int>   reversed;
+    intrusive_link_t * link = nullptr;
+
+    for (link = intrusive_list_peek_head(list); nullptr != link;
+         link = intrusive_list_next(list, link))
+    {
+        EXPECT_EQ(link, link->next->prev);
+        ids.push_back(INTRUSIVE_LIST_ENTRY(link, item_t, first_link)->id);
+    }
+
+    for (link = intrusive_list_peek_tail(list); nullptr != link;
+         link = intrusive_list_prev(list, link))
+    {
+        reversed.insert(reversed.begin(),
+                        INTRUSIVE_LIST_ENTRY(link, item_t, first_link)->id);
+    }
+
+    EXPECT_EQ(ids, reversed);
+    EXPECT_EQ(ids.size(), list->size);
+
+    return ids;
+}
+
+TEST(IntrusiveList, PushPopAndEntry)
+{
+    intrusive_list_t list = {};
+
+    init_items();
+    intrusive_list_init(&list);
+    EXPECT_TRUE(intrusive_list_is_empty(&list));
+    EXPECT_EQ(nullptr, intrusive_list_pop_head(&list));
+    EXPECT_EQ(nullptr, intrusive_list_pop_tail(&list));
+
+    ASSERT_EQ(E_SUCCESS, intrusive_list_push_tail(&list, first_link(1)));
+    ASSERT_EQ(E_SUCCESS, intrusive_list_push_head(&list, first_link(0)));
+    ASSERT_EQ(E_SUCCESS, intrusive_list_push_tail(&list, first_link(2)));
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2 }), ids_of(&list));
+
+    // A linked link cannot be pushed again until it is removed
+    EXPECT_TRUE(intrusive_link_is_linked(first_link(1)));
+    EXPECT_EQ(E_FAILURE, intrusive_list_push_tail(&list, first_link(1)));
+    EXPECT_EQ(3U, list.size);
+
+    EXPECT_EQ(&items_g[0],
+              INTRUSIVE_LIST_ENTRY(
+                  intrusive_list_pop_head(&list), item_t, first_link));
+    EXPECT_EQ(&items_g[2],
+              INTRUSIVE_LIST_ENTRY(
+                  intrusive_list_pop_tail(&list), item_t, first_link));
+    EXPECT_FALSE(intrusive_link_is_linked(first_link(0)));
+    EXPECT_EQ((std::vector<int>{ 1 }), ids_of(&list));
+
+    EXPECT_EQ(nullptr, INTRUSIVE_LIST_ENTRY(nullptr, item_t, first_link));
+}
+
+// One object on two lists through two links; removing it from one leaves
+// the other untouched
+TEST(IntrusiveList, ObjectOnTwoLists)
+{
+    intrusive_list_t first  = {};
+    intrusive_list_t second = {};
+
+    init_items();
+    intrusive_list_init(&first);
+    intrusive_list_init(&second);
+
+    for (int idx = 0; idx < 4; idx++)
+    {
+        ASSERT_EQ(E_SUCCESS, intrusive_list_push_tail(&first, first_link(idx)));
+        ASSERT_EQ(E_SUCCESS,
+                  intrusive_list_push_head(&second, second_link(idx)));
+    }
+
+    ASSERT_EQ(E_SUCCESS, intrusive_list_remove(&first, first_link(2)));
+    EXPECT_EQ(E_FAILURE, intrusive_list_remove(&first, first_link(2)));
+    EXPECT_EQ((std::vector<int>{ 0, 1, 3 }), ids_of(&first));
+
+    EXPECT_TRUE(intrusive_link_is_linked(second_link(2)));
+    EXPECT_EQ(4U, second.size);
+    EXPECT_EQ(&items_g[3],
+              INTRUSIVE_LIST_ENTRY(
+                  intrusive_list_peek_head(&second), item_t, second_link));
+    EXPECT_EQ(&items_g[0],
+              INTRUSIVE_LIST_ENTRY(
+                  intrusive_list_peek_tail(&second), item_t, second_link));
+}
+
+// Splicing moves every link in one step and leaves the source reusable;
+// splicing an empty list or a list onto itself changes nothing
+TEST(IntrusiveList, SpliceTail)
+{
+    intrusive_list_t dest   = {};
+    intrusive_list_t source = {};
+
+    init_items();
+    intrusive_list_init(&dest);
+    intrusive_list_init(&source);
+
+    ASSERT_EQ(E_SUCCESS, intrusive_list_splice_tail(&dest, &source));
+    EXPECT_TRUE(intrusive_list_is_empty(&dest));
+
+    for (int idx = 0; idx < 6; idx++)
+    {
+        intrusive_list_t * list = (idx < 2) ? &dest : &source;
+
+        ASSERT_EQ(E_SUCCESS, intrusive_list_push_tail(list, first_link(idx)));
+    }
+
+    ASSERT_EQ(E_SUCCESS, intrusive_list_splice_tail(&dest, &dest));
+    EXPECT_EQ((std::vector<int>{ 0, 1 }), ids_of(&dest));
+
+    ASSERT_EQ(E_SUCCESS, intrusive_list_splice_tail(&dest, &source));
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2, 3, 4, 5 }), ids_of(&dest));
+    EXPECT_TRUE(intrusive_list_is_empty(&source));
+    EXPECT_EQ(nullptr, intrusive_list_peek_head(&source));
+
+    ASSERT_EQ(E_SUCCESS, intrusive_list_push_tail(&source, first_link(6)));
+    EXPECT_EQ((std::vector<int>{ 6 }), ids_of(&source));
+}
+
+static intrusive_list_t * foreach_list_g = nullptr;
+
+static void remove_even(intrusive_link_t * link)
+{
+    if (0 == INTRUSIVE_LIST_ENTRY(link, item_t, first_link)->id % 2)
+    {
+        intrusive_list_remove(foreach_list_g, link);
+    }
+}
+
+// The foreach action may unlink the link it is given
+TEST(IntrusiveList, ForeachMayRemove)
+{
+    intrusive_list_t list = {};
+
+    init_items();
+    intrusive_list_init(&list);
+    for (int idx = 0; idx < 8; idx++)
+    {
+        ASSERT_EQ(E_SUCCESS, intrusive_list_push_tail(&list, first_link(idx)));
+    }
+
+    foreach_list_g = &list;
+    ASSERT_EQ(E_SUCCESS, intrusive_list_foreach_call(&list, remove_even));
+    EXPECT_EQ((std::vector<int>{ 1, 3, 5, 7 }), ids_of(&list));
+}
+
+// Random pushes, inserts next to a random member, removes and pops checked
+// against std::list
+TEST(IntrusiveList, MatchesListModel)
+{
+    intrusive_list_t list = {};
+    std::list<int>   model;
+
+    init_items();
+    intrusive_list_init(&list);
+    srand(1);
+
+    for (int step = 0; step < MODEL_STEPS; step++)
+    {
+        int      idx    = rand() % ITEM_COUNT;
+        item_t * item   = &items_g[idx];
+        auto     member = model.begin();
+
+        if (!model.empty())
+        {
+            std::advance(member, rand() % static_cast<int>(model.size()));
+        }
+
+        if (intrusive_link_is_linked(&item->first_link))
+        {
+            if (0 == rand() % 2)
+            {
+                ASSERT_EQ(E_SUCCESS,
+                          intrusive_list_remove(&list, &item->first_link));
+                model.remove(idx);
+            }
+            else
+            {
+                bool               head = (0 == rand() % 2);
+                intrusive_link_t * link = head ? intrusive_list_pop_head(&list)
+                                               : intrusive_list_pop_tail(&list);
+
+                ASSERT_NE(nullptr, link);
+                EXPECT_EQ(head ? model.front() : model.back(),
+                          INTRUSIVE_LIST_ENTRY(link, item_t, first_link)->id);
+                if (head)
+                {
+                    model.pop_front();
+                }
+                else
+                {
+                    model.pop_back();
+                }
+            }
+            continue;
+        }
+
+        switch (model.empty() ? rand() % 2 : rand() % 4)
+        {
+            case 0:
+                ASSERT_EQ(E_SUCCESS,
+                          intrusive_list_push_head(&list, &item->first_link));
+                model.push_front(idx);
+                break;
+
+            case 1:
+                ASSERT_EQ(E_SUCCESS,
+                          intrusive_list_push_tail(&list, &item->first_link));
+                model.push_back(idx);
+                break;
+
+            case 2:
+                ASSERT_EQ(E_SUCCESS,
+                          intrusive_list_insert_before(
+                              &list, first_link(*member), &item->first_link));
+                model.insert(member, idx);
+                break;
+
+            default:
+                ASSERT_EQ(E_SUCCESS,
+                          intrusive_list_insert_after(
+                              &list, first_link(*member), &item->first_link));
+                model.insert(std::next(member), idx);
+                break;
+        }
+    }
+
+    EXPECT_EQ(std::vector<int>(model.begin(), model.end()), ids_of(&list));
+}
+
+/*** end of file ***/
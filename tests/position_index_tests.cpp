@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+extern "C"
+{
+#include "comparisons.h"
+#include "linked_list.h"
+#include "position_index.h"
+#include "utilities.h"
+}
+
+#define VALUE_COUNT 512
+#define MODEL_STEPS 5000
+
+static int values_g[VALUE_COUNT];
+
+static void keep_element(void * data)
+{
+    (void)data;
+}
+
+static int * value(int idx)
+{
+    values_g[idx] = idx;
+    return &values_g[idx];
+}
+
+// Every position of the indexed list must hold the same data as the same
+// position of the list without an index, which walks to it
+static void expect_same_lists(list_t * indexed, list_t * naive)
+{
+    ASSERT_EQ(naive->size, indexed->size);
+    for (uint32_t position = 0; position < naive->size; position++)
+    {
+        list_node_t * expected = list_peek_position(naive, position);
+        list_node_t * actual   = list_peek_position(indexed, position);
+
+        ASSERT_NE(nullptr, expected);
+        ASSERT_NE(nullptr, actual);
+        EXPECT_EQ(expected->data, actual->data) << "position " << position;
+    }
+
+    EXPECT_EQ(nullptr, list_peek_position(indexed, indexed->size));
+}
+
+TEST(PositionIndex, MatchesVector)
+{
+    position_index_t *  index = position_index_new();
+    std::vector<void *> model;
+
+    ASSERT_NE(nullptr, index);
+    srand(1);
+    for (int step = 0; step < MODEL_STEPS; step++)
+    {
+        uint32_t position = static_cast<uint32_t>(rand()) %
+                            static_cast<uint32_t>(model.size() + 1);
+
+        if ((model.size() < 128) || (0 != rand() % 2))
+        {
+            void * item = value(rand() % VALUE_COUNT);
+
+            ASSERT_EQ(E_SUCCESS,
+                      position_index_insert(index, position, item));
+            model.insert(model.begin() + position, item);
+        }
+        else
+        {
+            position %= static_cast<uint32_t>(model.size());
+            EXPECT_EQ(model[position], position_index_remove(index, position));
+            model.erase(model.begin() + position);
+        }
+
+        ASSERT_EQ(model.size(), position_index_size(index));
+    }
+
+    for (uint32_t position = 0; position < model.size(); position++)
+    {
+        EXPECT_EQ(model[position], position_index_get(index, position));
+    }
+    EXPECT_EQ(nullptr,
+              position_index_get(index, static_cast<uint32_t>(model.size())));
+
+    position_index_clear(index);
+    EXPECT_EQ(0U, position_index_size(index));
+    position_index_destroy(&index);
+    EXPECT_EQ(nullptr, index);
+}
+
+// Runs the same random operations on a list with a position index and one
+// without, including the ones that rebuild or drop the index
+TEST(PositionIndex, IndexedListMatchesNaiveList)
+{
+    list_t *      indexed = list_new(keep_element, int_comp);
+    list_t *      naive   = list_new(keep_element, int_comp);
+    list_node_t * left    = nullptr;
+    list_node_t * right   = nullptr;
+
+    ASSERT_NE(nullptr, indexed);
+    ASSERT_NE(nullptr, naive);
+
+    // Build part of the list before indexing it, so the index starts from
+    // existing nodes
+    for (int idx = 0; idx < 64; idx++)
+    {
+        ASSERT_EQ(E_SUCCESS, list_push_tail(indexed, value(idx)));
+        ASSERT_EQ(E_SUCCESS, list_push_tail(naive, value(idx)));
+    }
+    ASSERT_EQ(E_SUCCESS, list_enable_position_index(indexed));
+    ASSERT_NE(nullptr, indexed->position_index);
+
+    srand(2);
+    for (int step = 0; step < MODEL_STEPS; step++)
+    {
+        uint32_t size     = naive->size;
+        uint32_t position = static_cast<uint32_t>(rand()) % (size + 1);
+        int *    data     = value(rand() % VALUE_COUNT);
+        void **  key      = reinterpret_cast<void **>(&data);
+
+        // Pops and removes need an existing position
+        if (position == size)
+        {
+            position = (0 == size) ? 0 : size - 1;
+        }
+
+        switch (rand() % 8)
+        {
+            case 0:
+                ASSERT_EQ(E_SUCCESS, list_push_head(indexed, data));
+                ASSERT_EQ(E_SUCCESS, list_push_head(naive, data));
+                break;
+
+            case 1:
+                ASSERT_EQ(E_SUCCESS, list_push_tail(indexed, data));
+                ASSERT_EQ(E_SUCCESS, list_push_tail(naive, data));
+                break;
+
+            case 2:
+            case 3:
+                ASSERT_EQ(E_SUCCESS,
+                          list_push_position(indexed, data, position));
+                ASSERT_EQ(E_SUCCESS, list_push_position(naive, data, position));
+                break;
+
+            case 4:
+                if (0 != size)
+                {
+                    left  = list_pop_position(indexed, position);
+                    right = list_pop_position(naive, position);
+                    ASSERT_NE(nullptr, left);
+                    ASSERT_NE(nullptr, right);
+                    EXPECT_EQ(right->data, left->data);
+                    list_node_release(indexed, left);
+                    list_node_release(naive, right);
+                }
+                break;
+
+            case 5:
+                if (0 != size)
+                {
+                    ASSERT_EQ(E_SUCCESS,
+                              list_remove_position(indexed, position));
+                    ASSERT_EQ(E_SUCCESS, list_remove_position(naive, position));
+                }
+                break;
+
+            case 6:
+                // Both lists remove the first node equal to 'data', if any
+                EXPECT_EQ(list_remove_data(naive, key),
+                          list_remove_data(indexed, key));
+                break;
+
+            default:
+                if (0 != size)
+                {
+                    bool head = (0 == rand() % 2);
+
+                    left  = head ? list_pop_head(indexed)
+                                 : list_pop_tail(indexed);
+                    right = head ? list_pop_head(naive) : list_pop_tail(naive);
+                    ASSERT_NE(nullptr, left);
+                    ASSERT_NE(nullptr, right);
+                    EXPECT_EQ(right->data, left->data);
+                    list_node_release(indexed, left);
+                    list_node_release(naive, right);
+                }
+                break;
+        }
+
+        if (0 == step % 500)
+        {
+            expect_same_lists(indexed, naive);
+        }
+    }
+    expect_same_lists(indexed, naive);
+
+    // Sorting relinks or rewrites the nodes, so the index is rebuilt
+    ASSERT_EQ(E_SUCCESS, list_sort(indexed));
+    ASSERT_EQ(E_SUCCESS, list_sort(naive));
+    expect_same_lists(indexed, naive);
+
+    ASSERT_EQ(E_SUCCESS, list_push_position(indexed, value(0), 3));
+    ASSERT_EQ(E_SUCCESS, list_push_position(naive, value(0), 3));
+    ASSERT_EQ(E_SUCCESS, list_sort_array(indexed));
+    ASSERT_EQ(E_SUCCESS, list_sort_array(naive));
+    expect_same_lists(indexed, naive);
+
+    list_disable_position_index(indexed);
+    EXPECT_EQ(nullptr, indexed->position_index);
+    expect_same_lists(indexed, naive);
+
+    ASSERT_EQ(E_SUCCESS, list_enable_position_index(indexed));
+    expect_same_lists(indexed, naive);
+
+    ASSERT_EQ(E_SUCCESS, list_clear(indexed));
+    EXPECT_EQ(nullptr, list_peek_position(indexed, 0));
+
+    list_delete(&indexed);
+    list_delete(&naive);
+}
+
+/*** end of file ***/
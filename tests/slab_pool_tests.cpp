@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+
+extern "C"
+{
+#include "linked_list.h"
+#include "slab_pool.h"
+#include "utilities.h"
+}
+
+#define OBJECT_SIZE 24
+#define PER_SLAB    4
+
+// Freed objects are handed out again, most recently freed first, before the
+// pool carves anything new
+TEST(SlabPool, ReusesFreedObjects)
+{
+    slab_pool_t * pool              = slab_pool_new(OBJECT_SIZE, PER_SLAB);
+    void *        objects[PER_SLAB] = {};
+
+    ASSERT_NE(nullptr, pool);
+    for (int idx = 0; idx < PER_SLAB; idx++)
+    {
+        objects[idx] = slab_pool_alloc(pool);
+        ASSERT_NE(nullptr, objects[idx]);
+        memset(objects[idx], 0xa5, OBJECT_SIZE);
+    }
+    EXPECT_EQ(static_cast<size_t>(PER_SLAB), slab_pool_in_use(pool));
+
+    slab_pool_free(pool, objects[1]);
+    slab_pool_free(pool, objects[2]);
+    EXPECT_EQ(static_cast<size_t>(PER_SLAB - 2), slab_pool_in_use(pool));
+
+    EXPECT_EQ(objects[2], slab_pool_alloc(pool));
+    EXPECT_EQ(objects[1], slab_pool_alloc(pool));
+    EXPECT_EQ(static_cast<size_t>(PER_SLAB), slab_pool_in_use(pool));
+
+    // A reused object comes back zeroed, like a fresh one
+    for (int idx = 1; idx <= 2; idx++)
+    {
+        const unsigned char * bytes =
+            static_cast<const unsigned char *>(objects[idx]);
+
+        for (int offset = 0; offset < OBJECT_SIZE; offset++)
+        {
+            EXPECT_EQ(0, bytes[offset]);
+        }
+    }
+
+    slab_pool_destroy(&pool);
+    EXPECT_EQ(nullptr, pool);
+}
+
+// Only a pool with every object in use grows, and objects stay distinct and
+// pointer aligned across slabs
+TEST(SlabPool, GrowsOnlyWhenFull)
+{
+    slab_pool_t *    pool   = slab_pool_new(OBJECT_SIZE, PER_SLAB);
+    void *           object = nullptr;
+    std::set<void *> seen;
+
+    ASSERT_NE(nullptr, pool);
+    for (int idx = 0; idx < 3 * PER_SLAB; idx++)
+    {
+        object = slab_pool_alloc(pool);
+        ASSERT_NE(nullptr, object);
+        EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(object) % sizeof(void *));
+        EXPECT_TRUE(seen.insert(object).second);
+    }
+
+    // Freeing and allocating one object in a loop never takes a new one
+    for (int idx = 0; idx < 100; idx++)
+    {
+        slab_pool_free(pool, object);
+        EXPECT_EQ(object, slab_pool_alloc(pool));
+    }
+    EXPECT_EQ(static_cast<size_t>(3 * PER_SLAB), slab_pool_in_use(pool));
+
+    slab_pool_free(pool, nullptr);
+    EXPECT_EQ(static_cast<size_t>(3 * PER_SLAB), slab_pool_in_use(pool));
+
+    slab_pool_destroy(&pool);
+}
+
+static void keep_element(void * data)
+{
+    (void)data;
+}
+
+// A pooled list puts the node it just released back into the next push
+TEST(SlabPool, PooledListReusesNodes)
+{
+    list_t *      list  = list_new_pooled(keep_element, nullptr, PER_SLAB);
+    int           value = 0;
+    list_node_t * node  = nullptr;
+
+    ASSERT_NE(nullptr, list);
+    ASSERT_EQ(E_SUCCESS, list_push_tail(list, &value));
+    node = list_pop_head(list);
+    ASSERT_NE(nullptr, node);
+    list_node_release(list, node);
+    EXPECT_EQ(0U, slab_pool_in_use(list->node_pool));
+
+    ASSERT_EQ(E_SUCCESS, list_push_tail(list, &value));
+    EXPECT_EQ(node, list->head);
+    EXPECT_EQ(1U, slab_pool_in_use(list->node_pool));
+
+    list_delete(&list);
+}
+
+/*** end of file ***/
@@ -0,0 +1,337 @@
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern "C"
+{
+#include "socket_io.h"
+#include "utilities.h"
+}
+
+#define LARGE_BYTES (size_t)(1024 * 1024) // Well past a socket buffer
+#define FILE_BYTES  (size_t)(512 * 1024)
+#define FILE_OFFSET 1000
+
+class SocketIo : public ::testing::Test
+{
+  protected:
+    int fds[2] = { -1, -1 };
+
+    void SetUp() override
+    {
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    }
+
+    void TearDown() override
+    {
+        close_end(0);
+        close_end(1);
+    }
+
+    void close_end(int end)
+    {
+        if (-1 != fds[end])
+        {
+            close(fds[end]);
+            fds[end] = -1;
+        }
+    }
+};
+
+static std::vector<uint8_t> pattern(size_t length, uint8_t seed)
+{
+    std::vector<uint8_t> bytes(length);
+
+    for (size_t idx = 0; idx < length; idx++)
+    {
+        bytes[idx] = static_cast<uint8_t>((idx * 31) + seed);
+    }
+
+    return bytes;
+}
+
+// A header, an empty buffer, a body larger than the socket buffer and a
+// trailer go out in one call, which has to resume after partial writes, and
+// are read back into buffers split at different points
+TEST_F(SocketIo, VectoredRoundTrip)
+{
+    std::vector<uint8_t> header  = pattern(16, 1);
+    std::vector<uint8_t> body    = pattern(LARGE_BYTES, 2);
+    std::vector<uint8_t> trailer = pattern(7, 3);
+    std::vector<uint8_t> sent;
+    std::vector<uint8_t> received(header.size() + body.size() +
+                                  trailer.size());
+    int                  send_result = E_FAILURE;
+
+    sent.insert(sent.end(), header.begin(), header.end());
+    sent.insert(sent.end(), body.begin(), body.end());
+    sent.insert(sent.end(), trailer.begin(), trailer.end());
+
+    std::thread sender(
+        [&]()
+        {
+            struct iovec iov[4] = {
+                { header.data(), header.size() },
+                { nullptr, 0 },
+                { body.data(), body.size() },
+                { trailer.data(), trailer.size() },
+            };
+
+            send_result = send_datav(fds[0], iov, 4);
+        });
+
+    struct iovec iov[3] = {
+        { received.data(), 5 },
+        { received.data() + 5, LARGE_BYTES + 10 },
+        { received.data() + 15 + LARGE_BYTES,
+          received.size() - 15 - LARGE_BYTES },
+    };
+
+    EXPECT_EQ(E_SUCCESS, recv_datav(fds[1], iov, 3));
+    sender.join();
+
+    EXPECT_EQ(E_SUCCESS, send_result);
+    EXPECT_EQ(sent, received);
+}
+
+// IOV_MAX small buffers are accepted and arrive in order; one more is not
+TEST_F(SocketIo, ManySmallBuffers)
+{
+    std::vector<struct iovec> iov(IOV_MAX + 1);
+    std::vector<uint8_t>      sent;
+    std::vector<uint8_t>      received;
+    uint8_t                   bytes[IOV_MAX][8];
+
+    for (int idx = 0; idx < IOV_MAX; idx++)
+    {
+        size_t length = 1 + (static_cast<size_t>(idx) % 8);
+
+        memset(bytes[idx], idx, length);
+        iov[idx].iov_base = bytes[idx];
+        iov[idx].iov_len  = length;
+        sent.insert(sent.end(), bytes[idx], bytes[idx] + length);
+    }
+    iov[IOV_MAX] = iov[0];
+
+    EXPECT_EQ(E_FAILURE, send_datav(fds[0], iov.data(), IOV_MAX + 1));
+    ASSERT_EQ(E_SUCCESS, send_datav(fds[0], iov.data(), IOV_MAX));
+
+    received.resize(sent.size());
+    ASSERT_EQ(E_SUCCESS, recv_data(fds[1], received.data(), received.size()));
+    EXPECT_EQ(sent, received);
+}
+
+// Reading more than the peer sends before closing fails instead of returning
+// a short read
+TEST_F(SocketIo, VectoredReceiveFailsOnEarlyClose)
+{
+    uint8_t      sent[10] = {};
+    uint8_t      first[8] = {};
+    uint8_t      rest[8]  = {};
+    struct iovec iov[2]   = { { first, sizeof(first) },
+                              { rest, sizeof(rest) } };
+
+    ASSERT_EQ(E_SUCCESS, send_data(fds[0], sent, sizeof(sent)));
+    close_end(0);
+
+    EXPECT_EQ(E_FAILURE, recv_datav(fds[1], iov, 2));
+}
+
+// Arrays with nothing to move, or a NULL buffer of non-zero length, are
+// rejected before any system call
+TEST_F(SocketIo, VectoredCallsRejectBadArrays)
+{
+    uint8_t      byte   = 0;
+    struct iovec empty  = { &byte, 0 };
+    struct iovec broken = { nullptr, 4 };
+
+    EXPECT_EQ(E_FAILURE, send_datav(fds[0], &empty, 1));
+    EXPECT_EQ(E_FAILURE, recv_datav(fds[1], &empty, 1));
+    EXPECT_EQ(E_FAILURE, send_datav(fds[0], &broken, 1));
+    EXPECT_EQ(E_FAILURE, send_datav(fds[0], &empty, 0));
+    EXPECT_EQ(E_FAILURE, send_datav(fds[0], nullptr, 1));
+    EXPECT_EQ(E_FAILURE, send_datav(-1, &broken, 1));
+}
+
+// Reads 'length' bytes on another thread while 'send' runs, so sends larger
+// than the socket buffer can complete
+template <typename SEND>
+static std::vector<uint8_t> receive_while(int socket, size_t length, SEND send)
+{
+    std::vector<uint8_t> received(length);
+    int                  recv_result = E_FAILURE;
+
+    std::thread receiver(
+        [&]()
+        {
+            recv_result = recv_data(socket, received.data(), length);
+        });
+
+    EXPECT_EQ(E_SUCCESS, send());
+    receiver.join();
+    EXPECT_EQ(E_SUCCESS, recv_result);
+
+    return received;
+}
+
+// A range from the middle of a regular file goes out with sendfile(), and
+// the file's own offset is left where it was
+TEST_F(SocketIo, SendFileRange)
+{
+    char                 path[] = "/tmp/socket_io_testXXXXXX";
+    int                  file   = mkstemp(path);
+    std::vector<uint8_t> bytes  = pattern(FILE_BYTES, 4);
+
+    ASSERT_LE(0, file);
+    unlink(path);
+    ASSERT_EQ(static_cast<ssize_t>(bytes.size()),
+              write(file, bytes.data(), bytes.size()));
+    ASSERT_EQ(7, lseek(file, 7, SEEK_SET));
+
+    size_t               length   = FILE_BYTES - FILE_OFFSET - 1;
+    std::vector<uint8_t> received = receive_while(
+        fds[1],
+        length,
+        [&]() { return send_file_range(fds[0], file, FILE_OFFSET, length); });
+
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin() + FILE_OFFSET,
+                                   bytes.begin() + FILE_OFFSET + length),
+              received);
+    EXPECT_EQ(7, lseek(file, 0, SEEK_CUR));
+
+    // Asking for more than the file holds fails once the file runs out
+    EXPECT_EQ(E_FAILURE, send_file_range(fds[0], file, FILE_BYTES - 4, 8));
+    close(file);
+}
+
+// A pipe has no offset and is spliced from its current position
+TEST_F(SocketIo, SendFileRangeFromPipe)
+{
+    int                  pipe_fds[2] = { -1, -1 };
+    std::vector<uint8_t> bytes       = pattern(FILE_BYTES, 5);
+
+    ASSERT_EQ(0, pipe(pipe_fds));
+
+    std::thread writer(
+        [&]()
+        {
+            EXPECT_EQ(static_cast<ssize_t>(bytes.size()),
+                      write(pipe_fds[1], bytes.data(), bytes.size()));
+        });
+
+    std::vector<uint8_t> received = receive_while(
+        fds[1],
+        FILE_BYTES,
+        [&]() { return send_file_range(fds[0], pipe_fds[0], 0, FILE_BYTES); });
+
+    writer.join();
+    EXPECT_EQ(bytes, received);
+
+    // The pipe closing before the range is complete is a failure
+    close(pipe_fds[1]);
+    EXPECT_EQ(E_FAILURE, send_file_range(fds[0], pipe_fds[0], 0, 1));
+    close(pipe_fds[0]);
+}
+
+// Builds a connected TCP pair over loopback, as MSG_ZEROCOPY needs an
+// IP socket
+static int tcp_pair(int * fds)
+{
+    int                listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address  = {};
+    socklen_t          length   = sizeof(address);
+    int                result   = E_FAILURE;
+
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if ((0 <= listener) &&
+        (0 == bind(listener,
+                   reinterpret_cast<struct sockaddr *>(&address),
+                   sizeof(address))) &&
+        (0 == listen(listener, 1)) &&
+        (0 == getsockname(listener,
+                          reinterpret_cast<struct sockaddr *>(&address),
+                          &length)))
+    {
+        fds[0] = socket(AF_INET, SOCK_STREAM, 0);
+        if ((0 <= fds[0]) &&
+            (0 == connect(fds[0],
+                          reinterpret_cast<struct sockaddr *>(&address),
+                          sizeof(address))))
+        {
+            fds[1] = accept(listener, nullptr, nullptr);
+            result = (0 <= fds[1]) ? E_SUCCESS : E_FAILURE;
+        }
+    }
+
+    if (0 <= listener)
+    {
+        close(listener);
+    }
+
+    return result;
+}
+
+// Small sends are copied and take no ids; a large one takes at least one id
+// and every id it took is reported complete through the error queue
+TEST_F(SocketIo, ZerocopySendsComplete)
+{
+    std::vector<uint8_t> bytes     = pattern(FILE_BYTES, 6);
+    uint32_t             next_id   = 0;
+    uint32_t             completed = 0;
+
+    close_end(0);
+    close_end(1);
+    ASSERT_EQ(E_SUCCESS, tcp_pair(fds));
+    if (E_SUCCESS != enable_zerocopy(fds[0]))
+    {
+        GTEST_SKIP() << "kernel does not support MSG_ZEROCOPY";
+    }
+
+    std::vector<uint8_t> received = receive_while(
+        fds[1],
+        16 + FILE_BYTES,
+        [&]()
+        {
+            int result =
+                send_data_zerocopy(fds[0], bytes.data(), 16, &next_id);
+
+            EXPECT_EQ(0U, next_id);
+            if (E_SUCCESS == result)
+            {
+                result = send_data_zerocopy(
+                    fds[0], bytes.data(), FILE_BYTES, &next_id);
+            }
+
+            return result;
+        });
+
+    std::vector<uint8_t> expected(bytes.begin(), bytes.begin() + 16);
+
+    expected.insert(expected.end(), bytes.begin(), bytes.end());
+    EXPECT_EQ(expected, received);
+    EXPECT_LT(0U, next_id);
+
+    // Completions arrive asynchronously; the socket polls POLLERR for them
+    for (int tries = 0; (completed != next_id) && (tries < 100); tries++)
+    {
+        struct pollfd poll_fd = { fds[0], 0, 0 };
+
+        poll(&poll_fd, 1, 10);
+        ASSERT_LE(0, reap_zerocopy(fds[0], &completed, nullptr));
+    }
+    EXPECT_EQ(next_id, completed);
+}
+
+/*** end of file ***/
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+
+extern "C"
+{
+#include "comparisons.h"
+#include "sort.h"
+#include "utilities.h"
+#include "value_vector.h"
+#include "vector.h"
+}
+
+// An empty array is already sorted, whatever its buffer is
+TEST(SortEmpty, NullBaseWithNoElements)
+{
+    EXPECT_EQ(E_SUCCESS, sort_introsort(nullptr, 0, sizeof(int), int_comp,
+                                        false));
+    EXPECT_EQ(E_SUCCESS, sort_radix_u32(nullptr, 0));
+    EXPECT_EQ(E_SUCCESS, sort_radix_i32(nullptr, 0));
+    EXPECT_EQ(E_SUCCESS, sort_radix_u64(nullptr, 0));
+    EXPECT_EQ(E_SUCCESS, sort_radix_i64(nullptr, 0));
+    EXPECT_EQ(E_SUCCESS, sort_radix_keyed(nullptr, 0, nullptr));
+}
+
+TEST(SortEmpty, NullBaseWithElementsFails)
+{
+    EXPECT_EQ(E_FAILURE, sort_introsort(nullptr, 2, sizeof(int), int_comp,
+                                        false));
+    EXPECT_EQ(E_FAILURE, sort_radix_u32(nullptr, 2));
+}
+
+TEST(SortEmpty, VectorWithNoCapacity)
+{
+    vector_t * vector = vector_new(free, int_comp, 0);
+
+    ASSERT_NE(nullptr, vector);
+    EXPECT_EQ(E_SUCCESS, vector_sort(vector));
+
+    vector_delete(&vector);
+}
+
+TEST(SortEmpty, ValueVectorWithNoCapacity)
+{
+    value_vector_t * vector = value_vector_new(sizeof(int), int_comp, 0);
+
+    ASSERT_NE(nullptr, vector);
+    EXPECT_EQ(E_SUCCESS, value_vector_sort(vector));
+
+    value_vector_delete(&vector);
+}
+
+// Merging a vector into itself would read elements it has already overwritten
+TEST(SortMerge, IntoItselfFails)
+{
+    vector_t * vector = vector_new(free, int_comp, 0);
+
+    ASSERT_NE(nullptr, vector);
+    for (int value = 0; value < 4; value++)
+    {
+        int * element = static_cast<int *>(malloc(sizeof(int)));
+
+        ASSERT_NE(nullptr, element);
+        *element = value;
+        ASSERT_EQ(E_SUCCESS, vector_insert_sorted(vector, element));
+    }
+
+    EXPECT_EQ(E_FAILURE, vector_merge_sorted(vector, vector));
+    EXPECT_EQ(4, vector_size(vector));
+
+    vector_delete(&vector);
+}
+
+// Integer vectors go through the radix sorts, which must order negative
+// values before positive ones
+TEST(SortTyped, Int32VectorWithNegatives)
+{
+    value_vector_t * vector     = int32_vector_new(0);
+    const int32_t    values[]   = { 7, -3, 0, INT32_MIN, 42, -3, INT32_MAX };
+    const int32_t    expected[] = { INT32_MIN, -3, -3, 0, 7, 42, INT32_MAX };
+
+    ASSERT_NE(nullptr, vector);
+    for (int32_t value : values)
+    {
+        ASSERT_EQ(E_SUCCESS, int32_vector_push(vector, value));
+    }
+
+    ASSERT_EQ(E_SUCCESS, int32_vector_sort(vector));
+    for (int idx = 0; idx < vector->size; idx++)
+    {
+        EXPECT_EQ(expected[idx], int32_vector_get(vector, idx));
+    }
+
+    value_vector_delete(&vector);
+}
+
+TEST(SortTyped, DoubleVector)
+{
+    value_vector_t * vector = double_vector_new(0);
+
+    ASSERT_NE(nullptr, vector);
+    for (int idx = 0; idx < 100; idx++)
+    {
+        ASSERT_EQ(E_SUCCESS,
+                  double_vector_push(vector, ((idx * 37) % 100) - 49.5));
+    }
+
+    ASSERT_EQ(E_SUCCESS, double_vector_sort(vector));
+    for (int idx = 0; idx < vector->size; idx++)
+    {
+        EXPECT_EQ(idx - 49.5, double_vector_get(vector, idx));
+    }
+
+    value_vector_delete(&vector);
+}
+
+/*** end of file ***/
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C"
+{
+#include "socket_io.h"
+#include "tcp_reactor.h"
+#include "threadpool.h"
+#include "utilities.h"
+}
+
+#define POOL_THREADS    4
+#define IO_THREADS      2
+#define CLIENT_COUNT    8
+#define ROUNDS          20
+#define MESSAGE_BYTES   4
+#define IDLE_TIMEOUT_MS 500
+#define PACE_MS         50 // Gap between requests, well inside the timeout
+#define RECV_TIMEOUT_S  5
+
+static std::atomic<int> freed_g{ 0 };
+
+// Echoes one fixed-size message and keeps the connection for the next one,
+// unless the message is "quit"
+static void * echo_message(void * args_p)
+{
+    client_data_t * client_p = static_cast<client_data_t *>(args_p);
+    int             socket   = client_p->client_fd;
+    char            message[MESSAGE_BYTES + 1] = {};
+
+    if ((E_SUCCESS == recv_data(socket, message, MESSAGE_BYTES)) &&
+        (E_SUCCESS == send_data(socket, message, MESSAGE_BYTES)))
+    {
+        client_p->keep_alive = (0 != strcmp("quit", message));
+    }
+
+    return nullptr;
+}
+
+static void count_free(void * args_p)
+{
+    (void)args_p;
+    freed_g++;
+}
+
+// Runs a reactor on its own threadpool and hands it one end of each
+// socketpair, keeping the other end as the client
+class TcpReactor : public ::testing::Test
+{
+  protected:
+    threadpool_t *   pool    = nullptr;
+    tcp_reactor_t *  reactor = nullptr;
+    std::vector<int> clients;
+
+    void start(unsigned int idle_timeout_ms, int client_count)
+    {
+        freed_g = 0;
+        pool    = threadpool_create(POOL_THREADS);
+        ASSERT_NE(nullptr, pool);
+        reactor = tcp_reactor_create(
+            pool, IO_THREADS, 0, idle_timeout_ms, echo_message, count_free);
+        ASSERT_NE(nullptr, reactor);
+
+        for (int idx = 0; idx < client_count; idx++)
+        {
+            int            fds[2]  = { -1, -1 };
+            struct timeval timeout = { RECV_TIMEOUT_S, 0 };
+
+            ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+            ASSERT_EQ(0,
+                      setsockopt(fds[0],
+                                 SOL_SOCKET,
+                                 SO_RCVTIMEO,
+                                 &timeout,
+                                 sizeof(timeout)));
+            clients.push_back(fds[0]);
+            ASSERT_EQ(E_SUCCESS,
+                      tcp_reactor_add_client(reactor, fds[1], nullptr));
+        }
+    }
+
+    void stop(void)
+    {
+        if (nullptr != reactor)
+        {
+            EXPECT_EQ(E_SUCCESS, tcp_reactor_stop(reactor));
+            EXPECT_EQ(E_SUCCESS, threadpool_shutdown(pool));
+            EXPECT_EQ(E_SUCCESS, tcp_reactor_destroy(&reactor));
+        }
+
+        if (nullptr != pool)
+        {
+            threadpool_destroy(&pool);
+        }
+    }
+
+    void TearDown() override
+    {
+        stop();
+        for (int client : clients)
+        {
+            close(client);
+        }
+    }
+};
+
+static bool round_trip(int client, const char * message)
+{
+    char reply[MESSAGE_BYTES] = {};
+
+    return (E_SUCCESS ==
+            send_data(client, const_cast<char *>(message), MESSAGE_BYTES)) &&
+           (E_SUCCESS == recv_data(client, reply, MESSAGE_BYTES)) &&
+           (0 == memcmp(message, reply, MESSAGE_BYTES));
+}
+
+// Returns true once the peer has closed the connection, false if it sends
+// anything or is still open when the receive timeout ends
+static bool peer_closed(int client)
+{
+    char byte = 0;
+
+    return 0 == recv(client, &byte, 1, 0);
+}
+
+// Every connection is re-armed after each request it keeps alive, across
+// both I/O threads, and closed, with its data freed once, when it is not
+TEST_F(TcpReactor, KeepsConnectionsAliveUntilQuit)
+{
+    start(0, CLIENT_COUNT);
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (int client : clients)
+        {
+            ASSERT_TRUE(round_trip(client, "ping")) << "round " << round;
+        }
+    }
+    EXPECT_EQ(0, freed_g.load());
+
+    for (int client : clients)
+    {
+        ASSERT_TRUE(round_trip(client, "quit"));
+        EXPECT_TRUE(peer_closed(client));
+    }
+
+    // The handler's job ends after it has closed the connection
+    EXPECT_EQ(E_SUCCESS, threadpool_wait_idle(pool, RECV_TIMEOUT_S * 1000));
+    EXPECT_EQ(CLIENT_COUNT, freed_g.load());
+}
+
+// A connection that stays quiet past the idle timeout is closed, while one
+// that keeps sending requests more often than that stays open
+TEST_F(TcpReactor, ClosesIdleConnections)
+{
+    start(IDLE_TIMEOUT_MS, 2);
+
+    // Keep one connection busy for longer than the timeout
+    for (int round = 0; round < (2 * IDLE_TIMEOUT_MS) / PACE_MS; round++)
+    {
+        ASSERT_TRUE(round_trip(clients[1], "ping"));
+        usleep(PACE_MS * 1000);
+    }
+
+    EXPECT_TRUE(peer_closed(clients[0]));
+    EXPECT_TRUE(round_trip(clients[1], "ping"));
+    EXPECT_EQ(1, freed_g.load());
+}
+
+// Destroying the reactor closes the connections still open
+TEST_F(TcpReactor, DestroyClosesOpenConnections)
+{
+    start(0, 2);
+
+    ASSERT_TRUE(round_trip(clients[0], "ping"));
+    stop();
+
+    EXPECT_EQ(2, freed_g.load());
+    EXPECT_TRUE(peer_closed(clients[0]));
+    EXPECT_TRUE(peer_closed(clients[1]));
+}
+
+/*** end of file ***/
@@ -0,0 +1,227 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+extern "C"
+{
+#include "timer_wheel.h"
+#include "utilities.h"
+}
+
+#define TIMER_COUNT 256
+#define MODEL_STEPS 4000
+#define TICK_MS     10
+#define SLOT_COUNT  8
+
+typedef struct timer
+{
+    int                 id;
+    timer_wheel_entry_t entry;
+} timer_t_;
+
+static timer_t_ timers_g[TIMER_COUNT];
+
+static void init_timers(void)
+{
+    for (int idx = 0; idx < TIMER_COUNT; idx++)
+    {
+        timers_g[idx].id = idx;
+        timer_wheel_entry_init(&timers_g[idx].entry);
+    }
+}
+
+// Expires the wheel at 'now' and returns the ids that fired, in order
+static std::vector<int> expire_ids(timer_wheel_t * wheel, uint64_t now)
+{
+    intrusive_list_t   expired = {};
+    intrusive_link_t * link    = nullptr;
+    std::vector<int>   ids;
+    size_t             count   = 0;
+
+    intrusive_list_init(&expired);
+    count = timer_wheel_expire(wheel, now, &expired);
+
+    while (nullptr != (link = intrusive_list_pop_head(&expired)))
+    {
+        ids.push_back(INTRUSIVE_LIST_ENTRY(link, timer_t_, entry.link)->id);
+    }
+    EXPECT_EQ(count, ids.size());
+
+    return ids;
+}
+
+// A timer fires on the first expire once the tick holding its deadline has
+// ended, never before its deadline and never in an earlier tick
+TEST(TimerWheel, FiresAtTheEndOfItsTick)
+{
+    timer_wheel_t * wheel = timer_wheel_new(SLOT_COUNT, TICK_MS, 1000);
+
+    ASSERT_NE(nullptr, wheel);
+    init_timers();
+
+    ASSERT_EQ(E_SUCCESS, timer_wheel_schedule(wheel, &timers_g[0].entry, 1015));
+    ASSERT_EQ(E_SUCCESS, timer_wheel_schedule(wheel, &timers_g[1].entry, 1020));
+    EXPECT_EQ(2U, timer_wheel_size(wheel));
+
+    EXPECT_TRUE(expire_ids(wheel, 1014).empty());
+    EXPECT_TRUE(expire_ids(wheel, 1019).empty());
+    EXPECT_EQ((std::vector<int>{ 0, 1 }), expire_ids(wheel, 1020));
+    EXPECT_EQ(0U, timer_wheel_size(wheel));
+
+    // A deadline already passed fires once the current tick has ended
+    ASSERT_EQ(E_SUCCESS, timer_wheel_schedule(wheel, &timers_g[2].entry, 900));
+    EXPECT_TRUE(expire_ids(wheel, 1029).empty());
+    EXPECT_EQ((std::vector<int>{ 2 }), expire_ids(wheel, 1030));
+
+    timer_wheel_destroy(&wheel);
+    EXPECT_EQ(nullptr, wheel);
+}
+
+// Deadlines further out than one turn share a slot with nearer ones and must
+// stay in it until their own turn, including when expire jumps more than a
+// whole turn at once
+TEST(TimerWheel, WrapsPastSlotCount)
+{
+    const uint64_t  turn  = SLOT_COUNT * TICK_MS;
+    timer_wheel_t * wheel = timer_wheel_new(SLOT_COUNT, TICK_MS, 0);
+
+    ASSERT_NE(nullptr, wheel);
+    init_timers();
+
+    // Same slot, one, two and five turns apart
+    ASSERT_EQ(E_SUCCESS, timer_wheel_schedule(wheel, &timers_g[0].entry, 30));
+    ASSERT_EQ(E_SUCCESS,
+              timer_wheel_schedule(wheel, &timers_g[1].entry, 30 + turn));
+    ASSERT_EQ(E_SUCCESS,
+              timer_wheel_schedule(wheel, &timers_g[2].entry, 30 + 2 * turn));
+    ASSERT_EQ(E_SUCCESS,
+              timer_wheel_schedule(wheel, &timers_g[3].entry, 30 + 5 * turn));
+    EXPECT_EQ(timers_g[0].entry.slot, timers_g[3].entry.slot);
+
+    // Step one tick at a time through the first three turns
+    for (uint64_t now = 0; now < 3 * turn; now += TICK_MS)
+    {
+        std::vector<int> ids = expire_ids(wheel, now);
+
+        if (now == 30)
+        {
+            EXPECT_EQ((std::vector<int>{ 0 }), ids);
+        }
+        else if (now == 30 + turn)
+        {
+            EXPECT_EQ((std::vector<int>{ 1 }), ids);
+        }
+        else if (now == 30 + 2 * turn)
+        {
+            EXPECT_EQ((std::vector<int>{ 2 }), ids);
+        }
+        else
+        {
+            EXPECT_TRUE(ids.empty()) << "at " << now;
+        }
+    }
+    EXPECT_EQ(1U, timer_wheel_size(wheel));
+
+    // Jump past several turns, short of the last deadline, then past it
+    EXPECT_TRUE(expire_ids(wheel, 29 + 5 * turn).empty());
+    EXPECT_EQ((std::vector<int>{ 3 }), expire_ids(wheel, 100 * turn));
+    EXPECT_EQ(0U, timer_wheel_size(wheel));
+
+    timer_wheel_destroy(&wheel);
+}
+
+// Rescheduling moves a timer and cancelling removes it, in any slot
+TEST(TimerWheel, RescheduleAndCancel)
+{
+    timer_wheel_t * wheel = timer_wheel_new(SLOT_COUNT, TICK_MS, 0);
+
+    ASSERT_NE(nullptr, wheel);
+    init_timers();
+
+    ASSERT_EQ(E_SUCCESS, timer_wheel_schedule(wheel, &timers_g[0].entry, 20));
+    ASSERT_EQ(E_SUCCESS, timer_wheel_schedule(wheel, &timers_g[1].entry, 20));
+    ASSERT_EQ(E_SUCCESS, timer_wheel_schedule(wheel, &timers_g[0].entry, 50));
+    EXPECT_EQ(2U, timer_wheel_size(wheel));
+
+    ASSERT_EQ(E_SUCCESS, timer_wheel_cancel(wheel, &timers_g[1].entry));
+    EXPECT_FALSE(timer_wheel_is_scheduled(&timers_g[1].entry));
+    ASSERT_EQ(E_SUCCESS, timer_wheel_cancel(wheel, &timers_g[1].entry));
+    EXPECT_EQ(1U, timer_wheel_size(wheel));
+
+    EXPECT_TRUE(expire_ids(wheel, 40).empty());
+    EXPECT_EQ((std::vector<int>{ 0 }), expire_ids(wheel, 50));
+
+    timer_wheel_destroy(&wheel);
+}
+
+// Random schedules, reschedules and cancels with the clock moving by random
+// steps, some longer than a turn. Every expired timer is due, and no timer is
+// left on the wheel once the tick it was due in has ended
+TEST(TimerWheel, NeverFiresEarlyOrLate)
+{
+    const uint64_t        turn  = SLOT_COUNT * TICK_MS;
+    uint64_t              now   = 12345;
+    timer_wheel_t *       wheel = timer_wheel_new(SLOT_COUNT, TICK_MS, now);
+    size_t                live  = 0;
+    std::vector<uint64_t> due_tick(TIMER_COUNT, 0);
+
+    ASSERT_NE(nullptr, wheel);
+    init_timers();
+    srand(1);
+
+    for (int step = 0; step < MODEL_STEPS; step++)
+    {
+        timer_t_ * timer = &timers_g[rand() % TIMER_COUNT];
+
+        if (0 == rand() % 8)
+        {
+            if (timer_wheel_is_scheduled(&timer->entry))
+            {
+                live--;
+            }
+            ASSERT_EQ(E_SUCCESS, timer_wheel_cancel(wheel, &timer->entry));
+        }
+        else
+        {
+            // Mostly within a few turns, sometimes overdue
+            uint64_t deadline =
+                now - TICK_MS + (static_cast<uint64_t>(rand()) % (4 * turn));
+            uint64_t tick = (deadline + TICK_MS - 1) / TICK_MS;
+
+            // An overdue timer waits for the end of the current tick
+            due_tick[timer->id] = std::max(tick, (now / TICK_MS) + 1);
+
+            if (!timer_wheel_is_scheduled(&timer->entry))
+            {
+                live++;
+            }
+            ASSERT_EQ(E_SUCCESS,
+                      timer_wheel_schedule(wheel, &timer->entry, deadline));
+        }
+
+        now += static_cast<uint64_t>(rand()) %
+               ((0 == rand() % 50) ? (3 * turn) : 7);
+        for (int id : expire_ids(wheel, now))
+        {
+            EXPECT_LE(timers_g[id].entry.deadline, now) << "fired early";
+            live--;
+        }
+        ASSERT_EQ(live, timer_wheel_size(wheel));
+
+        for (timer_t_ & left : timers_g)
+        {
+            if (timer_wheel_is_scheduled(&left.entry))
+            {
+                EXPECT_GT(due_tick[left.id], now / TICK_MS)
+                    << "missed at " << now;
+            }
+        }
+    }
+
+    timer_wheel_destroy(&wheel);
+}
+
+/*** end of file ***/
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+extern "C"
+{
+#include "unrolled_list.h"
+#include "utilities.h"
+}
+
+#define VALUE_COUNT 256
+#define MODEL_STEPS 4000
+
+static int values_g[VALUE_COUNT];
+
+static void keep_element(void * data)
+{
+    (void)data;
+}
+
+static int * value(int idx)
+{
+    values_g[idx] = idx;
+    return &values_g[idx];
+}
+
+// Walks the nodes checking their counts and links, then compares the
+// elements with 'expected'. Returns the node counts
+static std::vector<uint32_t> check_list(unrolled_list_t *        list,
+                                        const std::vector<int> & expected)
+{
+    std::vector<uint32_t> counts;
+    std::vector<int>      seen;
+    unrolled_node_t *     prev = nullptr;
+
+    for (unrolled_node_t * node = list->head; nullptr != node;
+         node                   = node->next)
+    {
+        EXPECT_EQ(prev, node->prev);
+        EXPECT_LT(0U, node->count);
+        EXPECT_GE(list->node_capacity, node->count);
+
+        counts.push_back(node->count);
+        for (uint32_t idx = 0; idx < node->count; idx++)
+        {
+            seen.push_back(*static_cast<int *>(node->items[idx]));
+        }
+        prev = node;
+    }
+
+    EXPECT_EQ(prev, list->tail);
+    EXPECT_EQ(expected.size(), static_cast<size_t>(list->size));
+    EXPECT_EQ(expected, seen);
+
+    return counts;
+}
+
+static unrolled_list_t * filled_list(uint32_t capacity, int count)
+{
+    unrolled_list_t * list = unrolled_list_new(keep_element, nullptr, capacity);
+
+    if (nullptr != list)
+    {
+        for (int idx = 0; idx < count; idx++)
+        {
+            if (E_SUCCESS != unrolled_list_push_tail(list, value(idx)))
+            {
+                unrolled_list_delete(&list);
+                break;
+            }
+        }
+    }
+
+    return list;
+}
+
+TEST(UnrolledList, PushesFillWholeNodes)
+{
+    unrolled_list_t * list = filled_list(4, 8);
+
+    ASSERT_NE(nullptr, list);
+    EXPECT_EQ((std::vector<uint32_t>{ 4, 4 }),
+              check_list(list, { 0, 1, 2, 3, 4, 5, 6, 7 }));
+
+    // A full head gets a node of its own in front
+    ASSERT_EQ(E_SUCCESS, unrolled_list_push_head(list, value(8)));
+    EXPECT_EQ((std::vector<uint32_t>{ 1, 4, 4 }),
+              check_list(list, { 8, 0, 1, 2, 3, 4, 5, 6, 7 }));
+
+    unrolled_list_delete(&list);
+}
+
+// Inserting into a full node keeps its lower half and moves the upper half
+// to a new node, putting the element on whichever side its offset falls
+TEST(UnrolledList, InsertIntoFullNodeSplits)
+{
+    const struct
+    {
+        uint32_t              position;
+        std::vector<int>      expected;
+        std::vector<uint32_t> counts;
+    } cases[] = {
+        { 0, { 9, 0, 1, 2, 3 }, { 3, 2 } },
+        { 1, { 0, 9, 1, 2, 3 }, { 3, 2 } },
+        { 2, { 0, 1, 9, 2, 3 }, { 3, 2 } },
+        { 3, { 0, 1, 2, 9, 3 }, { 2, 3 } },
+        { 4, { 0, 1, 2, 3, 9 }, { 4, 1 } },
+    };
+
+    for (const auto & test : cases)
+    {
+        unrolled_list_t * list = filled_list(4, 4);
+
+        ASSERT_NE(nullptr, list);
+        ASSERT_EQ(E_SUCCESS,
+                  unrolled_list_push_position(list, value(9), test.position));
+        EXPECT_EQ(test.counts, check_list(list, test.expected))
+            << "position " << test.position;
+
+        unrolled_list_delete(&list);
+    }
+}
+
+// A node that drops below half full merges with a neighbour once both fit
+// within half a node, and an emptied node is released
+TEST(UnrolledList, RemoveMergesUnderfullNodes)
+{
+    unrolled_list_t * list     = filled_list(8, 8);
+    std::vector<int>  expected = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    ASSERT_NE(nullptr, list);
+
+    // Split the full node into [0 9 1 2 3] [4 5 6 7]
+    ASSERT_EQ(E_SUCCESS, unrolled_list_push_position(list, value(9), 1));
+    expected.insert(expected.begin() + 1, 9);
+    EXPECT_EQ((std::vector<uint32_t>{ 5, 4 }), check_list(list, expected));
+
+    // Shrink the second node to 2; 2 + 5 does not fit in half a node
+    for (int idx = 7; idx > 5; idx--)
+    {
+        EXPECT_EQ(&values_g[idx], unrolled_list_pop_tail(list));
+        expected.pop_back();
+    }
+    EXPECT_EQ((std::vector<uint32_t>{ 5, 2 }), check_list(list, expected));
+
+    // Shrink the first node: at 3 it is under half but 3 + 2 > 4, at 2 the
+    // two nodes fit in half a node and merge
+    ASSERT_EQ(E_SUCCESS, unrolled_list_remove_position(list, 0));
+    expected.erase(expected.begin());
+    EXPECT_EQ((std::vector<uint32_t>{ 4, 2 }), check_list(list, expected));
+    ASSERT_EQ(E_SUCCESS, unrolled_list_remove_position(list, 0));
+    expected.erase(expected.begin());
+    EXPECT_EQ((std::vector<uint32_t>{ 3, 2 }), check_list(list, expected));
+    ASSERT_EQ(E_SUCCESS, unrolled_list_remove_position(list, 0));
+    expected.erase(expected.begin());
+    EXPECT_EQ((std::vector<uint32_t>{ 4 }), check_list(list, expected));
+
+    while (0 != list->size)
+    {
+        ASSERT_NE(nullptr, unrolled_list_pop_head(list));
+    }
+    EXPECT_EQ(nullptr, list->head);
+    EXPECT_EQ(nullptr, list->tail);
+
+    unrolled_list_delete(&list);
+}
+
+// Random inserts and removes at every position, checked against a vector,
+// for the smallest capacities and the default one
+TEST(UnrolledList, MatchesVectorModel)
+{
+    const uint32_t capacities[] = { 2, 3, 4, UNROLLED_LIST_NODE_CAPACITY };
+
+    srand(1);
+    for (uint32_t capacity : capacities)
+    {
+        unrolled_list_t * list =
+            unrolled_list_new(keep_element, nullptr, capacity);
+        std::vector<int> model;
+
+        ASSERT_NE(nullptr, list);
+        for (int step = 0; step < MODEL_STEPS; step++)
+        {
+            uint32_t position = static_cast<uint32_t>(rand()) %
+                                static_cast<uint32_t>(model.size() + 1);
+            int      idx      = rand() % VALUE_COUNT;
+
+            // Grow while small, then insert and remove evenly
+            if ((model.size() < 64) ? (0 != rand() % 4) : (0 != rand() % 2))
+            {
+                ASSERT_EQ(E_SUCCESS,
+                          unrolled_list_push_position(list, value(idx),
+                                                      position));
+                model.insert(model.begin() + position, idx);
+            }
+            else if (!model.empty())
+            {
+                position %= static_cast<uint32_t>(model.size());
+                EXPECT_EQ(model[position],
+                          *static_cast<int *>(
+                              unrolled_list_pop_position(list, position)));
+                model.erase(model.begin() + position);
+            }
+        }
+
+        check_list(list, model);
+        unrolled_list_delete(&list);
+    }
+}
+
+/*** end of file ***/